@@ -10,12 +10,14 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEntity.h"
 #include "../Scene/SceneHierarchyPanel.h"
+#include "../Scene/SceneSerializer.h"
 #include "../Scene/Entities/Skybox.h"
 #include "Shading/Material.h"
 #include "Rendering/GLStateCache.h"
 #include "Rendering/RendererSettingsPanel.h"
 #include "Models/DefaultPrimitives.h"
 #include "Rendering/RenderTarget.h"
+#include "Rendering/ShadowCascadeMap.h"
 #include "Lighting/DirectionalLight.h"
 #include "Lighting/PointLight.h"
 #include "Shading/TextureCube.h"
@@ -50,6 +52,7 @@ glm::vec3 lightDirection = glm::vec3(0.2f, -1.0f, 0.25f);
 float lightDirectionIntensity = 50.0f;
 glm::vec3 pointLightPosition = glm::vec3(1.2f, 0.0f, 0.0f);
 float lodLevel = 2.5f;
+const char* g_DemoScenePath = "Resources/Demo.scene";
 
 //Input Callbacks
 void RenderEditor(Crescent::SceneHierarchyPanel* sceneHierarchyPanel, Crescent::RendererSettingsPanel* rendererPanel);
@@ -97,19 +100,54 @@ int main(int argc, int argv[])
 	Crescent::Cube* cube = new Crescent::Cube();
 	//Crescent::Sphere* sphere = new Crescent::Sphere(16, 16);
 
-	Crescent::SceneEntity* sceneCube = demoScene->ConstructNewEntity(cube, defaultMaterial);
+	//Crescent::SceneEntity* sceneCube = demoScene->ConstructNewEntity(cube, defaultMaterial);
 	//Crescent::SceneEntity* sceneCube2 = demoScene->ConstructNewEntity(cube, defaultMaterial);
 	//Crescent::SceneEntity* sceneSphere = demoScene->ConstructNewEntity(sphere, defaultMaterial);
 
-	Crescent::SceneEntity* sponza = Crescent::Resources::LoadMesh(g_CoreSystems.m_Renderer, demoScene, "Sponza", "Resources/Models/Sponza/sponza.obj");
-	Crescent::SceneEntity* backpack = Crescent::Resources::LoadMesh(g_CoreSystems.m_Renderer, demoScene, "Backpack", "Resources/Models/Stormtrooper/source/silly_dancing.fbx");
-	Crescent::SceneEntity* pokeball = Crescent::Resources::LoadMesh(g_CoreSystems.m_Renderer, demoScene, "Pokeball", "Resources/Models/Eyeball/Wyvern.fbx");
+	/// To Do: Convert directional light into a screen entity so it may be used in the scene hierarchy.
+	Crescent::DirectionalLight directionalLight;
+	directionalLight.m_LightColor = glm::vec3(1.0f, 0.89f, 0.7f);
+
+	Crescent::PointLight pointLight;
+	pointLight.m_LightRadius = 2.5f;
+	pointLight.m_LightColor = glm::vec3(1.0f, 0.3f, 0.05f);
+	pointLight.m_LightIntensity = 50.0f;
+	pointLight.m_RenderMesh = true;
+
+	//The scene saved by a previous launch is loaded if there is one. Otherwise, we build it here and save it for next time.
+	std::vector<Crescent::DirectionalLight> loadedDirectionalLights;
+	std::vector<Crescent::PointLight> loadedPointLights;
+	if (Crescent::SceneSerializer::LoadScene(g_DemoScenePath, g_CoreSystems.m_Renderer, demoScene, loadedDirectionalLights, loadedPointLights))
+	{
+		if (!loadedDirectionalLights.empty())
+		{
+			directionalLight = loadedDirectionalLights[0];
+			lightDirection = directionalLight.m_LightDirection;
+			lightDirectionIntensity = directionalLight.m_LightIntensity;
+		}
+		if (!loadedPointLights.empty())
+		{
+			pointLight = loadedPointLights[0];
+			pointLightPosition = pointLight.m_LightPosition;
+		}
+	}
+	else
+	{
+		Crescent::SceneEntity* sponza = Crescent::Resources::LoadMesh(g_CoreSystems.m_Renderer, demoScene, "Sponza", "Resources/Models/Sponza/sponza.obj");
+		Crescent::SceneEntity* backpack = Crescent::Resources::LoadMesh(g_CoreSystems.m_Renderer, demoScene, "Backpack", "Resources/Models/Stormtrooper/source/silly_dancing.fbx");
+		Crescent::SceneEntity* pokeball = Crescent::Resources::LoadMesh(g_CoreSystems.m_Renderer, demoScene, "Pokeball", "Resources/Models/Eyeball/Wyvern.fbx");
 
-	sponza->SetEntityPosition(glm::vec3(0.00f, -1.00f, 0.00f));
-	sponza->SetEntityScale(0.01f);
-	backpack->SetEntityPosition(glm::vec3(4.10f, 0.0f, -0.10f));
-	backpack->SetEntityRotation(glm::vec3(0.0f, glm::radians(-90.0f), 0.0f));
-	pokeball->SetEntityRotation(glm::vec3(glm::radians(-90.0f), 0.0f, 0.0f));
+		sponza->SetEntityPosition(glm::vec3(0.00f, -1.00f, 0.00f));
+		sponza->SetEntityScale(0.01f);
+		backpack->SetEntityPosition(glm::vec3(4.10f, 0.0f, -0.10f));
+		backpack->SetEntityRotation(glm::vec3(0.0f, glm::radians(-90.0f), 0.0f));
+		pokeball->SetEntityRotation(glm::vec3(glm::radians(-90.0f), 0.0f, 0.0f));
+
+		directionalLight.m_LightDirection = lightDirection;
+		directionalLight.m_LightIntensity = lightDirectionIntensity;
+		pointLight.m_LightPosition = pointLightPosition;
+		Crescent::SceneSerializer::SaveScene(g_DemoScenePath, demoScene, { &directionalLight }, { &pointLight });
+	}
 
 	//Background
 	Crescent::Skybox* sceneSkybox = new Crescent::Skybox();
@@ -120,16 +158,6 @@ int main(int argc, int argv[])
 	//sceneCube2->SetEntityScale(glm::vec3(4.50f, 0.30f, 5.60f));
 	//sceneSphere->SetEntityPosition(glm::vec3(0.0f, 2.4f, 0.0f));
 
-	/// To Do: Convert directional light into a screen entity so it may be used in the scene hierarchy.
-	Crescent::DirectionalLight directionalLight;
-	directionalLight.m_LightColor = glm::vec3(1.0f, 0.89f, 0.7f);
-
-	Crescent::PointLight pointLight;
-	pointLight.m_LightRadius = 2.5f;
-	pointLight.m_LightColor = glm::vec3(1.0f, 0.3f, 0.05f);
-	pointLight.m_LightIntensity = 50.0f;
-	pointLight.m_RenderMesh = true;
-
 	g_CoreSystems.m_Renderer->AddLightSource(&pointLight);
 	g_CoreSystems.m_Renderer->AddLightSource(&directionalLight);
 	//===========================================
@@ -172,9 +200,7 @@ int main(int argc, int argv[])
 		//g_CoreSystems.m_Renderer->PushToRenderQueue(sceneCube2);
 		//g_CoreSystems.m_Renderer->PushToRenderQueue(sceneSphere);
 		g_CoreSystems.m_Renderer->PushToRenderQueue(sceneSkybox);
-		g_CoreSystems.m_Renderer->PushToRenderQueue(sponza);
-		g_CoreSystems.m_Renderer->PushToRenderQueue(backpack);
-		g_CoreSystems.m_Renderer->PushToRenderQueue(pokeball);
+		g_CoreSystems.m_Renderer->PushToRenderQueue(demoScene); //Sponza, backpack and pokeball.
 
 		g_CoreSystems.m_Renderer->RenderAllQueueItems();
 
@@ -217,9 +243,19 @@ void RenderEditor(Crescent::SceneHierarchyPanel* sceneHierarchyPanel, Crescent::
 		}
 	}
 
-	ImGui::Text("Shadow Map #1");
-	unsigned int shadowDepthAttachment = g_CoreSystems.m_Renderer->RetrieveShadowRenderTarget(0)->RetrieveDepthAndStencilAttachment()->RetrieveTextureID();
-	ImGui::Image((void*)shadowDepthAttachment, { 350.0f, 350.0f }, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
+	if (Crescent::ShadowCascadeMap* shadowCascadeMap = g_CoreSystems.m_Renderer->RetrieveShadowCascadeMap(0))
+	{
+		ImGui::Text("Shadow Map #1 Cascades");
+		for (unsigned int i = 0; i < shadowCascadeMap->RetrieveCascadeCount(); i++)
+		{
+			unsigned int cascadeView = shadowCascadeMap->RetrieveCascadeViewID(i);
+			ImGui::Image((void*)cascadeView, { 175.0f, 175.0f }, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
+			if (i % 2 == 0)
+			{
+				ImGui::SameLine();
+			}
+		}
+	}
 
 	ImGui::Text("Custom Render Target Color Buffer");
 	ImGui::Image((void*)g_CoreSystems.m_Renderer->RetrieveCustomRenderTarget()->RetrieveColorAttachment(0)->RetrieveTextureID(), { 350.0f, 350.0f }, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
@@ -235,6 +271,13 @@ void RenderEditor(Crescent::SceneHierarchyPanel* sceneHierarchyPanel, Crescent::
 	unsigned int colorAttachment = g_CoreSystems.m_Renderer->RetrieveMainRenderTarget()->RetrieveColorAttachment(0)->RetrieveTextureID();
 	ImGui::Image((void*)colorAttachment, { (float)g_CoreSystems.m_Editor.RetrieveViewportWidth(), (float)g_CoreSystems.m_Editor.RetrieveViewportHeight() }, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
 
+	//Left clicking the viewport selects the entity under the cursor.
+	if (ImGui::IsItemClicked(ImGuiMouseButton_Left))
+	{
+		ImVec2 cursorPosition = ImVec2(ImGui::GetMousePos().x - ImGui::GetItemRectMin().x, ImGui::GetMousePos().y - ImGui::GetItemRectMin().y);
+		sceneHierarchyPanel->PickEntity(g_CoreSystems.m_Camera, glm::vec2(cursorPosition.x, cursorPosition.y), glm::vec2(ImGui::GetItemRectSize().x, ImGui::GetItemRectSize().y));
+	}
+
 	ImGui::End();
 	ImGui::PopStyleVar(); //Pops the pushed style so other windows beyond this won't have the style's properties.
 
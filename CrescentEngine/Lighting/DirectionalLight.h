@@ -1,13 +1,14 @@
 #pragma once
 #include <glm/glm.hpp>
+#include "../Rendering/ShadowCascadeFitter.h"
 
 namespace Crescent
 {
-	class RenderTarget;
+	class ShadowCascadeMap;
 
 	/*
-		Light container object for any 3D directional light source. Directional light types support shadow casting, holding a reference to the RenderTarget and the
-		relevant Light Space View Projection Matrix used for its shadow map generation.
+		Light container object for any 3D directional light source. Directional light types support shadow casting, holding a reference to the cascaded shadow map
+		and the Light Space View Projection Matrix of each cascade used for its generation.
 	*/
 
 	class DirectionalLight
@@ -18,7 +19,10 @@ namespace Crescent
 		float m_LightIntensity = 1.0f;
 
 		bool m_ShadowCastingEnabled = true;
-		RenderTarget* m_ShadowMapRenderTarget = nullptr;
-		glm::mat4 m_LightSpaceViewProjectionMatrix = glm::mat4(1.0f);
+		ShadowCascadeMap* m_ShadowCascadeMap = nullptr;
+		glm::mat4 m_CascadeViewProjectionMatrices[ShadowCascadeCount] = {};
+		float m_CascadeSplitDepths[ShadowCascadeCount] = {}; //Far view depth of each cascade.
+		ShadowCascadeVolume m_CascadeVolumes[ShadowCascadeCount]; //Kept by the renderer between frames, so cascades only move once the camera leaves their padding.
+		glm::mat4 m_LightSpaceViewProjectionMatrix = glm::mat4(1.0f); //Nearest cascade, for shaders which only sample a single shadow map.
 	};
 }
\ No newline at end of file
@@ -16,7 +16,7 @@ namespace Crescent
 
 		float m_LightIntensity = 1.0f;
 		float m_LightRadius = 1.0f;
-		bool m_IsLightVisible = true;
+		bool m_IsLightVisible = true; //Whether the light's volume intersected the camera frustum this frame. Written by the renderer.
 		bool m_RenderMesh = false;
 	};
 }
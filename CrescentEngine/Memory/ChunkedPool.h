@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Crescent
+{
+	//Packs a slot index (low 20 bits) with the generation of the object living in it (high 12 bits).
+	typedef uint32_t PoolHandle;
+	const PoolHandle InvalidPoolHandle = 0xFFFFFFFF;
+	const uint32_t InvalidPoolIndex = 0xFFFFFFFF;
+
+	/*
+		Fixed size slots handed out from chunks that are never freed or moved, so object addresses stay stable and churning objects only ever recycles
+		memory the pool already owns. Free slots are chained through an index list, making creation and destruction O(1).
+
+		Each slot counts how often it has been reused. Handles carry the count of the object they were created for, so a handle outliving its object
+		resolves to nullptr instead of whatever took the slot over. Counts wrap after 4096 reuses of a slot, which is the limit of stale handle detection.
+	*/
+
+	template<typename T, uint32_t ChunkSize = 256>
+	class ChunkedPool
+	{
+	public:
+		static const uint32_t m_IndexBits = 20;
+		static const uint32_t m_IndexMask = (1u << m_IndexBits) - 1;
+		static const uint32_t m_GenerationMask = 0xFFFu;
+
+		ChunkedPool() = default;
+		~ChunkedPool()
+		{
+			for (uint32_t i = 0; i < m_SlotHandles.size(); i++)
+			{
+				if (m_SlotHandles[i] != InvalidPoolHandle)
+				{
+					RetrieveSlot(i)->~T();
+				}
+			}
+			for (size_t i = 0; i < m_Chunks.size(); i++)
+			{
+				delete[] m_Chunks[i];
+			}
+		}
+
+		ChunkedPool(const ChunkedPool&) = delete;
+		ChunkedPool& operator=(const ChunkedPool&) = delete;
+
+		//Constructs an object as T(arguments..., handle), so it knows its own handle from the start.
+		template<typename... Arguments>
+		T* Create(Arguments&&... arguments)
+		{
+			if (m_FreeList == InvalidPoolIndex)
+			{
+				AllocateChunk();
+			}
+
+			uint32_t slotIndex = m_FreeList;
+			m_FreeList = m_NextFreeSlots[slotIndex];
+			PoolHandle handle = ((uint32_t)m_SlotGenerations[slotIndex] << m_IndexBits) | slotIndex;
+			m_SlotHandles[slotIndex] = handle;
+			m_LiveCount++;
+			return new (RetrieveSlot(slotIndex)) T(std::forward<Arguments>(arguments)..., handle);
+		}
+
+		void Destroy(PoolHandle handle)
+		{
+			T* object = Resolve(handle);
+			if (!object)
+			{
+				return;
+			}
+
+			uint32_t slotIndex = handle & m_IndexMask;
+			object->~T();
+			m_SlotHandles[slotIndex] = InvalidPoolHandle;
+			m_SlotGenerations[slotIndex] = (m_SlotGenerations[slotIndex] + 1) & m_GenerationMask;
+			m_NextFreeSlots[slotIndex] = m_FreeList;
+			m_FreeList = slotIndex;
+			m_LiveCount--;
+		}
+
+		//Returns nullptr for invalid or stale handles.
+		T* Resolve(PoolHandle handle) const
+		{
+			uint32_t slotIndex = handle & m_IndexMask;
+			if (handle == InvalidPoolHandle || slotIndex >= m_SlotHandles.size() || m_SlotHandles[slotIndex] != handle)
+			{
+				return nullptr;
+			}
+			return RetrieveSlot(slotIndex);
+		}
+
+		//For links stored as bare indices, which are only valid while the object they point at is alive.
+		T* RetrieveByIndex(uint32_t slotIndex) const { return slotIndex == InvalidPoolIndex ? nullptr : RetrieveSlot(slotIndex); }
+		static uint32_t RetrieveIndex(PoolHandle handle) { return handle == InvalidPoolHandle ? InvalidPoolIndex : handle & m_IndexMask; }
+
+		size_t RetrieveLiveCount() const { return m_LiveCount; }
+		size_t RetrieveCapacity() const { return m_SlotHandles.size(); }
+		size_t RetrieveChunkCount() const { return m_Chunks.size(); }
+
+	private:
+		typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+		T* RetrieveSlot(uint32_t slotIndex) const
+		{
+			return reinterpret_cast<T*>(&m_Chunks[slotIndex / ChunkSize][slotIndex % ChunkSize]);
+		}
+
+		void AllocateChunk()
+		{
+			//Slots beyond what the index bits can address would alias earlier ones. The very last index is left out, as it spells InvalidPoolHandle.
+			uint32_t firstSlot = (uint32_t)m_SlotHandles.size();
+			if (firstSlot + ChunkSize > m_IndexMask)
+			{
+				throw std::bad_alloc();
+			}
+
+			m_Chunks.push_back(new Slot[ChunkSize]);
+			m_SlotHandles.resize(firstSlot + ChunkSize, InvalidPoolHandle);
+			m_SlotGenerations.resize(firstSlot + ChunkSize, 0);
+			m_NextFreeSlots.resize(firstSlot + ChunkSize);
+
+			//Chained in ascending order, so consecutive creations fill the chunk front to back.
+			for (uint32_t i = 0; i < ChunkSize; i++)
+			{
+				m_NextFreeSlots[firstSlot + i] = i + 1 < ChunkSize ? firstSlot + i + 1 : m_FreeList;
+			}
+			m_FreeList = firstSlot;
+		}
+
+	private:
+		std::vector<Slot*> m_Chunks;
+		std::vector<PoolHandle> m_SlotHandles; //Handle of the object living in each slot, InvalidPoolHandle if free.
+		std::vector<uint16_t> m_SlotGenerations;
+		std::vector<uint32_t> m_NextFreeSlots;
+		uint32_t m_FreeList = InvalidPoolIndex;
+		size_t m_LiveCount = 0;
+	};
+}
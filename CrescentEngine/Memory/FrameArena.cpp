@@ -0,0 +1,76 @@
+#include "CrescentPCH.h"
+#include "FrameArena.h"
+#include <algorithm>
+
+namespace Crescent
+{
+	FrameArena::FrameArena(size_t initialCapacity)
+	{
+		m_Blocks.reserve(8);
+		AllocateBlock(initialCapacity);
+	}
+
+	FrameArena::~FrameArena()
+	{
+		ReleaseBlocks();
+	}
+
+	void* FrameArena::Allocate(size_t byteSize, size_t alignment)
+	{
+		ArenaBlock* block = &m_Blocks.back();
+		size_t alignedOffset = (block->m_Offset + alignment - 1) & ~(alignment - 1);
+
+		if (alignedOffset + byteSize > block->m_Capacity)
+		{
+			//Chain on a new block that at least doubles our total capacity. The blocks are merged again on the next reset.
+			AllocateBlock(std::max(RetrieveCapacity(), byteSize + alignment));
+			block = &m_Blocks.back();
+			alignedOffset = (block->m_Offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		block->m_Offset = alignedOffset + byteSize;
+		return block->m_Memory + alignedOffset;
+	}
+
+	void FrameArena::Reset()
+	{
+		if (m_Blocks.size() > 1)
+		{
+			size_t totalCapacity = RetrieveCapacity();
+			ReleaseBlocks();
+			AllocateBlock(totalCapacity);
+		}
+		else
+		{
+			m_Blocks.back().m_Offset = 0;
+		}
+	}
+
+	size_t FrameArena::RetrieveCapacity() const
+	{
+		size_t totalCapacity = 0;
+		for (unsigned int i = 0; i < m_Blocks.size(); i++)
+		{
+			totalCapacity += m_Blocks[i].m_Capacity;
+		}
+		return totalCapacity;
+	}
+
+	void FrameArena::AllocateBlock(size_t byteSize)
+	{
+		ArenaBlock block;
+		block.m_Memory = static_cast<unsigned char*>(::operator new(byteSize));
+		block.m_Capacity = byteSize;
+		m_Blocks.push_back(block);
+		m_HeapAllocationCount++;
+	}
+
+	void FrameArena::ReleaseBlocks()
+	{
+		for (unsigned int i = 0; i < m_Blocks.size(); i++)
+		{
+			::operator delete(m_Blocks[i].m_Memory);
+		}
+		m_Blocks.clear();
+	}
+}
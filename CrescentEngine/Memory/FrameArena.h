@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Crescent
+{
+	/*
+		A linear allocator for data that only lives for a single frame. Allocations simply bump an offset and everything is released at once with Reset().
+		Should a frame outgrow the current block, an additional block is chained on. On the next Reset(), all blocks are coalesced into one block large
+		enough for the whole frame, so frames of a similar size never touch the heap again.
+	*/
+
+	class FrameArena
+	{
+	public:
+		FrameArena(size_t initialCapacity = 64 * 1024);
+		~FrameArena();
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void* Allocate(size_t byteSize, size_t alignment = alignof(std::max_align_t));
+
+		//Only trivially destructible types are allowed as the arena never runs destructors.
+		template<typename T>
+		T* Allocate()
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Frame arena objects must be trivially destructible.");
+			return new (Allocate(sizeof(T), alignof(T))) T();
+		}
+
+		void Reset();
+
+		//Number of heap allocations made since creation. Stays constant once the arena has settled to the frame's working size.
+		size_t RetrieveHeapAllocationCount() const { return m_HeapAllocationCount; }
+		size_t RetrieveCapacity() const;
+
+	private:
+		void AllocateBlock(size_t byteSize);
+		void ReleaseBlocks();
+
+	private:
+		struct ArenaBlock
+		{
+			unsigned char* m_Memory = nullptr;
+			size_t m_Capacity = 0;
+			size_t m_Offset = 0;
+		};
+
+		std::vector<ArenaBlock> m_Blocks;
+		size_t m_HeapAllocationCount = 0;
+	};
+}
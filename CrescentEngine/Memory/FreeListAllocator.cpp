@@ -0,0 +1,93 @@
+#include "CrescentPCH.h"
+#include "FreeListAllocator.h"
+#include <iterator>
+
+namespace Crescent
+{
+	FreeListAllocator::FreeListAllocator(size_t capacity)
+	{
+		Grow(capacity);
+	}
+
+	size_t FreeListAllocator::Allocate(size_t size)
+	{
+		if (size == 0 || size > m_FreeSize)
+		{
+			return InvalidAllocationOffset;
+		}
+
+		//Ties between equally sized ranges go to the lowest offset, keeping allocations packed towards the start.
+		auto bestRange = m_RangesBySize.lower_bound(std::make_pair(size, (size_t)0));
+		if (bestRange == m_RangesBySize.end())
+		{
+			return InvalidAllocationOffset;
+		}
+
+		//Allocations are taken from the front of the range, with the remainder staying free behind them.
+		size_t offset = bestRange->second;
+		size_t remainingSize = bestRange->first - size;
+		EraseRange(m_FreeRanges.find(offset));
+		if (remainingSize > 0)
+		{
+			InsertRange(offset + size, remainingSize);
+		}
+		m_FreeSize -= size;
+		return offset;
+	}
+
+	void FreeListAllocator::Free(size_t offset, size_t size)
+	{
+		if (offset == InvalidAllocationOffset || size == 0)
+		{
+			return;
+		}
+
+		m_FreeSize += size;
+
+		//Merge with the free range directly following us, then with the one directly preceding us.
+		auto nextRange = m_FreeRanges.lower_bound(offset);
+		if (nextRange != m_FreeRanges.end() && nextRange->first == offset + size)
+		{
+			size += nextRange->second;
+			auto mergedRange = nextRange++;
+			EraseRange(mergedRange);
+		}
+
+		if (nextRange != m_FreeRanges.begin())
+		{
+			auto previousRange = std::prev(nextRange);
+			if (previousRange->first + previousRange->second == offset)
+			{
+				offset = previousRange->first;
+				size += previousRange->second;
+				EraseRange(previousRange);
+			}
+		}
+
+		InsertRange(offset, size);
+	}
+
+	void FreeListAllocator::Grow(size_t newCapacity)
+	{
+		if (newCapacity <= m_Capacity)
+		{
+			return;
+		}
+
+		size_t previousCapacity = m_Capacity;
+		m_Capacity = newCapacity;
+		Free(previousCapacity, newCapacity - previousCapacity);
+	}
+
+	void FreeListAllocator::InsertRange(size_t offset, size_t size)
+	{
+		m_FreeRanges.emplace(offset, size);
+		m_RangesBySize.emplace(size, offset);
+	}
+
+	void FreeListAllocator::EraseRange(std::map<size_t, size_t>::iterator freeRange)
+	{
+		m_RangesBySize.erase(std::make_pair(freeRange->second, freeRange->first));
+		m_FreeRanges.erase(freeRange);
+	}
+}
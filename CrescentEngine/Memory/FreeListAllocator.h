@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace Crescent
+{
+	const size_t InvalidAllocationOffset = (size_t)-1;
+
+	/*
+		Hands out ranges of an abstract address space, such as elements of a GPU buffer, without ever touching the memory itself. Free ranges are kept
+		ordered by offset, so a freed range merges with free neighbours on either side and the space never fragments into adjacent scraps.
+
+		Allocation picks the smallest free range that fits (best fit), which leaves large ranges whole for large meshes. Free ranges are indexed by size as
+		well, so that finding it is a single lookup. Callers keep the size of their allocations and hand it back when freeing.
+	*/
+
+	class FreeListAllocator
+	{
+	public:
+		FreeListAllocator(size_t capacity = 0);
+
+		//Returns the offset of the allocated range, or InvalidAllocationOffset if no free range is large enough.
+		size_t Allocate(size_t size);
+		void Free(size_t offset, size_t size);
+		//Extends the address space, adding the new space to the free range at its end.
+		void Grow(size_t newCapacity);
+
+		size_t RetrieveCapacity() const { return m_Capacity; }
+		size_t RetrieveFreeSize() const { return m_FreeSize; }
+		size_t RetrieveLargestFreeRange() const { return m_RangesBySize.empty() ? 0 : m_RangesBySize.rbegin()->first; }
+		size_t RetrieveFreeRangeCount() const { return m_FreeRanges.size(); }
+
+	private:
+		void InsertRange(size_t offset, size_t size);
+		void EraseRange(std::map<size_t, size_t>::iterator freeRange);
+
+	private:
+		std::map<size_t, size_t> m_FreeRanges; //Offset to size.
+		std::set<std::pair<size_t, size_t>> m_RangesBySize; //The same ranges as size and offset pairs, ordered by size, then offset.
+		size_t m_Capacity = 0;
+		size_t m_FreeSize = 0;
+	};
+}
@@ -0,0 +1,111 @@
+#include "CrescentPCH.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Crescent
+{
+	MappedFile::~MappedFile()
+	{
+		CloseFile();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::OpenFile(const std::string& filePath)
+	{
+		CloseFile();
+
+		HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* mappedView = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!mappedView)
+		{
+			if (mappingHandle)
+			{
+				CloseHandle(mappingHandle);
+			}
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		m_FileHandle = fileHandle;
+		m_MappingHandle = mappingHandle;
+		m_Data = (const uint8_t*)mappedView;
+		m_Size = (size_t)fileSize.QuadPart;
+		return true;
+	}
+
+	void MappedFile::CloseFile()
+	{
+		if (m_Data)
+		{
+			UnmapViewOfFile(m_Data);
+			CloseHandle((HANDLE)m_MappingHandle);
+			CloseHandle((HANDLE)m_FileHandle);
+		}
+		m_Data = nullptr;
+		m_Size = 0;
+		m_FileHandle = nullptr;
+		m_MappingHandle = nullptr;
+	}
+#else
+	bool MappedFile::OpenFile(const std::string& filePath)
+	{
+		CloseFile();
+
+		int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+		if (fileDescriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStatus;
+		if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+		{
+			close(fileDescriptor);
+			return false;
+		}
+
+		//The descriptor isn't needed once mapped, the mapping keeps the file alive by itself.
+		void* mappedView = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		close(fileDescriptor);
+		if (mappedView == MAP_FAILED)
+		{
+			return false;
+		}
+
+		m_Data = (const uint8_t*)mappedView;
+		m_Size = (size_t)fileStatus.st_size;
+		return true;
+	}
+
+	void MappedFile::CloseFile()
+	{
+		if (m_Data)
+		{
+			munmap((void*)m_Data, m_Size);
+		}
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Crescent
+{
+	/*
+		A read only view of a whole file mapped into memory. Pages are brought in by the OS as they are touched, so nothing is copied or parsed up front.
+		The view stays valid until the file is closed.
+	*/
+
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		//Returns false if the file couldn't be opened or mapped. Empty files are not mapped.
+		bool OpenFile(const std::string& filePath);
+		void CloseFile();
+
+		const uint8_t* RetrieveData() const { return m_Data; }
+		size_t RetrieveSize() const { return m_Size; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+
+		//Platform handles, kept opaque so the header doesn't pull in any system headers.
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+	};
+}
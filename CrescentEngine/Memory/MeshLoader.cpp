@@ -2,11 +2,16 @@
 #include "MeshLoader.h"
 #include "../Scene/SceneEntity.h"
 #include "../Models/Mesh.h"
+#include "../Models/MeshOptimizer.h"
+#include "../Models/MeshBuilder.h"
+#include "../Models/MeshletBuilder.h"
+#include "../Models/MeshSimplifier.h"
 #include "../Rendering/Resources.h"
 #include "../Shading/Material.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <cstring>
 #include "../Rendering/Renderer.h"
 
 namespace Crescent
@@ -21,6 +26,11 @@ namespace Crescent
         }
     }
     // --------------------------------------------------------------------------------------------
+    void MeshLoader::StoreMesh(Mesh* mesh)
+    {
+        MeshLoader::m_MeshStore.push_back(mesh);
+    }
+    // --------------------------------------------------------------------------------------------
     SceneEntity* MeshLoader::LoadMesh(Renderer* rendererContext, const std::string& filePath, bool setDefaultMaterial)
     {
         CrescentLoad("Loading mesh: " + filePath + ".");
@@ -44,7 +54,7 @@ namespace Crescent
     {
         //Note that we allocate memory ourselves and pass memory responsibility to calling resource manager. 
         //The resource manager is responsible for holding the scene entity pointer and deleting where appropriate.
-        SceneEntity* node = new SceneEntity(aiNode->mName.C_Str(), 0);
+        SceneEntity* node = SceneEntity::CreateEntity(aiNode->mName.C_Str());
 
         for (unsigned int i = 0; i < aiNode->mNumMeshes; ++i)
         {
@@ -70,7 +80,7 @@ namespace Crescent
             //Otherwise, the meshes are considered on equal depth of its children
             else
             {
-                SceneEntity* child = new SceneEntity(aiScene->mMeshes[i]->mName.C_Str(), 0);
+                SceneEntity* child = SceneEntity::CreateEntity(aiScene->mMeshes[i]->mName.C_Str());
                 child->m_Mesh = mesh;
                 child->m_Material = material;
                 node->AddChildEntity(child);
@@ -88,39 +98,35 @@ namespace Crescent
     
     Mesh* MeshLoader::ParseMesh(aiMesh* aiMesh, const aiScene* aiScene)
     {
-        std::vector<glm::vec3> positions;
-        std::vector<glm::vec2> uv;
-        std::vector<glm::vec3> normals;
-        std::vector<glm::vec3> tangents;
-        std::vector<glm::vec3> bitangents;
-        std::vector<unsigned int> indices;
-
-        positions.resize(aiMesh->mNumVertices);
-        normals.resize(aiMesh->mNumVertices);
-        if (aiMesh->mNumUVComponents > 0)
+        //Arrays are sized once and filled in place, then handed over to the mesh without being copied again.
+        //We assume a constant of 3 vertex indices per face as we always triangulate in Assimp's post-processing step. Otherwise, you'll want transform this to a more flexible scheme.
+        //Only attributes the file actually provides are allocated, so meshes without them aren't packed or stored with zeroed arrays.
+        bool hasTextureCoordinates = aiMesh->HasTextureCoords(0);
+        bool hasTangents = aiMesh->HasTangentsAndBitangents();
+        MeshBuilder meshBuilder(aiMesh->mNumVertices, aiMesh->mNumFaces * 3, hasTextureCoordinates, aiMesh->HasNormals(), hasTangents);
+
+        //Assimp's vectors are laid out as ours are, so whole attribute arrays are copied at once.
+        static_assert(sizeof(aiVector3D) == sizeof(glm::vec3), "Assimp must be built with single precision vectors.");
+        std::memcpy(meshBuilder.RetrievePositions(), aiMesh->mVertices, aiMesh->mNumVertices * sizeof(glm::vec3));
+        if (aiMesh->HasNormals())
         {
-            uv.resize(aiMesh->mNumVertices);
-            tangents.resize(aiMesh->mNumVertices);
-            bitangents.resize(aiMesh->mNumVertices);
+            std::memcpy(meshBuilder.RetrieveNormals(), aiMesh->mNormals, aiMesh->mNumVertices * sizeof(glm::vec3));
         }
-        //We assume a constant of 3 vertex indices per face as we always triangulate in Assimp's post-processing step. Otherwise, you'll want transform this to a more flexible scheme.
-        indices.resize(aiMesh->mNumFaces * 3);
-
-        for (unsigned int i = 0; i < aiMesh->mNumVertices; ++i)
+        if (hasTextureCoordinates)
         {
-            positions[i] = glm::vec3(aiMesh->mVertices[i].x, aiMesh->mVertices[i].y, aiMesh->mVertices[i].z);
-            normals[i] = glm::vec3(aiMesh->mNormals[i].x, aiMesh->mNormals[i].y, aiMesh->mNormals[i].z);
-            if (aiMesh->mTextureCoords[0])
+            glm::vec2* uv = meshBuilder.RetrieveUV();
+            for (unsigned int i = 0; i < aiMesh->mNumVertices; ++i)
             {
                 uv[i] = glm::vec2(aiMesh->mTextureCoords[0][i].x, aiMesh->mTextureCoords[0][i].y);
-
-            }
-            if (aiMesh->mTangents)
-            {
-                tangents[i] = glm::vec3(aiMesh->mTangents[i].x, aiMesh->mTangents[i].y, aiMesh->mTangents[i].z);
-                bitangents[i] = glm::vec3(aiMesh->mBitangents[i].x, aiMesh->mBitangents[i].y, aiMesh->mBitangents[i].z);
             }
         }
+        if (hasTangents)
+        {
+            std::memcpy(meshBuilder.RetrieveTangents(), aiMesh->mTangents, aiMesh->mNumVertices * sizeof(glm::vec3));
+            std::memcpy(meshBuilder.RetrieveBitangents(), aiMesh->mBitangents, aiMesh->mNumVertices * sizeof(glm::vec3));
+        }
+
+        unsigned int* indices = meshBuilder.RetrieveIndices();
         for (unsigned int f = 0; f < aiMesh->mNumFaces; ++f)
         {
             //We know we're always working with triangles due to the Triangulate option.
@@ -130,15 +136,22 @@ namespace Crescent
             }
         }
 
-        Mesh* mesh = new Mesh;
-        mesh->m_Positions = positions;
-        mesh->m_UV = uv;
-        mesh->m_Normals = normals;
-        mesh->m_Tangents = tangents;
-        mesh->m_Bitangents = bitangents;
-        mesh->m_Indices = indices;
-        mesh->m_Topology = Triangles;
-        mesh->FinalizeMesh(true);
+        Mesh* mesh = meshBuilder.BuildMesh();
+
+        //Assimp hands us one vertex per face corner in file order, so duplicates are welded and triangles reordered for the vertex cache before upload.
+        MeshOptimizationReport optimizationReport = MeshOptimizer::OptimizeMesh(mesh);
+        CrescentInfo("Optimized mesh " << aiMesh->mName.C_Str() << ": " << optimizationReport.m_VertexCountBefore << " -> " << optimizationReport.m_VertexCountAfter << " vertices, ACMR "
+            << optimizationReport.m_CacheStatisticsBefore.m_ACMR << " -> " << optimizationReport.m_CacheStatisticsAfter.m_ACMR << ", ATVR "
+            << optimizationReport.m_CacheStatisticsBefore.m_ATVR << " -> " << optimizationReport.m_CacheStatisticsAfter.m_ATVR << ".");
+
+        //Levels of detail index into the same vertices, so they are built once those are final.
+        MeshSimplifier::GenerateLODs(mesh);
+        //Skinned vertices move away from whatever bounds we could compute here, so those meshes are always drawn whole.
+        if (!aiMesh->HasBones())
+        {
+            MeshletBuilder::BuildMeshlets(mesh);
+        }
+        mesh->FinalizeMesh(true, VertexFormat_Quantized);
 
         if (aiScene->HasAnimations())
         {
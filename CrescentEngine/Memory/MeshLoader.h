@@ -24,6 +24,8 @@ namespace Crescent
 	public:
 		static SceneEntity* LoadMesh(Renderer* rendererContext, const std::string& filePath, bool setDefaultMaterial = true);
 		static void ClearMeshStore();
+		//Hands a mesh built outside of the importer to the store, so that it is deleted along with the meshes we import.
+		static void StoreMesh(Mesh* mesh);
 
 	private:
 		static SceneEntity* ProcessNode(Renderer* rendererContext, aiNode* aiNode, const aiScene* aiScene, const std::string& fileDirectory, bool setDefaultMaterial = true);
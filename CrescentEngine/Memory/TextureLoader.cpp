@@ -61,6 +61,7 @@ namespace Crescent
 
 		texture.m_TextureWidth = textureWidth;
 		texture.m_TextureHeight = textureHeight;
+		texture.m_TexturePath = filePath;
 
 		return texture;
 	}
@@ -3,6 +3,10 @@
 #include "GL/glew.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <algorithm>
+#include <cstring>
+#include "../Rendering/GLStateCache.h"
+#include "../Rendering/InstanceBatcher.h"
+#include "VertexPacker.h"
 
 namespace Crescent
 {
@@ -13,38 +17,48 @@ namespace Crescent
 
 	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<unsigned int> indices)
 	{
-		m_Positions = positions;
-		m_Indices = indices;
+		m_Positions = std::move(positions);
+		m_Indices = std::move(indices);
 	}
 
 	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uv, std::vector<unsigned int> indices)
 	{
-		m_Positions = positions;
-		m_UV = uv;
-		m_Indices = indices;
+		m_Positions = std::move(positions);
+		m_UV = std::move(uv);
+		m_Indices = std::move(indices);
 	}
 
 	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uv, std::vector<glm::vec3> normals, std::vector<unsigned int> indices)
 	{
-		m_Positions = positions;
-		m_UV = uv;
-		m_Normals = normals;
-		m_Indices = indices;
+		m_Positions = std::move(positions);
+		m_UV = std::move(uv);
+		m_Normals = std::move(normals);
+		m_Indices = std::move(indices);
 	}
 
 	Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uv, std::vector<glm::vec3> normals, std::vector<glm::vec3> tangents, std::vector<glm::vec3> bitangents, std::vector<unsigned int> indices)
 	{
-		m_Positions = positions;
-		m_UV = uv;
-		m_Normals = normals;
-		m_Tangents = tangents;
-		m_Bitangents = bitangents;
-		m_Indices = indices;
+		m_Positions = std::move(positions);
+		m_UV = std::move(uv);
+		m_Normals = std::move(normals);
+		m_Tangents = std::move(tangents);
+		m_Bitangents = std::move(bitangents);
+		m_Indices = std::move(indices);
 	}
 
-	void Mesh::FinalizeMesh(bool interleaved)
+	void Mesh::FinalizeMesh(bool interleaved, VertexFormat vertexFormat)
 	{
-		//Initialize IDs if not configured before.
+		CalculateBounds();
+		ConfigureVertexFormat(vertexFormat);
+		if (vertexFormat != VertexFormat_Float)
+		{
+			FinalizePackedVertexArray();
+			FinalizeDepthVertexArray(true);
+			return;
+		}
+
+		//Float meshes always own their buffers. Initialize IDs if not configured before.
+		ReleaseGeometryAllocation();
 		if (!m_VertexArrayID)
 		{
 			glGenVertexArrays(1, &m_VertexArrayID);
@@ -52,85 +66,15 @@ namespace Crescent
 			glGenBuffers(1, &m_IndexBufferID);
 		}
 
-		//Preprocess buffer data.
-		std::vector<float> bufferData;
-
-		if (interleaved)
-		{
-			for (int i = 0; i < m_Positions.size(); i++)
-			{
-				bufferData.push_back(m_Positions[i].x);
-				bufferData.push_back(m_Positions[i].y);
-				bufferData.push_back(m_Positions[i].z);
-				if (m_UV.size() > 0)
-				{
-					bufferData.push_back(m_UV[i].x);
-					bufferData.push_back(m_UV[i].y);
-				}
-				if (m_Normals.size() > 0)
-				{
-					bufferData.push_back(m_Normals[i].x);
-					bufferData.push_back(m_Normals[i].y);
-					bufferData.push_back(m_Normals[i].z);
-				}
-				if (m_Tangents.size() > 0)
-				{
-					bufferData.push_back(m_Tangents[i].x);
-					bufferData.push_back(m_Tangents[i].y);
-					bufferData.push_back(m_Tangents[i].z);
-				}
-				if (m_Bitangents.size() > 0)
-				{
-					bufferData.push_back(m_Bitangents[i].x);
-					bufferData.push_back(m_Bitangents[i].y);
-					bufferData.push_back(m_Bitangents[i].z);
-				}				
-			}
-		}
-		else
-		{
-			//If any of the float arrays are empty, data won't be filled by them.
-			for (int i = 0; i < m_Positions.size(); i++)
-			{
-				bufferData.push_back(m_Positions[i].x);
-				bufferData.push_back(m_Positions[i].y);
-				bufferData.push_back(m_Positions[i].z);
-			}
-			for (int i = 0; i < m_UV.size(); i++)
-			{
-				bufferData.push_back(m_UV[i].x);
-				bufferData.push_back(m_UV[i].y);
-			}
-			for (int i = 0; i < m_Normals.size(); i++)
-			{
-				bufferData.push_back(m_Normals[i].x);
-				bufferData.push_back(m_Normals[i].y);
-				bufferData.push_back(m_Normals[i].z);
-			}
-			for (int i = 0; i < m_Tangents.size(); i++)
-			{
-				bufferData.push_back(m_Tangents[i].x);
-				bufferData.push_back(m_Tangents[i].y);
-				bufferData.push_back(m_Tangents[i].z);
-			}
-			for (int i = 0; i < m_Bitangents.size(); i++)
-			{
-				bufferData.push_back(m_Bitangents[i].x);
-				bufferData.push_back(m_Bitangents[i].y);
-				bufferData.push_back(m_Bitangents[i].z);
-			}
-		}
+		//Preprocess buffer data into a single block, sized up front.
+		std::vector<float> bufferData(VertexPacker::RetrieveFloatCount(this));
+		VertexPacker::PackFloatVertices(this, interleaved, bufferData.data());
 
 		//Configure vertex attributes only if vertex data size is more than 0.
-		glBindVertexArray(m_VertexArrayID);
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), m_VertexArrayID);
 		glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
 		glBufferData(GL_ARRAY_BUFFER, (bufferData.size() * sizeof(float) + (m_BoneIDs.size() * sizeof(int)) + (m_BoneWeights.size() * sizeof(float))), &bufferData[0], GL_STATIC_DRAW);
-		//Only fill the index buffer if the index array is not empty.
-		if (m_Indices.size() > 0)
-		{
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int), &m_Indices[0], GL_STATIC_DRAW);
-		}
+		UploadIndexData();
 		if (interleaved)
 		{
 			//Calculate stride from number of non-empty vertex attribute arrays. Remember that stride is the total amount of information owned by a single vertex.
@@ -248,9 +192,318 @@ namespace Crescent
 			}
 			*/
 		}
-		glBindVertexArray(0);
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), 0);
+
+		FinalizeDepthVertexArray(interleaved);
 	}	
 
+	void Mesh::ConfigureVertexFormat(VertexFormat vertexFormat)
+	{
+		m_VertexFormat = vertexFormat;
+		m_PositionOffset = glm::vec3(0.0f);
+		m_PositionScale = glm::vec3(1.0f);
+		if (vertexFormat == VertexFormat_Quantized && m_LocalBoundingBox.IsValid())
+		{
+			m_PositionOffset = m_LocalBoundingBox.m_Minimum;
+			m_PositionScale = m_LocalBoundingBox.m_Maximum - m_LocalBoundingBox.m_Minimum;
+		}
+	}
+
+	void Mesh::FinalizePackedVertexArray()
+	{
+		bool quantizedPositions = m_VertexFormat == VertexFormat_Quantized;
+		PackedVertexLayout vertexLayout = VertexPacker::RetrievePackedLayout(this, quantizedPositions);
+		size_t packedSize = VertexPacker::RetrievePackedSize(this, vertexLayout);
+
+		//Indexed meshes become ranges of the geometry arena's buffers, sharing a vertex array with every mesh of the same layout. Any previous range is given
+		//back first, as the mesh may have changed size or layout.
+		ReleaseGeometryAllocation();
+		GeometryArena* geometryArena = GeometryArena::RetrieveActiveArena();
+		if (geometryArena && m_Topology == Triangles && !m_Indices.empty() && !m_Positions.empty())
+		{
+			m_ShortIndices = m_Positions.size() < 65536;
+			m_GeometryAllocation = geometryArena->Allocate(vertexLayout, m_ShortIndices, m_Positions.size(), VertexPacker::RetrieveIndexCount(this));
+			PackPoolVertices(m_GeometryAllocation, vertexLayout);
+
+			//Depth passes only fetch positions. Rather than striding over every attribute, they read them from a pool of their own, shared by every mesh
+			//with the same position format. Indices are copied along, as each pool has its own index buffer.
+			PackedVertexLayout depthVertexLayout;
+			depthVertexLayout.m_QuantizedPositions = quantizedPositions;
+			if (!(depthVertexLayout == vertexLayout))
+			{
+				m_DepthGeometryAllocation = geometryArena->Allocate(depthVertexLayout, m_ShortIndices, m_Positions.size(), VertexPacker::RetrieveIndexCount(this));
+				PackPoolVertices(m_DepthGeometryAllocation, depthVertexLayout);
+			}
+			UploadIndexData();
+			m_InstanceBufferID = 0; //The pool's vertex array may not have instance attributes yet.
+			return;
+		}
+
+		if (!m_VertexArrayID)
+		{
+			glGenVertexArrays(1, &m_VertexArrayID);
+			glGenBuffers(1, &m_VertexBufferID);
+			glGenBuffers(1, &m_IndexBufferID);
+		}
+
+		std::vector<uint8_t> bufferData(packedSize);
+		VertexPacker::PackVertices(this, vertexLayout, m_PositionOffset, m_PositionScale, bufferData.data());
+
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), m_VertexArrayID);
+		glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+		glBufferData(GL_ARRAY_BUFFER, bufferData.size(), bufferData.data(), GL_STATIC_DRAW);
+		UploadIndexData();
+		vertexLayout.ConfigureAttributes();
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), 0);
+	}
+
+	void Mesh::PackPoolVertices(const GeometryAllocation& geometryAllocation, const PackedVertexLayout& vertexLayout)
+	{
+		//Vertices are packed straight into the pool's buffer. Unmapping fails should the buffer's contents be lost in the meantime, in which case we pack
+		//them again into a staging block.
+		bool packedInPlace = false;
+		if (uint8_t* mappedVertices = geometryAllocation.m_Pool->MapVertexData(geometryAllocation))
+		{
+			VertexPacker::PackVertices(this, vertexLayout, m_PositionOffset, m_PositionScale, mappedVertices);
+			packedInPlace = geometryAllocation.m_Pool->UnmapVertexData();
+		}
+		if (!packedInPlace)
+		{
+			std::vector<uint8_t> bufferData(VertexPacker::RetrievePackedSize(this, vertexLayout));
+			VertexPacker::PackVertices(this, vertexLayout, m_PositionOffset, m_PositionScale, bufferData.data());
+			geometryAllocation.m_Pool->UploadVertexData(geometryAllocation, bufferData.data());
+		}
+	}
+
+	void Mesh::UploadIndexData()
+	{
+		m_ShortIndices = m_Positions.size() < 65536;
+
+		//Only fill the index buffer if the index array is not empty.
+		if (m_Indices.empty())
+		{
+			return;
+		}
+
+		//Every level of detail follows the full resolution indices in the same buffer.
+		size_t indexOffset = m_Indices.size();
+		for (size_t i = 0; i < m_LODs.size(); i++)
+		{
+			m_LODs[i].m_IndexOffset = indexOffset;
+			indexOffset += m_LODs[i].m_Indices.size();
+		}
+		size_t byteSize = VertexPacker::RetrieveIndexCount(this) * RetrieveIndexSize();
+
+		//As with vertices, indices living in the geometry arena are written straight into its buffers when they can be mapped. Our depth range holds a copy.
+		if (m_GeometryAllocation.m_Pool)
+		{
+			const GeometryAllocation* geometryAllocations[2] = { &m_GeometryAllocation, &m_DepthGeometryAllocation };
+			for (const GeometryAllocation* geometryAllocation : geometryAllocations)
+			{
+				GeometryPool* geometryPool = geometryAllocation->m_Pool;
+				if (!geometryPool)
+				{
+					continue;
+				}
+
+				bool packedInPlace = false;
+				if (uint8_t* mappedIndices = geometryPool->MapIndexData(*geometryAllocation))
+				{
+					VertexPacker::PackIndices(this, m_ShortIndices, mappedIndices);
+					packedInPlace = geometryPool->UnmapIndexData();
+				}
+				if (!packedInPlace)
+				{
+					std::vector<uint8_t> indexData(byteSize);
+					VertexPacker::PackIndices(this, m_ShortIndices, indexData.data());
+					geometryPool->UploadIndexData(*geometryAllocation, indexData.data());
+				}
+			}
+			return;
+		}
+
+		std::vector<uint8_t> indexData(byteSize);
+		VertexPacker::PackIndices(this, m_ShortIndices, indexData.data());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, byteSize, indexData.data(), GL_STATIC_DRAW);
+	}
+
+	void Mesh::ReleaseGeometryAllocation()
+	{
+		if (!m_GeometryAllocation.m_Pool)
+		{
+			return;
+		}
+
+		if (GeometryArena* geometryArena = GeometryArena::RetrieveActiveArena())
+		{
+			geometryArena->Free(m_GeometryAllocation);
+			if (m_DepthGeometryAllocation.m_Pool)
+			{
+				geometryArena->Free(m_DepthGeometryAllocation);
+			}
+		}
+		m_GeometryAllocation = GeometryAllocation();
+		m_DepthGeometryAllocation = GeometryAllocation();
+		m_InstanceBufferID = 0; //Our vertex array changes.
+	}
+
+	unsigned int Mesh::RetrieveIndexType() const
+	{
+		return m_ShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+
+	unsigned int Mesh::RetrieveDepthVertexArrayID() const
+	{
+		if (m_DepthGeometryAllocation.m_Pool)
+		{
+			return m_DepthGeometryAllocation.m_Pool->RetrieveVertexArrayID();
+		}
+		return m_DepthVertexArrayID ? m_DepthVertexArrayID : RetrieveVertexArrayID();
+	}
+
+	size_t Mesh::RetrieveIndexByteOffset(unsigned int lodIndex, bool positionsOnly) const
+	{
+		size_t indexOffset = RetrieveGeometryAllocation(positionsOnly).m_FirstIndex + (lodIndex == 0 ? 0 : m_LODs[lodIndex - 1].m_IndexOffset);
+		return indexOffset * RetrieveIndexSize();
+	}
+
+	unsigned int Mesh::RetrieveGeometrySortID() const
+	{
+		if (!m_GeometryAllocation.m_Pool)
+		{
+			return m_VertexArrayID;
+		}
+
+		//Sort keys only keep the low bits, so IDs may collide with those of other meshes. This merely breaks up a sorted run, never a draw.
+		return (m_GeometryAllocation.m_Pool->RetrievePoolIndex() << 8) | (m_GeometryAllocation.m_AllocationID & 0xFF);
+	}
+
+	unsigned int Mesh::SelectLOD(float pixelsPerUnit, float maximumPixelError) const
+	{
+		//Errors grow with each level, so we walk down from the coarsest.
+		for (unsigned int lodIndex = RetrieveLODCount() - 1; lodIndex > 0; lodIndex--)
+		{
+			if (RetrieveGeometricError(lodIndex) * pixelsPerUnit <= maximumPixelError)
+			{
+				return lodIndex;
+			}
+		}
+		return 0;
+	}
+
+	void Mesh::FinalizeDepthVertexArray(bool interleaved)
+	{
+		//Separate arrays (or meshes holding nothing but positions) already keep positions tightly packed at the start of the vertex buffer. Packed formats
+		//keep their positions in the geometry arena's depth pools, or are drawn from their full vertex array when outside of the arena.
+		bool hasOtherAttributes = m_UV.size() > 0 || m_Normals.size() > 0 || m_Tangents.size() > 0 || m_Bitangents.size() > 0;
+		if (!interleaved || !hasOtherAttributes || m_VertexFormat != VertexFormat_Float)
+		{
+			if (m_DepthVertexArrayID)
+			{
+				if (GLStateCache* stateCache = GLStateCache::RetrieveActiveCache())
+				{
+					stateCache->InvalidateVertexArray(m_DepthVertexArrayID);
+				}
+				glDeleteVertexArrays(1, &m_DepthVertexArrayID);
+				glDeleteBuffers(1, &m_DepthVertexBufferID);
+				m_DepthVertexArrayID = 0;
+				m_DepthVertexBufferID = 0;
+			}
+			return;
+		}
+
+		if (!m_DepthVertexArrayID)
+		{
+			glGenVertexArrays(1, &m_DepthVertexArrayID);
+			glGenBuffers(1, &m_DepthVertexBufferID);
+			m_InstanceBufferID = 0; //The new vertex array has no instance attributes yet.
+		}
+
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), m_DepthVertexArrayID);
+		glBindBuffer(GL_ARRAY_BUFFER, m_DepthVertexBufferID);
+		glBufferData(GL_ARRAY_BUFFER, m_Positions.size() * sizeof(glm::vec3), m_Positions.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+
+		//Indices are shared with the full vertex array.
+		if (m_Indices.size() > 0)
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+		}
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), 0);
+	}
+
+	void Mesh::ConfigureInstanceAttributes(unsigned int instanceBufferID)
+	{
+		//Depth passes may draw from the full vertex array, in which case it is only configured once.
+		unsigned int vertexArrays[2] = { RetrieveVertexArrayID(), RetrieveDepthVertexArrayID() };
+		if (vertexArrays[1] == vertexArrays[0])
+		{
+			vertexArrays[1] = 0;
+		}
+		for (unsigned int vertexArrayID : vertexArrays)
+		{
+			if (!vertexArrayID)
+			{
+				continue;
+			}
+
+			GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), vertexArrayID);
+			glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+
+			//A mat4 attribute spans 4 consecutive locations, one per column. Locations 5 to 8 are reserved for bone data.
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				glEnableVertexAttribArray(9 + i);
+				glVertexAttribPointer(9 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(offsetof(InstanceData, m_Transform) + i * sizeof(glm::vec4)));
+				glVertexAttribDivisor(9 + i, 1);
+			}
+			glEnableVertexAttribArray(13);
+			glVertexAttribPointer(13, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)offsetof(InstanceData, m_PositionOffset));
+			glVertexAttribDivisor(13, 1);
+			glEnableVertexAttribArray(14);
+			glVertexAttribPointer(14, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)offsetof(InstanceData, m_PositionScale));
+			glVertexAttribDivisor(14, 1);
+		}
+
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), 0);
+		m_InstanceBufferID = instanceBufferID;
+	}
+
+	void Mesh::CalculateBounds()
+	{
+		m_LocalBoundingBox = BoundingBox();
+		m_LocalBoundingSphere = BoundingSphere();
+		if (m_Positions.empty())
+		{
+			return;
+		}
+
+		for (int i = 0; i < m_Positions.size(); i++)
+		{
+			m_LocalBoundingBox.Merge(m_Positions[i]);
+		}
+
+		//The sphere is centered on the box, with its radius reaching the furthest vertex. This is tighter than wrapping the box's corners.
+		float furthestDistanceSquared = 0.0f;
+		glm::vec3 center = m_LocalBoundingBox.RetrieveCenter();
+		for (int i = 0; i < m_Positions.size(); i++)
+		{
+			glm::vec3 offset = m_Positions[i] - center;
+			furthestDistanceSquared = std::max(furthestDistanceSquared, glm::dot(offset, offset));
+		}
+
+		m_LocalBoundingSphere.m_Center = center;
+		m_LocalBoundingSphere.m_Radius = std::sqrt(furthestDistanceSquared);
+	}
+
+	void Mesh::ClearBounds()
+	{
+		m_LocalBoundingBox = BoundingBox();
+		m_LocalBoundingSphere = BoundingSphere();
+	}
+
 	//==================================================================================================================
 
 	Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<MeshTexture> textures)
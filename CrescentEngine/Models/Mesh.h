@@ -8,6 +8,8 @@
 #include <assimp/scene.h>
 #include <map>
 #include "BoneMapper.h"
+#include "../Utilities/Bounds.h"
+#include "../Rendering/GeometryArena.h"
 
 namespace Crescent
 {
@@ -56,6 +58,34 @@ namespace Crescent
 		TriangleStrips
 	};
 
+	//How vertex attributes are stored on the GPU. Packed formats are always interleaved, and are decoded by shaders reading the object uniform block.
+	enum VertexFormat
+	{
+		VertexFormat_Float,		//Every attribute as 32-bit floats.
+		VertexFormat_Packed,	//Float positions, half float UVs, octahedral normals and tangents as 16-bit pairs, and the bitangent as a sign next to the tangent.
+		VertexFormat_Quantized	//As packed, with positions quantized to 16 bits each within the mesh's bounding box.
+	};
+
+	//A simplified index buffer over the vertices of the mesh owning it.
+	struct MeshLOD
+	{
+		std::vector<unsigned int> m_Indices;
+		float m_GeometricError = 0.0f; //Object space distance by which the simplified surface may deviate from the full resolution one.
+		size_t m_IndexOffset = 0; //Into the mesh's index buffer, which holds every level back to back.
+	};
+
+	//A small cluster of neighbouring triangles, owning a contiguous run of the mesh's full resolution indices. Bounds are in object space.
+	struct Meshlet
+	{
+		size_t m_IndexOffset = 0;
+		unsigned int m_TriangleCount = 0;
+		unsigned int m_VertexCount = 0;
+		BoundingSphere m_BoundingSphere;
+		//Every triangle faces away from any viewpoint for which dot(center - viewpoint, axis) >= cutoff * |center - viewpoint| + radius. A cutoff of 1 never culls.
+		glm::vec3 m_ConeAxis = glm::vec3(0.0f);
+		float m_ConeCutoff = 1.0f;
+	};
+
 	/*
 		Basic Mesh class. A mesh in its simplest form is purely a list of vertices with some added functionality for easily setting up the hardware configuration
 		relevant for rendering.
@@ -64,17 +94,54 @@ namespace Crescent
 	class Mesh
 	{
 	public:
-		//Here, we support multiple ways of initializing a mesh. 
+		//Here, we support multiple ways of initializing a mesh. Arrays are moved in, so passing them with std::move copies nothing (see also MeshBuilder).
 		Mesh();
 		Mesh(std::vector<glm::vec3> positions, std::vector<unsigned int> indices);
 		Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uv, std::vector<unsigned int> indices);
 		Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uv, std::vector<glm::vec3> normals, std::vector<unsigned int> indices);
 		Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec2> uv, std::vector<glm::vec3> normals, std::vector<glm::vec3> tangents, std::vector<glm::vec3> bitangents, std::vector<unsigned int> indices);
 
-		void FinalizeMesh(bool interleaved = true); //Preprocess buffer data as interleaved or seperate when specified. 
+		void FinalizeMesh(bool interleaved = true, VertexFormat vertexFormat = VertexFormat_Float); //Preprocess buffer data as interleaved or seperate when specified. 
+
+		//Points our per-instance attributes (locations 9 to 14, see InstanceData) at the given buffer. Only needs to be redone if the buffer changes.
+		void ConfigureInstanceAttributes(unsigned int instanceBufferID);
+		bool HasInstanceAttributes(unsigned int instanceBufferID) const { return m_InstanceBufferID == instanceBufferID; }
+
+		//Sets the vertex format without uploading anything, along with the box quantized positions span, taken from our current bounds. Done
+		//automatically when finalizing the mesh.
+		void ConfigureVertexFormat(VertexFormat vertexFormat);
+		void CalculateBounds(); //Recomputes the local bounding volumes from our positions. Done automatically when finalizing the mesh.
+		void ClearBounds(); //Leaves the mesh without bounds, so it is never culled. Meant for geometry surrounding the camera, such as skyboxes.
 
 		//Retrieves
-		unsigned int RetrieveVertexArrayID() const { return m_VertexArrayID; }
+		unsigned int RetrieveVertexArrayID() const { return m_GeometryAllocation.m_Pool ? m_GeometryAllocation.m_Pool->RetrieveVertexArrayID() : m_VertexArrayID; }
+		//Positions only, tightly packed, for depth passes. Packed meshes in the geometry arena keep theirs in a pool of their own. Falls back to the full vertex
+		//array when its positions are already tightly packed. Depth draws take their base vertex and index offsets from the same ranges, see positionsOnly below.
+		unsigned int RetrieveDepthVertexArrayID() const;
+		//The geometry arena pool holding our vertices and indices, or nullptr if we own our buffers.
+		GeometryPool* RetrieveGeometryPool() const { return m_GeometryAllocation.m_Pool; }
+		//Added to every index by draw calls. Always 0 for meshes owning their buffers.
+		int RetrieveBaseVertex(bool positionsOnly = false) const { return (int)RetrieveGeometryAllocation(positionsOnly).m_BaseVertex; }
+		//Tells apart meshes in sort keys. Meshes within the same pool share their upper bits, so that they are drawn one after another.
+		unsigned int RetrieveGeometrySortID() const;
+		//GL_UNSIGNED_SHORT for meshes with fewer than 65536 vertices, GL_UNSIGNED_INT otherwise.
+		unsigned int RetrieveIndexType() const;
+
+		//Level 0 is the full resolution mesh drawn from m_Indices, followed by the entries of m_LODs.
+		unsigned int RetrieveLODCount() const { return (unsigned int)m_LODs.size() + 1; }
+		size_t RetrieveIndexCount(unsigned int lodIndex = 0) const { return lodIndex == 0 ? m_Indices.size() : m_LODs[lodIndex - 1].m_Indices.size(); }
+		//Byte offset of a level's indices within the bound index buffer, to be passed to draw calls.
+		size_t RetrieveIndexByteOffset(unsigned int lodIndex = 0, bool positionsOnly = false) const;
+		size_t RetrieveIndexSize() const { return m_ShortIndices ? sizeof(uint16_t) : sizeof(unsigned int); }
+		float RetrieveGeometricError(unsigned int lodIndex) const { return lodIndex == 0 ? 0.0f : m_LODs[lodIndex - 1].m_GeometricError; }
+		//Returns the coarsest level whose error stays within the given number of pixels, given how many pixels an object space unit covers.
+		unsigned int SelectLOD(float pixelsPerUnit, float maximumPixelError) const;
+		VertexFormat RetrieveVertexFormat() const { return m_VertexFormat; }
+		//Stored positions map back to object space as offset + position * scale. This is the identity unless positions are quantized.
+		const glm::vec3& RetrievePositionOffset() const { return m_PositionOffset; }
+		const glm::vec3& RetrievePositionScale() const { return m_PositionScale; }
+		const BoundingBox& RetrieveLocalBoundingBox() const { return m_LocalBoundingBox; }
+		const BoundingSphere& RetrieveLocalBoundingSphere() const { return m_LocalBoundingSphere; }
 
 		//Skeletal Animations
 		void RecursivelyUpdateBoneMatrices(int animation_id, aiNode* node, glm::mat4 transform, double ticks);
@@ -116,6 +183,8 @@ namespace Crescent
 		
 
 		std::vector<unsigned int> m_Indices;
+		std::vector<MeshLOD> m_LODs; //Ordered from finest to coarsest. Uploaded along with the indices when finalizing.
+		std::vector<Meshlet> m_Meshlets; //Partitions m_Indices in order when present, letting the full resolution mesh be culled piecewise.
 
 		//Skeletal Animations
 		std::vector<glm::mat4> m_BoneMatrices, m_BoneOffsets;
@@ -125,9 +194,33 @@ namespace Crescent
 		BoneMapper m_BoneMapper;
 
 	private:
+		void FinalizePackedVertexArray();
+		void FinalizeDepthVertexArray(bool interleaved);
+		//Packs our vertices into a pool range, mapping it when possible and uploading from a staging block otherwise.
+		void PackPoolVertices(const GeometryAllocation& geometryAllocation, const PackedVertexLayout& vertexLayout);
+		void UploadIndexData(); //Expects our vertex array to be bound, unless our indices live in the geometry arena.
+		void ReleaseGeometryAllocation();
+		//The range depth passes draw from. Its pool holds nothing but positions, and is only used while the full range lives in the arena.
+		const GeometryAllocation& RetrieveGeometryAllocation(bool positionsOnly) const { return positionsOnly && m_DepthGeometryAllocation.m_Pool ? m_DepthGeometryAllocation : m_GeometryAllocation; }
+
+	private:
+		//Object space bounds.
+		BoundingBox m_LocalBoundingBox;
+		BoundingSphere m_LocalBoundingSphere;
+
 		unsigned int m_VertexArrayID = 0;
 		unsigned int m_VertexBufferID = 0;
 		unsigned int m_IndexBufferID = 0;
+		unsigned int m_InstanceBufferID = 0;
+		unsigned int m_DepthVertexArrayID = 0;
+		unsigned int m_DepthVertexBufferID = 0;
+		GeometryAllocation m_GeometryAllocation; //Packed meshes are suballocated from the active geometry arena when there is one.
+		GeometryAllocation m_DepthGeometryAllocation; //Positions only, in the same format, along with a copy of our indices.
+
+		VertexFormat m_VertexFormat = VertexFormat_Float;
+		glm::vec3 m_PositionOffset = glm::vec3(0.0f);
+		glm::vec3 m_PositionScale = glm::vec3(1.0f);
+		bool m_ShortIndices = false;
 
 	public:
 		//Defunct
@@ -0,0 +1,46 @@
+#include "CrescentPCH.h"
+#include "MeshBuilder.h"
+#include "Mesh.h"
+
+namespace Crescent
+{
+	MeshBuilder::MeshBuilder(size_t vertexCount, size_t indexCount, bool hasUV, bool hasNormals, bool hasTangents)
+	{
+		m_Positions.resize(vertexCount);
+		m_Indices.resize(indexCount);
+		if (hasUV)
+		{
+			m_UV.resize(vertexCount);
+		}
+		if (hasNormals)
+		{
+			m_Normals.resize(vertexCount);
+		}
+		if (hasTangents)
+		{
+			m_Tangents.resize(vertexCount);
+			m_Bitangents.resize(vertexCount);
+		}
+	}
+
+	Mesh* MeshBuilder::BuildMesh()
+	{
+		Mesh* mesh = new Mesh;
+		mesh->m_Positions = std::move(m_Positions);
+		mesh->m_UV = std::move(m_UV);
+		mesh->m_Normals = std::move(m_Normals);
+		mesh->m_Tangents = std::move(m_Tangents);
+		mesh->m_Bitangents = std::move(m_Bitangents);
+		mesh->m_Indices = std::move(m_Indices);
+		mesh->m_Topology = Triangles;
+
+		//Moved from vectors are only guaranteed to be valid, so we make sure we are left empty.
+		m_Positions.clear();
+		m_UV.clear();
+		m_Normals.clear();
+		m_Tangents.clear();
+		m_Bitangents.clear();
+		m_Indices.clear();
+		return mesh;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace Crescent
+{
+	class Mesh;
+
+	/*
+		Owns a mesh's CPU side arrays while an importer fills them. Arrays are sized once, up front, so that every attribute is written straight into its
+		final place rather than gathered into temporaries. Builders can only be moved, and their arrays are moved into the mesh they build, so the vertex
+		data has a single owner and is never copied on its way to being packed for the GPU.
+	*/
+
+	class MeshBuilder
+	{
+	public:
+		MeshBuilder(size_t vertexCount, size_t indexCount, bool hasUV, bool hasNormals, bool hasTangents);
+
+		MeshBuilder(const MeshBuilder&) = delete;
+		MeshBuilder& operator=(const MeshBuilder&) = delete;
+		MeshBuilder(MeshBuilder&&) = default;
+		MeshBuilder& operator=(MeshBuilder&&) = default;
+
+		//Attributes the builder was created without return nullptr.
+		glm::vec3* RetrievePositions() { return m_Positions.data(); }
+		glm::vec2* RetrieveUV() { return m_UV.empty() ? nullptr : m_UV.data(); }
+		glm::vec3* RetrieveNormals() { return m_Normals.empty() ? nullptr : m_Normals.data(); }
+		glm::vec3* RetrieveTangents() { return m_Tangents.empty() ? nullptr : m_Tangents.data(); }
+		glm::vec3* RetrieveBitangents() { return m_Bitangents.empty() ? nullptr : m_Bitangents.data(); }
+		unsigned int* RetrieveIndices() { return m_Indices.data(); }
+		size_t RetrieveVertexCount() const { return m_Positions.size(); }
+		size_t RetrieveIndexCount() const { return m_Indices.size(); }
+
+		//Hands our arrays over to a new, unfinalized mesh, leaving the builder empty.
+		Mesh* BuildMesh();
+
+	private:
+		std::vector<glm::vec3> m_Positions;
+		std::vector<glm::vec2> m_UV;
+		std::vector<glm::vec3> m_Normals;
+		std::vector<glm::vec3> m_Tangents;
+		std::vector<glm::vec3> m_Bitangents;
+		std::vector<unsigned int> m_Indices;
+	};
+}
@@ -0,0 +1,443 @@
+#include "CrescentPCH.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Crescent
+{
+	//FNV-1a over 32-bit words rather than bytes, as every attribute is made of floats or ints. Folded over each attribute in turn.
+	static uint32_t HashWords(uint32_t hash, const void* data, size_t size)
+	{
+		for (size_t i = 0; i < size; i += sizeof(uint32_t))
+		{
+			uint32_t word;
+			std::memcpy(&word, static_cast<const uint8_t*>(data) + i, sizeof(word));
+			hash = (hash ^ word) * 16777619u;
+		}
+		return hash ^ (hash >> 15);
+	}
+
+	template<typename T>
+	static uint32_t HashAttribute(uint32_t hash, const std::vector<T>& attribute, size_t vertexIndex)
+	{
+		return attribute.empty() ? hash : HashWords(hash, &attribute[vertexIndex], sizeof(T));
+	}
+
+	template<typename T>
+	static bool AttributesEqual(const std::vector<T>& attribute, size_t firstVertex, size_t secondVertex)
+	{
+		return attribute.empty() || std::memcmp(&attribute[firstVertex], &attribute[secondVertex], sizeof(T)) == 0;
+	}
+
+	template<typename T>
+	static void RemapAttribute(std::vector<T>& attribute, const std::vector<unsigned int>& remapTable, size_t newVertexCount)
+	{
+		//Empty attributes, or ones not stored per vertex, are left alone.
+		if (attribute.size() != remapTable.size())
+		{
+			return;
+		}
+
+		std::vector<T> remappedAttribute(newVertexCount);
+		for (size_t i = 0; i < remapTable.size(); i++)
+		{
+			if (remapTable[i] != InvalidVertexIndex)
+			{
+				remappedAttribute[remapTable[i]] = attribute[i];
+			}
+		}
+		attribute.swap(remappedAttribute);
+	}
+
+	MeshOptimizationReport MeshOptimizer::OptimizeMesh(Mesh* mesh)
+	{
+		MeshOptimizationReport optimizationReport;
+		optimizationReport.m_VertexCountBefore = mesh->m_Positions.size();
+		optimizationReport.m_CacheStatisticsBefore = AnalyzeVertexCache(mesh->m_Indices, mesh->m_Positions.size());
+
+		if (mesh->m_Topology == Triangles && !mesh->m_Indices.empty())
+		{
+			WeldVertices(mesh);
+
+			std::vector<unsigned int> clusterOffsets;
+			OptimizeVertexCache(mesh->m_Indices, mesh->m_Positions.size(), &clusterOffsets);
+			OptimizeOverdraw(mesh->m_Indices, mesh->m_Positions, clusterOffsets);
+			OptimizeVertexFetch(mesh);
+		}
+
+		optimizationReport.m_VertexCountAfter = mesh->m_Positions.size();
+		optimizationReport.m_CacheStatisticsAfter = AnalyzeVertexCache(mesh->m_Indices, mesh->m_Positions.size());
+		return optimizationReport;
+	}
+
+	size_t MeshOptimizer::WeldVertices(Mesh* mesh)
+	{
+		size_t vertexCount = mesh->m_Positions.size();
+		if (vertexCount == 0)
+		{
+			return 0;
+		}
+
+		//Open addressing table of representative vertices, kept at most half full so probe chains stay short.
+		size_t tableSize = 1;
+		while (tableSize < vertexCount * 2)
+		{
+			tableSize *= 2;
+		}
+		std::vector<unsigned int> hashTable(tableSize, InvalidVertexIndex);
+		std::vector<unsigned int> remapTable(vertexCount);
+		size_t uniqueVertexCount = 0;
+
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			uint32_t hash = 2166136261u;
+			hash = HashAttribute(hash, mesh->m_Positions, i);
+			hash = HashAttribute(hash, mesh->m_UV, i);
+			hash = HashAttribute(hash, mesh->m_Normals, i);
+			hash = HashAttribute(hash, mesh->m_Tangents, i);
+			hash = HashAttribute(hash, mesh->m_Bitangents, i);
+
+			size_t slot = hash & (tableSize - 1);
+			while (hashTable[slot] != InvalidVertexIndex)
+			{
+				unsigned int candidate = hashTable[slot];
+				if (AttributesEqual(mesh->m_Positions, candidate, i) && AttributesEqual(mesh->m_UV, candidate, i) && AttributesEqual(mesh->m_Normals, candidate, i) &&
+					AttributesEqual(mesh->m_Tangents, candidate, i) && AttributesEqual(mesh->m_Bitangents, candidate, i))
+				{
+					break;
+				}
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if (hashTable[slot] == InvalidVertexIndex)
+			{
+				hashTable[slot] = (unsigned int)i;
+				remapTable[i] = (unsigned int)uniqueVertexCount++;
+			}
+			else
+			{
+				remapTable[i] = remapTable[hashTable[slot]];
+			}
+		}
+
+		if (uniqueVertexCount == vertexCount)
+		{
+			return 0;
+		}
+
+		for (size_t i = 0; i < mesh->m_Indices.size(); i++)
+		{
+			mesh->m_Indices[i] = remapTable[mesh->m_Indices[i]];
+		}
+		RemapVertices(mesh, remapTable, uniqueVertexCount);
+		return vertexCount - uniqueVertexCount;
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, std::vector<unsigned int>* clusterOffsets)
+	{
+		//Tipsify, as in Sander et al. 2007, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw". We fan around one vertex at a time, emitting
+		//all its remaining triangles, then move on to a neighbour still in the cache. Dead ends fall back to recently emitted vertices, then to a linear scan.
+		size_t triangleCount = indices.size() / 3;
+		if (clusterOffsets)
+		{
+			clusterOffsets->clear();
+		}
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		std::vector<unsigned int> adjacencyOffsets, adjacentTriangles;
+		BuildTriangleAdjacency(indices, vertexCount, adjacencyOffsets, adjacentTriangles);
+		std::vector<unsigned int> liveTriangleCounts(vertexCount); //Triangles around each vertex that are yet to be emitted.
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			liveTriangleCounts[i] = adjacencyOffsets[i + 1] - adjacencyOffsets[i];
+		}
+
+		//A vertex is in the cache while fewer than m_VertexCacheSize vertices have entered it since. Timestamps start past the cache size, so nothing is.
+		std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+		unsigned int timestamp = m_VertexCacheSize + 1;
+		std::vector<uint8_t> emittedTriangles(triangleCount, 0);
+		std::vector<unsigned int> deadEndStack;
+		std::vector<unsigned int> candidateVertices;
+		std::vector<unsigned int> optimizedIndices;
+		optimizedIndices.reserve(triangleCount * 3);
+		size_t scanCursor = 0;
+
+		unsigned int fanningVertex = indices[0];
+		if (clusterOffsets)
+		{
+			clusterOffsets->push_back(0);
+		}
+
+		while (fanningVertex != InvalidVertexIndex)
+		{
+			candidateVertices.clear();
+			for (unsigned int i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; i++)
+			{
+				unsigned int triangle = adjacentTriangles[i];
+				if (emittedTriangles[triangle])
+				{
+					continue;
+				}
+
+				for (unsigned int j = 0; j < 3; j++)
+				{
+					unsigned int vertex = indices[triangle * 3 + j];
+					optimizedIndices.push_back(vertex);
+					deadEndStack.push_back(vertex);
+					candidateVertices.push_back(vertex);
+					liveTriangleCounts[vertex]--;
+					if (timestamp - cacheTimestamps[vertex] > m_VertexCacheSize)
+					{
+						cacheTimestamps[vertex] = timestamp++;
+					}
+				}
+				emittedTriangles[triangle] = 1;
+			}
+
+			//Prefer the candidate that entered the cache earliest, as long as fanning around it wouldn't push it out before it is done.
+			unsigned int nextVertex = InvalidVertexIndex;
+			int bestPriority = -1;
+			for (unsigned int vertex : candidateVertices)
+			{
+				if (liveTriangleCounts[vertex] == 0)
+				{
+					continue;
+				}
+
+				int priority = 0;
+				unsigned int cacheAge = timestamp - cacheTimestamps[vertex];
+				if (cacheAge + 2 * liveTriangleCounts[vertex] <= m_VertexCacheSize)
+				{
+					priority = (int)cacheAge;
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex = vertex;
+				}
+			}
+
+			if (nextVertex == InvalidVertexIndex)
+			{
+				while (!deadEndStack.empty() && nextVertex == InvalidVertexIndex)
+				{
+					unsigned int vertex = deadEndStack.back();
+					deadEndStack.pop_back();
+					if (liveTriangleCounts[vertex] > 0)
+					{
+						nextVertex = vertex;
+					}
+				}
+				while (scanCursor < vertexCount && nextVertex == InvalidVertexIndex)
+				{
+					if (liveTriangleCounts[scanCursor] > 0)
+					{
+						nextVertex = (unsigned int)scanCursor;
+					}
+					scanCursor++;
+				}
+
+				//A jump breaks locality, which is where overdraw sorting is free to cut.
+				size_t emittedTriangleCount = optimizedIndices.size() / 3;
+				if (clusterOffsets && nextVertex != InvalidVertexIndex && clusterOffsets->back() != emittedTriangleCount)
+				{
+					clusterOffsets->push_back((unsigned int)emittedTriangleCount);
+				}
+			}
+			fanningVertex = nextVertex;
+		}
+
+		indices.swap(optimizedIndices);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& clusterOffsets)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount < 2 || clusterOffsets.empty())
+		{
+			return;
+		}
+
+		//Split clusters wherever the triangles since the last split already reach (nearly) the cluster's own cache efficiency, so that reordering them
+		//costs little in vertex transforms. Runs start with an empty cache, which is what they will see in the worst case once shuffled.
+		std::vector<unsigned int> cacheTimestamps(positions.size(), 0);
+		unsigned int timestamp = m_VertexCacheSize + 1;
+		auto countCacheMisses = [&](size_t triangle)
+		{
+			unsigned int cacheMisses = 0;
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				unsigned int vertex = indices[triangle * 3 + j];
+				if (timestamp - cacheTimestamps[vertex] > m_VertexCacheSize)
+				{
+					cacheTimestamps[vertex] = timestamp++;
+					cacheMisses++;
+				}
+			}
+			return cacheMisses;
+		};
+
+		std::vector<unsigned int> splitOffsets;
+		for (size_t i = 0; i < clusterOffsets.size(); i++)
+		{
+			size_t clusterStart = clusterOffsets[i];
+			size_t clusterEnd = i + 1 < clusterOffsets.size() ? clusterOffsets[i + 1] : triangleCount;
+
+			timestamp += m_VertexCacheSize + 1;
+			unsigned int clusterCacheMisses = 0;
+			for (size_t triangle = clusterStart; triangle < clusterEnd; triangle++)
+			{
+				clusterCacheMisses += countCacheMisses(triangle);
+			}
+			float clusterACMR = (float)clusterCacheMisses / (float)(clusterEnd - clusterStart);
+
+			splitOffsets.push_back((unsigned int)clusterStart);
+			timestamp += m_VertexCacheSize + 1;
+			unsigned int runCacheMisses = 0;
+			for (size_t triangle = clusterStart; triangle < clusterEnd; triangle++)
+			{
+				runCacheMisses += countCacheMisses(triangle);
+				size_t runTriangleCount = triangle + 1 - splitOffsets.back();
+				if (triangle + 1 < clusterEnd && (float)runCacheMisses <= clusterACMR * m_OverdrawThreshold * (float)runTriangleCount)
+				{
+					splitOffsets.push_back((unsigned int)(triangle + 1));
+					timestamp += m_VertexCacheSize + 1;
+					runCacheMisses = 0;
+				}
+			}
+		}
+
+		//Clusters facing away from the mesh's center are likely to occlude the rest, so they are drawn first.
+		size_t clusterCount = splitOffsets.size();
+		std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+		glm::vec3 meshCentroid = glm::vec3(0.0f);
+		float meshArea = 0.0f;
+		for (size_t i = 0; i < clusterCount; i++)
+		{
+			size_t clusterEnd = i + 1 < clusterCount ? splitOffsets[i + 1] : triangleCount;
+			float clusterArea = 0.0f;
+			for (size_t triangle = splitOffsets[i]; triangle < clusterEnd; triangle++)
+			{
+				const glm::vec3& a = positions[indices[triangle * 3 + 0]];
+				const glm::vec3& b = positions[indices[triangle * 3 + 1]];
+				const glm::vec3& c = positions[indices[triangle * 3 + 2]];
+				glm::vec3 areaNormal = glm::cross(b - a, c - a); //Twice the triangle's area in length.
+				float area = glm::length(areaNormal);
+
+				clusterCentroids[i] += (a + b + c) * (area / 3.0f);
+				clusterNormals[i] += areaNormal;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroids[i];
+			meshArea += clusterArea;
+			clusterCentroids[i] = clusterArea > 0.0f ? clusterCentroids[i] / clusterArea : positions[indices[splitOffsets[i] * 3]];
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+		std::vector<float> sortKeys(clusterCount);
+		std::vector<unsigned int> clusterOrder(clusterCount);
+		for (size_t i = 0; i < clusterCount; i++)
+		{
+			float normalLength = glm::length(clusterNormals[i]);
+			sortKeys[i] = normalLength > 0.0f ? glm::dot(clusterCentroids[i] - meshCentroid, clusterNormals[i] / normalLength) : 0.0f;
+			clusterOrder[i] = (unsigned int)i;
+		}
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<unsigned int> sortedIndices;
+		sortedIndices.reserve(indices.size());
+		for (unsigned int cluster : clusterOrder)
+		{
+			size_t clusterEnd = cluster + 1 < clusterCount ? splitOffsets[cluster + 1] : triangleCount;
+			sortedIndices.insert(sortedIndices.end(), indices.begin() + splitOffsets[cluster] * 3, indices.begin() + clusterEnd * 3);
+		}
+		indices.swap(sortedIndices);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(Mesh* mesh)
+	{
+		std::vector<unsigned int> remapTable(mesh->m_Positions.size(), InvalidVertexIndex);
+		unsigned int nextVertex = 0;
+		for (size_t i = 0; i < mesh->m_Indices.size(); i++)
+		{
+			unsigned int& remappedVertex = remapTable[mesh->m_Indices[i]];
+			if (remappedVertex == InvalidVertexIndex)
+			{
+				remappedVertex = nextVertex++;
+			}
+			mesh->m_Indices[i] = remappedVertex;
+		}
+		RemapVertices(mesh, remapTable, nextVertex);
+	}
+
+	VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+	{
+		VertexCacheStatistics cacheStatistics;
+		if (indices.size() < 3)
+		{
+			return cacheStatistics;
+		}
+
+		//FIFO simulation, timestamped the same way as in OptimizeVertexCache.
+		std::vector<unsigned int> cacheTimestamps(vertexCount, 0);
+		unsigned int timestamp = cacheSize + 1;
+		size_t cacheMisses = 0;
+		size_t referencedVertexCount = 0;
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			unsigned int vertex = indices[i];
+			if (timestamp - cacheTimestamps[vertex] > cacheSize)
+			{
+				referencedVertexCount += cacheTimestamps[vertex] == 0;
+				cacheTimestamps[vertex] = timestamp++;
+				cacheMisses++;
+			}
+		}
+
+		cacheStatistics.m_ACMR = (float)cacheMisses / (float)(indices.size() / 3);
+		cacheStatistics.m_ATVR = (float)cacheMisses / (float)referencedVertexCount;
+		return cacheStatistics;
+	}
+
+	void MeshOptimizer::BuildTriangleAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount, std::vector<unsigned int>& adjacencyOffsets, std::vector<unsigned int>& adjacentTriangles,
+		const std::vector<unsigned int>* remapTable)
+	{
+		size_t indexCount = indices.size() / 3 * 3;
+		auto adjacentVertex = [&](size_t i) { return remapTable ? (*remapTable)[indices[i]] : indices[i]; };
+
+		//Counts first, then a prefix sum turns them into offsets, then every triangle is filed under each of its three vertices.
+		adjacencyOffsets.assign(vertexCount + 1, 0);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			adjacencyOffsets[adjacentVertex(i) + 1]++;
+		}
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+
+		adjacentTriangles.resize(indexCount);
+		std::vector<unsigned int> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			adjacentTriangles[fillOffsets[adjacentVertex(i)]++] = (unsigned int)(i / 3);
+		}
+	}
+
+	void MeshOptimizer::RemapVertices(Mesh* mesh, const std::vector<unsigned int>& remapTable, size_t newVertexCount)
+	{
+		RemapAttribute(mesh->m_Positions, remapTable, newVertexCount);
+		RemapAttribute(mesh->m_UV, remapTable, newVertexCount);
+		RemapAttribute(mesh->m_Normals, remapTable, newVertexCount);
+		RemapAttribute(mesh->m_Tangents, remapTable, newVertexCount);
+		RemapAttribute(mesh->m_Bitangents, remapTable, newVertexCount);
+		RemapAttribute(mesh->m_BoneIDs, remapTable, newVertexCount);
+		RemapAttribute(mesh->m_BoneWeights, remapTable, newVertexCount);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace Crescent
+{
+	class Mesh;
+
+	const unsigned int InvalidVertexIndex = 0xFFFFFFFF;
+
+	struct VertexCacheStatistics
+	{
+		float m_ACMR = 0.0f; //Average cache miss ratio. Vertices transformed per triangle, from 3 down to about 0.5 for regular grids.
+		float m_ATVR = 0.0f; //Average transform to vertex ratio. Vertices transformed per referenced vertex, 1 being optimal.
+	};
+
+	struct MeshOptimizationReport
+	{
+		size_t m_VertexCountBefore = 0;
+		size_t m_VertexCountAfter = 0;
+		VertexCacheStatistics m_CacheStatisticsBefore;
+		VertexCacheStatistics m_CacheStatisticsAfter;
+	};
+
+	/*
+		Load time optimization of triangle meshes, done entirely on the CPU side arrays of a mesh before it is finalized. A full pass welds duplicate
+		vertices, reorders triangles for the post-transform vertex cache (Tipsify), sorts the resulting clusters so outward facing ones draw first to cut
+		overdraw, then renumbers vertices in the order they are first referenced so vertex fetch walks memory linearly.
+	*/
+
+	class MeshOptimizer
+	{
+	public:
+		//Runs every pass below in order. Meshes without indices or with strip topology are left untouched.
+		static MeshOptimizationReport OptimizeMesh(Mesh* mesh);
+
+		//Merges vertices whose attributes are bitwise identical. Returns the number of vertices removed.
+		static size_t WeldVertices(Mesh* mesh);
+		//Reorders triangles for a FIFO vertex cache. Offsets of the triangle clusters produced along the way are written out for overdraw sorting.
+		static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, std::vector<unsigned int>* clusterOffsets = nullptr);
+		//Reorders whole clusters, front-facing from the outside first. Clusters whose cache efficiency allows it are split further beforehand.
+		static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& clusterOffsets);
+		//Renumbers vertices by first use, dropping any that are never referenced.
+		static void OptimizeVertexFetch(Mesh* mesh);
+
+		static VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = m_VertexCacheSize);
+		//Packs the triangles around each vertex into one array, those around vertex i lying between adjacencyOffsets[i] and adjacencyOffsets[i + 1].
+		//With a remap table, triangles are filed under the remapped indices of their vertices instead, which must all be below vertexCount.
+		static void BuildTriangleAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount, std::vector<unsigned int>& adjacencyOffsets, std::vector<unsigned int>& adjacentTriangles,
+			const std::vector<unsigned int>* remapTable = nullptr);
+
+	public:
+		static const unsigned int m_VertexCacheSize = 16;
+		static constexpr float m_OverdrawThreshold = 1.05f; //How much worse than its parent's a split cluster's ACMR may become.
+
+	private:
+		//Moves each vertex i to remapTable[i], or drops it if it maps to InvalidVertexIndex.
+		static void RemapVertices(Mesh* mesh, const std::vector<unsigned int>& remapTable, size_t newVertexCount);
+
+	private:
+		//Disallow creation of any MeshOptimizer object. This is a static object.
+		MeshOptimizer();
+	};
+}
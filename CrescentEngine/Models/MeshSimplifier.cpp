@@ -0,0 +1,336 @@
+#include "CrescentPCH.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Crescent
+{
+	//Sum of squared distances to a set of weighted planes, stored as the symmetric matrix A, vector b and scalar c of p'Ap + 2b'p + c.
+	struct Quadric
+	{
+		double m_A00 = 0.0, m_A11 = 0.0, m_A22 = 0.0, m_A01 = 0.0, m_A02 = 0.0, m_A12 = 0.0;
+		double m_B0 = 0.0, m_B1 = 0.0, m_B2 = 0.0;
+		double m_C = 0.0;
+		double m_Weight = 0.0;
+
+		void AddPlane(const glm::vec3& normal, float distance, float weight)
+		{
+			m_A00 += weight * normal.x * normal.x;
+			m_A11 += weight * normal.y * normal.y;
+			m_A22 += weight * normal.z * normal.z;
+			m_A01 += weight * normal.x * normal.y;
+			m_A02 += weight * normal.x * normal.z;
+			m_A12 += weight * normal.y * normal.z;
+			m_B0 += weight * normal.x * distance;
+			m_B1 += weight * normal.y * distance;
+			m_B2 += weight * normal.z * distance;
+			m_C += weight * distance * distance;
+			m_Weight += weight;
+		}
+
+		void Add(const Quadric& quadric)
+		{
+			m_A00 += quadric.m_A00; m_A11 += quadric.m_A11; m_A22 += quadric.m_A22;
+			m_A01 += quadric.m_A01; m_A02 += quadric.m_A02; m_A12 += quadric.m_A12;
+			m_B0 += quadric.m_B0; m_B1 += quadric.m_B1; m_B2 += quadric.m_B2;
+			m_C += quadric.m_C;
+			m_Weight += quadric.m_Weight;
+		}
+
+		//Weighted mean of the squared plane distances. Clamped, as cancellation can push it slightly below zero.
+		double Evaluate(const glm::vec3& point) const
+		{
+			double x = point.x, y = point.y, z = point.z;
+			double error = m_A00 * x * x + m_A11 * y * y + m_A22 * z * z + 2.0 * (m_A01 * x * y + m_A02 * x * z + m_A12 * y * z) + 2.0 * (m_B0 * x + m_B1 * y + m_B2 * z) + m_C;
+			return m_Weight > 0.0 ? std::max(error, 0.0) / m_Weight : 0.0;
+		}
+	};
+
+	struct EdgeCollapse
+	{
+		unsigned int m_SourceVertex;
+		unsigned int m_TargetVertex;
+		float m_Error; //Squared.
+	};
+
+	//Maps every vertex to the first vertex sharing its exact position.
+	static std::vector<unsigned int> BuildPositionRemap(const std::vector<glm::vec3>& positions)
+	{
+		size_t tableSize = 1;
+		while (tableSize < positions.size() * 2)
+		{
+			tableSize *= 2;
+		}
+		std::vector<unsigned int> hashTable(tableSize, InvalidVertexIndex);
+		std::vector<unsigned int> positionRemap(positions.size());
+
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			uint32_t words[3];
+			std::memcpy(words, &positions[i], sizeof(words));
+			uint32_t hash = (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+			hash ^= hash >> 15;
+
+			size_t slot = hash & (tableSize - 1);
+			while (hashTable[slot] != InvalidVertexIndex && std::memcmp(&positions[hashTable[slot]], &positions[i], sizeof(glm::vec3)) != 0)
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (hashTable[slot] == InvalidVertexIndex)
+			{
+				hashTable[slot] = (unsigned int)i;
+			}
+			positionRemap[i] = hashTable[slot];
+		}
+		return positionRemap;
+	}
+
+	void MeshSimplifier::GenerateLODs(Mesh* mesh)
+	{
+		mesh->m_LODs.clear();
+		if (mesh->m_Topology != Triangles || mesh->m_Indices.empty())
+		{
+			return;
+		}
+
+		BoundingBox meshBounds;
+		for (size_t i = 0; i < mesh->m_Positions.size(); i++)
+		{
+			meshBounds.Merge(mesh->m_Positions[i]);
+		}
+		float maximumError = glm::length(meshBounds.m_Maximum - meshBounds.m_Minimum) * m_MaximumRelativeError;
+
+		//Each level is simplified from the one before, so its error is at most the sum of every step's error.
+		mesh->m_LODs.reserve(m_MaximumLODCount - 1);
+		const std::vector<unsigned int>* previousIndices = &mesh->m_Indices;
+		float previousError = 0.0f;
+		for (unsigned int i = 1; i < m_MaximumLODCount; i++)
+		{
+			float simplificationError = 0.0f;
+			std::vector<unsigned int> lodIndices = SimplifyIndices(*previousIndices, mesh->m_Positions, previousIndices->size() / 6 * 3, maximumError - previousError, &simplificationError);
+			if (lodIndices.empty() || lodIndices.size() > previousIndices->size() * m_MinimumReduction)
+			{
+				break;
+			}
+
+			MeshOptimizer::OptimizeVertexCache(lodIndices, mesh->m_Positions.size());
+
+			MeshLOD meshLOD;
+			meshLOD.m_Indices.swap(lodIndices);
+			meshLOD.m_GeometricError = previousError + simplificationError;
+			mesh->m_LODs.push_back(std::move(meshLOD));
+
+			previousIndices = &mesh->m_LODs.back().m_Indices;
+			previousError = mesh->m_LODs.back().m_GeometricError;
+		}
+	}
+
+	std::vector<unsigned int> MeshSimplifier::SimplifyIndices(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		std::vector<unsigned int> simplifiedIndices(indices);
+		float largestError = 0.0f;
+		if (resultError)
+		{
+			*resultError = 0.0f;
+		}
+		size_t vertexCount = positions.size();
+		if (indices.size() <= targetIndexCount || vertexCount == 0 || targetError <= 0.0f)
+		{
+			return simplifiedIndices;
+		}
+
+		//Positions shared by several vertices lie on attribute seams, and positions on edges used by a single triangle lie on open borders. Both stay put.
+		std::vector<unsigned int> positionRemap = BuildPositionRemap(positions);
+		std::vector<uint8_t> lockedPositions(vertexCount, 0);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			if (positionRemap[i] != i)
+			{
+				lockedPositions[positionRemap[i]] = 1;
+			}
+		}
+
+		//An edge is interior if one of the triangles around its end position runs it the other way.
+		std::vector<unsigned int> adjacencyOffsets, adjacentTriangles;
+		MeshOptimizer::BuildTriangleAdjacency(indices, vertexCount, adjacencyOffsets, adjacentTriangles, &positionRemap);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			unsigned int edgeStart = positionRemap[indices[i]];
+			unsigned int edgeEnd = positionRemap[indices[i % 3 == 2 ? i - 2 : i + 1]];
+			bool hasOppositeEdge = false;
+			for (unsigned int j = adjacencyOffsets[edgeEnd]; j < adjacencyOffsets[edgeEnd + 1] && !hasOppositeEdge; j++)
+			{
+				unsigned int triangle = adjacentTriangles[j];
+				for (unsigned int k = 0; k < 3; k++)
+				{
+					hasOppositeEdge |= positionRemap[indices[triangle * 3 + k]] == edgeEnd && positionRemap[indices[triangle * 3 + (k + 1) % 3]] == edgeStart;
+				}
+			}
+			if (!hasOppositeEdge)
+			{
+				lockedPositions[edgeStart] = 1;
+				lockedPositions[edgeEnd] = 1;
+			}
+		}
+
+		//Quadrics live on positions, so that collapses can still merge them into a locked seam vertex's.
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const glm::vec3& a = positions[indices[i]];
+			glm::vec3 normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+			float doubleArea = glm::length(normal);
+			if (doubleArea == 0.0f)
+			{
+				continue;
+			}
+
+			normal /= doubleArea;
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				quadrics[positionRemap[indices[i + j]]].AddPlane(normal, -glm::dot(normal, a), doubleArea * 0.5f);
+			}
+		}
+
+		std::vector<unsigned int> collapseTargets(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			collapseTargets[i] = (unsigned int)i;
+		}
+		std::vector<uint8_t> touchedVertices(vertexCount);
+		std::vector<EdgeCollapse> edgeCollapses;
+		float targetErrorSquared = targetError * targetError;
+
+		auto calculateCollapseError = [&](unsigned int sourceVertex, unsigned int targetVertex)
+		{
+			Quadric quadric = quadrics[positionRemap[sourceVertex]];
+			quadric.Add(quadrics[positionRemap[targetVertex]]);
+			return (float)quadric.Evaluate(positions[targetVertex]);
+		};
+
+		//Moving the source vertex must not turn any of its remaining triangles over. Vertices moved earlier in this pass are looked up through their targets.
+		auto flipsTriangles = [&](unsigned int sourceVertex, unsigned int targetVertex)
+		{
+			for (unsigned int i = adjacencyOffsets[sourceVertex]; i < adjacencyOffsets[sourceVertex + 1]; i++)
+			{
+				unsigned int triangle = adjacentTriangles[i];
+				unsigned int triangleVertices[3];
+				bool collapsesAway = false;
+				for (unsigned int j = 0; j < 3; j++)
+				{
+					triangleVertices[j] = collapseTargets[simplifiedIndices[triangle * 3 + j]];
+					collapsesAway |= triangleVertices[j] == targetVertex;
+				}
+				if (collapsesAway)
+				{
+					continue;
+				}
+
+				glm::vec3 corners[3];
+				glm::vec3 movedCorners[3];
+				for (unsigned int j = 0; j < 3; j++)
+				{
+					corners[j] = positions[triangleVertices[j]];
+					movedCorners[j] = triangleVertices[j] == sourceVertex ? positions[targetVertex] : corners[j];
+				}
+
+				glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				glm::vec3 movedNormal = glm::cross(movedCorners[1] - movedCorners[0], movedCorners[2] - movedCorners[0]);
+				if (glm::dot(normal, movedNormal) <= 0.0f)
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		//Each pass collapses the cheapest edges whose vertices haven't been touched yet in the pass, then drops the triangles that degenerated.
+		while (simplifiedIndices.size() > targetIndexCount)
+		{
+			size_t triangleCount = simplifiedIndices.size() / 3;
+
+			MeshOptimizer::BuildTriangleAdjacency(simplifiedIndices, vertexCount, adjacencyOffsets, adjacentTriangles, &collapseTargets);
+
+			//Interior edges are shared by two triangles in opposite directions, so only one of them queues the edge.
+			edgeCollapses.clear();
+			for (size_t i = 0; i < simplifiedIndices.size(); i++)
+			{
+				unsigned int edgeStart = simplifiedIndices[i];
+				unsigned int edgeEnd = simplifiedIndices[i % 3 == 2 ? i - 2 : i + 1];
+				if (edgeStart >= edgeEnd)
+				{
+					continue;
+				}
+
+				bool startMovable = !lockedPositions[positionRemap[edgeStart]];
+				bool endMovable = !lockedPositions[positionRemap[edgeEnd]];
+				if (!startMovable && !endMovable)
+				{
+					continue;
+				}
+
+				float startError = startMovable ? calculateCollapseError(edgeStart, edgeEnd) : FLT_MAX;
+				float endError = endMovable ? calculateCollapseError(edgeEnd, edgeStart) : FLT_MAX;
+				EdgeCollapse edgeCollapse;
+				edgeCollapse.m_SourceVertex = startError <= endError ? edgeStart : edgeEnd;
+				edgeCollapse.m_TargetVertex = startError <= endError ? edgeEnd : edgeStart;
+				edgeCollapse.m_Error = std::min(startError, endError);
+				edgeCollapses.push_back(edgeCollapse);
+			}
+			std::sort(edgeCollapses.begin(), edgeCollapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.m_Error < b.m_Error; });
+
+			//An interior collapse removes two triangles, which is enough to know when to stop.
+			std::fill(touchedVertices.begin(), touchedVertices.end(), 0);
+			size_t remainingTriangleCount = triangleCount;
+			size_t collapseCount = 0;
+			for (const EdgeCollapse& edgeCollapse : edgeCollapses)
+			{
+				if (edgeCollapse.m_Error > targetErrorSquared || remainingTriangleCount * 3 <= targetIndexCount)
+				{
+					break;
+				}
+				if (touchedVertices[edgeCollapse.m_SourceVertex] || touchedVertices[edgeCollapse.m_TargetVertex] || flipsTriangles(edgeCollapse.m_SourceVertex, edgeCollapse.m_TargetVertex))
+				{
+					continue;
+				}
+
+				collapseTargets[edgeCollapse.m_SourceVertex] = edgeCollapse.m_TargetVertex;
+				quadrics[positionRemap[edgeCollapse.m_TargetVertex]].Add(quadrics[positionRemap[edgeCollapse.m_SourceVertex]]);
+				touchedVertices[edgeCollapse.m_SourceVertex] = 1;
+				touchedVertices[edgeCollapse.m_TargetVertex] = 1;
+				largestError = std::max(largestError, edgeCollapse.m_Error);
+				remainingTriangleCount -= std::min<size_t>(remainingTriangleCount, 2);
+				collapseCount++;
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			size_t writeOffset = 0;
+			for (size_t i = 0; i < simplifiedIndices.size(); i += 3)
+			{
+				unsigned int a = collapseTargets[simplifiedIndices[i]];
+				unsigned int b = collapseTargets[simplifiedIndices[i + 1]];
+				unsigned int c = collapseTargets[simplifiedIndices[i + 2]];
+				if (a != b && b != c && a != c)
+				{
+					simplifiedIndices[writeOffset++] = a;
+					simplifiedIndices[writeOffset++] = b;
+					simplifiedIndices[writeOffset++] = c;
+				}
+			}
+			simplifiedIndices.resize(writeOffset);
+		}
+
+		if (resultError)
+		{
+			*resultError = std::sqrt(largestError);
+		}
+		return simplifiedIndices;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace Crescent
+{
+	class Mesh;
+
+	/*
+		Quadric error metric simplification (Garland and Heckbert 1997) that only ever collapses edges onto one of their existing vertices. Simplified
+		index buffers therefore reference the original vertices, and every level of detail of a mesh can share its vertex buffer.
+
+		Vertices on open borders or attribute seams (several vertices sharing one position) are locked in place, so that silhouettes and UV layouts hold.
+		Errors are object space distances: the area weighted root mean square distance of a collapsed vertex to the planes it has absorbed.
+	*/
+
+	class MeshSimplifier
+	{
+	public:
+		//Fills the mesh's LODs, each aiming at half the triangles of the one before. Stops early when simplification stalls.
+		static void GenerateLODs(Mesh* mesh);
+
+		//Collapses edges until at most targetIndexCount indices remain, or until the next collapse would exceed targetError. The largest error of any
+		//collapse performed is written to resultError.
+		static std::vector<unsigned int> SimplifyIndices(const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	public:
+		static const unsigned int m_MaximumLODCount = 5; //Including the full resolution mesh.
+		static constexpr float m_MaximumRelativeError = 0.05f; //Largest error a LOD may reach, relative to the diagonal of the mesh's bounds.
+		static constexpr float m_MinimumReduction = 0.8f; //A LOD keeping more than this fraction of its predecessor's triangles is discarded.
+
+	private:
+		//Disallow creation of any MeshSimplifier object. This is a static object.
+		MeshSimplifier();
+	};
+}
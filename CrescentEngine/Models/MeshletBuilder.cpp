@@ -0,0 +1,247 @@
+#include "CrescentPCH.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Crescent
+{
+	void MeshletBuilder::BuildMeshlets(Mesh* mesh)
+	{
+		mesh->m_Meshlets.clear();
+		const std::vector<unsigned int>& indices = mesh->m_Indices;
+		if (mesh->m_Topology != Triangles || indices.size() < 3)
+		{
+			return;
+		}
+
+		size_t vertexCount = mesh->m_Positions.size();
+		size_t triangleCount = indices.size() / 3;
+
+		std::vector<unsigned int> adjacencyOffsets, adjacentTriangles;
+		MeshOptimizer::BuildTriangleAdjacency(indices, vertexCount, adjacencyOffsets, adjacentTriangles);
+
+		std::vector<uint8_t> emittedTriangles(triangleCount, 0);
+		std::vector<unsigned int> liveTriangleCounts(vertexCount); //Triangles around each vertex that are yet to be emitted.
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			liveTriangleCounts[i] = adjacencyOffsets[i + 1] - adjacencyOffsets[i];
+		}
+		std::vector<unsigned int> vertexMeshlets(vertexCount, InvalidVertexIndex); //The meshlet each vertex was last added to.
+		std::vector<unsigned int> candidateMeshlets(triangleCount, InvalidVertexIndex); //The meshlet each triangle was last a candidate of, to avoid duplicates.
+		std::vector<unsigned int> meshletTriangles;
+		std::vector<unsigned int> candidateTriangles;
+		std::vector<unsigned int> reorderedIndices;
+		reorderedIndices.reserve(triangleCount * 3);
+		meshletTriangles.reserve(m_MaximumTriangles);
+
+		const std::vector<glm::vec3>& positions = mesh->m_Positions;
+		unsigned int meshletIndex = 0;
+		unsigned int meshletVertexCount = 0;
+		glm::vec3 meshletVertexSum = glm::vec3(0.0f);
+		glm::vec3 meshletCenter = glm::vec3(0.0f); //Kept past the end of a meshlet, so that the next one starts close by.
+		size_t emittedTriangleCount = 0;
+		size_t seedTriangle = 0;
+
+		auto queueAdjacentTriangles = [&](unsigned int vertex)
+		{
+			for (unsigned int k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1]; k++)
+			{
+				unsigned int triangle = adjacentTriangles[k];
+				if (!emittedTriangles[triangle] && candidateMeshlets[triangle] != meshletIndex)
+				{
+					candidateMeshlets[triangle] = meshletIndex;
+					candidateTriangles.push_back(triangle);
+				}
+			}
+		};
+
+		//Triangles are written back in their previous order, which the vertex cache optimization left them in.
+		auto emitMeshlet = [&]()
+		{
+			std::sort(meshletTriangles.begin(), meshletTriangles.end());
+
+			Meshlet meshlet;
+			meshlet.m_IndexOffset = reorderedIndices.size();
+			meshlet.m_TriangleCount = (unsigned int)meshletTriangles.size();
+			meshlet.m_VertexCount = meshletVertexCount;
+			for (unsigned int triangle : meshletTriangles)
+			{
+				reorderedIndices.insert(reorderedIndices.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+			}
+			CalculateMeshletBounds(meshlet, reorderedIndices, positions);
+			mesh->m_Meshlets.push_back(meshlet);
+
+			meshletIndex++;
+			meshletVertexCount = 0;
+			meshletVertexSum = glm::vec3(0.0f);
+			meshletTriangles.clear();
+
+			//Triangles still bordering the finished meshlet become the candidates seeding the next one.
+			candidateTriangles.clear();
+			for (size_t i = meshlet.m_IndexOffset; i < reorderedIndices.size(); i++)
+			{
+				if (liveTriangleCounts[reorderedIndices[i]] > 0)
+				{
+					queueAdjacentTriangles(reorderedIndices[i]);
+				}
+			}
+		};
+
+		//Fewest new vertices first. Then the fewest triangles left around its vertices, which fills in corners before they are stranded, then the closest
+		//to the meshlet's center. Candidates emitted in the meantime are dropped along the way.
+		auto selectCandidate = [&](unsigned int& bestNewVertexCount)
+		{
+			unsigned int bestTriangle = InvalidVertexIndex;
+			unsigned int bestLiveCount = 0;
+			float bestDistance = 0.0f;
+			for (size_t i = 0; i < candidateTriangles.size();)
+			{
+				unsigned int triangle = candidateTriangles[i];
+				if (emittedTriangles[triangle])
+				{
+					candidateTriangles[i] = candidateTriangles.back();
+					candidateTriangles.pop_back();
+					continue;
+				}
+				i++;
+
+				unsigned int newVertexCount = 0;
+				unsigned int liveCount = 0;
+				glm::vec3 centroid = glm::vec3(0.0f);
+				for (unsigned int j = 0; j < 3; j++)
+				{
+					unsigned int vertex = indices[triangle * 3 + j];
+					newVertexCount += vertexMeshlets[vertex] != meshletIndex;
+					liveCount += liveTriangleCounts[vertex];
+					centroid += positions[vertex];
+				}
+				glm::vec3 offset = centroid / 3.0f - meshletCenter;
+				float distance = glm::dot(offset, offset);
+
+				if (bestTriangle == InvalidVertexIndex || newVertexCount < bestNewVertexCount || (newVertexCount == bestNewVertexCount && (liveCount < bestLiveCount ||
+					(liveCount == bestLiveCount && distance < bestDistance))))
+				{
+					bestTriangle = triangle;
+					bestNewVertexCount = newVertexCount;
+					bestLiveCount = liveCount;
+					bestDistance = distance;
+				}
+			}
+			return bestTriangle;
+		};
+
+		while (emittedTriangleCount < triangleCount)
+		{
+			unsigned int bestNewVertexCount = 0;
+			unsigned int bestTriangle = selectCandidate(bestNewVertexCount);
+			if (bestTriangle == InvalidVertexIndex)
+			{
+				//A meshlet whose surface has run out ends there, rather than jumping elsewhere and growing its bounds.
+				if (!meshletTriangles.empty())
+				{
+					emitMeshlet();
+					continue;
+				}
+
+				//Nothing is left around the previous meshlet either, so we start over from the earliest triangle left.
+				while (emittedTriangles[seedTriangle])
+				{
+					seedTriangle++;
+				}
+				bestTriangle = (unsigned int)seedTriangle;
+				bestNewVertexCount = 3;
+			}
+
+			if (meshletVertexCount + bestNewVertexCount > m_MaximumVertices || meshletTriangles.size() == m_MaximumTriangles)
+			{
+				emitMeshlet();
+				continue;
+			}
+
+			emittedTriangles[bestTriangle] = 1;
+			emittedTriangleCount++;
+			meshletTriangles.push_back(bestTriangle);
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				unsigned int vertex = indices[bestTriangle * 3 + j];
+				liveTriangleCounts[vertex]--;
+				if (vertexMeshlets[vertex] == meshletIndex)
+				{
+					continue;
+				}
+
+				vertexMeshlets[vertex] = meshletIndex;
+				meshletVertexCount++;
+				meshletVertexSum += positions[vertex];
+				meshletCenter = meshletVertexSum / (float)meshletVertexCount;
+				queueAdjacentTriangles(vertex);
+			}
+		}
+
+		if (!meshletTriangles.empty())
+		{
+			emitMeshlet();
+		}
+		mesh->m_Indices.swap(reorderedIndices);
+	}
+
+	void MeshletBuilder::CalculateMeshletBounds(Meshlet& meshlet, const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions)
+	{
+		size_t firstIndex = meshlet.m_IndexOffset;
+		size_t lastIndex = meshlet.m_IndexOffset + meshlet.m_TriangleCount * 3;
+
+		BoundingBox boundingBox;
+		for (size_t i = firstIndex; i < lastIndex; i++)
+		{
+			boundingBox.Merge(positions[indices[i]]);
+		}
+		meshlet.m_BoundingSphere.m_Center = boundingBox.RetrieveCenter();
+		meshlet.m_BoundingSphere.m_Radius = 0.0f;
+		for (size_t i = firstIndex; i < lastIndex; i++)
+		{
+			meshlet.m_BoundingSphere.m_Radius = std::max(meshlet.m_BoundingSphere.m_Radius, glm::length(positions[indices[i]] - meshlet.m_BoundingSphere.m_Center));
+		}
+
+		//The cone axis is the average triangle normal, and its spread the largest angle between the axis and any normal.
+		glm::vec3 normalSum = glm::vec3(0.0f);
+		for (size_t i = firstIndex; i < lastIndex; i += 3)
+		{
+			const glm::vec3& a = positions[indices[i]];
+			glm::vec3 normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+			float normalLength = glm::length(normal);
+			if (normalLength > 0.0f)
+			{
+				normalSum += normal / normalLength;
+			}
+		}
+
+		meshlet.m_ConeCutoff = 1.0f;
+		float axisLength = glm::length(normalSum);
+		if (axisLength == 0.0f)
+		{
+			meshlet.m_ConeAxis = glm::vec3(0.0f);
+			return;
+		}
+		meshlet.m_ConeAxis = normalSum / axisLength;
+
+		float minimumDot = 1.0f;
+		for (size_t i = firstIndex; i < lastIndex; i += 3)
+		{
+			const glm::vec3& a = positions[indices[i]];
+			glm::vec3 normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+			float normalLength = glm::length(normal);
+			if (normalLength > 0.0f)
+			{
+				minimumDot = std::min(minimumDot, glm::dot(meshlet.m_ConeAxis, normal / normalLength));
+			}
+		}
+
+		//The view direction must lie within 90 degrees minus the spread of the axis, whose cosine is the sine of the spread.
+		if (minimumDot > m_MinimumConeSpread)
+		{
+			meshlet.m_ConeCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace Crescent
+{
+	class Mesh;
+	struct Meshlet;
+
+	/*
+		Splits a mesh's full resolution triangles into meshlets of at most 64 unique vertices and 124 triangles, sized after what mesh shading hardware
+		favours, so that large meshes can be culled piecewise on the CPU. Meshlets are grown greedily from a seed triangle, always taking the neighbouring
+		triangle that adds the fewest new vertices, which keeps them compact and their bounds tight.
+
+		The mesh's indices are rewritten so that each meshlet owns a contiguous run. Triangles within a meshlet keep their previous relative order, preserving
+		most of the vertex cache optimization done beforehand.
+	*/
+
+	class MeshletBuilder
+	{
+	public:
+		//Fills the mesh's meshlets and reorders its indices to match. Meshes without indices or with strip topology are left without meshlets.
+		static void BuildMeshlets(Mesh* mesh);
+
+		//Bounding sphere and normal cone of the given triangles.
+		static void CalculateMeshletBounds(Meshlet& meshlet, const std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions);
+
+	public:
+		static const unsigned int m_MaximumVertices = 64;
+		static const unsigned int m_MaximumTriangles = 124;
+		static constexpr float m_MinimumConeSpread = 0.1f; //Cones whose normals diverge further than this from the axis (as a cosine) are never culled.
+
+	private:
+		//Disallow creation of any MeshletBuilder object. This is a static object.
+		MeshletBuilder();
+	};
+}
@@ -0,0 +1,382 @@
+#include "CrescentPCH.h"
+#include "VertexPacker.h"
+#include "Mesh.h"
+#include <glm/gtc/packing.hpp>
+#include <emmintrin.h>
+#include <cstring>
+
+namespace Crescent
+{
+	//Splits 4 consecutive vec3s into one register per component.
+	static void LoadDirections(const glm::vec3* directions, __m128& x, __m128& y, __m128& z)
+	{
+		//Loaded as x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3.
+		__m128 first = _mm_loadu_ps(&directions[0].x);
+		__m128 second = _mm_loadu_ps(&directions[0].x + 4);
+		__m128 third = _mm_loadu_ps(&directions[0].x + 8);
+
+		__m128 latterXY = _mm_shuffle_ps(second, third, _MM_SHUFFLE(2, 1, 3, 2)); //x2 y2 x3 y3
+		__m128 formerYZ = _mm_shuffle_ps(first, second, _MM_SHUFFLE(1, 0, 2, 1)); //y0 z0 y1 z1
+		x = _mm_shuffle_ps(first, latterXY, _MM_SHUFFLE(2, 0, 3, 0));
+		y = _mm_shuffle_ps(formerYZ, latterXY, _MM_SHUFFLE(3, 1, 2, 0));
+		z = _mm_shuffle_ps(formerYZ, third, _MM_SHUFFLE(3, 0, 3, 1));
+	}
+
+	//EncodeOctahedral for 4 directions at once, with the same operations in the same order, so that results match it bit for bit.
+	static void EncodeOctahedralLanes(__m128 x, __m128 y, __m128 z, __m128& encodedX, __m128& encodedY)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 absoluteMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+
+		__m128 manhattanLength = _mm_add_ps(_mm_add_ps(_mm_and_ps(x, absoluteMask), _mm_and_ps(y, absoluteMask)), _mm_and_ps(z, absoluteMask));
+		encodedX = _mm_div_ps(x, manhattanLength);
+		encodedY = _mm_div_ps(y, manhattanLength);
+
+		//Signs are 1 for anything but negative values, negative zero included, so only lanes below zero get their sign bit set.
+		__m128 signX = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(encodedX, zero), signMask));
+		__m128 signY = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(encodedY, zero), signMask));
+		__m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(encodedY, absoluteMask)), signX);
+		__m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(encodedX, absoluteMask)), signY);
+
+		__m128 lowerHalf = _mm_cmplt_ps(z, zero);
+		__m128 nonZeroLength = _mm_cmpneq_ps(manhattanLength, zero);
+		encodedX = _mm_and_ps(nonZeroLength, _mm_or_ps(_mm_and_ps(lowerHalf, foldedX), _mm_andnot_ps(lowerHalf, encodedX)));
+		encodedY = _mm_and_ps(nonZeroLength, _mm_or_ps(_mm_and_ps(lowerHalf, foldedY), _mm_andnot_ps(lowerHalf, encodedY)));
+	}
+
+	//round(clamp(value, -1, 1) * 32767) per lane, as glm's snorm packing does. Halves round away from zero, unlike _mm_cvtps_epi32.
+	static __m128i ConvertToSnorm16(__m128 values)
+	{
+		__m128 scaled = _mm_mul_ps(_mm_min_ps(_mm_max_ps(values, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f)), _mm_set1_ps(32767.0f));
+		__m128i truncated = _mm_cvttps_epi32(scaled);
+		__m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated));
+
+		//Comparison masks are -1 where true.
+		__m128i roundUp = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f)));
+		__m128i roundDown = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f)));
+		return _mm_add_epi32(_mm_sub_epi32(truncated, roundUp), roundDown);
+	}
+
+	//Converts each lane to a half float in its low 16 bits, as glm::packHalf2x16 does. Values turning into half denormals, infinities and NaNs take
+	//branches of their own there, so we return false should any lane hold one, leaving the whole batch to glm.
+	static bool ConvertToHalf(__m128 values, __m128i& halves)
+	{
+		__m128i bits = _mm_castps_si128(values);
+		__m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+		__m128i exponent = _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF));
+
+		//Float exponents below 102 flush to zero, 113 to 142 are normal halves, and 143 to 254 overflow to infinity.
+		__m128i flushed = _mm_cmplt_epi32(exponent, _mm_set1_epi32(102));
+		__m128i overflowed = _mm_cmpgt_epi32(exponent, _mm_set1_epi32(142));
+		__m128i denormal = _mm_andnot_si128(flushed, _mm_cmplt_epi32(exponent, _mm_set1_epi32(113)));
+		if (_mm_movemask_epi8(_mm_or_si128(denormal, _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0xFF)))))
+		{
+			return false;
+		}
+
+		//Rebias the exponent and round the mantissa half up. A carry out of the mantissa bumps the exponent, which is what glm does separately.
+		__m128i magnitude = _mm_sub_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF)), _mm_set1_epi32((127 - 15) << 23));
+		magnitude = _mm_srli_epi32(_mm_add_epi32(magnitude, _mm_set1_epi32(0x1000)), 13);
+		magnitude = _mm_andnot_si128(flushed, magnitude);
+		magnitude = _mm_or_si128(_mm_and_si128(overflowed, _mm_set1_epi32(0x7C00)), _mm_andnot_si128(overflowed, magnitude));
+		halves = _mm_or_si128(sign, magnitude);
+		return true;
+	}
+
+	//Packs the low 16 bits of each lane of both registers, first's lanes followed by second's. Sign extending first makes the saturating pack exact.
+	static __m128i PackLow16(__m128i first, __m128i second)
+	{
+		return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(first, 16), 16), _mm_srai_epi32(_mm_slli_epi32(second, 16), 16));
+	}
+
+	//Joins two lanes of 16-bit values into one 32-bit value per lane, low half first.
+	static __m128i Combine16(__m128i low, __m128i high)
+	{
+		return _mm_or_si128(_mm_and_si128(low, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(high, 16));
+	}
+
+	//Writes each 32-bit lane into its own vertex, stride bytes apart.
+	static void ScatterLanes(__m128i lanes, uint8_t* destination, size_t stride)
+	{
+		alignas(16) uint32_t laneValues[4];
+		_mm_store_si128((__m128i*)laneValues, lanes);
+		for (int i = 0; i < 4; i++)
+		{
+			std::memcpy(destination + i * stride, &laneValues[i], sizeof(uint32_t));
+		}
+	}
+
+	//Writes each 64-bit value, made of a 32-bit lane of low followed by the same lane of high, into its own vertex.
+	static void ScatterLanePairs(__m128i low, __m128i high, uint8_t* destination, size_t stride)
+	{
+		__m128i former = _mm_unpacklo_epi32(low, high);
+		__m128i latter = _mm_unpackhi_epi32(low, high);
+		_mm_storel_epi64((__m128i*)destination, former);
+		_mm_storel_epi64((__m128i*)(destination + stride), _mm_unpackhi_epi64(former, former));
+		_mm_storel_epi64((__m128i*)(destination + 2 * stride), latter);
+		_mm_storel_epi64((__m128i*)(destination + 3 * stride), _mm_unpackhi_epi64(latter, latter));
+	}
+
+	PackedVertexLayout VertexPacker::RetrievePackedLayout(const Mesh* mesh, bool quantizedPositions)
+	{
+		PackedVertexLayout vertexLayout;
+		vertexLayout.m_QuantizedPositions = quantizedPositions;
+		vertexLayout.m_HasUV = mesh->m_UV.size() > 0;
+		vertexLayout.m_HasNormals = mesh->m_Normals.size() > 0;
+		vertexLayout.m_HasTangents = mesh->m_Tangents.size() > 0;
+		return vertexLayout;
+	}
+
+	size_t VertexPacker::RetrievePackedSize(const Mesh* mesh, const PackedVertexLayout& vertexLayout)
+	{
+		return mesh->m_Positions.size() * vertexLayout.RetrieveStride();
+	}
+
+	void VertexPacker::PackVertices(const Mesh* mesh, const PackedVertexLayout& vertexLayout, const glm::vec3& positionOffset, const glm::vec3& positionScale, uint8_t* destination)
+	{
+		const size_t vertexCount = mesh->m_Positions.size();
+		const size_t stride = vertexLayout.RetrieveStride();
+		const size_t uvOffset = vertexLayout.RetrievePositionSize();
+		const size_t normalOffset = uvOffset + (vertexLayout.m_HasUV ? sizeof(uint32_t) : 0);
+		const size_t tangentOffset = normalOffset + (vertexLayout.m_HasNormals ? sizeof(uint32_t) : 0);
+		const bool hasBitangentSigns = mesh->m_Bitangents.size() > 0 && mesh->m_Normals.size() > 0;
+
+		//Flat axes get an inverse scale of zero, so all of their positions land on the box's minimum.
+		glm::vec3 quantizationScale = glm::vec3(0.0f);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			quantizationScale[axis] = positionScale[axis] > 0.0f ? 65535.0f / positionScale[axis] : 0.0f;
+		}
+
+		//Vertices go 4 at a time, with each attribute's components split across registers so that every lane holds a vertex. The remaining vertices,
+		//and UVs glm has to handle, are packed one by one below.
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 quantizationMaximum = _mm_set1_ps(65535.0f);
+		const glm::vec3* positions = mesh->m_Positions.data();
+		size_t batchedCount = vertexCount & ~(size_t)3;
+		for (size_t i = 0; i < batchedCount; i += 4)
+		{
+			uint8_t* vertexData = destination + i * stride;
+			if (vertexLayout.m_QuantizedPositions)
+			{
+				__m128 x, y, z;
+				LoadDirections(&positions[i], x, y, z);
+				x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(x, _mm_set1_ps(positionOffset.x)), _mm_set1_ps(quantizationScale.x)), zero), quantizationMaximum);
+				y = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(positionOffset.y)), _mm_set1_ps(quantizationScale.y)), zero), quantizationMaximum);
+				z = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, _mm_set1_ps(positionOffset.z)), _mm_set1_ps(quantizationScale.z)), zero), quantizationMaximum);
+
+				//The fourth, unused component is zero.
+				ScatterLanePairs(Combine16(_mm_cvtps_epi32(x), _mm_cvtps_epi32(y)), _mm_cvtps_epi32(z), vertexData, stride);
+			}
+			else
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					std::memcpy(vertexData + j * stride, &positions[i + j], sizeof(glm::vec3));
+				}
+			}
+
+			if (vertexLayout.m_HasUV)
+			{
+				//Lanes hold u0 v0 u1 v1 and u2 v2 u3 v3, so packing their halves in order lays out each vertex's pair as packHalf2x16 does.
+				__m128i firstHalves, secondHalves;
+				if (ConvertToHalf(_mm_loadu_ps(&mesh->m_UV[i].x), firstHalves) && ConvertToHalf(_mm_loadu_ps(&mesh->m_UV[i + 2].x), secondHalves))
+				{
+					ScatterLanes(PackLow16(firstHalves, secondHalves), vertexData + uvOffset, stride);
+				}
+				else
+				{
+					for (int j = 0; j < 4; j++)
+					{
+						uint32_t uv = glm::packHalf2x16(mesh->m_UV[i + j]);
+						std::memcpy(vertexData + j * stride + uvOffset, &uv, sizeof(uv));
+					}
+				}
+			}
+
+			__m128 normalX = zero, normalY = zero, normalZ = zero;
+			if (vertexLayout.m_HasNormals)
+			{
+				__m128 encodedX, encodedY;
+				LoadDirections(&mesh->m_Normals[i], normalX, normalY, normalZ);
+				EncodeOctahedralLanes(normalX, normalY, normalZ, encodedX, encodedY);
+				ScatterLanes(Combine16(ConvertToSnorm16(encodedX), ConvertToSnorm16(encodedY)), vertexData + normalOffset, stride);
+			}
+
+			if (vertexLayout.m_HasTangents)
+			{
+				__m128 tangentX, tangentY, tangentZ, encodedX, encodedY;
+				LoadDirections(&mesh->m_Tangents[i], tangentX, tangentY, tangentZ);
+				EncodeOctahedralLanes(tangentX, tangentY, tangentZ, encodedX, encodedY);
+
+				//The handedness is the sign of dot(cross(normal, tangent), bitangent), evaluated in glm's order. It is stored as 32767 or -32767.
+				__m128i bitangentSign = _mm_set1_epi32(32767);
+				if (hasBitangentSigns)
+				{
+					__m128 bitangentX, bitangentY, bitangentZ;
+					LoadDirections(&mesh->m_Bitangents[i], bitangentX, bitangentY, bitangentZ);
+					__m128 crossX = _mm_sub_ps(_mm_mul_ps(normalY, tangentZ), _mm_mul_ps(tangentY, normalZ));
+					__m128 crossY = _mm_sub_ps(_mm_mul_ps(normalZ, tangentX), _mm_mul_ps(tangentZ, normalX));
+					__m128 crossZ = _mm_sub_ps(_mm_mul_ps(normalX, tangentY), _mm_mul_ps(tangentX, normalY));
+					__m128 handedness = _mm_add_ps(_mm_add_ps(_mm_mul_ps(crossX, bitangentX), _mm_mul_ps(crossY, bitangentY)), _mm_mul_ps(crossZ, bitangentZ));
+					__m128i leftHanded = _mm_castps_si128(_mm_cmplt_ps(handedness, zero));
+					bitangentSign = _mm_or_si128(_mm_and_si128(leftHanded, _mm_set1_epi32(-32767)), _mm_andnot_si128(leftHanded, bitangentSign));
+				}
+
+				//The fourth component is zero.
+				ScatterLanePairs(Combine16(ConvertToSnorm16(encodedX), ConvertToSnorm16(encodedY)), _mm_and_si128(bitangentSign, _mm_set1_epi32(0xFFFF)), vertexData + tangentOffset, stride);
+			}
+		}
+
+		for (size_t i = batchedCount; i < vertexCount; i++)
+		{
+			uint8_t* vertexData = destination + i * stride;
+			if (vertexLayout.m_QuantizedPositions)
+			{
+				__m128 position = _mm_setr_ps(positions[i].x, positions[i].y, positions[i].z, 0.0f);
+				__m128 quantized = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(position, _mm_setr_ps(positionOffset.x, positionOffset.y, positionOffset.z, 0.0f)),
+					_mm_setr_ps(quantizationScale.x, quantizationScale.y, quantizationScale.z, 0.0f)), zero), quantizationMaximum);
+				__m128i quantizedLanes = _mm_cvtps_epi32(quantized);
+				_mm_storel_epi64((__m128i*)vertexData, PackLow16(quantizedLanes, quantizedLanes));
+			}
+			else
+			{
+				std::memcpy(vertexData, &positions[i], sizeof(glm::vec3));
+			}
+
+			if (vertexLayout.m_HasUV)
+			{
+				uint32_t uv = glm::packHalf2x16(mesh->m_UV[i]);
+				std::memcpy(vertexData + uvOffset, &uv, sizeof(uv));
+			}
+			if (vertexLayout.m_HasNormals)
+			{
+				uint32_t normal = glm::packSnorm2x16(EncodeOctahedral(mesh->m_Normals[i]));
+				std::memcpy(vertexData + normalOffset, &normal, sizeof(normal));
+			}
+			if (vertexLayout.m_HasTangents)
+			{
+				//Only the bitangent's handedness is kept. Shaders rebuild it from the normal and tangent.
+				float bitangentSign = 1.0f;
+				if (hasBitangentSigns && glm::dot(glm::cross(mesh->m_Normals[i], mesh->m_Tangents[i]), mesh->m_Bitangents[i]) < 0.0f)
+				{
+					bitangentSign = -1.0f;
+				}
+				uint64_t tangent = glm::packSnorm4x16(glm::vec4(EncodeOctahedral(mesh->m_Tangents[i]), bitangentSign, 0.0f));
+				std::memcpy(vertexData + tangentOffset, &tangent, sizeof(tangent));
+			}
+		}
+	}
+
+	size_t VertexPacker::RetrieveFloatCount(const Mesh* mesh)
+	{
+		return mesh->m_Positions.size() * 3 + mesh->m_UV.size() * 2 + mesh->m_Normals.size() * 3 + mesh->m_Tangents.size() * 3 + mesh->m_Bitangents.size() * 3;
+	}
+
+	void VertexPacker::PackFloatVertices(const Mesh* mesh, bool interleaved, float* destination)
+	{
+		if (!interleaved)
+		{
+			//If any of the float arrays are empty, data won't be filled by them.
+			std::memcpy(destination, mesh->m_Positions.data(), mesh->m_Positions.size() * sizeof(glm::vec3));
+			destination += mesh->m_Positions.size() * 3;
+			std::memcpy(destination, mesh->m_UV.data(), mesh->m_UV.size() * sizeof(glm::vec2));
+			destination += mesh->m_UV.size() * 2;
+			std::memcpy(destination, mesh->m_Normals.data(), mesh->m_Normals.size() * sizeof(glm::vec3));
+			destination += mesh->m_Normals.size() * 3;
+			std::memcpy(destination, mesh->m_Tangents.data(), mesh->m_Tangents.size() * sizeof(glm::vec3));
+			destination += mesh->m_Tangents.size() * 3;
+			std::memcpy(destination, mesh->m_Bitangents.data(), mesh->m_Bitangents.size() * sizeof(glm::vec3));
+			return;
+		}
+
+		for (size_t i = 0; i < mesh->m_Positions.size(); i++)
+		{
+			std::memcpy(destination, &mesh->m_Positions[i], sizeof(glm::vec3));
+			destination += 3;
+			if (mesh->m_UV.size() > 0)
+			{
+				std::memcpy(destination, &mesh->m_UV[i], sizeof(glm::vec2));
+				destination += 2;
+			}
+			if (mesh->m_Normals.size() > 0)
+			{
+				std::memcpy(destination, &mesh->m_Normals[i], sizeof(glm::vec3));
+				destination += 3;
+			}
+			if (mesh->m_Tangents.size() > 0)
+			{
+				std::memcpy(destination, &mesh->m_Tangents[i], sizeof(glm::vec3));
+				destination += 3;
+			}
+			if (mesh->m_Bitangents.size() > 0)
+			{
+				std::memcpy(destination, &mesh->m_Bitangents[i], sizeof(glm::vec3));
+				destination += 3;
+			}
+		}
+	}
+
+	size_t VertexPacker::RetrieveIndexCount(const Mesh* mesh)
+	{
+		size_t indexCount = mesh->m_Indices.size();
+		for (const MeshLOD& lod : mesh->m_LODs)
+		{
+			indexCount += lod.m_Indices.size();
+		}
+		return indexCount;
+	}
+
+	void VertexPacker::PackIndices(const Mesh* mesh, bool shortIndices, uint8_t* destination)
+	{
+		auto packLevel = [&](const std::vector<unsigned int>& indices)
+		{
+			if (!shortIndices)
+			{
+				std::memcpy(destination, indices.data(), indices.size() * sizeof(unsigned int));
+				destination += indices.size() * sizeof(unsigned int);
+				return;
+			}
+
+			//Every index fits in 16 bits here, 8 of them narrowed per iteration.
+			uint16_t* shortDestination = (uint16_t*)destination;
+			size_t batchedCount = indices.size() & ~(size_t)7;
+			for (size_t i = 0; i < batchedCount; i += 8)
+			{
+				__m128i firstIndices = _mm_loadu_si128((const __m128i*)&indices[i]);
+				__m128i secondIndices = _mm_loadu_si128((const __m128i*)&indices[i + 4]);
+				_mm_storeu_si128((__m128i*)&shortDestination[i], PackLow16(firstIndices, secondIndices));
+			}
+			for (size_t i = batchedCount; i < indices.size(); i++)
+			{
+				shortDestination[i] = (uint16_t)indices[i];
+			}
+			destination += indices.size() * sizeof(uint16_t);
+		};
+
+		packLevel(mesh->m_Indices);
+		for (const MeshLOD& lod : mesh->m_LODs)
+		{
+			packLevel(lod.m_Indices);
+		}
+	}
+
+	glm::vec2 VertexPacker::EncodeOctahedral(const glm::vec3& direction)
+	{
+		float manhattanLength = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (manhattanLength == 0.0f)
+		{
+			return glm::vec2(0.0f);
+		}
+
+		glm::vec2 encoded = glm::vec2(direction) / manhattanLength;
+		if (direction.z < 0.0f)
+		{
+			glm::vec2 signs = glm::vec2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+			encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+		}
+		return encoded;
+	}
+}
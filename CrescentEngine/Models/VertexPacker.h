@@ -0,0 +1,46 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+#include "../Rendering/GeometryArena.h"
+
+namespace Crescent
+{
+	class Mesh;
+
+	/*
+		Interleaves a mesh's CPU side arrays into the vertex layouts uploaded to the GPU. Sizes are known before any vertex is written, so callers hand in
+		a destination of exactly the right size, be it a mapped range of a GPU buffer or a single staging block, and every byte is written exactly once.
+
+		Vertices are packed 4 at a time through SSE2, with each register lane holding one vertex's component. UVs, normals and tangents match glm's packing
+		functions bit for bit, while quantized positions stay within 1 unit of glm::packUnorm4x16. UVs that glm turns into half denormals, infinities or NaNs
+		are left to it, as are the last vertices of meshes that aren't a multiple of 4 long.
+	*/
+
+	class VertexPacker
+	{
+	public:
+		//The packed layout matching the attributes the mesh has.
+		static PackedVertexLayout RetrievePackedLayout(const Mesh* mesh, bool quantizedPositions);
+		static size_t RetrievePackedSize(const Mesh* mesh, const PackedVertexLayout& vertexLayout);
+		//Writes every vertex in the given layout. Quantized positions span the box starting at positionOffset with size positionScale.
+		static void PackVertices(const Mesh* mesh, const PackedVertexLayout& vertexLayout, const glm::vec3& positionOffset, const glm::vec3& positionScale, uint8_t* destination);
+
+		//Floats taken by the mesh's vertices in the float vertex format, which are the same whether interleaved or not.
+		static size_t RetrieveFloatCount(const Mesh* mesh);
+		//Writes every vertex as floats, either interleaved or as one array per attribute, one after another.
+		static void PackFloatVertices(const Mesh* mesh, bool interleaved, float* destination);
+
+		//Indices across every level of detail, which follow the full resolution indices back to back.
+		static size_t RetrieveIndexCount(const Mesh* mesh);
+		//Writes every level's indices, as 16-bit or 32-bit values.
+		static void PackIndices(const Mesh* mesh, bool shortIndices, uint8_t* destination);
+
+		//Projects a unit vector onto the octahedron |x| + |y| + |z| = 1 and folds its lower half over the upper one, leaving two components in [-1, 1].
+		static glm::vec2 EncodeOctahedral(const glm::vec3& direction);
+
+	private:
+		//Disallow creation of any VertexPacker object. This is a static object.
+		VertexPacker();
+	};
+}
@@ -3,19 +3,25 @@
 
 namespace Crescent
 {
+	GLStateCache* GLStateCache::m_ActiveCache = nullptr;
+
 	GLStateCache::GLStateCache()
 	{
-
+		InvalidateBindings();
+		m_ActiveCache = this;
 	}
 
 	GLStateCache::~GLStateCache()
 	{
-
+		if (m_ActiveCache == this)
+		{
+			m_ActiveCache = nullptr;
+		}
 	}
 
 	void GLStateCache::ToggleDepthTesting(bool depthTestingEnabled)
 	{
-		if (m_DepthTestEnabled != depthTestingEnabled)
+		if (RecordCall(m_DepthTestEnabled != depthTestingEnabled))
 		{
 			m_DepthTestEnabled = depthTestingEnabled;
 			depthTestingEnabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
@@ -24,7 +30,7 @@ namespace Crescent
 
 	void GLStateCache::SetDepthFunction(GLenum depthTestFunction)
 	{
-		if (m_DepthTestFunction != depthTestFunction)
+		if (RecordCall(m_DepthTestFunction != depthTestFunction))
 		{
 			m_DepthTestFunction = depthTestFunction;
 			glDepthFunc(depthTestFunction);
@@ -33,7 +39,7 @@ namespace Crescent
 
 	void GLStateCache::ToggleBlending(bool blendingEnabled)
 	{
-		if (m_BlendingEnabled != blendingEnabled)
+		if (RecordCall(m_BlendingEnabled != blendingEnabled))
 		{
 			m_BlendingEnabled = blendingEnabled;
 			blendingEnabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
@@ -42,7 +48,7 @@ namespace Crescent
 
 	void GLStateCache::SetBlendingFunction(GLenum source, GLenum destination)
 	{
-		if (m_BlendSource != source || m_BlendDestination != destination)
+		if (RecordCall(m_BlendSource != source || m_BlendDestination != destination))
 		{
 			m_BlendSource = source;
 			m_BlendDestination = destination;
@@ -52,7 +58,7 @@ namespace Crescent
 
 	void GLStateCache::ToggleFaceCulling(bool faceCullingEnabled)
 	{
-		if (m_FaceCullingEnabled != faceCullingEnabled)
+		if (RecordCall(m_FaceCullingEnabled != faceCullingEnabled))
 		{
 			m_FaceCullingEnabled = faceCullingEnabled;
 			faceCullingEnabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
@@ -61,7 +67,7 @@ namespace Crescent
 
 	void GLStateCache::SetCulledFace(GLenum culledFace)
 	{
-		if (m_CulledFace != culledFace)
+		if (RecordCall(m_CulledFace != culledFace))
 		{
 			m_CulledFace = culledFace;
 			glCullFace(culledFace);
@@ -70,10 +76,201 @@ namespace Crescent
 
 	void GLStateCache::SetPolygonMode(GLenum polygonMode)
 	{
-		if (m_PolygonMode != polygonMode)
+		if (RecordCall(m_PolygonMode != polygonMode))
 		{
 			m_PolygonMode = polygonMode;
 			glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
 		}
 	}
+
+	void GLStateCache::UseProgram(unsigned int programID)
+	{
+		if (RecordCall(m_ProgramID != programID))
+		{
+			m_ProgramID = programID;
+			glUseProgram(programID);
+		}
+	}
+
+	void GLStateCache::BindVertexArray(unsigned int vertexArrayID)
+	{
+		if (RecordCall(m_VertexArrayID != vertexArrayID))
+		{
+			m_VertexArrayID = vertexArrayID;
+			glBindVertexArray(vertexArrayID);
+		}
+	}
+
+	void GLStateCache::BindTexture(int textureUnit, GLenum textureTarget, unsigned int textureID)
+	{
+		unsigned int requestedUnit = textureUnit >= 0 ? (unsigned int)textureUnit : m_ActiveTextureUnit;
+		int targetIndex = RetrieveTextureTargetIndex(textureTarget);
+
+		//Bindings we can't track (unknown active unit, unit or target outside of our table) are always issued.
+		if (requestedUnit >= m_MaximumTextureUnits || targetIndex < 0)
+		{
+			RecordCall(true);
+			if (textureUnit >= 0)
+			{
+				m_ActiveTextureUnit = textureUnit;
+				glActiveTexture(GL_TEXTURE0 + textureUnit);
+			}
+			if (m_ActiveTextureUnit < m_MaximumTextureUnits && targetIndex >= 0)
+			{
+				m_TextureBindings[m_ActiveTextureUnit][targetIndex] = textureID;
+			}
+			glBindTexture(textureTarget, textureID);
+			return;
+		}
+
+		if (RecordCall(m_TextureBindings[requestedUnit][targetIndex] != textureID))
+		{
+			if (m_ActiveTextureUnit != requestedUnit)
+			{
+				m_ActiveTextureUnit = requestedUnit;
+				glActiveTexture(GL_TEXTURE0 + requestedUnit);
+			}
+			m_TextureBindings[requestedUnit][targetIndex] = textureID;
+			glBindTexture(textureTarget, textureID);
+		}
+	}
+
+	void GLStateCache::BindFramebuffer(GLenum framebufferTarget, unsigned int framebufferID)
+	{
+		bool bindsDraw = framebufferTarget == GL_FRAMEBUFFER || framebufferTarget == GL_DRAW_FRAMEBUFFER;
+		bool bindsRead = framebufferTarget == GL_FRAMEBUFFER || framebufferTarget == GL_READ_FRAMEBUFFER;
+
+		if (RecordCall((bindsDraw && m_DrawFramebufferID != framebufferID) || (bindsRead && m_ReadFramebufferID != framebufferID)))
+		{
+			if (bindsDraw)
+			{
+				m_DrawFramebufferID = framebufferID;
+			}
+			if (bindsRead)
+			{
+				m_ReadFramebufferID = framebufferID;
+			}
+			glBindFramebuffer(framebufferTarget, framebufferID);
+		}
+	}
+
+	void GLStateCache::SetViewport(int x, int y, int width, int height)
+	{
+		if (RecordCall(m_Viewport[0] != x || m_Viewport[1] != y || m_Viewport[2] != width || m_Viewport[3] != height))
+		{
+			m_Viewport[0] = x;
+			m_Viewport[1] = y;
+			m_Viewport[2] = width;
+			m_Viewport[3] = height;
+			glViewport(x, y, width, height);
+		}
+	}
+
+	void GLStateCache::InvalidateBindings()
+	{
+		m_ProgramID = m_UnknownBinding;
+		m_VertexArrayID = m_UnknownBinding;
+		m_ActiveTextureUnit = m_UnknownBinding;
+		m_DrawFramebufferID = m_UnknownBinding;
+		m_ReadFramebufferID = m_UnknownBinding;
+
+		for (unsigned int i = 0; i < m_MaximumTextureUnits; i++)
+		{
+			for (unsigned int j = 0; j < m_TextureTargetCount; j++)
+			{
+				m_TextureBindings[i][j] = m_UnknownBinding;
+			}
+		}
+
+		for (int i = 0; i < 4; i++)
+		{
+			m_Viewport[i] = -1;
+		}
+	}
+
+	void GLStateCache::InvalidateProgram(unsigned int programID)
+	{
+		if (m_ProgramID == programID)
+		{
+			m_ProgramID = m_UnknownBinding;
+		}
+	}
+
+	void GLStateCache::InvalidateVertexArray(unsigned int vertexArrayID)
+	{
+		if (m_VertexArrayID == vertexArrayID)
+		{
+			m_VertexArrayID = m_UnknownBinding;
+		}
+	}
+
+	void GLStateCache::UseProgram(GLStateCache* stateCache, unsigned int programID)
+	{
+		if (stateCache)
+		{
+			stateCache->UseProgram(programID);
+			return;
+		}
+		glUseProgram(programID);
+	}
+
+	void GLStateCache::BindVertexArray(GLStateCache* stateCache, unsigned int vertexArrayID)
+	{
+		if (stateCache)
+		{
+			stateCache->BindVertexArray(vertexArrayID);
+			return;
+		}
+		glBindVertexArray(vertexArrayID);
+	}
+
+	void GLStateCache::BindTexture(GLStateCache* stateCache, int textureUnit, GLenum textureTarget, unsigned int textureID)
+	{
+		if (stateCache)
+		{
+			stateCache->BindTexture(textureUnit, textureTarget, textureID);
+			return;
+		}
+
+		if (textureUnit >= 0)
+		{
+			glActiveTexture(GL_TEXTURE0 + textureUnit);
+		}
+		glBindTexture(textureTarget, textureID);
+	}
+
+	void GLStateCache::BindFramebuffer(GLStateCache* stateCache, GLenum framebufferTarget, unsigned int framebufferID)
+	{
+		if (stateCache)
+		{
+			stateCache->BindFramebuffer(framebufferTarget, framebufferID);
+			return;
+		}
+		glBindFramebuffer(framebufferTarget, framebufferID);
+	}
+
+	int GLStateCache::RetrieveTextureTargetIndex(GLenum textureTarget) const
+	{
+		switch (textureTarget)
+		{
+			case GL_TEXTURE_1D:
+				return 0;
+			case GL_TEXTURE_2D:
+				return 1;
+			case GL_TEXTURE_3D:
+				return 2;
+			case GL_TEXTURE_CUBE_MAP:
+				return 3;
+			case GL_TEXTURE_2D_ARRAY:
+				return 4;
+			default:
+				return -1;
+		}
+	}
+
+	bool GLStateCache::RecordCall(bool stateChanged)
+	{
+		stateChanged ? m_IssuedCallCount++ : m_ElidedCallCount++;
+		return stateChanged;
+	}
 }
\ No newline at end of file
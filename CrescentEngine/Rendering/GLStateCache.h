@@ -7,6 +7,10 @@ namespace Crescent
 		This state cache stores the latest relevant OpenGL state and only through the use of public setters can OpenGL's actual global state be altered.
 		Switching OpenGL states (such as shaders, depth tests and blend states) can be quite expensive. By propagating every change through this cache,
 		we can prevent unneccessary state changes.
+
+		Object bindings (programs, vertex arrays, textures, framebuffers and the viewport) are shadowed too. As shaders, meshes and textures bind
+		themselves, the most recently created cache is made available through RetrieveActiveCache(). Anything binding objects behind the cache's back
+		must call InvalidateBindings() afterwards.
 	*/
 
 	class GLStateCache
@@ -27,7 +31,57 @@ namespace Crescent
 
 		void SetPolygonMode(GLenum polygonMode);
 
+		//Object bindings.
+		void UseProgram(unsigned int programID);
+		void BindVertexArray(unsigned int vertexArrayID);
+		void BindTexture(int textureUnit, GLenum textureTarget, unsigned int textureID); //A negative texture unit binds to the active unit.
+		void BindFramebuffer(GLenum framebufferTarget, unsigned int framebufferID);
+		void SetViewport(int x, int y, int width, int height);
+
+		//Forget all shadowed bindings, so the next request for each is always issued.
+		void InvalidateBindings();
+		//Objects being deleted may have their names reused, so any cached binding of them has to be forgotten.
+		void InvalidateProgram(unsigned int programID);
+		void InvalidateVertexArray(unsigned int vertexArrayID);
+
+		//Counts binding and state calls since the last reset, including those elided by the cache.
+		void ResetCallCounters() { m_IssuedCallCount = 0; m_ElidedCallCount = 0; }
+		unsigned int RetrieveIssuedCallCount() const { return m_IssuedCallCount; }
+		unsigned int RetrieveElidedCallCount() const { return m_ElidedCallCount; }
+
+		//Whether back faces are known to be culled. Only reliable for state set through the cache.
+		bool CullsBackFaces() const { return m_FaceCullingEnabled && m_CulledFace == GL_BACK; }
+
+		static GLStateCache* RetrieveActiveCache() { return m_ActiveCache; }
+
+		//Bindings go through the given cache if there is one, so it never loses track of them, and straight to OpenGL otherwise.
+		static void UseProgram(GLStateCache* stateCache, unsigned int programID);
+		static void BindVertexArray(GLStateCache* stateCache, unsigned int vertexArrayID);
+		static void BindTexture(GLStateCache* stateCache, int textureUnit, GLenum textureTarget, unsigned int textureID);
+		static void BindFramebuffer(GLStateCache* stateCache, GLenum framebufferTarget, unsigned int framebufferID);
+
+	private:
+		int RetrieveTextureTargetIndex(GLenum textureTarget) const;
+		bool RecordCall(bool stateChanged);
+
 	private:
+		static GLStateCache* m_ActiveCache;
+		static const unsigned int m_MaximumTextureUnits = 32;
+		static const unsigned int m_TextureTargetCount = 5; //1D, 2D, 3D, Cube and 2D Array.
+		static const unsigned int m_UnknownBinding = 0xFFFFFFFF;
+
+		unsigned int m_IssuedCallCount = 0;
+		unsigned int m_ElidedCallCount = 0;
+
+		//Bindings
+		unsigned int m_ProgramID = m_UnknownBinding;
+		unsigned int m_VertexArrayID = m_UnknownBinding;
+		unsigned int m_ActiveTextureUnit = m_UnknownBinding;
+		unsigned int m_TextureBindings[m_MaximumTextureUnits][m_TextureTargetCount];
+		unsigned int m_DrawFramebufferID = m_UnknownBinding;
+		unsigned int m_ReadFramebufferID = m_UnknownBinding;
+		int m_Viewport[4] = { -1, -1, -1, -1 };
+
 		//Toggles
 		bool m_DepthTestEnabled = false;
 		bool m_BlendingEnabled = false; 
@@ -0,0 +1,288 @@
+#include "CrescentPCH.h"
+#include "GeometryArena.h"
+#include "GLStateCache.h"
+#include <GL/glew.h>
+#include <algorithm>
+
+namespace Crescent
+{
+	GeometryArena* GeometryArena::m_ActiveArena = nullptr;
+
+	size_t PackedVertexLayout::RetrievePositionSize() const
+	{
+		return m_QuantizedPositions ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+	}
+
+	size_t PackedVertexLayout::RetrieveStride() const
+	{
+		size_t stride = RetrievePositionSize();
+		if (m_HasUV) stride += 2 * sizeof(uint16_t);
+		if (m_HasNormals) stride += 2 * sizeof(int16_t);
+		if (m_HasTangents) stride += 4 * sizeof(int16_t); //Octahedral tangent, bitangent sign and padding.
+		return stride;
+	}
+
+	void PackedVertexLayout::ConfigureAttributes(size_t byteOffset) const
+	{
+		//Attributes left over from a previous float layout would read past our smaller vertices.
+		for (unsigned int i = 0; i < 5; i++)
+		{
+			glDisableVertexAttribArray(i);
+		}
+
+		size_t stride = RetrieveStride();
+		size_t offset = byteOffset;
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, m_QuantizedPositions ? GL_UNSIGNED_SHORT : GL_FLOAT, m_QuantizedPositions ? GL_TRUE : GL_FALSE, (GLsizei)stride, (GLvoid*)offset);
+		offset += RetrievePositionSize();
+		if (m_HasUV)
+		{
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, (GLsizei)stride, (GLvoid*)offset);
+			offset += 2 * sizeof(uint16_t);
+		}
+		if (m_HasNormals)
+		{
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, (GLsizei)stride, (GLvoid*)offset);
+			offset += 2 * sizeof(int16_t);
+		}
+		if (m_HasTangents)
+		{
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 3, GL_SHORT, GL_TRUE, (GLsizei)stride, (GLvoid*)offset);
+			offset += 4 * sizeof(int16_t);
+		}
+	}
+
+	bool PackedVertexLayout::operator==(const PackedVertexLayout& otherLayout) const
+	{
+		return m_QuantizedPositions == otherLayout.m_QuantizedPositions && m_HasUV == otherLayout.m_HasUV && m_HasNormals == otherLayout.m_HasNormals &&
+			m_HasTangents == otherLayout.m_HasTangents;
+	}
+
+	//==================================================================================================================
+
+	GeometryPool::GeometryPool(const PackedVertexLayout& vertexLayout, bool shortIndices, unsigned int poolIndex, size_t initialVertexCount, size_t initialIndexCount)
+		: m_VertexLayout(vertexLayout), m_ShortIndices(shortIndices), m_PoolIndex(poolIndex)
+	{
+		glGenVertexArrays(1, &m_VertexArrayID);
+		GrowVertexBuffer(initialVertexCount);
+		GrowIndexBuffer(initialIndexCount);
+	}
+
+	GeometryPool::~GeometryPool()
+	{
+		if (GLStateCache* stateCache = GLStateCache::RetrieveActiveCache())
+		{
+			stateCache->InvalidateVertexArray(m_VertexArrayID);
+		}
+		glDeleteVertexArrays(1, &m_VertexArrayID);
+		glDeleteBuffers(1, &m_VertexBufferID);
+		glDeleteBuffers(1, &m_IndexBufferID);
+	}
+
+	GeometryAllocation GeometryPool::Allocate(size_t vertexCount, size_t indexCount)
+	{
+		GeometryAllocation allocation;
+		allocation.m_Pool = this;
+		allocation.m_VertexCount = vertexCount;
+		allocation.m_IndexCount = indexCount;
+
+		allocation.m_BaseVertex = m_VertexAllocator.Allocate(vertexCount);
+		if (allocation.m_BaseVertex == InvalidAllocationOffset)
+		{
+			GrowVertexBuffer(vertexCount);
+			allocation.m_BaseVertex = m_VertexAllocator.Allocate(vertexCount);
+		}
+
+		allocation.m_FirstIndex = m_IndexAllocator.Allocate(indexCount);
+		if (allocation.m_FirstIndex == InvalidAllocationOffset)
+		{
+			GrowIndexBuffer(indexCount);
+			allocation.m_FirstIndex = m_IndexAllocator.Allocate(indexCount);
+		}
+		return allocation;
+	}
+
+	void GeometryPool::Free(const GeometryAllocation& allocation)
+	{
+		m_VertexAllocator.Free(allocation.m_BaseVertex, allocation.m_VertexCount);
+		m_IndexAllocator.Free(allocation.m_FirstIndex, allocation.m_IndexCount);
+	}
+
+	void GeometryPool::UploadVertexData(const GeometryAllocation& allocation, const void* vertexData)
+	{
+		//Uploads go through the copy target, leaving the array and element buffer bindings untouched.
+		size_t stride = m_VertexLayout.RetrieveStride();
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBufferID);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.m_BaseVertex * stride, allocation.m_VertexCount * stride, vertexData);
+	}
+
+	void GeometryPool::UploadIndexData(const GeometryAllocation& allocation, const void* indexData)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBufferID);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.m_FirstIndex * RetrieveIndexSize(), allocation.m_IndexCount * RetrieveIndexSize(), indexData);
+	}
+
+	uint8_t* GeometryPool::MapVertexData(const GeometryAllocation& allocation)
+	{
+		size_t stride = m_VertexLayout.RetrieveStride();
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBufferID);
+		return (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, allocation.m_BaseVertex * stride, allocation.m_VertexCount * stride, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+
+	bool GeometryPool::UnmapVertexData()
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBufferID);
+		return glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+	}
+
+	uint8_t* GeometryPool::MapIndexData(const GeometryAllocation& allocation)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBufferID);
+		return (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, allocation.m_FirstIndex * RetrieveIndexSize(), allocation.m_IndexCount * RetrieveIndexSize(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	}
+
+	bool GeometryPool::UnmapIndexData()
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBufferID);
+		return glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+	}
+
+	unsigned int GeometryPool::RetrieveIndexType() const
+	{
+		return m_ShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+
+	size_t GeometryPool::RetrieveIndexSize() const
+	{
+		return m_ShortIndices ? sizeof(uint16_t) : sizeof(unsigned int);
+	}
+
+	void GeometryPool::ResizeBuffer(unsigned int& bufferID, size_t previousByteSize, size_t newByteSize)
+	{
+		unsigned int newBufferID = 0;
+		glGenBuffers(1, &newBufferID);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newBufferID);
+		glBufferData(GL_COPY_WRITE_BUFFER, newByteSize, nullptr, GL_STATIC_DRAW);
+
+		if (bufferID)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, previousByteSize);
+			glDeleteBuffers(1, &bufferID);
+		}
+		bufferID = newBufferID;
+	}
+
+	size_t GeometryPool::RetrieveGrownCapacity(size_t previousCapacity, size_t minimumCount, size_t minimumCapacity)
+	{
+		//Doubling keeps the number of copies logarithmic in the amount of geometry loaded.
+		if (previousCapacity > 0)
+		{
+			return std::max(previousCapacity * 2, previousCapacity + minimumCount);
+		}
+
+		size_t newCapacity = minimumCapacity;
+		while (newCapacity < minimumCount)
+		{
+			newCapacity *= 2;
+		}
+		return newCapacity;
+	}
+
+	void GeometryPool::GrowVertexBuffer(size_t minimumVertexCount)
+	{
+		size_t previousCapacity = m_VertexAllocator.RetrieveCapacity();
+		size_t newCapacity = RetrieveGrownCapacity(previousCapacity, minimumVertexCount, m_MinimumVertexCapacity);
+		size_t stride = m_VertexLayout.RetrieveStride();
+		ResizeBuffer(m_VertexBufferID, previousCapacity * stride, newCapacity * stride);
+		m_VertexAllocator.Grow(newCapacity);
+		ConfigureVertexArray();
+
+		if (previousCapacity > 0)
+		{
+			CrescentInfo("Geometry pool " << m_PoolIndex << " grown to " << newCapacity << " vertices.");
+		}
+	}
+
+	void GeometryPool::GrowIndexBuffer(size_t minimumIndexCount)
+	{
+		size_t previousCapacity = m_IndexAllocator.RetrieveCapacity();
+		size_t newCapacity = RetrieveGrownCapacity(previousCapacity, minimumIndexCount, m_MinimumIndexCapacity);
+		ResizeBuffer(m_IndexBufferID, previousCapacity * RetrieveIndexSize(), newCapacity * RetrieveIndexSize());
+		m_IndexAllocator.Grow(newCapacity);
+		ConfigureVertexArray();
+
+		if (previousCapacity > 0)
+		{
+			CrescentInfo("Geometry pool " << m_PoolIndex << " grown to " << newCapacity << " indices.");
+		}
+	}
+
+	void GeometryPool::ConfigureVertexArray()
+	{
+		//Instance attributes point at their own buffer and are left as they are.
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), m_VertexArrayID);
+		glBindBuffer(GL_ARRAY_BUFFER, m_VertexBufferID);
+		m_VertexLayout.ConfigureAttributes();
+		if (m_IndexBufferID)
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBufferID);
+		}
+		GLStateCache::BindVertexArray(GLStateCache::RetrieveActiveCache(), 0);
+	}
+
+	//==================================================================================================================
+
+	GeometryArena::GeometryArena()
+	{
+		m_ActiveArena = this;
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+		for (GeometryPool* pool : m_Pools)
+		{
+			delete pool;
+		}
+
+		if (m_ActiveArena == this)
+		{
+			m_ActiveArena = nullptr;
+		}
+	}
+
+	GeometryAllocation GeometryArena::Allocate(const PackedVertexLayout& vertexLayout, bool shortIndices, size_t vertexCount, size_t indexCount)
+	{
+		GeometryPool* matchingPool = nullptr;
+		for (GeometryPool* pool : m_Pools)
+		{
+			if (pool->RetrieveVertexLayout() == vertexLayout && pool->UsesShortIndices() == shortIndices)
+			{
+				matchingPool = pool;
+				break;
+			}
+		}
+
+		if (!matchingPool)
+		{
+			matchingPool = new GeometryPool(vertexLayout, shortIndices, (unsigned int)m_Pools.size(), vertexCount, indexCount);
+			m_Pools.push_back(matchingPool);
+		}
+
+		GeometryAllocation allocation = matchingPool->Allocate(vertexCount, indexCount);
+		allocation.m_AllocationID = m_NextAllocationID++;
+		return allocation;
+	}
+
+	void GeometryArena::Free(GeometryAllocation& allocation)
+	{
+		if (allocation.m_Pool)
+		{
+			allocation.m_Pool->Free(allocation);
+			allocation = GeometryAllocation();
+		}
+	}
+}
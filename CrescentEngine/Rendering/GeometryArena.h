@@ -0,0 +1,133 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "../Memory/FreeListAllocator.h"
+
+namespace Crescent
+{
+	class GeometryPool;
+
+	//Attributes of a packed vertex, as laid out by Mesh's packed vertex formats. Meshes sharing a layout and index type share a geometry pool.
+	struct PackedVertexLayout
+	{
+		bool m_QuantizedPositions = false;
+		bool m_HasUV = false;
+		bool m_HasNormals = false;
+		bool m_HasTangents = false;
+
+		//Every attribute starts on a 4 byte boundary. Quantized positions carry a fourth, unused component for this reason.
+		size_t RetrievePositionSize() const;
+		size_t RetrieveStride() const;
+		//Points the attributes of the bound vertex array at the bound array buffer, starting at the given byte offset.
+		void ConfigureAttributes(size_t byteOffset = 0) const;
+
+		bool operator==(const PackedVertexLayout& otherLayout) const;
+	};
+
+	//A mesh's share of a geometry pool. Its indices are relative to its base vertex, so they never change wherever the mesh ends up.
+	struct GeometryAllocation
+	{
+		GeometryPool* m_Pool = nullptr;
+		size_t m_BaseVertex = 0;
+		size_t m_VertexCount = 0;
+		size_t m_FirstIndex = 0;
+		size_t m_IndexCount = 0;
+		unsigned int m_AllocationID = 0; //Unique within the arena, telling apart meshes sharing a vertex array in sort keys.
+	};
+
+	/*
+		One large vertex buffer and one large index buffer, suballocated through free lists, along with a single vertex array describing them. Buffers
+		grow by doubling, with their contents copied over on the GPU, and the vertex array is repointed at the new buffers.
+	*/
+
+	class GeometryPool
+	{
+	public:
+		//Buffers start out sized to the first mesh the pool is created for, so layouts used by few meshes take little memory.
+		GeometryPool(const PackedVertexLayout& vertexLayout, bool shortIndices, unsigned int poolIndex, size_t initialVertexCount, size_t initialIndexCount);
+		~GeometryPool();
+
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		//Reserves ranges for the given number of vertices and indices, growing the buffers if needed.
+		GeometryAllocation Allocate(size_t vertexCount, size_t indexCount);
+		void Free(const GeometryAllocation& allocation);
+
+		//Copies a whole allocation's worth of data into the buffers. Indices are expected in the pool's index type.
+		void UploadVertexData(const GeometryAllocation& allocation, const void* vertexData);
+		void UploadIndexData(const GeometryAllocation& allocation, const void* indexData);
+		//Maps an allocation's range for writing, letting callers fill it in place. Its previous contents are discarded. Returns nullptr if mapping fails,
+		//and unmapping returns false if the contents were lost meanwhile, in which case they have to be uploaded again.
+		uint8_t* MapVertexData(const GeometryAllocation& allocation);
+		bool UnmapVertexData();
+		uint8_t* MapIndexData(const GeometryAllocation& allocation);
+		bool UnmapIndexData();
+
+		const PackedVertexLayout& RetrieveVertexLayout() const { return m_VertexLayout; }
+		bool UsesShortIndices() const { return m_ShortIndices; }
+		unsigned int RetrieveIndexType() const;
+		size_t RetrieveIndexSize() const;
+		unsigned int RetrieveVertexArrayID() const { return m_VertexArrayID; }
+		unsigned int RetrievePoolIndex() const { return m_PoolIndex; }
+
+		size_t RetrieveVertexCapacity() const { return m_VertexAllocator.RetrieveCapacity(); }
+		size_t RetrieveIndexCapacity() const { return m_IndexAllocator.RetrieveCapacity(); }
+		size_t RetrieveUsedVertexCount() const { return m_VertexAllocator.RetrieveCapacity() - m_VertexAllocator.RetrieveFreeSize(); }
+		size_t RetrieveUsedIndexCount() const { return m_IndexAllocator.RetrieveCapacity() - m_IndexAllocator.RetrieveFreeSize(); }
+
+	private:
+		//Reallocates a buffer at the new size, keeping its contents.
+		static void ResizeBuffer(unsigned int& bufferID, size_t previousByteSize, size_t newByteSize);
+		//Capacity after growing to fit the given count, doubling any previous capacity. Fresh buffers are rounded up to a power of two.
+		static size_t RetrieveGrownCapacity(size_t previousCapacity, size_t minimumCount, size_t minimumCapacity);
+		void GrowVertexBuffer(size_t minimumVertexCount);
+		void GrowIndexBuffer(size_t minimumIndexCount);
+		void ConfigureVertexArray();
+
+	private:
+		static const size_t m_MinimumVertexCapacity = 1 << 12;
+		static const size_t m_MinimumIndexCapacity = 1 << 14;
+
+		PackedVertexLayout m_VertexLayout;
+		bool m_ShortIndices = false;
+		unsigned int m_PoolIndex = 0;
+
+		unsigned int m_VertexArrayID = 0;
+		unsigned int m_VertexBufferID = 0;
+		unsigned int m_IndexBufferID = 0;
+		FreeListAllocator m_VertexAllocator;
+		FreeListAllocator m_IndexAllocator;
+	};
+
+	/*
+		Owns a geometry pool per packed vertex layout and index type, so that meshes become ranges within a few large buffers rather than owning buffers
+		and a vertex array each. Meshes drawn one after another then share their vertex array, and draws of many meshes can be merged into a single
+		multi-draw. As with the state cache, the most recently created arena is made available through RetrieveActiveArena() for meshes to upload into.
+	*/
+
+	class GeometryArena
+	{
+	public:
+		GeometryArena();
+		~GeometryArena();
+
+		GeometryArena(const GeometryArena&) = delete;
+		GeometryArena& operator=(const GeometryArena&) = delete;
+
+		GeometryAllocation Allocate(const PackedVertexLayout& vertexLayout, bool shortIndices, size_t vertexCount, size_t indexCount);
+		void Free(GeometryAllocation& allocation);
+
+		size_t RetrievePoolCount() const { return m_Pools.size(); }
+		const GeometryPool* RetrievePool(size_t poolIndex) const { return m_Pools[poolIndex]; }
+
+		static GeometryArena* RetrieveActiveArena() { return m_ActiveArena; }
+
+	private:
+		static GeometryArena* m_ActiveArena;
+
+		std::vector<GeometryPool*> m_Pools;
+		unsigned int m_NextAllocationID = 0;
+	};
+}
@@ -0,0 +1,43 @@
+#include "CrescentPCH.h"
+#include "IndirectCommandBuilder.h"
+
+namespace Crescent
+{
+	void IndirectCommandBuilder::Clear()
+	{
+		m_Commands.clear();
+		m_Groups.clear();
+	}
+
+	void IndirectCommandBuilder::PushDraw(Material* material, Mesh* mesh, GeometryPool* geometryPool, const DrawElementsIndirectCommand& drawCommand)
+	{
+		if (drawCommand.m_IndexCount == 0 || drawCommand.m_InstanceCount == 0)
+		{
+			return;
+		}
+
+		if (!m_Groups.empty() && m_Groups.back().m_Material == material && m_Groups.back().m_GeometryPool == geometryPool)
+		{
+			DrawElementsIndirectCommand& previousCommand = m_Commands.back();
+			if (previousCommand.m_FirstIndex == drawCommand.m_FirstIndex && previousCommand.m_IndexCount == drawCommand.m_IndexCount &&
+				previousCommand.m_BaseVertex == drawCommand.m_BaseVertex && previousCommand.m_BaseInstance + previousCommand.m_InstanceCount == drawCommand.m_BaseInstance)
+			{
+				previousCommand.m_InstanceCount += drawCommand.m_InstanceCount;
+				return;
+			}
+
+			m_Commands.push_back(drawCommand);
+			m_Groups.back().m_CommandCount++;
+			return;
+		}
+
+		IndirectDrawGroup drawGroup;
+		drawGroup.m_Material = material;
+		drawGroup.m_GeometryPool = geometryPool;
+		drawGroup.m_Mesh = mesh;
+		drawGroup.m_FirstCommand = (uint32_t)m_Commands.size();
+		drawGroup.m_CommandCount = 1;
+		m_Groups.push_back(drawGroup);
+		m_Commands.push_back(drawCommand);
+	}
+}
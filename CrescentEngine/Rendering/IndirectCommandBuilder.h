@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace Crescent
+{
+	class Material;
+	class Mesh;
+	class GeometryPool;
+
+	//Laid out as glMultiDrawElementsIndirect reads its commands.
+	struct DrawElementsIndirectCommand
+	{
+		uint32_t m_IndexCount;
+		uint32_t m_InstanceCount;
+		uint32_t m_FirstIndex;
+		int32_t m_BaseVertex;
+		uint32_t m_BaseInstance;
+	};
+
+	//A run of commands drawn with a single multi-draw. Every command shares the group's material and indexes into the same geometry pool.
+	struct IndirectDrawGroup
+	{
+		Material* m_Material;
+		GeometryPool* m_GeometryPool;
+		Mesh* m_Mesh; //The group's first mesh, standing in for the others when binding per-object uniforms.
+		uint32_t m_FirstCommand;
+		uint32_t m_CommandCount;
+	};
+
+	/*
+		Gathers draws into indirect commands, grouped by material and geometry pool, so that each group costs one draw call however many meshes it holds.
+		Draws are expected in sorted order, where draws sharing a group already sit next to each other. Commands continuing the previous one's instances
+		over the same indices are folded into it, growing its instance count.
+
+		Building commands only touches CPU data and never calls into OpenGL. Uploading them is left to the renderer.
+	*/
+
+	class IndirectCommandBuilder
+	{
+	public:
+		void Clear();
+		void PushDraw(Material* material, Mesh* mesh, GeometryPool* geometryPool, const DrawElementsIndirectCommand& drawCommand);
+
+		const std::vector<DrawElementsIndirectCommand>& RetrieveCommands() const { return m_Commands; }
+		const std::vector<IndirectDrawGroup>& RetrieveGroups() const { return m_Groups; }
+
+	private:
+		std::vector<DrawElementsIndirectCommand> m_Commands;
+		std::vector<IndirectDrawGroup> m_Groups;
+	};
+}
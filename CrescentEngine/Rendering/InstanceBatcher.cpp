@@ -0,0 +1,36 @@
+#include "CrescentPCH.h"
+#include "InstanceBatcher.h"
+#include "../Models/Mesh.h"
+
+namespace Crescent
+{
+	void InstanceBatcher::FormInstanceBatches(const RenderCommandList& renderCommands, bool matchMaterials, std::vector<InstanceBatch>& instanceBatches, std::vector<InstanceData>& instanceData)
+	{
+		instanceBatches.clear();
+		instanceData.resize(renderCommands.size());
+
+		for (uint32_t i = 0; i < renderCommands.size(); i++)
+		{
+			const RenderCommand& renderCommand = renderCommands[i];
+			instanceData[i].m_Transform = renderCommand.m_Transform;
+			instanceData[i].m_PositionOffset = glm::vec4(renderCommand.m_Mesh->RetrievePositionOffset(), 0.0f);
+			instanceData[i].m_PositionScale = glm::vec4(renderCommand.m_Mesh->RetrievePositionScale(), 0.0f);
+
+			if (!instanceBatches.empty())
+			{
+				//Compare against the pointers themselves rather than sort keys, as truncated key fields may collide.
+				const RenderCommand& batchCommand = renderCommands[instanceBatches.back().m_FirstCommand];
+				if (batchCommand.m_Mesh == renderCommand.m_Mesh && batchCommand.m_LODIndex == renderCommand.m_LODIndex && (!matchMaterials || batchCommand.m_Material == renderCommand.m_Material))
+				{
+					instanceBatches.back().m_InstanceCount++;
+					continue;
+				}
+			}
+
+			InstanceBatch instanceBatch;
+			instanceBatch.m_FirstCommand = i;
+			instanceBatch.m_InstanceCount = 1;
+			instanceBatches.push_back(instanceBatch);
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "RenderCommand.h"
+#include <vector>
+
+namespace Crescent
+{
+	//Per-instance vertex attributes, read from locations 9 to 14. Positions are dequantized per instance rather than per draw, as meshes packed with
+	//different bounds may share a multi-draw.
+	struct InstanceData
+	{
+		glm::mat4 m_Transform;
+		glm::vec4 m_PositionOffset;
+		glm::vec4 m_PositionScale;
+	};
+
+	struct InstanceBatch
+	{
+		uint32_t m_FirstCommand;  //Index of the batch's first command, which is also the base instance of its data in the instance buffer.
+		uint32_t m_InstanceCount;
+	};
+
+	/*
+		Collapses runs of adjacent render commands that share the same mesh and level of detail (and material, when requested) into instanced batches. As the render queue is
+		sorted by state, identical pairs already sit next to each other. Batch formation only touches CPU data and never calls into OpenGL.
+
+		Instance data is gathered in command order, meaning a batch's instances start at its first command's index.
+	*/
+
+	class InstanceBatcher
+	{
+	public:
+		static void FormInstanceBatches(const RenderCommandList& renderCommands, bool matchMaterials, std::vector<InstanceBatch>& instanceBatches, std::vector<InstanceData>& instanceData);
+	};
+}
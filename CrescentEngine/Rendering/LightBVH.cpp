@@ -0,0 +1,163 @@
+#include "CrescentPCH.h"
+#include "LightBVH.h"
+#include "../Utilities/Frustum.h"
+#include <algorithm>
+
+namespace Crescent
+{
+	static BoundingBox RetrieveSphereBounds(const BoundingSphere& boundingSphere)
+	{
+		BoundingBox boundingBox;
+		boundingBox.m_Minimum = boundingSphere.m_Center - glm::vec3(boundingSphere.m_Radius);
+		boundingBox.m_Maximum = boundingSphere.m_Center + glm::vec3(boundingSphere.m_Radius);
+		return boundingBox;
+	}
+
+	void LightBVH::UpdateHierarchy(const std::vector<BoundingSphere>& lightSpheres)
+	{
+		if (lightSpheres.size() != m_LightSpheres.size())
+		{
+			m_LightSpheres = lightSpheres;
+			BuildHierarchy();
+			return;
+		}
+
+		bool lightsChanged = false;
+		for (unsigned int i = 0; i < lightSpheres.size() && !lightsChanged; i++)
+		{
+			lightsChanged = lightSpheres[i].m_Center != m_LightSpheres[i].m_Center || lightSpheres[i].m_Radius != m_LightSpheres[i].m_Radius;
+		}
+
+		if (lightsChanged)
+		{
+			m_LightSpheres = lightSpheres;
+			RefitHierarchy();
+		}
+	}
+
+	void LightBVH::BuildHierarchy()
+	{
+		m_Nodes.clear();
+		m_LightIndices.resize(m_LightSpheres.size());
+		for (uint32_t i = 0; i < m_LightIndices.size(); i++)
+		{
+			m_LightIndices[i] = i;
+		}
+
+		if (!m_LightSpheres.empty())
+		{
+			m_Nodes.reserve(m_LightSpheres.size() / m_MaximumLeafLights * 2 + 1);
+			m_Nodes.emplace_back();
+			BuildNode(0, 0, (uint32_t)m_LightSpheres.size());
+		}
+	}
+
+	void LightBVH::BuildNode(uint32_t nodeIndex, uint32_t firstLight, uint32_t lightCount)
+	{
+		BoundingBox nodeBounds;
+		BoundingBox centerBounds;
+		for (uint32_t i = firstLight; i < firstLight + lightCount; i++)
+		{
+			BoundingBox sphereBounds = RetrieveSphereBounds(m_LightSpheres[m_LightIndices[i]]);
+			nodeBounds.Merge(sphereBounds.m_Minimum);
+			nodeBounds.Merge(sphereBounds.m_Maximum);
+			centerBounds.Merge(m_LightSpheres[m_LightIndices[i]].m_Center);
+		}
+
+		m_Nodes[nodeIndex].m_Bounds = nodeBounds;
+		m_Nodes[nodeIndex].m_FirstLight = firstLight;
+		m_Nodes[nodeIndex].m_LightCount = lightCount;
+		if (lightCount <= m_MaximumLeafLights)
+		{
+			return;
+		}
+
+		//Median split along the axis the light centers spread furthest on. This always halves the range, so the depth stays logarithmic.
+		glm::vec3 centerSpread = centerBounds.m_Maximum - centerBounds.m_Minimum;
+		int splitAxis = centerSpread.x > centerSpread.y ? (centerSpread.x > centerSpread.z ? 0 : 2) : (centerSpread.y > centerSpread.z ? 1 : 2);
+
+		uint32_t halfCount = lightCount / 2;
+		uint32_t* lightRange = m_LightIndices.data() + firstLight;
+		std::nth_element(lightRange, lightRange + halfCount, lightRange + lightCount, [this, splitAxis](uint32_t leftLight, uint32_t rightLight)
+		{
+			return m_LightSpheres[leftLight].m_Center[splitAxis] < m_LightSpheres[rightLight].m_Center[splitAxis];
+		});
+
+		//Both children are allocated together before either is built, so the right child always sits right after the left one.
+		uint32_t leftChild = (uint32_t)m_Nodes.size();
+		m_Nodes[nodeIndex].m_LeftChild = leftChild;
+		m_Nodes.resize(m_Nodes.size() + 2);
+		BuildNode(leftChild, firstLight, halfCount);
+		BuildNode(leftChild + 1, firstLight + halfCount, lightCount - halfCount);
+	}
+
+	void LightBVH::RefitHierarchy()
+	{
+		//Children always come after their parent, so walking the nodes backwards visits both children before their parent.
+		for (size_t i = m_Nodes.size(); i-- > 0;)
+		{
+			BVHNode& node = m_Nodes[i];
+			node.m_Bounds = BoundingBox();
+			if (node.m_LeftChild == 0)
+			{
+				for (uint32_t j = node.m_FirstLight; j < node.m_FirstLight + node.m_LightCount; j++)
+				{
+					BoundingBox sphereBounds = RetrieveSphereBounds(m_LightSpheres[m_LightIndices[j]]);
+					node.m_Bounds.Merge(sphereBounds.m_Minimum);
+					node.m_Bounds.Merge(sphereBounds.m_Maximum);
+				}
+			}
+			else
+			{
+				for (uint32_t j = node.m_LeftChild; j < node.m_LeftChild + 2; j++)
+				{
+					node.m_Bounds.Merge(m_Nodes[j].m_Bounds.m_Minimum);
+					node.m_Bounds.Merge(m_Nodes[j].m_Bounds.m_Maximum);
+				}
+			}
+		}
+	}
+
+	void LightBVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& visibleLights) const
+	{
+		visibleLights.clear();
+		if (m_Nodes.empty())
+		{
+			return;
+		}
+
+		//Median splits keep the tree balanced, so 64 entries covers far more lights than we'll ever have.
+		uint32_t nodeStack[64];
+		unsigned int stackSize = 0;
+		nodeStack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = m_Nodes[nodeStack[--stackSize]];
+			if (!frustum.IntersectsBoundingBox(node.m_Bounds))
+			{
+				continue;
+			}
+
+			if (frustum.ContainsBoundingBox(node.m_Bounds))
+			{
+				visibleLights.insert(visibleLights.end(), m_LightIndices.begin() + node.m_FirstLight, m_LightIndices.begin() + node.m_FirstLight + node.m_LightCount);
+			}
+			else if (node.m_LeftChild == 0)
+			{
+				for (uint32_t i = node.m_FirstLight; i < node.m_FirstLight + node.m_LightCount; i++)
+				{
+					if (frustum.IntersectsBoundingSphere(m_LightSpheres[m_LightIndices[i]]))
+					{
+						visibleLights.push_back(m_LightIndices[i]);
+					}
+				}
+			}
+			else
+			{
+				nodeStack[stackSize++] = node.m_LeftChild;
+				nodeStack[stackSize++] = node.m_LeftChild + 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "../Utilities/Bounds.h"
+
+namespace Crescent
+{
+	class Frustum;
+
+	/*
+		Bounding volume hierarchy over light spheres, letting frustum queries reject or accept whole groups of lights with a single box test.
+
+		Nodes are split at the median light along their widest axis, and every node owns a contiguous range of the light index list. A node found fully
+		inside the frustum thus hands over its whole range without testing any of its lights. Lights rarely come and go, so the tree is only rebuilt when
+		their count changes. Moved lights are handled by refitting the node bounds bottom up.
+	*/
+
+	class LightBVH
+	{
+	public:
+		//Rebuilds or refits the hierarchy for this frame's light spheres.
+		void UpdateHierarchy(const std::vector<BoundingSphere>& lightSpheres);
+
+		//Writes the indices of all lights intersecting the frustum into visibleLights, in no particular order.
+		void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& visibleLights) const;
+
+		size_t RetrieveNodeCount() const { return m_Nodes.size(); }
+
+	private:
+		struct BVHNode
+		{
+			BoundingBox m_Bounds;
+			uint32_t m_FirstLight = 0; //Into m_LightIndices.
+			uint32_t m_LightCount = 0;
+			uint32_t m_LeftChild = 0; //The right child directly follows the left one. Leaves have none, marked with 0 as the root is never a child.
+		};
+
+		void BuildHierarchy();
+		void BuildNode(uint32_t nodeIndex, uint32_t firstLight, uint32_t lightCount);
+		void RefitHierarchy();
+
+	private:
+		static const uint32_t m_MaximumLeafLights = 4;
+
+		std::vector<BVHNode> m_Nodes;
+		std::vector<uint32_t> m_LightIndices;
+		std::vector<BoundingSphere> m_LightSpheres;
+	};
+}
@@ -0,0 +1,147 @@
+#include "CrescentPCH.h"
+#include "LightClusterGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Crescent
+{
+	LightClusterGrid::LightClusterGrid(unsigned int tileCountX, unsigned int tileCountY, unsigned int depthSliceCount)
+	{
+		m_TileCountX = tileCountX;
+		m_TileCountY = tileCountY;
+		m_DepthSliceCount = depthSliceCount;
+
+		m_ColumnPlanes.resize(tileCountX + 1);
+		m_RowPlanes.resize(tileCountY + 1);
+		m_Clusters.resize(tileCountX * tileCountY * depthSliceCount);
+	}
+
+	void LightClusterGrid::AssignLights(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float nearClip, float farClip, const std::vector<ClusterLight>& lights)
+	{
+		m_NearClip = nearClip;
+		m_DepthSliceScale = (float)m_DepthSliceCount / std::log(farClip / nearClip);
+
+		//A boundary at NDC coordinate n holds the view space points where offset = n * tanHalfFov * depth. Its normalized plane equation is
+		//(offset - slope * depth) / sqrt(1 + slope^2), positive on the side of increasing NDC coordinates.
+		float tanHalfFovX = 1.0f / projectionMatrix[0][0];
+		float tanHalfFovY = 1.0f / projectionMatrix[1][1];
+		for (unsigned int i = 0; i <= m_TileCountX; i++)
+		{
+			float slope = (-1.0f + 2.0f * i / m_TileCountX) * tanHalfFovX;
+			m_ColumnPlanes[i] = glm::vec2(1.0f, -slope) / std::sqrt(1.0f + slope * slope);
+		}
+		for (unsigned int i = 0; i <= m_TileCountY; i++)
+		{
+			float slope = (-1.0f + 2.0f * i / m_TileCountY) * tanHalfFovY;
+			m_RowPlanes[i] = glm::vec2(1.0f, -slope) / std::sqrt(1.0f + slope * slope);
+		}
+
+		//1) Find the cluster range each light touches, counting its entries per cluster.
+		for (unsigned int i = 0; i < m_Clusters.size(); i++)
+		{
+			m_Clusters[i].m_LightCount = 0;
+		}
+		m_LightRanges.clear();
+		m_LightRangeIndices.clear();
+
+		for (uint32_t i = 0; i < lights.size(); i++)
+		{
+			glm::vec3 viewPosition = glm::vec3(viewMatrix * glm::vec4(glm::vec3(lights[i].m_PositionRadius), 1.0f));
+			float viewDepth = -viewPosition.z;
+			float radius = lights[i].m_PositionRadius.w;
+			if (viewDepth + radius < nearClip || viewDepth - radius > farClip)
+			{
+				continue;
+			}
+
+			ClusterRange clusterRange;
+			if (!CalculateTileRange(m_ColumnPlanes, viewPosition.x, viewDepth, radius, clusterRange.m_MinimumX, clusterRange.m_MaximumX) ||
+				!CalculateTileRange(m_RowPlanes, viewPosition.y, viewDepth, radius, clusterRange.m_MinimumY, clusterRange.m_MaximumY))
+			{
+				continue;
+			}
+			clusterRange.m_MinimumZ = (uint16_t)CalculateDepthSlice(viewDepth - radius);
+			clusterRange.m_MaximumZ = (uint16_t)CalculateDepthSlice(viewDepth + radius);
+
+			for (unsigned int z = clusterRange.m_MinimumZ; z <= clusterRange.m_MaximumZ; z++)
+			{
+				for (unsigned int y = clusterRange.m_MinimumY; y <= clusterRange.m_MaximumY; y++)
+				{
+					unsigned int rowIndex = (z * m_TileCountY + y) * m_TileCountX;
+					for (unsigned int x = clusterRange.m_MinimumX; x <= clusterRange.m_MaximumX; x++)
+					{
+						m_Clusters[rowIndex + x].m_LightCount++;
+					}
+				}
+			}
+
+			m_LightRanges.push_back(clusterRange);
+			m_LightRangeIndices.push_back(i);
+		}
+
+		//2) Give each cluster its slice of the index list.
+		uint32_t lightOffset = 0;
+		for (unsigned int i = 0; i < m_Clusters.size(); i++)
+		{
+			m_Clusters[i].m_LightOffset = lightOffset;
+			lightOffset += m_Clusters[i].m_LightCount;
+			m_Clusters[i].m_LightCount = 0;
+		}
+		m_LightIndices.resize(lightOffset);
+
+		//3) Fill in the indices. Counts are rebuilt as we go, leaving each cluster's lights in ascending order.
+		for (unsigned int i = 0; i < m_LightRanges.size(); i++)
+		{
+			const ClusterRange& clusterRange = m_LightRanges[i];
+			for (unsigned int z = clusterRange.m_MinimumZ; z <= clusterRange.m_MaximumZ; z++)
+			{
+				for (unsigned int y = clusterRange.m_MinimumY; y <= clusterRange.m_MaximumY; y++)
+				{
+					unsigned int rowIndex = (z * m_TileCountY + y) * m_TileCountX;
+					for (unsigned int x = clusterRange.m_MinimumX; x <= clusterRange.m_MaximumX; x++)
+					{
+						LightCluster& lightCluster = m_Clusters[rowIndex + x];
+						m_LightIndices[lightCluster.m_LightOffset + lightCluster.m_LightCount++] = m_LightRangeIndices[i];
+					}
+				}
+			}
+		}
+	}
+
+	unsigned int LightClusterGrid::CalculateDepthSlice(float viewDepth) const
+	{
+		if (viewDepth <= m_NearClip)
+		{
+			return 0;
+		}
+
+		int depthSlice = (int)(std::log(viewDepth / m_NearClip) * m_DepthSliceScale);
+		return (unsigned int)std::min(depthSlice, (int)m_DepthSliceCount - 1);
+	}
+
+	bool LightClusterGrid::CalculateTileRange(const std::vector<glm::vec2>& boundaryPlanes, float sphereOffset, float sphereDepth, float sphereRadius, uint16_t& minimumTile, uint16_t& maximumTile) const
+	{
+		//Tile i lies between boundaries i and i + 1. Signed distances fall as the boundaries move across the screen, so we walk in from both ends.
+		unsigned int tileCount = (unsigned int)boundaryPlanes.size() - 1;
+		unsigned int firstTile = 0;
+		while (firstTile < tileCount && boundaryPlanes[firstTile + 1].x * sphereOffset + boundaryPlanes[firstTile + 1].y * sphereDepth > sphereRadius)
+		{
+			firstTile++;
+		}
+
+		int lastTile = (int)tileCount - 1;
+		while (lastTile >= (int)firstTile && boundaryPlanes[lastTile].x * sphereOffset + boundaryPlanes[lastTile].y * sphereDepth < -sphereRadius)
+		{
+			lastTile--;
+		}
+
+		if (lastTile < (int)firstTile)
+		{
+			return false;
+		}
+
+		minimumTile = (uint16_t)firstTile;
+		maximumTile = (uint16_t)lastTile;
+		return true;
+	}
+}
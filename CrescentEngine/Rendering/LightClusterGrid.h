@@ -0,0 +1,74 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace Crescent
+{
+	//Mirrors the std430 light layout read by ClusteredPointLightFragment.shader.
+	struct ClusterLight
+	{
+		glm::vec4 m_PositionRadius; //World space position in xyz, radius in w.
+		glm::vec4 m_Color; //Intensity scaled color in xyz. W unused.
+	};
+
+	struct LightCluster
+	{
+		uint32_t m_LightOffset; //Into the light index list.
+		uint32_t m_LightCount;
+	};
+
+	/*
+		Divides the camera frustum into a grid of clusters - screen tiles split into exponentially spaced depth slices - and lists the point lights whose
+		volumes touch each cluster. Shading then only evaluates the lights listed for the cluster a pixel falls in, instead of drawing a volume per light.
+
+		Tiles are bounded by planes through the camera, so each light finds its tile range by testing its sphere against a handful of planes, rather than
+		against every cluster. The light index list is built with a counting pass and a prefix sum, so assignment allocates nothing once the lists have grown
+		to fit the scene. This class has no GPU dependencies; uploading its lists is up to the caller.
+	*/
+
+	class LightClusterGrid
+	{
+	public:
+		LightClusterGrid(unsigned int tileCountX = 16, unsigned int tileCountY = 9, unsigned int depthSliceCount = 24);
+
+		//Expects a symmetric perspective projection matrix, whose near and far clips are passed along.
+		void AssignLights(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float nearClip, float farClip, const std::vector<ClusterLight>& lights);
+
+		const std::vector<LightCluster>& RetrieveClusters() const { return m_Clusters; }
+		const std::vector<uint32_t>& RetrieveLightIndices() const { return m_LightIndices; }
+		glm::uvec3 RetrieveGridDimensions() const { return glm::uvec3(m_TileCountX, m_TileCountY, m_DepthSliceCount); }
+
+		//A view depth's slice is floor(log(depth / nearClip) * sliceScale), matching the lookup done in shaders.
+		float RetrieveNearClip() const { return m_NearClip; }
+		float RetrieveDepthSliceScale() const { return m_DepthSliceScale; }
+
+	private:
+		struct ClusterRange
+		{
+			uint16_t m_MinimumX, m_MaximumX;
+			uint16_t m_MinimumY, m_MaximumY;
+			uint16_t m_MinimumZ, m_MaximumZ;
+		};
+
+		unsigned int CalculateDepthSlice(float viewDepth) const;
+		//Finds the tiles between boundary planes a sphere overlaps. Returns false if it overlaps none.
+		bool CalculateTileRange(const std::vector<glm::vec2>& boundaryPlanes, float sphereOffset, float sphereDepth, float sphereRadius, uint16_t& minimumTile, uint16_t& maximumTile) const;
+
+	private:
+		unsigned int m_TileCountX;
+		unsigned int m_TileCountY;
+		unsigned int m_DepthSliceCount;
+		float m_NearClip = 0.1f;
+		float m_DepthSliceScale = 1.0f;
+
+		//Planes through the camera bounding each tile column and row. Each holds the normalized (offset, depth) coefficients of its plane equation.
+		std::vector<glm::vec2> m_ColumnPlanes;
+		std::vector<glm::vec2> m_RowPlanes;
+
+		std::vector<ClusterRange> m_LightRanges;
+		std::vector<uint32_t> m_LightRangeIndices; //Light each range belongs to, as culled lights get no range.
+		std::vector<LightCluster> m_Clusters;
+		std::vector<uint32_t> m_LightIndices;
+	};
+}
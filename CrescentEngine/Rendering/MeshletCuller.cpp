@@ -0,0 +1,57 @@
+#include "CrescentPCH.h"
+#include "MeshletCuller.h"
+#include "../Models/Mesh.h"
+#include "../Utilities/Frustum.h"
+
+namespace Crescent
+{
+	size_t MeshletCuller::CullMeshlets(const Mesh* mesh, const glm::mat4& transform, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, bool backFacesCulled)
+	{
+		m_DrawCounts.clear();
+		m_DrawFirstIndices.clear();
+		m_DrawOffsets.clear();
+		m_DrawBaseVertices.clear();
+
+		Frustum objectFrustum(viewProjection * transform);
+		glm::vec3 objectCameraPosition = glm::vec3(glm::inverse(transform) * glm::vec4(cameraPosition, 1.0f));
+
+		//Mirroring transforms flip the winding the rasterizer sees, turning our cones inside out.
+		bool coneCullingEnabled = backFacesCulled && glm::determinant(glm::mat3(transform)) > 0.0f;
+
+		size_t indexSize = mesh->RetrieveIndexSize();
+		size_t firstIndex = mesh->RetrieveIndexByteOffset(0) / indexSize;
+		size_t rangeEnd = 0; //End of the last range, in indices.
+		for (const Meshlet& meshlet : mesh->m_Meshlets)
+		{
+			bool meshletVisible = objectFrustum.IntersectsBoundingSphere(meshlet.m_BoundingSphere);
+			if (meshletVisible && coneCullingEnabled)
+			{
+				glm::vec3 viewOffset = meshlet.m_BoundingSphere.m_Center - objectCameraPosition;
+				meshletVisible = glm::dot(viewOffset, meshlet.m_ConeAxis) < meshlet.m_ConeCutoff * glm::length(viewOffset) + meshlet.m_BoundingSphere.m_Radius;
+			}
+
+			if (!meshletVisible)
+			{
+				m_CulledMeshletCount++;
+				continue;
+			}
+			m_VisibleMeshletCount++;
+
+			GLsizei indexCount = (GLsizei)meshlet.m_TriangleCount * 3;
+			if (!m_DrawCounts.empty() && rangeEnd == meshlet.m_IndexOffset)
+			{
+				m_DrawCounts.back() += indexCount;
+			}
+			else
+			{
+				m_DrawCounts.push_back(indexCount);
+				m_DrawFirstIndices.push_back((GLuint)(firstIndex + meshlet.m_IndexOffset));
+				m_DrawOffsets.push_back((const void*)((firstIndex + meshlet.m_IndexOffset) * indexSize));
+				m_DrawBaseVertices.push_back(mesh->RetrieveBaseVertex());
+			}
+			rangeEnd = meshlet.m_IndexOffset + indexCount;
+		}
+
+		return m_DrawCounts.size();
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Crescent
+{
+	class Mesh;
+
+	/*
+		Culls the meshlets of a mesh's full resolution level against a camera, testing their bounding spheres against the frustum and, where back faces
+		are culled anyway, their normal cones against the camera position. Both tests run in the mesh's object space, which is exact under any transform:
+		frustum planes are extracted straight from the model view projection matrix, and whether a point lies in front of a plane survives affine maps.
+
+		Surviving meshlets that are neighbours in the index buffer are merged into a single range, and the ranges are laid out both for
+		glMultiDrawElementsBaseVertex and, through their first indices, for indirect draw commands.
+	*/
+
+	class MeshletCuller
+	{
+	public:
+		//Gathers the draw ranges of the mesh's visible meshlets and returns their count. Zero means the whole mesh is culled.
+		size_t CullMeshlets(const Mesh* mesh, const glm::mat4& transform, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, bool backFacesCulled);
+
+		//Index counts, first indices, byte offsets and base vertices of the ranges found by the most recent cull. Offsets include the mesh's position within
+		//the geometry arena.
+		const GLsizei* RetrieveDrawCounts() const { return m_DrawCounts.data(); }
+		const GLuint* RetrieveDrawFirstIndices() const { return m_DrawFirstIndices.data(); }
+		const void* const* RetrieveDrawOffsets() const { return m_DrawOffsets.data(); }
+		const GLint* RetrieveDrawBaseVertices() const { return m_DrawBaseVertices.data(); }
+
+		//Statistics accumulated since the last reset.
+		void ResetStatistics() { m_VisibleMeshletCount = 0; m_CulledMeshletCount = 0; }
+		size_t RetrieveVisibleMeshletCount() const { return m_VisibleMeshletCount; }
+		size_t RetrieveCulledMeshletCount() const { return m_CulledMeshletCount; }
+
+	private:
+		std::vector<GLsizei> m_DrawCounts;
+		std::vector<GLuint> m_DrawFirstIndices;
+		std::vector<const void*> m_DrawOffsets;
+		std::vector<GLint> m_DrawBaseVertices;
+		size_t m_VisibleMeshletCount = 0;
+		size_t m_CulledMeshletCount = 0;
+	};
+}
@@ -37,7 +37,7 @@ namespace Crescent
 		m_PBRPrefilterCaptureMaterial->m_FaceCullingEnabled = false;
 
 		m_PBRCaptureCube = new Cube();
-		m_SceneEnvironmentCube = new SceneEntity("Scene Environment Cube", 0);
+		m_SceneEnvironmentCube = SceneEntity::CreateEntity("Scene Environment Cube");
 		m_SceneEnvironmentCube->m_Mesh = m_PBRCaptureCube;
 		m_SceneEnvironmentCube->m_Material = m_PBRHDRToCubemapMaterial;
 
@@ -48,7 +48,7 @@ namespace Crescent
 	PBR::~PBR()
 	{
 		delete m_PBRCaptureCube;
-		delete m_SceneEnvironmentCube;
+		SceneEntity::DestroyEntity(m_SceneEnvironmentCube);
 		delete m_RenderTargetBRDFLUT;
 		delete m_PBRHDRToCubemapMaterial;
 		delete m_PBRIrradianceCaptureMaterial;
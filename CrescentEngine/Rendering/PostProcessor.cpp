@@ -6,6 +6,7 @@
 #include "../Utilities/Camera.h"
 #include "../Models/DefaultPrimitives.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
 #include <random>
 #include "glm/gtx/compatibility.hpp"
 
@@ -107,12 +108,12 @@ namespace Crescent
 			m_SSAONoiseTexture->BindTexture(2);
 
 			m_SSAOShader->UseShader();
-			m_SSAOShader->SetUniformVector2("renderSize", rendererContext->RetrieveRenderWindowSize());
-			m_SSAOShader->SetUniformMat4("projection", cameraContext->m_ProjectionMatrix);
-			m_SSAOShader->SetUniformMat4("view", cameraContext->m_ViewMatrix);
+			m_SSAOShader->SetUniform(UID("renderSize"), rendererContext->RetrieveRenderWindowSize());
+			m_SSAOShader->SetUniform(UID("projection"), cameraContext->m_ProjectionMatrix);
+			m_SSAOShader->SetUniform(UID("view"), cameraContext->m_ViewMatrix);
 
-			glBindFramebuffer(GL_FRAMEBUFFER, m_SSAORenderTarget->m_FramebufferID);
-			glViewport(0, 0, m_SSAORenderTarget->m_FramebufferWidth, m_SSAORenderTarget->m_FramebufferHeight);
+			rendererContext->RetrieveGLStateCache()->BindFramebuffer(GL_FRAMEBUFFER, m_SSAORenderTarget->m_FramebufferID);
+			rendererContext->RetrieveGLStateCache()->SetViewport(0, 0, m_SSAORenderTarget->m_FramebufferWidth, m_SSAORenderTarget->m_FramebufferHeight);
 			glClear(GL_COLOR_BUFFER_BIT);
 			rendererContext->RenderMesh(rendererContext->m_NDCQuad);
 		}
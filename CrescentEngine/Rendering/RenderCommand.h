@@ -1,5 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cstdint>
+#include "../Utilities/Bounds.h"
 
 namespace Crescent
 {
@@ -11,5 +13,26 @@ namespace Crescent
 		glm::mat4 m_Transform = glm::mat4(1.0f);
 		Mesh* m_Mesh;
 		Material* m_Material;
+		BoundingBox m_WorldBoundingBox; //Mesh bounds transformed into world space, used for culling.
+		bool m_StaticShadowCaster = false; //Drawn into cached shadow layers instead of every frame.
+		unsigned int m_LODIndex = 0; //Mesh level of detail picked from the command's projected size. Shadow passes draw the same level.
+
+		//Packed state keys generated when the command is queued. See RenderSort.h for their bit layouts.
+		uint64_t m_SortKey = 0;
+		uint64_t m_ShadowSortKey = 0;
+	};
+
+	/*
+		A non-owning view over a list of queued render commands. The commands themselves live in the render queue's frame arena and stay valid until the
+		queue is cleared at the end of the frame.
+	*/
+	struct RenderCommandList
+	{
+		RenderCommand* const* m_Commands = nullptr;
+		size_t m_CommandCount = 0;
+
+		size_t size() const { return m_CommandCount; }
+		bool empty() const { return m_CommandCount == 0; }
+		RenderCommand& operator[](size_t index) const { return *m_Commands[index]; }
 	};
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "CrescentPCH.h"
 #include "RenderQueue.h"
 #include "RenderCommand.h"
+#include "Renderer.h"
+#include "RenderTarget.h"
 #include "../Shading/Material.h"
+#include "../Models/Mesh.h"
+#include "../Utilities/Camera.h"
 
 namespace Crescent
 {
@@ -15,13 +19,26 @@ namespace Crescent
 		ClearQueuedCommands();
 	}
 
-	void RenderQueue::PushToRenderQueue(Mesh* mesh, Material* material, glm::mat4 transform, RenderTarget* renderTarget)
+	void RenderQueue::PushToRenderQueue(Mesh* mesh, Material* material, glm::mat4 transform, RenderTarget* renderTarget, bool staticShadowCaster)
 	{
-		RenderCommand renderCommand = {};
+		RenderCommand* renderCommand = m_CommandArena.Allocate<RenderCommand>();
+		m_QueuedCommandCount++;
 
-		renderCommand.m_Mesh = mesh;
-		renderCommand.m_Material = material;
-		renderCommand.m_Transform = transform;
+		renderCommand->m_Mesh = mesh;
+		renderCommand->m_Material = material;
+		renderCommand->m_Transform = transform;
+		renderCommand->m_StaticShadowCaster = staticShadowCaster;
+		if (mesh->RetrieveLocalBoundingBox().IsValid())
+		{
+			renderCommand->m_WorldBoundingBox = mesh->RetrieveLocalBoundingBox().Transform(transform);
+		}
+		renderCommand->m_LODIndex = SelectMeshLOD(mesh, transform, renderCommand->m_WorldBoundingBox);
+
+		Camera* camera = m_Renderer->RetrieveSceneCamera();
+		float viewDepth = CalculateViewDepth(transform);
+		float farClip = camera ? camera->m_FarClip : 0.0f;
+		renderCommand->m_SortKey = RenderSort::GenerateSortKey(renderTarget ? renderTarget->m_FramebufferID : 0, material->RetrieveMaterialShader()->GetShaderID(), material,
+			mesh->RetrieveGeometrySortID(), viewDepth, farClip);
 
 		//Here, we will have different queue types for different rendering styles. We can filter with material types.
 		if (material->m_BlendingEnabled)
@@ -37,67 +54,232 @@ namespace Crescent
 			}
 			else if (material->m_MaterialType == Material_Custom)
 			{
-				//Check if this render target has been pushed before. If so, we add to its vector.
-				//Otherwise, we create a new vector with this render target. 
-				if (m_CustomRenderCommands.find(renderTarget) != m_CustomRenderCommands.end())
-				{
-					m_CustomRenderCommands[renderTarget].push_back(renderCommand);
-				}
-				else
-				{
-					m_CustomRenderCommands[renderTarget] = std::vector<RenderCommand>();
-					m_CustomRenderCommands[renderTarget].push_back(renderCommand);
-				}
+				//Render targets seen in earlier frames keep their (cleared) vector, so this only allocates the first time a target is used.
+				m_CustomRenderCommands[renderTarget].push_back(renderCommand);
 			}
 			//One more check if its a post-processing material. 
+
+			//Shadow casters are gathered from deferred commands and custom commands drawn to our main/null render target. Every caster is drawn with the
+			//same shadow shader, so their key only groups by mesh.
+			bool isShadowCandidate = material->m_MaterialType == Material_Default || (material->m_MaterialType == Material_Custom && renderTarget == nullptr);
+			if (material->m_ShadowCasting && isShadowCandidate)
+			{
+				renderCommand->m_ShadowSortKey = RenderSort::GenerateShadowSortKey(mesh->RetrieveGeometrySortID(), viewDepth, farClip);
+				m_ShadowCastingRenderCommands.push_back(renderCommand);
+			}
 		}
 	}
 
-	std::vector<RenderCommand> RenderQueue::RetrieveDeferredRenderingCommands()
+	RenderCommandList RenderQueue::RetrieveDeferredRenderingCommands()
 	{
-		//Add cull check here.
-		return m_DeferredRenderingCommands;
+		//Already culled in CullQueuedCommands.
+		return CreateCommandList(m_DeferredRenderingCommands);
 	}
 
-	std::vector<RenderCommand> RenderQueue::RetrieveShadowCastingRenderCommands()
+	RenderCommandList RenderQueue::RetrieveShadowCastingRenderCommands()
 	{
-		std::vector<RenderCommand> renderCommands;
-		for (auto iterator = m_DeferredRenderingCommands.begin(); iterator != m_DeferredRenderingCommands.end(); iterator++)
+		return CreateCommandList(m_ShadowCastingRenderCommands);
+	}
+
+	RenderCommandList RenderQueue::RetrieveShadowCastingRenderCommands(const Frustum& shadowFrustum, ShadowCasterLayer casterLayer)
+	{
+		GatherShadowCasterBounds();
+		shadowFrustum.CullBoundingBoxes(m_ShadowCasterBoundingBoxes, m_ShadowCullingResults);
+
+		m_VisibleShadowCommands.clear();
+		for (unsigned int i = 0; i < m_ShadowCastingRenderCommands.size(); i++)
 		{
-			if (iterator->m_Material->m_ShadowCasting)
+			bool inCasterLayer = casterLayer == ShadowCaster_All || m_ShadowCastingRenderCommands[i]->m_StaticShadowCaster == (casterLayer == ShadowCaster_Static);
+			if (m_ShadowCullingResults[i] && inCasterLayer)
 			{
-				renderCommands.push_back(*iterator);
+				m_VisibleShadowCommands.push_back(m_ShadowCastingRenderCommands[i]);
 			}
 		}
+		return CreateCommandList(m_VisibleShadowCommands);
+	}
 
-		for (auto iterator = m_CustomRenderCommands[nullptr].begin(); iterator != m_CustomRenderCommands[nullptr].end(); iterator++)
+	const BoundingBox& RenderQueue::RetrieveShadowCasterBounds()
+	{
+		GatherShadowCasterBounds();
+		return m_ShadowCasterBounds;
+	}
+
+	RenderCommandList RenderQueue::RetrieveCustomRenderCommands(RenderTarget* renderTarget, bool cullingEnabled)
+	{
+		auto iterator = m_CustomRenderCommands.find(renderTarget);
+		if (iterator == m_CustomRenderCommands.end())
 		{
-			if (iterator->m_Material->m_ShadowCasting)
-			{
-				renderCommands.push_back(*iterator);
-			}
+			return RenderCommandList();
 		}
 
-		return renderCommands;
+		//Only do culling when on our main/null render target, as other targets are viewed through cameras of their own.
+		if (cullingEnabled && renderTarget == nullptr && m_CullingFrustumAvailable)
+		{
+			CullRenderCommands(iterator->second, m_VisibleCustomCommands);
+			return CreateCommandList(m_VisibleCustomCommands);
+		}
+		return CreateCommandList(iterator->second); //Return render commands belonging to the passed in render target.
 	}
 
-	std::vector<RenderCommand> RenderQueue::RetrieveCustomRenderCommands(RenderTarget* renderTarget, bool cullingEnabled)
+	RenderCommandList RenderQueue::RetrievePostProcessingRenderCommands()
 	{
-		//Only do culling when on our main/null render target. Culling code here.
+		return CreateCommandList(m_PostProcessingRenderCommands);
+	}
 
-		return m_CustomRenderCommands[renderTarget]; //Return render commands belonging to the passed in render target.
+	void RenderQueue::CullQueuedCommands(const Frustum& viewFrustum)
+	{
+		m_CullingFrustum = viewFrustum;
+		m_CullingFrustumAvailable = true;
+		m_VisibleCommandCount = 0;
+		m_CulledCommandCount = 0;
+
+		CullRenderCommands(m_DeferredRenderingCommands, m_CullingScratchCommands);
+		m_DeferredRenderingCommands.swap(m_CullingScratchCommands);
 	}
 
-	std::vector<RenderCommand> RenderQueue::RetrievePostProcessingRenderCommands()
+	void RenderQueue::SortQueuedCommands()
 	{
-		return m_PostProcessingRenderCommands;
+		if (!m_CullingFrustumAvailable)
+		{
+			m_VisibleCommandCount = m_DeferredRenderingCommands.size();
+			m_CulledCommandCount = 0;
+		}
+
+		SortRenderCommands(m_DeferredRenderingCommands);
+		SortRenderCommands(m_ShadowCastingRenderCommands, true);
+		m_ShadowCasterBoundsAvailable = false;
+
+		for (auto iterator = m_CustomRenderCommands.begin(); iterator != m_CustomRenderCommands.end(); iterator++)
+		{
+			SortRenderCommands(iterator->second);
+		}
 	}
 
 	void RenderQueue::ClearQueuedCommands()
 	{
+		//Lists are cleared rather than released so their capacity carries over to the next frame.
 		m_DeferredRenderingCommands.clear();
+		m_ShadowCastingRenderCommands.clear();
 		m_PostProcessingRenderCommands.clear();
-		m_CustomRenderCommands.clear();
+		for (auto iterator = m_CustomRenderCommands.begin(); iterator != m_CustomRenderCommands.end(); iterator++)
+		{
+			iterator->second.clear();
+		}
+
+		m_CommandArena.Reset();
+		m_QueuedCommandCount = 0;
+		m_CullingFrustumAvailable = false;
+		m_ShadowCasterBoundsAvailable = false;
+	}
+
+	float RenderQueue::CalculateViewDepth(const glm::mat4& transform) const
+	{
+		Camera* camera = m_Renderer->RetrieveSceneCamera();
+		if (!camera)
+		{
+			return 0.0f;
+		}
+
+		//Distance along the view direction from the camera to the object's origin.
+		glm::vec3 objectPosition = glm::vec3(transform[3]);
+		return glm::dot(objectPosition - camera->m_CameraPosition, camera->m_ForwardDirection);
+	}
+
+	unsigned int RenderQueue::SelectMeshLOD(const Mesh* mesh, const glm::mat4& transform, const BoundingBox& worldBoundingBox) const
+	{
+		Camera* camera = m_Renderer->RetrieveSceneCamera();
+		if (!m_Renderer->m_LODSelectionEnabled || !camera || mesh->RetrieveLODCount() == 1 || !worldBoundingBox.IsValid())
+		{
+			return 0;
+		}
+
+		//Measured to the closest point of the bounds, so the camera never sees a coarse level of something it stands next to or inside of.
+		glm::vec3 closestPoint = glm::clamp(camera->m_CameraPosition, worldBoundingBox.m_Minimum, worldBoundingBox.m_Maximum);
+		float distance = std::max(glm::length(closestPoint - camera->m_CameraPosition), camera->m_NearClip);
+
+		//Pixels covered by an object space unit at that distance. The projection's Y scale is the cotangent of half the vertical field of view.
+		float maximumScale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		float pixelsPerUnit = maximumScale * camera->m_ProjectionMatrix[1][1] * m_Renderer->RetrieveRenderWindowSize().y * 0.5f / distance;
+		return mesh->SelectLOD(pixelsPerUnit, m_Renderer->m_LODErrorThreshold);
+	}
+
+	void RenderQueue::SortRenderCommands(std::vector<RenderCommand*>& renderCommands, bool shadowSortKeys)
+	{
+		if (renderCommands.size() < 2)
+		{
+			return;
+		}
+
+		//We sort small key/index pairs, then permute the command pointers once at the end.
+		m_SortEntries.resize(renderCommands.size());
+		for (uint32_t i = 0; i < renderCommands.size(); i++)
+		{
+			m_SortEntries[i].m_SortKey = shadowSortKeys ? renderCommands[i]->m_ShadowSortKey : renderCommands[i]->m_SortKey;
+			m_SortEntries[i].m_CommandIndex = i;
+		}
+
+		RenderSort::RadixSort(m_SortEntries, m_SortScratchEntries);
+
+		m_SortScratchCommands.resize(renderCommands.size());
+		for (unsigned int i = 0; i < m_SortEntries.size(); i++)
+		{
+			m_SortScratchCommands[i] = renderCommands[m_SortEntries[i].m_CommandIndex];
+		}
+		renderCommands.swap(m_SortScratchCommands);
+	}
+
+	void RenderQueue::CullRenderCommands(const std::vector<RenderCommand*>& renderCommands, std::vector<RenderCommand*>& visibleCommands)
+	{
+		m_CullingBoundingBoxes.Clear();
+		for (unsigned int i = 0; i < renderCommands.size(); i++)
+		{
+			m_CullingBoundingBoxes.PushBoundingBox(renderCommands[i]->m_WorldBoundingBox);
+		}
+
+		size_t visibleCount = m_CullingFrustum.CullBoundingBoxes(m_CullingBoundingBoxes, m_CullingResults);
+
+		//Compact the survivors while keeping their queued order.
+		visibleCommands.clear();
+		for (unsigned int i = 0; i < renderCommands.size(); i++)
+		{
+			if (m_CullingResults[i])
+			{
+				visibleCommands.push_back(renderCommands[i]);
+			}
+		}
+
+		m_VisibleCommandCount += visibleCount;
+		m_CulledCommandCount += renderCommands.size() - visibleCount;
+	}
+
+	void RenderQueue::GatherShadowCasterBounds()
+	{
+		if (m_ShadowCasterBoundsAvailable)
+		{
+			return;
+		}
+
+		m_ShadowCasterBoundingBoxes.Clear();
+		m_ShadowCasterBounds = BoundingBox();
+		for (unsigned int i = 0; i < m_ShadowCastingRenderCommands.size(); i++)
+		{
+			const BoundingBox& worldBoundingBox = m_ShadowCastingRenderCommands[i]->m_WorldBoundingBox;
+			m_ShadowCasterBoundingBoxes.PushBoundingBox(worldBoundingBox);
+			if (worldBoundingBox.IsValid())
+			{
+				m_ShadowCasterBounds.Merge(worldBoundingBox.m_Minimum);
+				m_ShadowCasterBounds.Merge(worldBoundingBox.m_Maximum);
+			}
+		}
+		m_ShadowCasterBoundsAvailable = true;
+	}
+
+	RenderCommandList RenderQueue::CreateCommandList(const std::vector<RenderCommand*>& renderCommands) const
+	{
+		RenderCommandList commandList;
+		commandList.m_Commands = renderCommands.data();
+		commandList.m_CommandCount = renderCommands.size();
+		return commandList;
 	}
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 #include "RenderCommand.h"
-#include <deque>
+#include "RenderSort.h"
+#include "../Memory/FrameArena.h"
+#include "../Utilities/Frustum.h"
 #include <map>
 
 namespace Crescent
@@ -10,28 +12,92 @@ namespace Crescent
 	class Material;
 	class RenderTarget;
 
+	enum ShadowCasterLayer
+	{
+		ShadowCaster_All,
+		ShadowCaster_Static,
+		ShadowCaster_Dynamic
+	};
+
+	/*
+		Commands are allocated from a per-frame arena, while each queue only holds pointers into it. Retrieval hands out views over these lists, so nothing is
+		copied once a command is queued. All lists keep their capacity between frames, meaning a steady-state frame performs no heap allocations.
+	*/
+
 	class RenderQueue
 	{
 	public:
 		RenderQueue(Renderer* renderer);
 		~RenderQueue();
 
-		void PushToRenderQueue(Mesh* model, Material* material, glm::mat4 transform, RenderTarget* renderTarget = nullptr);
-		std::vector<RenderCommand> RetrieveDeferredRenderingCommands();
+		void PushToRenderQueue(Mesh* model, Material* material, glm::mat4 transform, RenderTarget* renderTarget = nullptr, bool staticShadowCaster = false);
+		RenderCommandList RetrieveDeferredRenderingCommands();
 
-		//Returns the list of all render commands with mesh shadow casting.
-		std::vector<RenderCommand> RetrieveShadowCastingRenderCommands();
+		//Returns the list of all render commands with mesh shadow casting. This list is filtered as commands are queued.
+		RenderCommandList RetrieveShadowCastingRenderCommands();
+		//Returns the shadow casters of a layer intersecting a light volume, in sorted order. The list is only valid until the next call.
+		RenderCommandList RetrieveShadowCastingRenderCommands(const Frustum& shadowFrustum, ShadowCasterLayer casterLayer = ShadowCaster_All);
+		//World space bounds enclosing every queued shadow caster.
+		const BoundingBox& RetrieveShadowCasterBounds();
 
-		std::vector<RenderCommand> RetrievePostProcessingRenderCommands();
+		RenderCommandList RetrievePostProcessingRenderCommands();
 		//Returns a list of custom render commands for a specific render target.
-		std::vector<RenderCommand> RetrieveCustomRenderCommands(RenderTarget* renderTarget, bool cullingEnabled = false);
+		RenderCommandList RetrieveCustomRenderCommands(RenderTarget* renderTarget, bool cullingEnabled = false);
+
+		//Removes deferred commands outside of the frustum, which is also kept for culling custom commands upon retrieval. Should be called before sorting.
+		void CullQueuedCommands(const Frustum& viewFrustum);
+
+		//Orders all queued commands by their sort keys so that state changes are grouped together. Should be called once all commands for the frame are queued.
+		void SortQueuedCommands();
 
 		void ClearQueuedCommands();
 
+		size_t RetrieveHeapAllocationCount() const { return m_CommandArena.RetrieveHeapAllocationCount(); }
+		//Commands queued since the queue was last cleared.
+		size_t RetrieveQueuedCommandCount() const { return m_QueuedCommandCount; }
+
+		//Culling statistics of the most recent frame.
+		size_t RetrieveVisibleCommandCount() const { return m_VisibleCommandCount; }
+		size_t RetrieveCulledCommandCount() const { return m_CulledCommandCount; }
+
+	private:
+		float CalculateViewDepth(const glm::mat4& transform) const;
+		unsigned int SelectMeshLOD(const Mesh* mesh, const glm::mat4& transform, const BoundingBox& worldBoundingBox) const;
+		void SortRenderCommands(std::vector<RenderCommand*>& renderCommands, bool shadowSortKeys = false);
+		RenderCommandList CreateCommandList(const std::vector<RenderCommand*>& renderCommands) const;
+		void CullRenderCommands(const std::vector<RenderCommand*>& renderCommands, std::vector<RenderCommand*>& visibleCommands);
+		void GatherShadowCasterBounds();
+
 	private:
-		std::vector<RenderCommand> m_DeferredRenderingCommands;
-		std::vector<RenderCommand> m_PostProcessingRenderCommands;
-		std::map<RenderTarget*, std::vector<RenderCommand>> m_CustomRenderCommands;
+		FrameArena m_CommandArena;
+		size_t m_QueuedCommandCount = 0;
+
+		std::vector<RenderCommand*> m_DeferredRenderingCommands;
+		std::vector<RenderCommand*> m_ShadowCastingRenderCommands;
+		std::vector<RenderCommand*> m_PostProcessingRenderCommands;
+		std::map<RenderTarget*, std::vector<RenderCommand*>> m_CustomRenderCommands; //Entries persist between frames so their capacity is reused.
 		Renderer* m_Renderer;
+
+		//Culling
+		Frustum m_CullingFrustum;
+		bool m_CullingFrustumAvailable = false;
+		BoundingBoxStream m_CullingBoundingBoxes;
+		std::vector<uint8_t> m_CullingResults;
+		std::vector<RenderCommand*> m_VisibleCustomCommands;
+		std::vector<RenderCommand*> m_CullingScratchCommands;
+		size_t m_VisibleCommandCount = 0;
+		size_t m_CulledCommandCount = 0;
+
+		//Shadow casters are culled once per cascade, so their bounds are gathered once and reused.
+		BoundingBoxStream m_ShadowCasterBoundingBoxes;
+		BoundingBox m_ShadowCasterBounds;
+		bool m_ShadowCasterBoundsAvailable = false;
+		std::vector<uint8_t> m_ShadowCullingResults;
+		std::vector<RenderCommand*> m_VisibleShadowCommands;
+
+		//Sorting
+		std::vector<RenderSortEntry> m_SortEntries;
+		std::vector<RenderSortEntry> m_SortScratchEntries;
+		std::vector<RenderCommand*> m_SortScratchCommands;
 	};
 }
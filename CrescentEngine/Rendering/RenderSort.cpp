@@ -0,0 +1,95 @@
+#include "CrescentPCH.h"
+#include "RenderSort.h"
+#include <algorithm>
+
+namespace Crescent
+{
+	uint64_t RenderSort::GenerateSortKey(unsigned int framebufferID, unsigned int shaderID, const Material* material, unsigned int vertexArrayID, float viewDepth, float farClip)
+	{
+		//Materials have no ID of their own. We fold their address instead, dropping the low bits that are always zero due to allocation alignment.
+		uint64_t materialAddress = (uint64_t)(uintptr_t)material;
+		uint64_t materialBits = ((materialAddress >> 4) ^ (materialAddress >> 20)) & 0xFFFF;
+
+		uint64_t sortKey = 0;
+		sortKey |= ((uint64_t)framebufferID & 0xFF) << 56;
+		sortKey |= ((uint64_t)shaderID & 0xFFF) << 44;
+		sortKey |= materialBits << 28;
+		sortKey |= ((uint64_t)vertexArrayID & 0xFFF) << 16;
+		sortKey |= QuantizeDepth(viewDepth, farClip);
+
+		return sortKey;
+	}
+
+	uint64_t RenderSort::GenerateShadowSortKey(unsigned int vertexArrayID, float viewDepth, float farClip)
+	{
+		return (((uint64_t)vertexArrayID & 0xFFF) << 16) | QuantizeDepth(viewDepth, farClip);
+	}
+
+	void RenderSort::RadixSort(std::vector<RenderSortEntry>& sortEntries, std::vector<RenderSortEntry>& scratchEntries)
+	{
+		const size_t entryCount = sortEntries.size();
+		if (entryCount < 2)
+		{
+			return;
+		}
+		scratchEntries.resize(entryCount);
+
+		//Build the histograms of all 8 digits in a single pass over the keys.
+		uint32_t histograms[8][256] = {};
+		for (size_t i = 0; i < entryCount; i++)
+		{
+			uint64_t sortKey = sortEntries[i].m_SortKey;
+			for (unsigned int digit = 0; digit < 8; digit++)
+			{
+				histograms[digit][(sortKey >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		RenderSortEntry* source = sortEntries.data();
+		RenderSortEntry* destination = scratchEntries.data();
+
+		for (unsigned int digit = 0; digit < 8; digit++)
+		{
+			uint32_t* histogram = histograms[digit];
+			//If every key falls into the same bucket, this pass would leave the order untouched.
+			if (histogram[(source[0].m_SortKey >> (digit * 8)) & 0xFF] == entryCount)
+			{
+				continue;
+			}
+
+			//Convert counts into starting offsets.
+			uint32_t offset = 0;
+			for (unsigned int bucket = 0; bucket < 256; bucket++)
+			{
+				uint32_t count = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += count;
+			}
+
+			for (size_t i = 0; i < entryCount; i++)
+			{
+				unsigned int bucket = (source[i].m_SortKey >> (digit * 8)) & 0xFF;
+				destination[histogram[bucket]++] = source[i];
+			}
+
+			std::swap(source, destination);
+		}
+
+		//After an odd number of passes, our sorted results live in the scratch buffer.
+		if (source != sortEntries.data())
+		{
+			sortEntries.swap(scratchEntries);
+		}
+	}
+
+	uint64_t RenderSort::QuantizeDepth(float viewDepth, float farClip)
+	{
+		if (farClip <= 0.0f)
+		{
+			return 0;
+		}
+
+		float normalizedDepth = std::min(std::max(viewDepth / farClip, 0.0f), 1.0f);
+		return (uint64_t)(normalizedDepth * 65535.0f);
+	}
+}
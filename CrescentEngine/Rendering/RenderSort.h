@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Crescent
+{
+	class Material;
+
+	/*
+		Render commands are sorted by a packed 64-bit key so that commands sharing GPU state are submitted next to each other. From most to least significant bit:
+
+		[63 - 56] Render Target (Framebuffer ID)
+		[55 - 44] Shader (Program ID)
+		[43 - 28] Material (Folded address)
+		[27 - 16] Mesh (Vertex Array ID)
+		[15 -  0] Quantized view depth (front to back)
+
+		As all IDs are truncated to fit their fields, two different objects may share the same bits. This only costs us grouping quality, never correctness.
+	*/
+
+	struct RenderSortEntry
+	{
+		uint64_t m_SortKey;
+		uint32_t m_CommandIndex;
+	};
+
+	class RenderSort
+	{
+	public:
+		static uint64_t GenerateSortKey(unsigned int framebufferID, unsigned int shaderID, const Material* material, unsigned int vertexArrayID, float viewDepth, float farClip);
+		//Shadow passes share a single shader, thus only the mesh and depth are relevant.
+		static uint64_t GenerateShadowSortKey(unsigned int vertexArrayID, float viewDepth, float farClip);
+
+		//LSD radix sort over 8-bit digits. Passes where every key shares the same digit are skipped. Results are stable and always end up in sortEntries.
+		static void RadixSort(std::vector<RenderSortEntry>& sortEntries, std::vector<RenderSortEntry>& scratchEntries);
+
+	private:
+		static uint64_t QuantizeDepth(float viewDepth, float farClip);
+	};
+}
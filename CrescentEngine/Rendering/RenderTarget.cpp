@@ -1,5 +1,6 @@
 #include "CrescentPCH.h"
 #include "RenderTarget.h"
+#include "GLStateCache.h"
 
 namespace Crescent
 {
@@ -10,7 +11,7 @@ namespace Crescent
 		m_FramebufferDataType = framebufferDataType;
 
 		glGenFramebuffers(1, &m_FramebufferID);
-		glBindFramebuffer(GL_FRAMEBUFFER, m_FramebufferID);
+		BindFramebuffer(m_FramebufferID);
 		//Generate all requested color attachments.
 		for (unsigned int i = 0; i < colorAttachmentCount; i++)
 		{
@@ -57,7 +58,7 @@ namespace Crescent
 		{
 			CrescentInfo("Framebuffer creation failed - Not complete!");
 		}
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		BindFramebuffer(0);
 	}
 
 	Texture* RenderTarget::RetrieveDepthAndStencilAttachment()
@@ -95,6 +96,11 @@ namespace Crescent
 		}
 	}
 
+	void RenderTarget::BindFramebuffer(unsigned int framebufferID)
+	{
+		GLStateCache::BindFramebuffer(GLStateCache::RetrieveActiveCache(), GL_FRAMEBUFFER, framebufferID);
+	}
+
 	void RenderTarget::SetRenderTarget(GLenum target)
 	{
 		m_FramebufferTarget = target;
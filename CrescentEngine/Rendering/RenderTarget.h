@@ -28,6 +28,9 @@ namespace Crescent
 
 		bool m_HasDepthAndStencilAttachments;
 
+	private:
+		void BindFramebuffer(unsigned int framebufferID);
+
 	private:
 		GLenum m_FramebufferTarget = GL_TEXTURE_2D;
 		Texture m_DepthAndStencilAttachment;
@@ -7,6 +7,7 @@
 #include "../Models/DefaultPrimitives.h"
 #include "../Utilities/FlyCamera.h"
 #include "../Scene/SceneEntity.h"
+#include "../Scene/Scene.h"
 #include "../Models/Model.h"
 #include "../Shading/Shader.h"
 #include "../Shading/Material.h"
@@ -15,8 +16,14 @@
 #include "../Rendering/Resources.h"
 #include "../Shading/TextureCube.h"
 #include "PostProcessor.h"
+#include "UniformRingBuffer.h"
+#include "ShadowCascadeMap.h"
+#include "ShadowCascadeFitter.h"
+#include "GeometryArena.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <stack>
+#include <algorithm>
+#include <cassert>
 
 //As of now, our renderer only supports Forward Pass Rendering.
 
@@ -34,15 +41,31 @@ namespace Crescent
 		delete m_GBuffer;
 		delete m_CustomRenderTarget;
 
-		for (int i = 0; i < m_ShadowRenderTargets.size(); i++)
+		for (unsigned int i = 0; i < m_ShadowCascadeMaps.size(); i++)
 		{
-			delete m_ShadowRenderTargets[i];
+			delete m_ShadowCascadeMaps[i];
 		}
 
 		delete m_DebugLightMesh;
 		delete m_PostProcessRenderTarget;
 		delete m_PostProcessor;
 		delete m_PBR;
+		delete m_ObjectUniformRingBuffer;
+		delete m_GeometryArena;
+
+		//Renderers that were never initialized, such as those of tests, hold no GL objects.
+		if (!m_GLStateCache)
+		{
+			return;
+		}
+		delete m_GLStateCache;
+
+		glDeleteBuffers(1, &m_InstanceBufferID);
+		glDeleteBuffers(1, &m_IndirectBufferID);
+		glDeleteBuffers(1, &m_ClusterLightBufferID);
+		glDeleteBuffers(1, &m_LightClusterBufferID);
+		glDeleteBuffers(1, &m_ClusterLightIndexBufferID);
+		glDeleteBuffers(1, &m_GlobalUniformBufferID);
 	}
 
 	void Renderer::InitializeRenderer(const int& renderWindowWidth, const int& renderWindowHeight, Camera* sceneCamera)
@@ -64,7 +87,7 @@ namespace Crescent
 		m_DeviceVersionInformation = (char*)glGetString(GL_VERSION);
 		
 		m_RenderWindowSize = glm::vec2(renderWindowWidth, renderWindowHeight);
-		glViewport(0.0f, 0.0f, renderWindowWidth, renderWindowHeight);
+		m_GLStateCache->SetViewport(0, 0, renderWindowWidth, renderWindowHeight);
 		glClearDepth(1.0f);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
@@ -73,10 +96,10 @@ namespace Crescent
 		//Core Primitives
 		m_NDCQuad = new Quad();
 		m_DebugLightMesh = new Sphere(16, 16);
-		m_DeferredPointLightMesh = new Sphere(16, 16);
 
 		//Core Systems
 		m_RenderQueue = new RenderQueue(this);
+		m_QueueHeapAllocationCount = m_RenderQueue->RetrieveHeapAllocationCount();
 		m_MaterialLibrary = new MaterialLibrary(m_GBuffer);
 
 		//Render Targets
@@ -86,21 +109,37 @@ namespace Crescent
 		m_PostProcessRenderTarget = new RenderTarget(1, 1, GL_UNSIGNED_BYTE, 1, false);
 		m_PostProcessor = new PostProcessor(this);
 
-		//Shadows
-		for (int i = 0; i < 4; i++) //Allow for up to a total of 4 directional/spot shadow casters.
-		{
-			RenderTarget* renderTarget = new RenderTarget(2048, 2048, GL_UNSIGNED_BYTE, 1, true);
-			renderTarget->m_DepthAndStencilAttachment.BindTexture();
+		//Shadow cascade maps are created as shadow casting lights need them.
 
-			renderTarget->m_DepthAndStencilAttachment.SetMinificationFilter(GL_NEAREST);
-			renderTarget->m_DepthAndStencilAttachment.SetMagnificationFilter(GL_NEAREST);
-			renderTarget->m_DepthAndStencilAttachment.SetWrappingMode(GL_CLAMP_TO_BORDER);
+		//Instancing
+		glGenBuffers(1, &m_InstanceBufferID);
 
-			float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-			m_ShadowRenderTargets.push_back(renderTarget);
+		//Shared Geometry. Packed meshes finalized from here on are suballocated from the arena's buffers.
+		m_GeometryArena = new GeometryArena();
+		m_MultiDrawIndirectSupported = GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+		if (m_MultiDrawIndirectSupported)
+		{
+			glGenBuffers(1, &m_IndirectBufferID);
+		}
+		else
+		{
+			CrescentInfo("Multi-draw indirect is not supported. Geometry buffer draws will be issued one batch at a time.");
 		}
 
+		//Clustered Lighting
+		glGenBuffers(1, &m_ClusterLightBufferID);
+		glGenBuffers(1, &m_LightClusterBufferID);
+		glGenBuffers(1, &m_ClusterLightIndexBufferID);
+
+		//Global Uniform Buffer Object
+		glGenBuffers(1, &m_GlobalUniformBufferID);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_GlobalUniformBufferID);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(GlobalUniformData), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, UniformBinding_Global, m_GlobalUniformBufferID);
+
+		//Per-object uniforms. Each segment fits ~16k draws at the common 256 byte offset alignment.
+		m_ObjectUniformRingBuffer = new UniformRingBuffer(4 * 1024 * 1024);
+
 		//Cubemap
 		glGenFramebuffers(1, &m_CubemapFramebufferID);
 		glGenRenderbuffers(1, &m_CubemapDepthRenderbufferID);
@@ -112,12 +151,6 @@ namespace Crescent
 		Texture* milkyWayMap = Resources::LoadHDRTexture("Sky Environment", "Resources/Skybox/AlleyWay/Alley.hdr");
 		EnvironmentalPBR* environmentalCapture = m_PBR->ProcessEquirectangularMap(milkyWayMap);
 		SetSkyCapture(environmentalCapture);
-
-		//Global Uniform Buffer Object
-		//glGenBuffers(1, &m_GlobalUniformBufferID);
-		//glBindBuffer(GL_UNIFORM_BUFFER, m_GlobalUniformBufferID);
-		//glBufferData(GL_UNIFORM_BUFFER, 720, nullptr, GL_STREAM_DRAW);
-		//glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_GlobalUniformBufferID);
 	}
 
 	void Renderer::PushToRenderQueue(SceneEntity* sceneEntity)
@@ -127,34 +160,140 @@ namespace Crescent
 
 		std::stack<SceneEntity*> nodeStack;
 		nodeStack.push(sceneEntity);
-		for (unsigned int i = 0; i < sceneEntity->RetrieveChildCount(); i++)
-		{
-			nodeStack.push(sceneEntity->RetrieveChildByIndex(i));
-		}
-
 		while (!nodeStack.empty())
 		{
 			SceneEntity* node = nodeStack.top();
 			nodeStack.pop();
-			if (node->m_Mesh)
+			if (node->m_Mesh || node->RetrievePrefab())
+			{
+				PushEntityToRenderQueue(node);
+			}
+
+			for (SceneEntity* childEntity = node->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
+			{
+				nodeStack.push(childEntity);
+			}
+		}
+	}
+
+	void Renderer::PushToRenderQueue(Scene* scene)
+	{
+		scene->UpdateSpatialIndex();
+		scene->ConsumeRemovedShadowCasterBounds(m_RemovedShadowCasterBounds);
+		for (size_t i = 0; i < m_RemovedShadowCasterBounds.size(); i++)
+		{
+			InvalidateStaticShadows(m_RemovedShadowCasterBounds[i]);
+		}
+
+		if (!m_FrustumCullingEnabled || !m_Camera)
+		{
+			std::vector<SceneEntity*> sceneEntities = scene->RetrieveSceneEntities();
+			for (unsigned int i = 0; i < sceneEntities.size(); i++)
 			{
-				m_RenderQueue->PushToRenderQueue(node->m_Mesh, node->m_Material, node->RetrieveEntityTransform());
+				PushToRenderQueue(sceneEntities[i]);
 			}
+			return;
+		}
 
-			for (unsigned int i = 0; i < node->RetrieveChildCount(); i++)
+		//Entities in view, plus those that may cast shadows into it. The latter lie within a single cascade spanning the whole shadow distance, with its
+		//near plane pulled back to the scene's bounds. It is padded like the cascades are, so it covers every caster their padded volumes may draw.
+		m_QueriedSceneEntities.clear();
+		scene->QueryFrustum(m_Camera->RetrieveViewFrustum(), m_QueriedSceneEntities);
+		if (m_ShadowsEnabled)
+		{
+			float shadowFarClip = std::max(std::min(m_Camera->m_FarClip, m_ShadowDistance), m_Camera->m_NearClip + 1.0f);
+			for (unsigned int i = 0; i < m_DirectionalLights.size(); i++)
 			{
-				nodeStack.push(node->RetrieveChildByIndex(i));
+				if (m_DirectionalLights[i]->m_ShadowCastingEnabled)
+				{
+					ShadowCascade shadowVolume = ShadowCascadeFitter::FitCascadeToFrustumSlice(*m_Camera, m_Camera->m_NearClip, shadowFarClip, m_DirectionalLights[i]->m_LightDirection,
+						scene->RetrieveSpatialIndex().RetrieveRootBounds(), 2048, m_ShadowCascadePadding);
+					scene->QueryFrustum(Frustum(shadowVolume.m_LightProjectionMatrix * shadowVolume.m_LightViewMatrix), m_QueriedSceneEntities);
+				}
 			}
 		}
+
+		//Entities found by several queries are pushed once. Casters outside of the view are dropped from the deferred pass by the command culling later on.
+		std::sort(m_QueriedSceneEntities.begin(), m_QueriedSceneEntities.end());
+		m_QueriedSceneEntities.erase(std::unique(m_QueriedSceneEntities.begin(), m_QueriedSceneEntities.end()), m_QueriedSceneEntities.end());
+		for (unsigned int i = 0; i < m_QueriedSceneEntities.size(); i++)
+		{
+			PushEntityToRenderQueue(m_QueriedSceneEntities[i]);
+		}
+	}
+
+	void Renderer::PushEntityToRenderQueue(SceneEntity* sceneEntity)
+	{
+		//Entities are promoted to static shadow casters once they stop moving for a while. Any movement of a static caster invalidates all cached shadows, as
+		//we no longer know where it was drawn. Promotions, and casters toggling their shadows in place, only invalidate the cascades around them.
+		const Prefab* prefab = sceneEntity->RetrievePrefab();
+		bool shadowCasting = prefab ? prefab->IsShadowCasting() : sceneEntity->m_Material->m_ShadowCasting;
+		if (sceneEntity->ConsumeTransformChange())
+		{
+			m_StaticShadowsDirty |= sceneEntity->m_StaticShadowCaster;
+			sceneEntity->m_StaticFrameCount = 0;
+		}
+		else if (sceneEntity->m_StaticFrameCount < m_StaticShadowFrameThreshold)
+		{
+			sceneEntity->m_StaticFrameCount++;
+		}
+
+		bool staticShadowCaster = sceneEntity->m_StaticFrameCount >= m_StaticShadowFrameThreshold;
+		if ((staticShadowCaster && shadowCasting) != sceneEntity->m_StaticShadowCaster)
+		{
+			sceneEntity->m_StaticShadowCaster = staticShadowCaster && shadowCasting;
+			InvalidateStaticShadows(sceneEntity->CalculateWorldBounds());
+		}
+
+		if (!prefab)
+		{
+			m_RenderQueue->PushToRenderQueue(sceneEntity->m_Mesh, sceneEntity->m_Material, sceneEntity->RetrieveEntityTransform(), nullptr, staticShadowCaster);
+			return;
+		}
+
+		//Prefab nodes are placed relative to the instance. Their root relative transforms are shared unless this instance overrides any of them.
+		const std::vector<glm::mat4>* rootTransforms = &prefab->RetrieveRootTransforms();
+		if (sceneEntity->HasPrefabTransformOverrides())
+		{
+			prefab->ResolveRootTransforms(sceneEntity->RetrievePrefabOverrides(), m_PrefabRootTransforms);
+			rootTransforms = &m_PrefabRootTransforms;
+		}
+
+		const glm::mat4& instanceTransform = sceneEntity->RetrieveEntityTransform();
+		const std::vector<uint32_t>& renderableNodes = prefab->RetrieveRenderableNodes();
+		for (unsigned int i = 0; i < renderableNodes.size(); i++)
+		{
+			uint32_t nodeIndex = renderableNodes[i];
+			m_RenderQueue->PushToRenderQueue(prefab->RetrieveNodes()[nodeIndex].m_Mesh, sceneEntity->RetrievePrefabMaterial(nodeIndex), instanceTransform * (*rootTransforms)[nodeIndex], nullptr, staticShadowCaster);
+		}
+	}
+
+	void Renderer::InvalidateStaticShadows(const BoundingBox& casterBounds)
+	{
+		if (!casterBounds.IsValid())
+		{
+			return;
+		}
+
+		for (unsigned int i = 0; i < m_ShadowCascadeMaps.size(); i++)
+		{
+			m_ShadowCascadeMaps[i]->InvalidateStaticCascades(casterBounds);
+		}
 	}
 
 	//Attach shader to material.
 	void Renderer::RenderAllQueueItems()
 	{
+		//The editor UI binds its own objects between frames, so we can't trust any bindings shadowed last frame.
+		m_GLStateCache->InvalidateBindings();
+		m_GLStateCache->ResetCallCounters();
+		m_MeshletCuller.ResetStatistics();
+
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		//Update Global Uniform Buffer Object
-		UpdateGlobalUniformBufferObjects();
+		m_ObjectUniformRingBuffer->BeginFrame();
+		UpdateGlobalUniformBufferObjects(m_Camera);
 
 		//Set default OpenGL state.
 		m_GLStateCache->ToggleBlending(false);
@@ -163,19 +302,48 @@ namespace Crescent
 		m_GLStateCache->ToggleDepthTesting(true);
 		m_GLStateCache->SetDepthFunction(GL_LESS);
 		
+		//Drop everything outside of the view frustum, then group the survivors by render state before walking them.
+		if (m_FrustumCullingEnabled)
+		{
+			m_RenderQueue->CullQueuedCommands(m_Camera->RetrieveViewFrustum());
+		}
+		m_RenderQueue->SortQueuedCommands();
+		CullPointLights();
+
 		//1) Geometry Buffer
-		std::vector<RenderCommand> deferredRenderCommands = m_RenderQueue->RetrieveDeferredRenderingCommands();
-		glViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
-		glBindFramebuffer(GL_FRAMEBUFFER, m_GBuffer->m_FramebufferID);
+		RenderCommandList deferredRenderCommands = m_RenderQueue->RetrieveDeferredRenderingCommands();
+		m_GLStateCache->SetViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_GBuffer->m_FramebufferID);
 		unsigned int attachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
 		glDrawBuffers(4, attachments);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		m_GLStateCache->SetPolygonMode(m_WireframesEnabled ? GL_LINE : GL_FILL);
 
-		for (int i = 0; i < deferredRenderCommands.size(); i++)
+		//Repeated mesh/material pairs are drawn in a single instanced call. Batches of meshes living in the geometry arena are further merged with their
+		//neighbours sharing a material into multi-draws, issued once every batch has been recorded.
+		InstanceBatcher::FormInstanceBatches(deferredRenderCommands, true, m_InstanceBatches, m_InstanceData);
+		UploadInstanceData();
+		m_IndirectCommandBuilder.Clear();
+		bool multiDrawIndirectEnabled = m_MultiDrawIndirectEnabled && m_MultiDrawIndirectSupported && m_InstancingEnabled;
+		for (unsigned int i = 0; i < m_InstanceBatches.size(); i++)
 		{
-			RenderCustomCommand(&deferredRenderCommands[i], nullptr, false);
+			if (multiDrawIndirectEnabled && deferredRenderCommands[m_InstanceBatches[i].m_FirstCommand].m_Mesh->RetrieveGeometryPool())
+			{
+				PushIndirectDraws(deferredRenderCommands, m_InstanceBatches[i]);
+			}
+			else if (m_InstancingEnabled && m_InstanceBatches[i].m_InstanceCount > 1)
+			{
+				RenderInstancedCommand(deferredRenderCommands, m_InstanceBatches[i]);
+			}
+			else
+			{
+				for (unsigned int j = 0; j < m_InstanceBatches[i].m_InstanceCount; j++)
+				{
+					RenderCustomCommand(&deferredRenderCommands[m_InstanceBatches[i].m_FirstCommand + j], nullptr, false);
+				}
+			}
 		}
+		RenderIndirectDraws();
 		m_GLStateCache->SetPolygonMode(GL_FILL);
 
 		//Disable for next pass (shadow map generation).
@@ -188,36 +356,90 @@ namespace Crescent
 		if (m_ShadowsEnabled)
 		{
 			m_GLStateCache->SetCulledFace(GL_FRONT);
-			std::vector<RenderCommand> shadowRenderCommands = m_RenderQueue->RetrieveShadowCastingRenderCommands();
+			const BoundingBox& shadowCasterBounds = m_RenderQueue->RetrieveShadowCasterBounds();
+
+			m_StaticShadowsDirty |= !m_StaticShadowCachingEnabled;
+			if (m_StaticShadowsDirty)
+			{
+				for (unsigned int i = 0; i < m_ShadowCascadeMaps.size(); i++)
+				{
+					m_ShadowCascadeMaps[i]->InvalidateStaticCascades();
+				}
+			}
+
+			//Cascades split the camera frustum up to the shadow distance. Fragments beyond it are left unshadowed.
+			float splitDepths[ShadowCascadeCount];
+			float shadowFarClip = std::max(std::min(m_Camera->m_FarClip, m_ShadowDistance), m_Camera->m_NearClip + 1.0f);
+			ShadowCascadeFitter::CalculateSplitDepths(m_Camera->m_NearClip, shadowFarClip, m_CascadeSplitLambda, splitDepths);
 
-			unsigned int shadowRenderTargetIndex = 0;
-			for (int i = 0; i < m_DirectionalLights.size(); i++) //We usually have 1 directional light source.
+			unsigned int shadowCascadeMapIndex = 0;
+			for (unsigned int i = 0; i < m_DirectionalLights.size(); i++) //We usually have 1 directional light source.
 			{
 				DirectionalLight* directionalLight = m_DirectionalLights[i];
-				if (directionalLight->m_ShadowCastingEnabled)
+				if (!directionalLight->m_ShadowCastingEnabled)
 				{
-					m_MaterialLibrary->m_DirectionalShadowShader->UseShader();
+					directionalLight->m_ShadowCascadeMap = nullptr;
+					continue;
+				}
 
-					glBindFramebuffer(GL_FRAMEBUFFER, m_ShadowRenderTargets[shadowRenderTargetIndex]->m_FramebufferID);
-					glViewport(0, 0, m_ShadowRenderTargets[shadowRenderTargetIndex]->m_FramebufferWidth, m_ShadowRenderTargets[shadowRenderTargetIndex]->m_FramebufferHeight);
-					glClear(GL_DEPTH_BUFFER_BIT);
+				if (shadowCascadeMapIndex == m_ShadowCascadeMaps.size())
+				{
+					m_ShadowCascadeMaps.push_back(new ShadowCascadeMap(2048, ShadowCascadeCount));
+				}
+				ShadowCascadeMap* shadowCascadeMap = m_ShadowCascadeMaps[shadowCascadeMapIndex++];
+				directionalLight->m_ShadowCascadeMap = shadowCascadeMap;
 
-					glm::mat4 lightProjectionMatrix = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, -15.0f, 20.0f);
-					glm::mat4 lightViewMatrix = glm::lookAt(-directionalLight->m_LightDirection * 10.0f, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+				Shader* shadowShader = m_MaterialLibrary->m_DirectionalShadowShader;
+				shadowShader->UseShader();
 
-					m_DirectionalLights[i]->m_LightSpaceViewProjectionMatrix = lightProjectionMatrix * lightViewMatrix;
-					m_DirectionalLights[i]->m_ShadowMapRenderTarget = m_ShadowRenderTargets[shadowRenderTargetIndex];
+				for (unsigned int j = 0; j < ShadowCascadeCount; j++)
+				{
+					float sliceNear = j == 0 ? m_Camera->m_NearClip : splitDepths[j - 1];
+					ShadowCascade shadowCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(*m_Camera, sliceNear, splitDepths[j], directionalLight->m_LightDirection,
+						shadowCasterBounds, shadowCascadeMap->RetrieveResolution(), m_ShadowCascadePadding, &directionalLight->m_CascadeVolumes[j]);
+
+					glm::mat4 lightSpaceViewProjection = shadowCascade.m_LightProjectionMatrix * shadowCascade.m_LightViewMatrix;
+					directionalLight->m_CascadeViewProjectionMatrices[j] = lightSpaceViewProjection;
+					directionalLight->m_CascadeSplitDepths[j] = splitDepths[j];
+
+					//Light space matrices are shared by every caster, so we only set them once per cascade.
+					shadowShader->SetUniform(UID("lightSpaceProjection"), shadowCascade.m_LightProjectionMatrix);
+					shadowShader->SetUniform(UID("lightSpaceView"), shadowCascade.m_LightViewMatrix);
+
+					//Only casters overlapping the cascade's light volume are drawn into it. The volume holds still until the camera leaves its padding, so the static
+					//layer is kept across camera motion until then, or until the static casters change.
+					Frustum cascadeFrustum(lightSpaceViewProjection);
+					bool staticCascadeCached = shadowCascadeMap->IsStaticCascadeCached(j, lightSpaceViewProjection);
+					if (!staticCascadeCached)
+					{
+						shadowCascadeMap->BindStaticCascadeFramebuffer(m_GLStateCache, j);
+						glClear(GL_DEPTH_BUFFER_BIT);
+						RenderShadowCasters(m_RenderQueue->RetrieveShadowCastingRenderCommands(cascadeFrustum, ShadowCaster_Static));
+						shadowCascadeMap->MarkStaticCascadeCached(j, lightSpaceViewProjection);
+					}
 
-					//This varies based on the amount of objects in our scene that can cast shadows on objects. This filtered whenever we submit commands into the render queue.
-					//By default, all physical objects in the scene can cast and receive shadows.
-					for (int j = 0; j < shadowRenderCommands.size(); j++) 
+					//Dynamic casters are composited over a copy of the static depths. If there are none and the static layer is unchanged, last frame's result stands.
+					RenderCommandList dynamicRenderCommands = m_RenderQueue->RetrieveShadowCastingRenderCommands(cascadeFrustum, ShadowCaster_Dynamic);
+					if (!staticCascadeCached || !dynamicRenderCommands.empty() || !shadowCascadeMap->IsCascadeStatic(j))
 					{
-						RenderShadowCastCommand(&shadowRenderCommands[j], lightProjectionMatrix, lightViewMatrix);
+						shadowCascadeMap->CopyStaticCascade(j);
+						if (!dynamicRenderCommands.empty())
+						{
+							shadowCascadeMap->BindCascadeFramebuffer(m_GLStateCache, j);
+							RenderShadowCasters(dynamicRenderCommands);
+						}
 					}
-					shadowRenderTargetIndex++;
 				}
+				directionalLight->m_LightSpaceViewProjectionMatrix = directionalLight->m_CascadeViewProjectionMatrices[0];
 			}
 			m_GLStateCache->SetCulledFace(GL_BACK);
+			m_StaticShadowsDirty = false;
+
+			//Light space matrices are now known for this frame.
+			UpdateGlobalUniformBufferObjects(m_Camera);
+
+			//Back to the GBuffer, whose draw buffers are restored below.
+			m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_GBuffer->m_FramebufferID);
 		}
 		attachments[0] = GL_COLOR_ATTACHMENT0;
 		glDrawBuffers(4, attachments);
@@ -226,8 +448,8 @@ namespace Crescent
 		m_PostProcessor->ProcessPreLighting(this, m_GBuffer, m_Camera);
 
 		//4) Render deferred shader for each light (full quad for directional, spheres for point lights).
-		glBindFramebuffer(GL_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID);
-		glViewport(0, 0, m_CustomRenderTarget->m_FramebufferWidth, m_CustomRenderTarget->m_FramebufferHeight);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID);
+		m_GLStateCache->SetViewport(0, 0, m_CustomRenderTarget->m_FramebufferWidth, m_CustomRenderTarget->m_FramebufferHeight);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 		m_GLStateCache->ToggleDepthTesting(false);
@@ -251,13 +473,10 @@ namespace Crescent
 			}
 			
 			//Point Lights
-			m_GLStateCache->SetCulledFace(GL_FRONT);
-			for (auto iterator = m_PointLights.begin(); iterator != m_PointLights.end(); iterator++) //Remember that our objects are stored as pointers, thus the dereference.
+			if (m_VisibleLightCount > 0)
 			{
-				///Frustrum Check.
-				RenderDeferredPointLight(*iterator);
+				RenderDeferredPointLights();
 			}
-			m_GLStateCache->SetCulledFace(GL_BACK);
 		}
 
 		m_GLStateCache->ToggleDepthTesting(true);
@@ -265,8 +484,8 @@ namespace Crescent
 		m_GLStateCache->ToggleBlending(false);
 
 		//5) Blit Depth Framebuffer to Default for Rendering
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_GBuffer->m_FramebufferID);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID); //Write to our default framebuffer.
+		m_GLStateCache->BindFramebuffer(GL_READ_FRAMEBUFFER, m_GBuffer->m_FramebufferID);
+		m_GLStateCache->BindFramebuffer(GL_DRAW_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID); //Write to our default framebuffer.
 		glBlitFramebuffer(0, 0, m_GBuffer->m_FramebufferWidth, m_GBuffer->m_FramebufferHeight, 0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 		
 		//6) Custom Forward Render Pass
@@ -276,8 +495,8 @@ namespace Crescent
 			RenderTarget* renderTarget = m_RenderTargetsCustom[targetIndex];
 			if (renderTarget)
 			{
-				glViewport(0, 0, renderTarget->m_FramebufferWidth, renderTarget->m_FramebufferHeight);
-				glBindFramebuffer(GL_FRAMEBUFFER, renderTarget->m_FramebufferID);
+				m_GLStateCache->SetViewport(0, 0, renderTarget->m_FramebufferWidth, renderTarget->m_FramebufferHeight);
+				m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, renderTarget->m_FramebufferID);
 				if (renderTarget->m_HasDepthAndStencilAttachments)
 				{
 					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -287,17 +506,19 @@ namespace Crescent
 					glClear(GL_COLOR_BUFFER_BIT);
 				}
 				m_Camera->SetPerspectiveMatrix(glm::radians(60.0f), ((float)renderTarget->m_FramebufferWidth / (float)renderTarget->m_FramebufferHeight), 0.2f, 100.0f);
+				UpdateGlobalUniformBufferObjects(m_Camera);
 			}
 			else
 			{
 				//Don't render to default framebuffer, but to custom target framebuffer which we will use for postprocessing.
-				glViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
-				glBindFramebuffer(GL_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID);
+				m_GLStateCache->SetViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
+				m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID);
 				m_Camera->SetPerspectiveMatrix(m_Camera->m_FieldOfView, m_RenderWindowSize.x / m_RenderWindowSize.y, 0.1f, 100.0f);
+				UpdateGlobalUniformBufferObjects(m_Camera);
 			}
 
-			///Render custom commands here. (Things with custom material). By default, we will have 1 for the sky.
-			std::vector<RenderCommand> renderCommands = m_RenderQueue->RetrieveCustomRenderCommands(renderTarget);
+			///Render custom commands here. (Things with custom material). By default, we will have 1 for the sky, which has no bounds and is never culled.
+			RenderCommandList renderCommands = m_RenderQueue->RetrieveCustomRenderCommands(renderTarget, m_FrustumCullingEnabled);
 
 			//Iterate over all render commands and execute.
 			m_GLStateCache->SetPolygonMode(m_WireframesEnabled ? GL_LINE : GL_FILL);
@@ -316,7 +537,7 @@ namespace Crescent
 		//Render Light Mesh (as visual cue), if requested.
 		for (auto iterator = m_PointLights.begin(); iterator != m_PointLights.end(); iterator++)
 		{
-			if ((*iterator)->m_RenderMesh)
+			if ((*iterator)->m_RenderMesh && (*iterator)->m_IsLightVisible)
 			{
 				m_MaterialLibrary->m_DebugLightMaterial->SetShaderVector3("lightColor", (*iterator)->m_LightColor * (*iterator)->m_LightIntensity * 0.25f);
 			
@@ -336,14 +557,18 @@ namespace Crescent
 		//8) Pody-Processing Stage after all lighting calculations.
 
 		//9) Render Debug Visuals
-		glViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
-		glBindFramebuffer(GL_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID);
+		m_GLStateCache->SetViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_CustomRenderTarget->m_FramebufferID);
 		if (m_ShowDebugLightVolumes)
 		{
 			m_GLStateCache->SetPolygonMode(GL_LINE);
 			m_GLStateCache->SetCulledFace(GL_FRONT);
 			for (auto iterator = m_PointLights.begin(); iterator != m_PointLights.end(); iterator++)
 			{
+				if (!(*iterator)->m_IsLightVisible)
+				{
+					continue;
+				}
 				m_MaterialLibrary->m_DebugLightMaterial->SetShaderVector3("lightColor", (*iterator)->m_LightColor);
 
 				RenderCommand renderCommand;
@@ -362,7 +587,7 @@ namespace Crescent
 		}
 
 		//10) Custom Post Processing Pass
-		std::vector<RenderCommand> postProcessingCommands = m_RenderQueue->RetrievePostProcessingRenderCommands();
+		RenderCommandList postProcessingCommands = m_RenderQueue->RetrievePostProcessingRenderCommands();
 		for (unsigned int i = 0; i < postProcessingCommands.size(); i++)
 		{
 			//Ping Pong
@@ -374,16 +599,23 @@ namespace Crescent
 		//11) Finally, Blit everything to our framebuffer for rendering.
 		BlitToMainFramebuffer(postProcessingCommands.size() % 2 == 0 ? m_CustomRenderTarget->RetrieveColorAttachment(0) : m_PostProcessRenderTarget->RetrieveColorAttachment(0));
 
+		//A frame queuing no more commands than an earlier one is served from the memory that frame left behind, without touching the heap.
+		size_t queuedCommandCount = m_RenderQueue->RetrieveQueuedCommandCount();
 		m_RenderQueue->ClearQueuedCommands();
+		assert(queuedCommandCount > m_PeakQueuedCommandCount || m_RenderQueue->RetrieveHeapAllocationCount() == m_QueueHeapAllocationCount);
+		m_PeakQueuedCommandCount = std::max(m_PeakQueuedCommandCount, queuedCommandCount);
+		m_QueueHeapAllocationCount = m_RenderQueue->RetrieveHeapAllocationCount();
 		m_RenderTargetsCustom.clear();
+		m_RecomputedTransformCount = SceneEntity::RetrieveTransformHierarchy().ConsumeRecomputedTransformCount();
+		m_ObjectUniformRingBuffer->EndFrame();
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void Renderer::BlitToMainFramebuffer(Texture* sourceRenderTarget)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_MainRenderTarget->m_FramebufferID);
-		glViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_MainRenderTarget->m_FramebufferID);
+		m_GLStateCache->SetViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 		//Bind Input Texture Data
@@ -392,9 +624,9 @@ namespace Crescent
 		m_GBuffer->RetrieveColorAttachment(3)->BindTexture(5);
 
 		m_PostProcessor->m_PostProcessingShader->UseShader();
-		m_PostProcessor->m_PostProcessingShader->SetUniformBool("SSAO", true);
-		m_PostProcessor->m_PostProcessingShader->SetUniformBool("GreyscaleEnabled", m_PostProcessor->m_GreyscaleEnabled);
-		m_PostProcessor->m_PostProcessingShader->SetUniformBool("InverseEnabled", m_PostProcessor->m_InversionEnabled);
+		m_PostProcessor->m_PostProcessingShader->SetUniform(UID("SSAO"), true);
+		m_PostProcessor->m_PostProcessingShader->SetUniform(UID("GreyscaleEnabled"), m_PostProcessor->m_GreyscaleEnabled);
+		m_PostProcessor->m_PostProcessingShader->SetUniform(UID("InverseEnabled"), m_PostProcessor->m_InversionEnabled);
 
 		RenderMesh(m_NDCQuad);
 	}
@@ -404,8 +636,8 @@ namespace Crescent
 		//If a destination is given, bind to its framebuffer.
 		if (targetDestination)
 		{
-			glViewport(0, 0, targetDestination->m_FramebufferWidth, targetDestination->m_FramebufferHeight);
-			glBindFramebuffer(GL_FRAMEBUFFER, targetDestination->m_FramebufferID);
+			m_GLStateCache->SetViewport(0, 0, targetDestination->m_FramebufferWidth, targetDestination->m_FramebufferHeight);
+			m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, targetDestination->m_FramebufferID);
 			if (targetDestination->m_HasDepthAndStencilAttachments)
 			{
 				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -418,8 +650,8 @@ namespace Crescent
 		//Else, we bind to the default framebuffer.
 		else
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, m_MainRenderTarget->m_FramebufferID);
-			glViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
+			m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_MainRenderTarget->m_FramebufferID);
+			m_GLStateCache->SetViewport(0, 0, m_RenderWindowSize.x, m_RenderWindowSize.y);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 		}
 		//If no material was given, we use our default blit material.
@@ -445,11 +677,11 @@ namespace Crescent
 		RenderQueue renderQueue(this);
 		renderQueue.PushToRenderQueue(sceneEntity->m_Mesh, sceneEntity->m_Material, sceneEntity->RetrieveEntityTransform());
 
-		std::vector<RenderCommand> renderCommands = renderQueue.RetrieveCustomRenderCommands(nullptr);
+		RenderCommandList renderCommands = renderQueue.RetrieveCustomRenderCommands(nullptr);
 		RenderCubemap(renderCommands, cubemapTarget, position, mipmappingLevel);
 	}
 
-	void Renderer::RenderCubemap(std::vector<RenderCommand>& renderCommands, TextureCube* cubeTarget, glm::vec3 position, unsigned int mipmappingLevel)
+	void Renderer::RenderCubemap(const RenderCommandList& renderCommands, TextureCube* cubeTarget, glm::vec3 position, unsigned int mipmappingLevel)
 	{
 		//Define 6 camera directions/lookup vectors.
 		Camera faceCameras[6] =
@@ -466,14 +698,14 @@ namespace Crescent
 		float width = (float)cubeTarget->m_TextureCubeFaceWidth * std::pow(0.5f, mipmappingLevel);
 		float height = (float)cubeTarget->m_TextureCubeFaceHeight * std::pow(0.5f, mipmappingLevel);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, m_CubemapFramebufferID);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_CubemapFramebufferID);
 		glBindRenderbuffer(GL_RENDERBUFFER, m_CubemapDepthRenderbufferID);
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_CubemapDepthRenderbufferID);
 
 		//Resize the relevant buffers.
-		glViewport(0, 0, width, height);
-		glBindFramebuffer(GL_FRAMEBUFFER, m_CubemapFramebufferID);
+		m_GLStateCache->SetViewport(0, 0, width, height);
+		m_GLStateCache->BindFramebuffer(GL_FRAMEBUFFER, m_CubemapFramebufferID);
 
 		for (unsigned int i = 0; i < 6; i++) //Inject the actual texture data (We only default initialized it).
 		{
@@ -481,6 +713,7 @@ namespace Crescent
 			camera->m_ProjectionMatrix = glm::perspective(glm::radians(90.0f), width / height, 0.1f, 100.0f);
 			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubeTarget->m_TextureCubeID, mipmappingLevel);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			UpdateGlobalUniformBufferObjects(camera);
 
 			for (unsigned int i = 0; i < renderCommands.size(); i++)
 			{
@@ -492,19 +725,46 @@ namespace Crescent
 				RenderCustomCommand(&renderCommands[i], camera);
 			}
 		}
+
+		//Restore the scene camera for everything rendered after us.
+		UpdateGlobalUniformBufferObjects(m_Camera);
 	}
 
 	//Renders from the light's point of view. 
-	void Renderer::RenderShadowCastCommand(RenderCommand* renderCommand, const glm::mat4& lightSpaceProjectionMatrix, const glm::mat4& lightSpaceViewMatrix)
+	void Renderer::RenderShadowCastCommand(RenderCommand* renderCommand)
+	{
+		//Depth passes only read positions, so we draw from the packed position stream to cut down on vertex fetch.
+		BindObjectUniforms(m_MaterialLibrary->m_DirectionalShadowShader, renderCommand->m_Mesh, renderCommand->m_Transform, false);
+		RenderMesh(renderCommand->m_Mesh, true, renderCommand->m_LODIndex);
+	}
+
+	void Renderer::RenderShadowCastBatch(const RenderCommandList& renderCommands, const InstanceBatch& instanceBatch)
 	{
-		Shader* shadowShader = m_MaterialLibrary->m_DirectionalShadowShader;
+		BindObjectUniforms(m_MaterialLibrary->m_DirectionalShadowShader, renderCommands[instanceBatch.m_FirstCommand].m_Mesh, glm::mat4(1.0f), true);
+		const RenderCommand& batchCommand = renderCommands[instanceBatch.m_FirstCommand];
+		RenderMeshInstanced(batchCommand.m_Mesh, instanceBatch.m_FirstCommand, instanceBatch.m_InstanceCount, true, batchCommand.m_LODIndex);
+	}
 
-		shadowShader->UseShader();
-		shadowShader->SetUniformMat4("lightSpaceProjection", lightSpaceProjectionMatrix);
-		shadowShader->SetUniformMat4("lightSpaceView", lightSpaceViewMatrix);
-		shadowShader->SetUniformMat4("model", renderCommand->m_Transform);
+	void Renderer::RenderShadowCasters(const RenderCommandList& shadowRenderCommands)
+	{
+		//Casters all share the shadow shader, so only the mesh needs to match for them to be instanced together.
+		InstanceBatcher::FormInstanceBatches(shadowRenderCommands, false, m_InstanceBatches, m_InstanceData);
+		UploadInstanceData();
 
-		RenderMesh(renderCommand->m_Mesh);
+		for (unsigned int i = 0; i < m_InstanceBatches.size(); i++)
+		{
+			if (m_InstancingEnabled && m_InstanceBatches[i].m_InstanceCount > 1)
+			{
+				RenderShadowCastBatch(shadowRenderCommands, m_InstanceBatches[i]);
+			}
+			else
+			{
+				for (unsigned int j = 0; j < m_InstanceBatches[i].m_InstanceCount; j++)
+				{
+					RenderShadowCastCommand(&shadowRenderCommands[m_InstanceBatches[i].m_FirstCommand + j]);
+				}
+			}
+		}
 	}
 
 	void Renderer::RenderDeferredDirectionalLight(DirectionalLight* directionalLight)
@@ -513,15 +773,16 @@ namespace Crescent
 		Shader* directionalShader = m_MaterialLibrary->m_DeferredDirectionalLightShader;
 
 		directionalShader->UseShader();
-		directionalShader->SetUniformVector3("cameraPosition", m_Camera->m_CameraPosition);
-		directionalShader->SetUniformVector3("lightDirection", directionalLight->m_LightDirection);
-		directionalShader->SetUniformVector3("lightColor", glm::normalize(directionalLight->m_LightColor) * directionalLight->m_LightIntensity);
-		directionalShader->SetUniformBool("ShadowsEnabled", m_ShadowsEnabled);
+		directionalShader->SetUniform(UID("lightDirection"), directionalLight->m_LightDirection);
+		directionalShader->SetUniform(UID("lightColor"), glm::normalize(directionalLight->m_LightColor) * directionalLight->m_LightIntensity);
+		directionalShader->SetUniform(UID("ShadowsEnabled"), m_ShadowsEnabled);
 
-		if (directionalLight->m_ShadowMapRenderTarget)
+		if (directionalLight->m_ShadowCascadeMap)
 		{
-			directionalShader->SetUniformMat4("lightShadowViewProjection", directionalLight->m_LightSpaceViewProjectionMatrix);
-			directionalLight->m_ShadowMapRenderTarget->RetrieveDepthAndStencilAttachment()->BindTexture(3); //In our material library, we set the shadow map sampler to be in texture slot 3.
+			const float* splitDepths = directionalLight->m_CascadeSplitDepths;
+			directionalShader->SetUniformArray(UID("cascadeViewProjections"), directionalLight->m_CascadeViewProjectionMatrices, ShadowCascadeCount);
+			directionalShader->SetUniform(UID("cascadeSplitDepths"), glm::vec4(splitDepths[0], splitDepths[1], splitDepths[2], splitDepths[3]));
+			directionalLight->m_ShadowCascadeMap->BindShadowMap(3); //In our material library, we set the shadow map sampler to be in texture slot 3.
 		}
 
 		RenderMesh(m_NDCQuad);
@@ -541,38 +802,199 @@ namespace Crescent
 			
 			Shader* ambientShader = m_MaterialLibrary->m_DeferredAmbientLightShader;
 			ambientShader->UseShader();
-			ambientShader->SetUniformVector3("camPos", m_Camera->m_CameraPosition);
-			ambientShader->SetUniformInteger("SSAO", true);
+			ambientShader->SetUniform(UID("SSAO"), true);
 			RenderMesh(m_NDCQuad);
 		}
 	}
 
-	void Renderer::RenderDeferredPointLight(PointLight* pointLight)
+	void Renderer::CullPointLights()
 	{
-		Shader* pointLightShader = m_MaterialLibrary->m_DeferredPointLightShader;
+		m_VisiblePointLights.clear();
+		if (m_FrustumCullingEnabled)
+		{
+			m_PointLightSpheres.resize(m_PointLights.size());
+			for (unsigned int i = 0; i < m_PointLights.size(); i++)
+			{
+				m_PointLightSpheres[i].m_Center = m_PointLights[i]->m_LightPosition;
+				m_PointLightSpheres[i].m_Radius = m_PointLights[i]->m_LightRadius;
+			}
 
-		pointLightShader->UseShader();
-		pointLightShader->SetUniformVector3("cameraPosition", m_Camera->m_CameraPosition);
-		pointLightShader->SetUniformVector3("lightPosition", pointLight->m_LightPosition);
-		pointLightShader->SetUniformFloat("lightRadius", pointLight->m_LightRadius);
-		pointLightShader->SetUniformVector3("lightColor", glm::normalize(pointLight->m_LightColor) * pointLight->m_LightIntensity);
+			//The hierarchy lets whole groups of lights be accepted or rejected at once, which matters once scenes hold thousands of them.
+			m_LightBVH.UpdateHierarchy(m_PointLightSpheres);
+			m_LightBVH.QueryFrustum(m_Camera->RetrieveViewFrustum(), m_VisiblePointLights);
+			std::sort(m_VisiblePointLights.begin(), m_VisiblePointLights.end()); //Keeps the shading order stable between frames.
+		}
+		else
+		{
+			for (uint32_t i = 0; i < m_PointLights.size(); i++)
+			{
+				m_VisiblePointLights.push_back(i);
+			}
+		}
+
+		for (unsigned int i = 0; i < m_PointLights.size(); i++)
+		{
+			m_PointLights[i]->m_IsLightVisible = false;
+		}
+		for (unsigned int i = 0; i < m_VisiblePointLights.size(); i++)
+		{
+			m_PointLights[m_VisiblePointLights[i]]->m_IsLightVisible = true;
+		}
+
+		m_VisibleLightCount = m_VisiblePointLights.size();
+		m_CulledLightCount = m_PointLights.size() - m_VisibleLightCount;
+	}
+
+	//Replaces the storage buffer's contents, letting the driver hand us fresh memory rather than wait on last frame's reads.
+	static void UploadStorageBuffer(unsigned int bufferID, unsigned int bindingPoint, const void* data, size_t byteSize)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferID);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, byteSize > 0 ? byteSize : 16, byteSize > 0 ? data : nullptr, GL_STREAM_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, bufferID);
+	}
+
+	void Renderer::RenderDeferredPointLights()
+	{
+		//Only lights which survived culling are assigned to clusters.
+		m_ClusterLights.resize(m_VisiblePointLights.size());
+		for (unsigned int i = 0; i < m_VisiblePointLights.size(); i++)
+		{
+			PointLight* pointLight = m_PointLights[m_VisiblePointLights[i]];
+			m_ClusterLights[i].m_PositionRadius = glm::vec4(pointLight->m_LightPosition, pointLight->m_LightRadius);
+			m_ClusterLights[i].m_Color = glm::vec4(glm::normalize(pointLight->m_LightColor) * pointLight->m_LightIntensity, 0.0f);
+		}
+
+		m_LightClusterGrid.AssignLights(m_Camera->m_ViewMatrix, m_Camera->m_ProjectionMatrix, m_Camera->m_NearClip, m_Camera->m_FarClip, m_ClusterLights);
 
-		glm::mat4 pointLightModelMatrix = glm::mat4(1.0f);
-		pointLightModelMatrix = glm::translate(pointLightModelMatrix, pointLight->m_LightPosition);
-		pointLightModelMatrix = glm::scale(pointLightModelMatrix, glm::vec3(pointLight->m_LightRadius));
+		const std::vector<LightCluster>& lightClusters = m_LightClusterGrid.RetrieveClusters();
+		const std::vector<uint32_t>& lightIndices = m_LightClusterGrid.RetrieveLightIndices();
+		UploadStorageBuffer(m_ClusterLightBufferID, StorageBinding_ClusterLights, m_ClusterLights.data(), m_ClusterLights.size() * sizeof(ClusterLight));
+		UploadStorageBuffer(m_LightClusterBufferID, StorageBinding_LightClusters, lightClusters.data(), lightClusters.size() * sizeof(LightCluster));
+		UploadStorageBuffer(m_ClusterLightIndexBufferID, StorageBinding_ClusterLightIndices, lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+
+		Shader* pointLightShader = m_MaterialLibrary->m_DeferredPointLightShader;
+		pointLightShader->UseShader();
 
-		pointLightShader->SetUniformMat4("projection", m_Camera->m_ProjectionMatrix);
-		pointLightShader->SetUniformMat4("view", m_Camera->m_ViewMatrix);
-		pointLightShader->SetUniformMat4("model", pointLightModelMatrix);
+		glm::vec3 gridDimensions = glm::vec3(m_LightClusterGrid.RetrieveGridDimensions());
+		pointLightShader->SetUniform(UID("clusterGrid"), glm::vec4(gridDimensions, m_LightClusterGrid.RetrieveNearClip()));
+		pointLightShader->SetUniform(UID("clusterDepthSliceScale"), m_LightClusterGrid.RetrieveDepthSliceScale());
 
-		RenderMesh(m_DeferredPointLightMesh);
+		RenderMesh(m_NDCQuad);
 	}
 
 	void Renderer::RenderCustomCommand(RenderCommand* renderCommand, Camera* customRenderCamera, bool updateGLStates)
 	{
-		Mesh* mesh = renderCommand->m_Mesh;
 		Material* material = renderCommand->m_Material;
+		ApplyMaterialState(material, customRenderCamera, updateGLStates);
+
+		BindObjectUniforms(material->RetrieveMaterialShader(), renderCommand->m_Mesh, renderCommand->m_Transform, false);
+
+		//Meshes split into meshlets at import are culled piecewise at full resolution. Coarser levels are only picked at a distance, where that gains little.
+		if (m_MeshletCullingEnabled && renderCommand->m_LODIndex == 0 && !renderCommand->m_Mesh->m_Meshlets.empty())
+		{
+			RenderMeshlets(renderCommand->m_Mesh, renderCommand->m_Transform, customRenderCamera ? customRenderCamera : m_Camera);
+			return;
+		}
+
+		RenderMesh(renderCommand->m_Mesh, false, renderCommand->m_LODIndex);
+	}
+
+	void Renderer::RenderMeshlets(Mesh* mesh, const glm::mat4& transform, Camera* camera)
+	{
+		//Normal cones are tested against the camera position, which orthographic projections (with their last column being 0, 0, 0, 1) don't look from.
+		bool perspectiveProjection = camera->m_ProjectionMatrix[3][3] == 0.0f;
+		size_t rangeCount = m_MeshletCuller.CullMeshlets(mesh, transform, camera->m_ProjectionMatrix * camera->m_ViewMatrix, camera->m_CameraPosition, perspectiveProjection && m_GLStateCache->CullsBackFaces());
+		if (rangeCount == 0)
+		{
+			return;
+		}
+
+		m_GLStateCache->BindVertexArray(mesh->RetrieveVertexArrayID());
+		//GLEW declares the arrays as non-const, though GL only reads from them.
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, const_cast<GLsizei*>(m_MeshletCuller.RetrieveDrawCounts()), mesh->RetrieveIndexType(),
+			const_cast<void**>(m_MeshletCuller.RetrieveDrawOffsets()), (GLsizei)rangeCount, const_cast<GLint*>(m_MeshletCuller.RetrieveDrawBaseVertices()));
+	}
+
+	void Renderer::RenderInstancedCommand(const RenderCommandList& renderCommands, const InstanceBatch& instanceBatch)
+	{
+		Material* material = renderCommands[instanceBatch.m_FirstCommand].m_Material;
+		ApplyMaterialState(material, nullptr, false);
+
+		//Model matrices are sourced from the instance buffer instead.
+		BindObjectUniforms(material->RetrieveMaterialShader(), renderCommands[instanceBatch.m_FirstCommand].m_Mesh, glm::mat4(1.0f), true);
+
+		const RenderCommand& batchCommand = renderCommands[instanceBatch.m_FirstCommand];
+		RenderMeshInstanced(batchCommand.m_Mesh, instanceBatch.m_FirstCommand, instanceBatch.m_InstanceCount, false, batchCommand.m_LODIndex);
+	}
+
+	void Renderer::PushIndirectDraws(const RenderCommandList& renderCommands, const InstanceBatch& instanceBatch)
+	{
+		const RenderCommand& batchCommand = renderCommands[instanceBatch.m_FirstCommand];
+		Mesh* mesh = batchCommand.m_Mesh;
+
+		DrawElementsIndirectCommand drawCommand;
+		drawCommand.m_InstanceCount = instanceBatch.m_InstanceCount;
+		drawCommand.m_BaseVertex = mesh->RetrieveBaseVertex();
+		drawCommand.m_BaseInstance = instanceBatch.m_FirstCommand;
+
+		//Lone meshes split into meshlets push each of their visible ranges as a command of its own, all reading the same instance.
+		if (instanceBatch.m_InstanceCount == 1 && m_MeshletCullingEnabled && batchCommand.m_LODIndex == 0 && !mesh->m_Meshlets.empty())
+		{
+			bool perspectiveProjection = m_Camera->m_ProjectionMatrix[3][3] == 0.0f;
+			size_t rangeCount = m_MeshletCuller.CullMeshlets(mesh, batchCommand.m_Transform, m_Camera->m_ProjectionMatrix * m_Camera->m_ViewMatrix, m_Camera->m_CameraPosition,
+				perspectiveProjection && m_GLStateCache->CullsBackFaces());
+			for (size_t i = 0; i < rangeCount; i++)
+			{
+				drawCommand.m_IndexCount = (uint32_t)m_MeshletCuller.RetrieveDrawCounts()[i];
+				drawCommand.m_FirstIndex = m_MeshletCuller.RetrieveDrawFirstIndices()[i];
+				m_IndirectCommandBuilder.PushDraw(batchCommand.m_Material, mesh, mesh->RetrieveGeometryPool(), drawCommand);
+			}
+			return;
+		}
+
+		drawCommand.m_IndexCount = (uint32_t)mesh->RetrieveIndexCount(batchCommand.m_LODIndex);
+		drawCommand.m_FirstIndex = (uint32_t)(mesh->RetrieveIndexByteOffset(batchCommand.m_LODIndex) / mesh->RetrieveIndexSize());
+		m_IndirectCommandBuilder.PushDraw(batchCommand.m_Material, mesh, mesh->RetrieveGeometryPool(), drawCommand);
+	}
 
+	void Renderer::RenderIndirectDraws()
+	{
+		const std::vector<DrawElementsIndirectCommand>& drawCommands = m_IndirectCommandBuilder.RetrieveCommands();
+		const std::vector<IndirectDrawGroup>& drawGroups = m_IndirectCommandBuilder.RetrieveGroups();
+		m_IndirectDrawCount = drawGroups.size();
+		m_IndirectCommandCount = drawCommands.size();
+		if (drawCommands.empty())
+		{
+			return;
+		}
+
+		//Orphaned every frame, as with the instance buffer.
+		size_t byteSize = drawCommands.size() * sizeof(DrawElementsIndirectCommand);
+		m_IndirectBufferCapacity = std::max(m_IndirectBufferCapacity, byteSize);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBufferID);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, m_IndirectBufferCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, byteSize, drawCommands.data());
+
+		for (const IndirectDrawGroup& drawGroup : drawGroups)
+		{
+			ApplyMaterialState(drawGroup.m_Material, nullptr, false);
+
+			//Model matrices and dequantization are sourced from the instance buffer. Every mesh of a pool shares its vertex format, which is all the first
+			//mesh stands in for.
+			BindObjectUniforms(drawGroup.m_Material->RetrieveMaterialShader(), drawGroup.m_Mesh, glm::mat4(1.0f), true);
+			if (!drawGroup.m_Mesh->HasInstanceAttributes(m_InstanceBufferID))
+			{
+				drawGroup.m_Mesh->ConfigureInstanceAttributes(m_InstanceBufferID);
+			}
+
+			m_GLStateCache->BindVertexArray(drawGroup.m_GeometryPool->RetrieveVertexArrayID());
+			glMultiDrawElementsIndirect(GL_TRIANGLES, drawGroup.m_GeometryPool->RetrieveIndexType(), (const void*)(drawGroup.m_FirstCommand * sizeof(DrawElementsIndirectCommand)),
+				(GLsizei)drawGroup.m_CommandCount, 0);
+		}
+	}
+
+	void Renderer::ApplyMaterialState(Material* material, Camera* customRenderCamera, bool updateGLStates)
+	{
 		//Update global OpenGL states based on the material.
 		if (updateGLStates)
 		{
@@ -589,105 +1011,86 @@ namespace Crescent
 		}
 
 		//Default uniforms that are always configured regardless of shader configuration. See these as a set of default shader variables that are always there.
-		///To implement with Uniform Buffer Objects.
+		//Shaders including Uniforms.shader read them from the global uniform buffer instead, which is only written when the camera changes.
+		bool usesGlobalUniforms = material->RetrieveMaterialShader()->UsesGlobalUniforms();
 		material->RetrieveMaterialShader()->UseShader();
-		material->RetrieveMaterialShader()->SetUniformMat4("projection", m_Camera->m_ProjectionMatrix);
-		material->RetrieveMaterialShader()->SetUniformMat4("view", m_Camera->m_ViewMatrix);
-		material->RetrieveMaterialShader()->SetUniformVector3("cameraPosition", m_Camera->m_CameraPosition);
-
-		if (customRenderCamera) //If a custom camera is defined, we will update our shader uniforms with its information as needed.
+		if (!usesGlobalUniforms)
 		{
-			material->RetrieveMaterialShader()->SetUniformMat4("projection", customRenderCamera->m_ProjectionMatrix);
-			material->RetrieveMaterialShader()->SetUniformMat4("view", customRenderCamera->m_ViewMatrix);
-			material->RetrieveMaterialShader()->SetUniformVector3("cameraPosition", customRenderCamera->m_CameraPosition);
+			Camera* camera = customRenderCamera ? customRenderCamera : m_Camera; //If a custom camera is defined, we will update our shader uniforms with its information as needed.
+			material->RetrieveMaterialShader()->SetUniform(UID("projection"), camera->m_ProjectionMatrix);
+			material->RetrieveMaterialShader()->SetUniform(UID("view"), camera->m_ViewMatrix);
+			material->RetrieveMaterialShader()->SetUniform(UID("cameraPosition"), camera->m_CameraPosition);
 		}
 
 		//==============================================
-		material->RetrieveMaterialShader()->SetUniformMat4("model", renderCommand->m_Transform);
-
 		///Shadow Related Stuff. Create Shaders for relevant stuff in Material Library.
-		material->RetrieveMaterialShader()->SetUniformBool("ShadowsEnabled", m_ShadowsEnabled); //If global shadows are enabled.
+		material->RetrieveMaterialShader()->SetUniform(UID("ShadowsEnabled"), m_ShadowsEnabled); //If global shadows are enabled.
 		if (m_ShadowsEnabled && material->m_MaterialType == Material_Custom && material->m_ShadowReceiving) //If the mesh in question should receive shadows...
 		{
-			for (int i = 0; i < m_DirectionalLights.size(); i++)
+			//Light space matrices are only declared in Uniforms.shader, and so always come from the global uniform buffer.
+			for (unsigned int i = 0; i < m_DirectionalLights.size(); i++)
 			{
-				if (m_DirectionalLights[i]->m_ShadowMapRenderTarget != nullptr)
+				if (m_DirectionalLights[i]->m_ShadowCascadeMap != nullptr)
 				{
-					material->RetrieveMaterialShader()->SetUniformMat4("lightShadowViewProjection" + std::to_string(i + 1), m_DirectionalLights[i]->m_LightSpaceViewProjectionMatrix);
-					m_DirectionalLights[i]->m_ShadowMapRenderTarget->RetrieveDepthAndStencilAttachment()->BindTexture(10 + i);
+					m_DirectionalLights[i]->m_ShadowCascadeMap->BindShadowMap(10 + i);
 				}
 			}
 		}
 
-		//Bind and set active uniform sampler/texture objects.
-		auto* samplers = material->GetSamplerUniforms(); //Returns a map of a string (uniform name) and its corresponding uniform information.
-		for (auto iterator = samplers->begin(); iterator != samplers->end(); iterator++)
+		//Bind the material's textures and parameters. These are compiled into a block with resolved locations, and only re-uploaded when changed.
+		material->ApplyParameters();
+	}
+
+	void Renderer::RenderMesh(Mesh* mesh, bool positionsOnly, unsigned int lodIndex)
+	{
+		m_GLStateCache->BindVertexArray(positionsOnly ? mesh->RetrieveDepthVertexArrayID() : mesh->RetrieveVertexArrayID()); //Binding will automatically fill the vertex array with the attributes allocated during its time. 
+		if (mesh->m_Indices.size() > 0)
 		{
-			if (iterator->second.m_UniformType == Shader_Type_SamplerCube)
-			{
-				iterator->second.m_TextureCube->BindTextureCube(iterator->second.m_TextureUnit);
-			}
-			else
-			{
-				iterator->second.m_Texture->BindTexture(iterator->second.m_TextureUnit);
-			}
+			glDrawElementsBaseVertex(mesh->m_Topology == TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh->RetrieveIndexCount(lodIndex), mesh->RetrieveIndexType(),
+				(GLvoid*)mesh->RetrieveIndexByteOffset(lodIndex, positionsOnly), mesh->RetrieveBaseVertex(positionsOnly));
 		}
-
-		//Set uniform states of material.
-		auto* uniforms = material->GetUniforms(); //Returns a map of a string (uniform name) and its corresponding uniform information.
-		for (auto iterator = uniforms->begin(); iterator != uniforms->end(); iterator++)
+		else
 		{
-			switch (iterator->second.m_UniformType)
-			{
-			case Shader_Type_Boolean:
-				material->RetrieveMaterialShader()->SetUniformBool(iterator->first, iterator->second.m_BoolValue);
-				break;
-			case Shader_Type_Integer:
-				material->RetrieveMaterialShader()->SetUniformInteger(iterator->first, iterator->second.m_IntValue);
-				break;
-			case Shader_Type_Float:
-				material->RetrieveMaterialShader()->SetUniformFloat(iterator->first, iterator->second.m_FloatValue);
-				break;
-			//case Shader_Type_Vec2:
-				//material->RetrieveMaterialShader()->SetUniformVector2(it->first, it->second.Vec2);
-				//break;
-			case Shader_Type_Vector3:
-				material->RetrieveMaterialShader()->SetUniformVector3(iterator->first, iterator->second.m_Vector3Value);
-				break;
-			//case Shader_Type_Vec4:
-				//material->RetrieveMaterialShader()->SetVector(it->first, it->second.Vec4);
-				//break;
-			//case Shader_Type_Mat2:
-				//material->RetrieveMaterialShader()->SetMatrix(it->first, it->second.Mat2);
-				//break;
-			//case Shader_Type_Mat3:
-				//material->RetrieveMaterialShader()->SetMatrix(it->first, it->second.Mat3);
-				//break;
-			case Shader_Type_Matrix4:
-				material->RetrieveMaterialShader()->SetUniformMat4(iterator->first, iterator->second.m_Mat4Value);
-				break;
-			default:
-				CrescentError("You tried to set an unidentified uniform data type and value. Please check."); //Include which shader.
-				break;
-			}
+			glDrawArrays(mesh->m_Topology == TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, 0, mesh->m_Positions.size());
 		}
-
-		RenderMesh(renderCommand->m_Mesh);
 	}
 
-	void Renderer::RenderMesh(Mesh* mesh)
+	void Renderer::RenderMeshInstanced(Mesh* mesh, unsigned int baseInstance, unsigned int instanceCount, bool positionsOnly, unsigned int lodIndex)
 	{
-		glBindVertexArray(mesh->RetrieveVertexArrayID()); //Binding will automatically fill the vertex array with the attributes allocated during its time. 
+		if (!mesh->HasInstanceAttributes(m_InstanceBufferID))
+		{
+			mesh->ConfigureInstanceAttributes(m_InstanceBufferID);
+		}
+
+		//Base instance offsets into the instance buffer, so every batch can share the attribute setup above.
+		m_GLStateCache->BindVertexArray(positionsOnly ? mesh->RetrieveDepthVertexArrayID() : mesh->RetrieveVertexArrayID());
 		if (mesh->m_Indices.size() > 0)
 		{
-			glDrawElements(mesh->m_Topology == TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh->m_Indices.size(), GL_UNSIGNED_INT, 0);
+			glDrawElementsInstancedBaseVertexBaseInstance(mesh->m_Topology == TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh->RetrieveIndexCount(lodIndex), mesh->RetrieveIndexType(),
+				(GLvoid*)mesh->RetrieveIndexByteOffset(lodIndex, positionsOnly), instanceCount, mesh->RetrieveBaseVertex(positionsOnly), baseInstance);
 		}
 		else
 		{
-			glDrawArrays(mesh->m_Topology == TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, 0, mesh->m_Positions.size());
+			glDrawArraysInstancedBaseInstance(mesh->m_Topology == TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, 0, mesh->m_Positions.size(), instanceCount, baseInstance);
 		}
 	}
 
+	void Renderer::UploadInstanceData()
+	{
+		if (m_InstanceData.empty())
+		{
+			return;
+		}
+
+		//Orphan the previous contents so that we never stall on draws still reading from them.
+		size_t byteSize = m_InstanceData.size() * sizeof(InstanceData);
+		m_InstanceBufferCapacity = std::max(m_InstanceBufferCapacity, byteSize);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBufferID);
+		glBufferData(GL_ARRAY_BUFFER, m_InstanceBufferCapacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, byteSize, m_InstanceData.data());
+	}
+
 	void Renderer::SetRenderingWindowSize(int newWidth, int newHeight)
 	{
 		m_RenderWindowSize = glm::vec2(newWidth, newHeight);
@@ -709,9 +1112,9 @@ namespace Crescent
 		return m_GBuffer;
 	}
 
-	RenderTarget* Renderer::RetrieveShadowRenderTarget(int index)
+	ShadowCascadeMap* Renderer::RetrieveShadowCascadeMap(int index)
 	{
-		return m_ShadowRenderTargets[index];
+		return index < m_ShadowCascadeMaps.size() ? m_ShadowCascadeMaps[index] : nullptr;
 	}
 
 	RenderTarget* Renderer::RetrieveCustomRenderTarget()
@@ -754,11 +1157,41 @@ namespace Crescent
 		m_PBR->SetSkyCapture(capturedEnvironment);
 	}
 
-	void Renderer::UpdateGlobalUniformBufferObjects()
+	void Renderer::UpdateGlobalUniformBufferObjects(Camera* camera)
 	{
-		//glBindBuffer(GL_UNIFORM_BUFFER, m_GlobalUniformBufferID);
-		//For now, we will update the global uniforms here. 
-		//glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(m_Camera->m_ProjectionMatrix);
-		//glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(m_Camera->GetViewMatrix()));
+		if (!camera)
+		{
+			return;
+		}
+
+		m_GlobalUniformData.m_Projection = camera->m_ProjectionMatrix;
+		m_GlobalUniformData.m_View = camera->m_ViewMatrix;
+		m_GlobalUniformData.m_CameraPosition = glm::vec4(camera->m_CameraPosition, 1.0f);
+		for (unsigned int i = 0; i < m_DirectionalLights.size() && i < 4; i++)
+		{
+			m_GlobalUniformData.m_LightShadowViewProjections[i] = m_DirectionalLights[i]->m_LightSpaceViewProjectionMatrix;
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_GlobalUniformBufferID);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GlobalUniformData), &m_GlobalUniformData);
+	}
+
+	void Renderer::BindObjectUniforms(Shader* shader, const Mesh* mesh, const glm::mat4& modelMatrix, bool instancingEnabled)
+	{
+		//Packed vertex formats can only be decoded by shaders reading the object uniform block.
+		if (shader->UsesObjectUniforms())
+		{
+			ObjectUniformData objectUniformData;
+			objectUniformData.m_Model = modelMatrix;
+			objectUniformData.m_InstancingEnabled = instancingEnabled;
+			objectUniformData.m_PackedVertexAttributes = mesh->RetrieveVertexFormat() != VertexFormat_Float;
+			objectUniformData.m_PositionOffset = glm::vec4(mesh->RetrievePositionOffset(), 0.0f);
+			objectUniformData.m_PositionScale = glm::vec4(mesh->RetrievePositionScale(), 0.0f);
+			m_ObjectUniformRingBuffer->BindUniformData(UniformBinding_Object, &objectUniformData, sizeof(ObjectUniformData));
+		}
+		else
+		{
+			shader->SetUniform(UID("model"), modelMatrix);
+		}
 	}
 }
\ No newline at end of file
@@ -2,12 +2,19 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include "RenderCommand.h"
+#include "InstanceBatcher.h"
+#include "LightClusterGrid.h"
+#include "LightBVH.h"
+#include "MeshletCuller.h"
+#include "IndirectCommandBuilder.h"
+#include "UniformBlocks.h"
 #include "EnvironmentalPBR.h"
 #include "PBR.h"
 
 namespace Crescent
 {
 	class SceneEntity;
+	class Scene;
 	class RenderQueue;
 	class Shader;
 	class GLStateCache;
@@ -24,6 +31,9 @@ namespace Crescent
 	class EnvironmentalPBR;
 	class PBR;
 	class PostProcessor;
+	class UniformRingBuffer;
+	class ShadowCascadeMap;
+	class GeometryArena;
 
 	class Renderer
 	{
@@ -37,8 +47,11 @@ namespace Crescent
 
 		//Rendering Items
 		void PushToRenderQueue(SceneEntity* sceneEntity);
+		//Pushes the scene's entities that are in view or may cast shadows into it, as found through its spatial index.
+		void PushToRenderQueue(Scene* scene);
 		void RenderAllQueueItems();
-		void RenderMesh(Mesh* mesh);
+		void RenderMesh(Mesh* mesh, bool positionsOnly = false, unsigned int lodIndex = 0);
+		void RenderMeshInstanced(Mesh* mesh, unsigned int baseInstance, unsigned int instanceCount, bool positionsOnly = false, unsigned int lodIndex = 0);
 
 		//Window Size
 		void SetRenderingWindowSize(int newWidth, int newHeight);
@@ -61,7 +74,7 @@ namespace Crescent
 
 		//Cubemap
 		void RenderCubemap(SceneEntity* sceneEntity, TextureCube* cubemapTarget, glm::vec3 position = glm::vec3(0.0f), unsigned int mipmappingLevel = 0);
-		void RenderCubemap(std::vector<RenderCommand>& renderCommands, TextureCube* cubeTarget, glm::vec3 position = glm::vec3(0.0f), unsigned int mipmappingLevel = 0);
+		void RenderCubemap(const RenderCommandList& renderCommands, TextureCube* cubeTarget, glm::vec3 position = glm::vec3(0.0f), unsigned int mipmappingLevel = 0);
 
 		const char* RetrieveDeviceRendererInformation() const { return m_DeviceRendererInformation; }
 		const char* RetrieveDeviceVendorInformation() const { return m_DeviceVendorInformation; }
@@ -70,39 +83,85 @@ namespace Crescent
 
 		GLStateCache* RetrieveGLStateCache() { return m_GLStateCache; }
 
+		//Point light culling statistics of the most recent frame.
+		size_t RetrieveVisibleLightCount() const { return m_VisibleLightCount; }
+		size_t RetrieveCulledLightCount() const { return m_CulledLightCount; }
+		//Entity world matrices recomputed during the most recent frame.
+		size_t RetrieveRecomputedTransformCount() const { return m_RecomputedTransformCount; }
+		const MeshletCuller& RetrieveMeshletCuller() const { return m_MeshletCuller; }
+		//Multi-draws issued for the geometry buffer during the most recent frame, and the indirect commands they held.
+		size_t RetrieveIndirectDrawCount() const { return m_IndirectDrawCount; }
+		size_t RetrieveIndirectCommandCount() const { return m_IndirectCommandCount; }
+		const GeometryArena* RetrieveGeometryArena() const { return m_GeometryArena; }
+		RenderQueue* RetrieveRenderQueue() { return m_RenderQueue; }
+
 		RenderTarget* RetrieveMainRenderTarget();
 		RenderTarget* RetrieveGBuffer();
-		RenderTarget* RetrieveShadowRenderTarget(int index = 0);
+		ShadowCascadeMap* RetrieveShadowCascadeMap(int index = 0); //Returns nullptr until a shadow casting light has been rendered.
 		RenderTarget* RetrieveCustomRenderTarget();
 
 	public:
 		bool m_ShadowsEnabled = true;
+		bool m_FrustumCullingEnabled = true;
+		bool m_InstancingEnabled = true;
 		bool m_LightsEnabled = true;
 		bool m_ShowDebugLightVolumes = true;
 		bool m_WireframesEnabled = false;
 		bool m_CubemapEnabled = true;
 		bool m_IBLAmbience = true;
+		bool m_StaticShadowCachingEnabled = true;
+		bool m_LODSelectionEnabled = true;
+		bool m_MeshletCullingEnabled = true;
+		bool m_MultiDrawIndirectEnabled = true; //Only takes effect along with instancing, and where GL 4.3 or ARB_multi_draw_indirect is available.
+
+		float m_ShadowDistance = 60.0f; //View depth up to which directional shadows are cascaded.
+		float m_CascadeSplitLambda = 0.75f; //Blend between uniform (0) and logarithmic (1) cascade splits.
+		float m_ShadowCascadePadding = 0.25f; //Fraction of its radius by which each cascade is enlarged. The camera can move this far before a cascade, and its cached static shadows, are refit.
+		float m_LODErrorThreshold = 1.0f; //Screen space error, in pixels, a mesh level of detail may introduce before a finer one is picked.
 
 		Quad* m_NDCQuad = nullptr;
 
 		PostProcessor* m_PostProcessor = nullptr;
 
 	private:
+		void PushEntityToRenderQueue(SceneEntity* sceneEntity);
+		//Redraws the static layer of every cascade whose cached light volume overlaps the caster's bounds.
+		void InvalidateStaticShadows(const BoundingBox& casterBounds);
+
 		//Renderer-specific logic for rendering a custom forward-pass command.
 		void RenderCustomCommand(RenderCommand* renderCommand, Camera* customRenderCamera, bool updateGLStates = true);
+		//Draws the meshlets of the mesh's full resolution level that the camera can see, in as few ranges as their order allows.
+		void RenderMeshlets(Mesh* mesh, const glm::mat4& transform, Camera* camera);
+		//Draws a batch of commands sharing the same mesh and material with a single instanced call.
+		void RenderInstancedCommand(const RenderCommandList& renderCommands, const InstanceBatch& instanceBatch);
+		//Records a batch of commands whose mesh lives in the geometry arena as indirect draws, splitting single meshes into their visible meshlet ranges.
+		void PushIndirectDraws(const RenderCommandList& renderCommands, const InstanceBatch& instanceBatch);
+		//Uploads the recorded indirect commands and draws each group of them with a single call.
+		void RenderIndirectDraws();
+		//Binds the material's shader, its samplers and uniforms, along with the camera's default uniforms.
+		void ApplyMaterialState(Material* material, Camera* customRenderCamera, bool updateGLStates);
 
 		//Render Directional Light
 		void RenderDeferredDirectionalLight(DirectionalLight* directionalLight);
 		//Render Ambient Lighting (Including Indirect IBL)
 		void RenderDeferredAmbientLight();
-		//Render Point Light
-		void RenderDeferredPointLight(PointLight* pointLight);
+		//Flags point lights whose volumes lie outside of the camera frustum as invisible, skipping them for the rest of the frame.
+		void CullPointLights();
+		//Render Point Lights, shading all of them in a single full screen pass through the light cluster grid.
+		void RenderDeferredPointLights();
 		
 		//Render Mesh for Shadow Buffer Generation
-		void RenderShadowCastCommand(RenderCommand* renderCommand, const glm::mat4& lightSpaceProjectionMatrix, const glm::mat4& lightSpaceViewMatrix);
+		void RenderShadowCastCommand(RenderCommand* renderCommand); //Expects the shadow shader and its light space matrices to be bound.
+		void RenderShadowCastBatch(const RenderCommandList& renderCommands, const InstanceBatch& instanceBatch);
+		void RenderShadowCasters(const RenderCommandList& shadowRenderCommands); //Batches and draws casters into the bound shadow framebuffer.
 
-		//Update the global uniform buffer objects.
-		void UpdateGlobalUniformBufferObjects();
+		//Streams the gathered instance data into the instance buffer.
+		void UploadInstanceData();
+
+		//Update the global uniform buffer objects. Called whenever the camera used for rendering changes.
+		void UpdateGlobalUniformBufferObjects(Camera* camera);
+		//Streams per-object data through the uniform ring buffer, or sets it as a plain uniform for shaders without the object uniform block.
+		void BindObjectUniforms(Shader* shader, const Mesh* mesh, const glm::mat4& modelMatrix, bool instancingEnabled);
 
 		//Final
 		void BlitToMainFramebuffer(Texture* sourceRenderTarget);
@@ -113,6 +172,23 @@ namespace Crescent
 
 		//UBO
 		unsigned int m_GlobalUniformBufferID;
+		GlobalUniformData m_GlobalUniformData = {};
+		UniformRingBuffer* m_ObjectUniformRingBuffer = nullptr;
+
+		//Instancing
+		unsigned int m_InstanceBufferID = 0;
+		size_t m_InstanceBufferCapacity = 0;
+		std::vector<InstanceBatch> m_InstanceBatches;
+		std::vector<InstanceData> m_InstanceData;
+
+		//Shared Geometry
+		GeometryArena* m_GeometryArena = nullptr;
+		IndirectCommandBuilder m_IndirectCommandBuilder;
+		unsigned int m_IndirectBufferID = 0;
+		size_t m_IndirectBufferCapacity = 0;
+		bool m_MultiDrawIndirectSupported = false;
+		size_t m_IndirectDrawCount = 0;
+		size_t m_IndirectCommandCount = 0;
 
 		MaterialLibrary* m_MaterialLibrary = nullptr;
 		RenderQueue* m_RenderQueue = nullptr;
@@ -130,12 +206,40 @@ namespace Crescent
 		std::vector<RenderTarget*> m_RenderTargetsCustom;
 
 		//Shadow Target
-		std::vector<RenderTarget*> m_ShadowRenderTargets;;
+		std::vector<ShadowCascadeMap*> m_ShadowCascadeMaps;
+
+		//Static Shadow Caching. Casters which haven't moved for a number of frames are drawn into cached shadow layers, which are redrawn only when the set of static casters changes.
+		static const unsigned int m_StaticShadowFrameThreshold = 30;
+		bool m_StaticShadowsDirty = true;
+		std::vector<BoundingBox> m_RemovedShadowCasterBounds;
 
 		//Lights
 		std::vector<DirectionalLight*> m_DirectionalLights;
 		std::vector<PointLight*> m_PointLights;
-		Mesh* m_DeferredPointLightMesh = nullptr;
+
+		//Point Light Culling
+		LightBVH m_LightBVH;
+		std::vector<BoundingSphere> m_PointLightSpheres;
+		std::vector<uint32_t> m_VisiblePointLights;
+		size_t m_VisibleLightCount = 0;
+		size_t m_CulledLightCount = 0;
+
+		//Meshlet Culling
+		MeshletCuller m_MeshletCuller;
+
+		size_t m_RecomputedTransformCount = 0;
+		//Heap allocations of the render queue and the most commands it held in any frame, checked at the end of each frame in debug builds.
+		size_t m_QueueHeapAllocationCount = 0;
+		size_t m_PeakQueuedCommandCount = 0;
+		std::vector<SceneEntity*> m_QueriedSceneEntities;
+		std::vector<glm::mat4> m_PrefabRootTransforms; //Scratch for instances overriding node transforms.
+
+		//Clustered Lighting
+		LightClusterGrid m_LightClusterGrid;
+		std::vector<ClusterLight> m_ClusterLights;
+		unsigned int m_ClusterLightBufferID = 0;
+		unsigned int m_LightClusterBufferID = 0;
+		unsigned int m_ClusterLightIndexBufferID = 0;
 
 		glm::vec2 m_RenderWindowSize = glm::vec2(0.0f);
 
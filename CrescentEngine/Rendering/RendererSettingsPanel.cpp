@@ -2,6 +2,7 @@
 #include "RendererSettingsPanel.h"
 #include "Renderer.h"
 #include "GLStateCache.h"
+#include "RenderQueue.h"
 #include "PostProcessor.h"
 #include <imgui/imgui.h>
 
@@ -20,6 +21,16 @@ namespace Crescent
 		ImGui::Checkbox("Enable Lighting", &m_RendererContext->m_LightsEnabled);
 		ImGui::Checkbox("Enable Shadows", &m_RendererContext->m_ShadowsEnabled);
 		ImGui::Checkbox("Enable Lighting Volumes", &m_RendererContext->m_ShowDebugLightVolumes);
+		ImGui::Checkbox("Enable Frustum Culling", &m_RendererContext->m_FrustumCullingEnabled);
+		ImGui::Checkbox("Enable Instancing", &m_RendererContext->m_InstancingEnabled);
+		ImGui::Checkbox("Cache Static Shadows", &m_RendererContext->m_StaticShadowCachingEnabled);
+		ImGui::Checkbox("Enable Mesh LODs", &m_RendererContext->m_LODSelectionEnabled);
+		ImGui::Checkbox("Enable Meshlet Culling", &m_RendererContext->m_MeshletCullingEnabled);
+		ImGui::Checkbox("Enable Multi-Draw Indirect", &m_RendererContext->m_MultiDrawIndirectEnabled);
+		ImGui::SliderFloat("LOD Pixel Error", &m_RendererContext->m_LODErrorThreshold, 0.25f, 8.0f);
+		ImGui::SliderFloat("Shadow Distance", &m_RendererContext->m_ShadowDistance, 5.0f, 500.0f);
+		ImGui::SliderFloat("Cascade Split Lambda", &m_RendererContext->m_CascadeSplitLambda, 0.0f, 1.0f);
+		ImGui::SliderFloat("Cascade Padding", &m_RendererContext->m_ShadowCascadePadding, 0.0f, 1.0f);
 
 		ImGui::End();
 
@@ -37,6 +48,20 @@ namespace Crescent
 		ImGui::NewLine();
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
+		RenderQueue* renderQueue = m_RendererContext->RetrieveRenderQueue();
+		ImGui::Text("Visible Commands: %zu", renderQueue->RetrieveVisibleCommandCount());
+		ImGui::Text("Culled Commands: %zu", renderQueue->RetrieveCulledCommandCount());
+		ImGui::Text("Visible Meshlets: %zu", m_RendererContext->RetrieveMeshletCuller().RetrieveVisibleMeshletCount());
+		ImGui::Text("Culled Meshlets: %zu", m_RendererContext->RetrieveMeshletCuller().RetrieveCulledMeshletCount());
+		ImGui::Text("Indirect Draws: %zu (%zu Commands)", m_RendererContext->RetrieveIndirectDrawCount(), m_RendererContext->RetrieveIndirectCommandCount());
+		ImGui::Text("Visible Lights: %zu", m_RendererContext->RetrieveVisibleLightCount());
+		ImGui::Text("Culled Lights: %zu", m_RendererContext->RetrieveCulledLightCount());
+		ImGui::Text("Recomputed Transforms: %zu", m_RendererContext->RetrieveRecomputedTransformCount());
+
+		GLStateCache* stateCache = m_RendererContext->RetrieveGLStateCache();
+		ImGui::Text("State Changes Issued: %u", stateCache->RetrieveIssuedCallCount());
+		ImGui::Text("State Changes Elided: %u", stateCache->RetrieveElidedCallCount());
+
 		ImGui::End();
 	}
 }
\ No newline at end of file
@@ -8,13 +8,14 @@
 #include "../Utilities/StringID.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEntity.h"
+#include "../Scene/Prefab.h"
 
 namespace Crescent
 {
 	std::map<unsigned int, Shader> Resources::m_Shaders = std::map<unsigned int, Shader>();
 	std::map<unsigned int, Texture> Resources::m_Textures = std::map<unsigned int, Texture>();
 	std::map<unsigned int, TextureCube> Resources::m_TextureCubes = std::map<unsigned int, TextureCube>();
-	std::map<unsigned int, SceneEntity*> Resources::m_SceneMeshes = std::map<unsigned int, SceneEntity*>();
+	std::map<unsigned int, Prefab*> Resources::m_ScenePrefabs = std::map<unsigned int, Prefab*>();
 
 	void Resources::InitializeResourceManager()
 	{
@@ -23,7 +24,7 @@ namespace Crescent
 
 	void Resources::Clean()
 	{
-		for (auto iterator = m_SceneMeshes.begin(); iterator != m_SceneMeshes.end(); iterator++)
+		for (auto iterator = m_ScenePrefabs.begin(); iterator != m_ScenePrefabs.end(); iterator++)
 		{
 			delete iterator->second;
 		}
@@ -163,29 +164,62 @@ namespace Crescent
 		}
 	}
 
-	SceneEntity* Resources::LoadMesh(Renderer* rendererContext, Scene* sceneContext, const std::string& meshName, const std::string& filePath)
+	Prefab* Resources::LoadPrefab(Renderer* rendererContext, const std::string& meshName, const std::string& filePath)
 	{
 		unsigned int stringID = SID(meshName);
 
 		//Check if mesh exists.
-		if (Resources::m_SceneMeshes.find(stringID) != Resources::m_SceneMeshes.end())
+		if (Resources::m_ScenePrefabs.find(stringID) != Resources::m_ScenePrefabs.end())
 		{
-			return sceneContext->ConstructNewEntity(Resources::m_SceneMeshes[stringID]);
+			return Resources::m_ScenePrefabs[stringID];
 		}
 
 		SceneEntity* sceneEntity = MeshLoader::LoadMesh(rendererContext, filePath);
-		Resources::m_SceneMeshes[stringID] = sceneEntity;
+		if (sceneEntity == nullptr)
+		{
+			return nullptr;
+		}
+
+		//The loaded entities are only needed to build the prefab, which takes over their meshes and materials.
+		Prefab* prefab = new Prefab(meshName, filePath, sceneEntity);
+		SceneEntity::DestroyEntityHierarchy(sceneEntity);
+		Resources::m_ScenePrefabs[stringID] = prefab;
+
+		return prefab;
+	}
+
+	Prefab* Resources::AddPrefab(Prefab* prefab)
+	{
+		unsigned int stringID = SID(prefab->RetrievePrefabName());
+		if (Resources::m_ScenePrefabs.find(stringID) != Resources::m_ScenePrefabs.end())
+		{
+			delete prefab;
+			return Resources::m_ScenePrefabs[stringID];
+		}
 
-		return sceneContext->ConstructNewEntity(sceneEntity);
+		Resources::m_ScenePrefabs[stringID] = prefab;
+		return prefab;
+	}
+
+	Prefab* Resources::RetrievePrefab(const std::string& prefabName)
+	{
+		auto iterator = Resources::m_ScenePrefabs.find(SID(prefabName));
+		return iterator != Resources::m_ScenePrefabs.end() ? iterator->second : nullptr;
+	}
+
+	SceneEntity* Resources::LoadMesh(Renderer* rendererContext, Scene* sceneContext, const std::string& meshName, const std::string& filePath)
+	{
+		Prefab* prefab = LoadPrefab(rendererContext, meshName, filePath);
+		return prefab ? sceneContext->ConstructNewEntity(prefab) : nullptr;
 	}
 
 	SceneEntity* Resources::RetrieveMesh(const std::string& meshName)
 	{
 		unsigned int stringID = SID(meshName);
 
-		if (Resources::m_SceneMeshes.find(stringID) != Resources::m_SceneMeshes.end())
+		if (Resources::m_ScenePrefabs.find(stringID) != Resources::m_ScenePrefabs.end())
 		{
-			//return Scene::ConstructNewEntity(Resources::m_SceneMeshes[stringID]);
+			//return Scene::ConstructNewEntity(Resources::m_ScenePrefabs[stringID]);
 		}
 		else
 		{
@@ -10,6 +10,7 @@ namespace Crescent
 	class Shader;
 	class Scene;
 	class SceneEntity;
+	class Prefab;
 	class Renderer;
 
 	/*
@@ -38,7 +39,13 @@ namespace Crescent
 		static TextureCube* LoadTextureCube(const std::string& name, const std::string& folderPath);
 		static TextureCube* RetrieveTextureCube(const std::string& name);
 
-		//Meshes
+		//Meshes. Models are loaded once into a prefab, and every load of the same name places another instance of it.
+		static Prefab* LoadPrefab(Renderer* rendererContext, const std::string& meshName, const std::string& filePath);
+		//Takes ownership of an already built prefab, so later loads of its name place it rather than reading its source file. If the name is taken,
+		//the given prefab is deleted and the existing one returned, as instances may already refer to it.
+		static Prefab* AddPrefab(Prefab* prefab);
+		//Nullptr if no prefab of that name has been loaded or added yet.
+		static Prefab* RetrievePrefab(const std::string& prefabName);
 		static SceneEntity* LoadMesh(Renderer* rendererContext, Scene* sceneContext, const std::string& meshName, const std::string& filePath);
 		static SceneEntity* RetrieveMesh(const std::string& meshName);
 
@@ -51,6 +58,6 @@ namespace Crescent
 		static std::map<unsigned int, Shader> m_Shaders;
 		static std::map<unsigned int, Texture> m_Textures;
 		static std::map<unsigned int, TextureCube> m_TextureCubes;
-		static std::map<unsigned int, SceneEntity*> m_SceneMeshes;
+		static std::map<unsigned int, Prefab*> m_ScenePrefabs;
 	};
 }
\ No newline at end of file
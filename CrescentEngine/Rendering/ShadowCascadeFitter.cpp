@@ -0,0 +1,107 @@
+#include "CrescentPCH.h"
+#include "ShadowCascadeFitter.h"
+#include "../Utilities/Camera.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace Crescent
+{
+	void ShadowCascadeFitter::CalculateSplitDepths(float nearClip, float farClip, float splitLambda, float splitDepths[ShadowCascadeCount])
+	{
+		for (unsigned int i = 0; i < ShadowCascadeCount; i++)
+		{
+			float splitFraction = (float)(i + 1) / (float)ShadowCascadeCount;
+			float logarithmicSplit = nearClip * std::pow(farClip / nearClip, splitFraction);
+			float uniformSplit = nearClip + (farClip - nearClip) * splitFraction;
+			splitDepths[i] = splitLambda * logarithmicSplit + (1.0f - splitLambda) * uniformSplit;
+		}
+	}
+
+	ShadowCascade ShadowCascadeFitter::FitCascadeToFrustumSlice(const Camera& camera, float sliceNear, float sliceFar, const glm::vec3& lightDirection, const BoundingBox& casterBounds, unsigned int shadowMapResolution,
+		float volumePadding, ShadowCascadeVolume* cascadeVolume)
+	{
+		//Unproject the camera's near and far plane corners. Points along each corner ray are linear in view depth, so the slice corners are plain lerps.
+		glm::mat4 inverseViewProjection = glm::inverse(camera.m_ProjectionMatrix * camera.m_ViewMatrix);
+		glm::vec3 sliceCorners[8];
+		unsigned int cornerIndex = 0;
+		for (float x = -1.0f; x <= 1.0f; x += 2.0f)
+		{
+			for (float y = -1.0f; y <= 1.0f; y += 2.0f)
+			{
+				glm::vec4 nearCorner = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+				glm::vec4 farCorner = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+				glm::vec3 nearPoint = glm::vec3(nearCorner) / nearCorner.w;
+				glm::vec3 farPoint = glm::vec3(farCorner) / farCorner.w;
+
+				float depthRange = camera.m_FarClip - camera.m_NearClip;
+				sliceCorners[cornerIndex++] = glm::mix(nearPoint, farPoint, (sliceNear - camera.m_NearClip) / depthRange);
+				sliceCorners[cornerIndex++] = glm::mix(nearPoint, farPoint, (sliceFar - camera.m_NearClip) / depthRange);
+			}
+		}
+
+		glm::vec3 sliceCenter = glm::vec3(0.0f);
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			sliceCenter += sliceCorners[i];
+		}
+		sliceCenter /= 8.0f;
+
+		float sliceRadius = 0.0f;
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			sliceRadius = std::max(sliceRadius, glm::length(sliceCorners[i] - sliceCenter));
+		}
+		sliceRadius = std::ceil(sliceRadius * 16.0f) / 16.0f; //Quantized so floating point noise can't resize the cascade from frame to frame.
+
+		glm::vec3 direction = glm::normalize(lightDirection);
+		glm::vec3 upDirection = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+		//Volumes are placed in the light's rotation alone, where a camera translation only shifts the slice and never the volume.
+		glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, upDirection);
+		glm::vec3 lightSpaceSliceCenter = glm::vec3(lightRotation * glm::vec4(sliceCenter, 1.0f));
+		float volumeRadius = std::ceil(sliceRadius * (1.0f + std::max(volumePadding, 0.0f)) * 16.0f) / 16.0f;
+
+		//The previous volume is kept for as long as the slice's sphere stays inside of it.
+		bool volumeReused = cascadeVolume && cascadeVolume->m_Radius == volumeRadius && cascadeVolume->m_LightDirection == direction &&
+			glm::all(glm::lessThanEqual(glm::abs(lightSpaceSliceCenter - cascadeVolume->m_LightSpaceCenter) + sliceRadius, glm::vec3(volumeRadius)));
+
+		ShadowCascadeVolume fittedVolume;
+		if (volumeReused)
+		{
+			fittedVolume = *cascadeVolume;
+		}
+		else
+		{
+			//Centered on the slice and snapped to whole shadow map texels across the light's view, so the cascade only ever moves in whole texel steps.
+			float texelSize = volumeRadius * 2.0f / shadowMapResolution;
+			fittedVolume.m_LightSpaceCenter = glm::vec3(glm::round(glm::vec2(lightSpaceSliceCenter) / texelSize) * texelSize, lightSpaceSliceCenter.z);
+			fittedVolume.m_Radius = volumeRadius;
+			fittedVolume.m_LightDirection = direction;
+			if (cascadeVolume)
+			{
+				*cascadeVolume = fittedVolume;
+			}
+		}
+
+		//The light looks down its view's negative Z axis, so it is placed one radius along positive Z from the volume's center.
+		ShadowCascade shadowCascade;
+		shadowCascade.m_LightViewMatrix = glm::translate(glm::mat4(1.0f), -(fittedVolume.m_LightSpaceCenter + glm::vec3(0.0f, 0.0f, volumeRadius))) * lightRotation;
+
+		//The volume starts at depth 0 in light view space. Casters between the light and the slice must still land in the depth range.
+		float nearDepth = 0.0f;
+		float farDepth = volumeRadius * 2.0f;
+		if (casterBounds.IsValid())
+		{
+			BoundingBox lightSpaceCasterBounds = casterBounds.Transform(shadowCascade.m_LightViewMatrix);
+			nearDepth = std::min(nearDepth, -lightSpaceCasterBounds.m_Maximum.z);
+
+			//Moved in whole radius steps, so a caster moving around doesn't change the cascade (and invalidate its cached static depths) every frame.
+			nearDepth = std::floor(nearDepth / volumeRadius) * volumeRadius;
+		}
+
+		shadowCascade.m_LightProjectionMatrix = glm::ortho(-volumeRadius, volumeRadius, -volumeRadius, volumeRadius, nearDepth, farDepth);
+
+		return shadowCascade;
+	}
+}
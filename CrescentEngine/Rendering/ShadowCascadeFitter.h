@@ -0,0 +1,46 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "../Utilities/Bounds.h"
+
+namespace Crescent
+{
+	class Camera;
+
+	//Matches the cascade count expected by DirectionalFragment.shader.
+	const unsigned int ShadowCascadeCount = 4;
+
+	struct ShadowCascade
+	{
+		glm::mat4 m_LightProjectionMatrix;
+		glm::mat4 m_LightViewMatrix;
+	};
+
+	//A cascade's light volume, kept between frames so the cascade stays put until the camera moves its slice out of the volume's padding.
+	struct ShadowCascadeVolume
+	{
+		glm::vec3 m_LightSpaceCenter = glm::vec3(0.0f); //In the light's rotation, snapped to whole texels across its view.
+		float m_Radius = 0.0f; //Half extent of the volume, padding included.
+		glm::vec3 m_LightDirection = glm::vec3(0.0f);
+	};
+
+	/*
+		Splits the camera frustum into depth slices and fits an orthographic light volume around each of them.
+
+		Splits follow the practical split scheme, blending logarithmic and uniform distributions by a lambda in [0, 1]. Each slice is enclosed by a bounding
+		sphere rather than a box, so a cascade's extents never change as the camera rotates. The sphere is padded into a light space volume whose center
+		is snapped to whole shadow map texels, keeping shadow edges from shimmering. Given the previous frame's volume, the fit keeps it for as long as the
+		slice stays inside, so the cascade's matrices (and any depths cached with them) survive camera motion up to the padding.
+	*/
+
+	class ShadowCascadeFitter
+	{
+	public:
+		//Writes the view depth at which each cascade ends.
+		static void CalculateSplitDepths(float nearClip, float farClip, float splitLambda, float splitDepths[ShadowCascadeCount]);
+
+		//The light volume's near plane is pulled back to include every caster in casterBounds, so objects outside of the slice still cast into it.
+		//volumePadding enlarges the volume by a fraction of the slice's radius. Without a cascadeVolume, a new volume is fit every call.
+		static ShadowCascade FitCascadeToFrustumSlice(const Camera& camera, float sliceNear, float sliceFar, const glm::vec3& lightDirection, const BoundingBox& casterBounds, unsigned int shadowMapResolution,
+			float volumePadding = 0.0f, ShadowCascadeVolume* cascadeVolume = nullptr);
+	};
+}
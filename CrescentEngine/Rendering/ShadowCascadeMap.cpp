@@ -0,0 +1,139 @@
+#include "CrescentPCH.h"
+#include "ShadowCascadeMap.h"
+#include "GLStateCache.h"
+#include "../Utilities/Frustum.h"
+
+namespace Crescent
+{
+	ShadowCascadeMap::ShadowCascadeMap(unsigned int resolution, unsigned int cascadeCount)
+	{
+		m_Resolution = resolution;
+		m_CascadeStates.resize(cascadeCount);
+
+		CreateDepthArray(m_TextureID, cascadeCount);
+		CreateDepthArray(m_StaticTextureID, cascadeCount);
+		CreateLayerFramebuffers(m_TextureID, m_CascadeFramebufferIDs);
+		CreateLayerFramebuffers(m_StaticTextureID, m_StaticFramebufferIDs);
+
+		if (GLEW_VERSION_4_3 || GLEW_ARB_texture_view)
+		{
+			m_CascadeViewIDs.resize(cascadeCount);
+			glGenTextures(cascadeCount, m_CascadeViewIDs.data());
+			for (unsigned int i = 0; i < cascadeCount; i++)
+			{
+				glTextureView(m_CascadeViewIDs[i], GL_TEXTURE_2D, m_TextureID, GL_DEPTH_COMPONENT32F, 0, 1, i, 1);
+			}
+		}
+	}
+
+	ShadowCascadeMap::~ShadowCascadeMap()
+	{
+		if (!m_CascadeViewIDs.empty())
+		{
+			glDeleteTextures((GLsizei)m_CascadeViewIDs.size(), m_CascadeViewIDs.data());
+		}
+		glDeleteFramebuffers((GLsizei)m_CascadeFramebufferIDs.size(), m_CascadeFramebufferIDs.data());
+		glDeleteFramebuffers((GLsizei)m_StaticFramebufferIDs.size(), m_StaticFramebufferIDs.data());
+		glDeleteTextures(1, &m_TextureID);
+		glDeleteTextures(1, &m_StaticTextureID);
+
+		//Deleted names may be handed out again, so the cache must not assume they are still bound.
+		if (GLStateCache* stateCache = GLStateCache::RetrieveActiveCache())
+		{
+			stateCache->InvalidateBindings();
+		}
+	}
+
+	void ShadowCascadeMap::CreateDepthArray(unsigned int& textureID, unsigned int cascadeCount)
+	{
+		//Immutable storage, which texture views require.
+		glGenTextures(1, &textureID);
+		GLStateCache::BindTexture(GLStateCache::RetrieveActiveCache(), -1, GL_TEXTURE_2D_ARRAY, textureID);
+
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, m_Resolution, m_Resolution, cascadeCount);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+		float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+	}
+
+	void ShadowCascadeMap::CreateLayerFramebuffers(unsigned int textureID, std::vector<unsigned int>& framebufferIDs)
+	{
+		GLStateCache* stateCache = GLStateCache::RetrieveActiveCache();
+		framebufferIDs.resize(m_CascadeStates.size());
+		glGenFramebuffers((GLsizei)framebufferIDs.size(), framebufferIDs.data());
+		for (unsigned int i = 0; i < framebufferIDs.size(); i++)
+		{
+			GLStateCache::BindFramebuffer(stateCache, GL_FRAMEBUFFER, framebufferIDs[i]);
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureID, 0, i);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			{
+				CrescentInfo("Shadow cascade framebuffer creation failed - Not complete!");
+			}
+		}
+		GLStateCache::BindFramebuffer(stateCache, GL_FRAMEBUFFER, 0);
+	}
+
+	void ShadowCascadeMap::BindCascadeFramebuffer(GLStateCache* stateCache, unsigned int cascadeIndex)
+	{
+		stateCache->BindFramebuffer(GL_FRAMEBUFFER, m_CascadeFramebufferIDs[cascadeIndex]);
+		stateCache->SetViewport(0, 0, m_Resolution, m_Resolution);
+		m_CascadeStates[cascadeIndex].m_HoldsStaticDepths = false;
+	}
+
+	void ShadowCascadeMap::BindStaticCascadeFramebuffer(GLStateCache* stateCache, unsigned int cascadeIndex)
+	{
+		stateCache->BindFramebuffer(GL_FRAMEBUFFER, m_StaticFramebufferIDs[cascadeIndex]);
+		stateCache->SetViewport(0, 0, m_Resolution, m_Resolution);
+		m_CascadeStates[cascadeIndex].m_StaticCached = false;
+	}
+
+	void ShadowCascadeMap::BindShadowMap(int textureUnit)
+	{
+		GLStateCache::BindTexture(GLStateCache::RetrieveActiveCache(), textureUnit, GL_TEXTURE_2D_ARRAY, m_TextureID);
+	}
+
+	bool ShadowCascadeMap::IsStaticCascadeCached(unsigned int cascadeIndex, const glm::mat4& lightSpaceViewProjection) const
+	{
+		const CascadeState& cascadeState = m_CascadeStates[cascadeIndex];
+		return cascadeState.m_StaticCached && cascadeState.m_StaticViewProjection == lightSpaceViewProjection;
+	}
+
+	void ShadowCascadeMap::MarkStaticCascadeCached(unsigned int cascadeIndex, const glm::mat4& lightSpaceViewProjection)
+	{
+		m_CascadeStates[cascadeIndex].m_StaticViewProjection = lightSpaceViewProjection;
+		m_CascadeStates[cascadeIndex].m_StaticCached = true;
+	}
+
+	void ShadowCascadeMap::InvalidateStaticCascades()
+	{
+		for (unsigned int i = 0; i < m_CascadeStates.size(); i++)
+		{
+			m_CascadeStates[i].m_StaticCached = false;
+		}
+	}
+
+	void ShadowCascadeMap::InvalidateStaticCascades(const BoundingBox& casterBounds)
+	{
+		for (unsigned int i = 0; i < m_CascadeStates.size(); i++)
+		{
+			if (m_CascadeStates[i].m_StaticCached && Frustum(m_CascadeStates[i].m_StaticViewProjection).IntersectsBoundingBox(casterBounds))
+			{
+				m_CascadeStates[i].m_StaticCached = false;
+			}
+		}
+	}
+
+	void ShadowCascadeMap::CopyStaticCascade(unsigned int cascadeIndex)
+	{
+		//A straight GPU side copy of one layer. Framebuffer bindings are untouched, so the state cache stays in sync.
+		glCopyImageSubData(m_StaticTextureID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascadeIndex, m_TextureID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascadeIndex, m_Resolution, m_Resolution, 1);
+		m_CascadeStates[cascadeIndex].m_HoldsStaticDepths = true;
+	}
+}
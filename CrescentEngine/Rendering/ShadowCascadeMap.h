@@ -0,0 +1,72 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "../Utilities/Bounds.h"
+
+namespace Crescent
+{
+	class GLStateCache;
+
+	/*
+		Depth texture array holding one layer per shadow cascade, with a framebuffer per layer so switching cascades never re-attaches textures.
+		Each layer is also exposed as a 2D texture view, as debug displays can't sample array textures directly.
+
+		Static casters are drawn into a second, cached array which is only redrawn when its cascade's light volume changes or the renderer invalidates it.
+		Each frame, the cached layer is copied into the sampled array and dynamic casters are drawn on top. When no dynamic casters touch a cascade and its
+		cached layer is unchanged, the sampled layer already holds the right depths and the cascade is skipped entirely.
+	*/
+
+	class ShadowCascadeMap
+	{
+	public:
+		ShadowCascadeMap(unsigned int resolution, unsigned int cascadeCount);
+		~ShadowCascadeMap();
+
+		ShadowCascadeMap(const ShadowCascadeMap&) = delete;
+		ShadowCascadeMap& operator=(const ShadowCascadeMap&) = delete;
+
+		//Binds the cascade's framebuffer and viewport for rendering dynamic casters.
+		void BindCascadeFramebuffer(GLStateCache* stateCache, unsigned int cascadeIndex);
+		//Binds the cascade's cached static layer and viewport for rendering static casters.
+		void BindStaticCascadeFramebuffer(GLStateCache* stateCache, unsigned int cascadeIndex);
+		//Binds the array texture for sampling.
+		void BindShadowMap(int textureUnit);
+
+		//Whether the cascade's static layer was drawn with this light volume and hasn't been invalidated since.
+		bool IsStaticCascadeCached(unsigned int cascadeIndex, const glm::mat4& lightSpaceViewProjection) const;
+		void MarkStaticCascadeCached(unsigned int cascadeIndex, const glm::mat4& lightSpaceViewProjection);
+		void InvalidateStaticCascades();
+		//Invalidates only the cascades whose cached light volume overlaps the bounds, such as those of a static caster that was added or removed.
+		void InvalidateStaticCascades(const BoundingBox& casterBounds);
+
+		//Whether the sampled layer holds exactly the static layer's depths, with no dynamic casters drawn over them.
+		bool IsCascadeStatic(unsigned int cascadeIndex) const { return m_CascadeStates[cascadeIndex].m_HoldsStaticDepths; }
+		//Overwrites the sampled layer with the cached static depths.
+		void CopyStaticCascade(unsigned int cascadeIndex);
+
+		unsigned int RetrieveResolution() const { return m_Resolution; }
+		unsigned int RetrieveCascadeCount() const { return (unsigned int)m_CascadeFramebufferIDs.size(); }
+		unsigned int RetrieveCascadeViewID(unsigned int cascadeIndex) const { return cascadeIndex < m_CascadeViewIDs.size() ? m_CascadeViewIDs[cascadeIndex] : 0; }
+
+	private:
+		struct CascadeState
+		{
+			glm::mat4 m_StaticViewProjection = glm::mat4(1.0f);
+			bool m_StaticCached = false;
+			bool m_HoldsStaticDepths = false;
+		};
+
+		void CreateDepthArray(unsigned int& textureID, unsigned int cascadeCount);
+		void CreateLayerFramebuffers(unsigned int textureID, std::vector<unsigned int>& framebufferIDs);
+
+	private:
+		unsigned int m_Resolution = 0;
+		unsigned int m_TextureID = 0;
+		unsigned int m_StaticTextureID = 0;
+		std::vector<unsigned int> m_CascadeFramebufferIDs;
+		std::vector<unsigned int> m_StaticFramebufferIDs;
+		std::vector<unsigned int> m_CascadeViewIDs;
+		std::vector<CascadeState> m_CascadeStates;
+	};
+}
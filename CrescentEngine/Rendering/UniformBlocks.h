@@ -0,0 +1,46 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace Crescent
+{
+	/*
+		CPU mirrors of the uniform blocks declared in Resources/Shaders/Constants/Uniforms.shader. Members are ordered and padded per std140 rules, so
+		they can be copied to the GPU as is. Any change here must be reflected in the shader declarations.
+	*/
+
+	enum UniformBlockBinding
+	{
+		UniformBinding_Global = 0,
+		UniformBinding_Object = 1,
+		UniformBinding_Material = 2 //Layout is declared per shader. See MaterialParameterBlock.
+	};
+
+	//Shader storage buffers. Their std430 layouts are declared in the shaders using them.
+	enum StorageBufferBinding
+	{
+		StorageBinding_ClusterLights = 0,
+		StorageBinding_LightClusters = 1,
+		StorageBinding_ClusterLightIndices = 2
+	};
+
+	struct GlobalUniformData
+	{
+		glm::mat4 m_Projection;
+		glm::mat4 m_View;
+		glm::vec4 m_CameraPosition; //W unused.
+		glm::mat4 m_LightShadowViewProjections[4];
+	};
+
+	struct ObjectUniformData
+	{
+		glm::mat4 m_Model;
+		int m_InstancingEnabled;
+		int m_PackedVertexAttributes; //See VertexFormat.
+		int m_Padding[2];
+		glm::vec4 m_PositionOffset; //Dequantizes positions as offset + position * scale. W unused.
+		glm::vec4 m_PositionScale;
+	};
+
+	static_assert(sizeof(GlobalUniformData) == 400, "GlobalUniformData no longer matches its std140 layout.");
+	static_assert(sizeof(ObjectUniformData) == 112, "ObjectUniformData no longer matches its std140 layout.");
+}
@@ -0,0 +1,125 @@
+#include "CrescentPCH.h"
+#include "UniformRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Crescent
+{
+	UniformRingBuffer::UniformRingBuffer(size_t segmentSize, unsigned int segmentCount)
+	{
+		int offsetAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+		m_OffsetAlignment = std::max(offsetAlignment, 1);
+
+		m_SegmentCount = std::min(std::max(segmentCount, 1u), m_MaximumSegmentCount);
+		m_SegmentSize = (segmentSize + m_OffsetAlignment - 1) / m_OffsetAlignment * m_OffsetAlignment;
+		size_t bufferSize = m_SegmentSize * m_SegmentCount;
+
+		glGenBuffers(1, &m_BufferID);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_BufferID);
+
+		if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+		{
+			//Coherent mapping makes our writes visible to the GPU without explicit flushes.
+			GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_UNIFORM_BUFFER, bufferSize, nullptr, storageFlags);
+			m_MappedMemory = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, bufferSize, storageFlags));
+		}
+		else
+		{
+			glBufferData(GL_UNIFORM_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+			CrescentInfo("Persistently mapped buffers are not supported. Per-object uniforms will be uploaded with glBufferSubData.");
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	UniformRingBuffer::~UniformRingBuffer()
+	{
+		for (unsigned int i = 0; i < m_SegmentCount; i++)
+		{
+			if (m_SegmentFences[i])
+			{
+				glDeleteSync(m_SegmentFences[i]);
+			}
+		}
+
+		if (m_MappedMemory)
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_BufferID);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+		}
+		glDeleteBuffers(1, &m_BufferID);
+	}
+
+	void UniformRingBuffer::BeginFrame()
+	{
+		m_CurrentSegment = (m_CurrentSegment + 1) % m_SegmentCount;
+		m_SegmentOffset = 0;
+
+		WaitForFence(m_SegmentFences[m_CurrentSegment]);
+	}
+
+	void UniformRingBuffer::EndFrame()
+	{
+		if (m_SegmentFences[m_CurrentSegment])
+		{
+			glDeleteSync(m_SegmentFences[m_CurrentSegment]);
+		}
+		m_SegmentFences[m_CurrentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	void UniformRingBuffer::BindUniformData(unsigned int bindingPoint, const void* data, size_t byteSize)
+	{
+		size_t alignedSize = (byteSize + m_OffsetAlignment - 1) / m_OffsetAlignment * m_OffsetAlignment;
+		if (alignedSize > m_SegmentSize)
+		{
+			CrescentError("Uniform data is larger than a ring buffer segment.");
+		}
+
+		if (m_SegmentOffset + alignedSize > m_SegmentSize)
+		{
+			//The segment is full. Wait for every draw issued so far to complete before reusing it from the start.
+			GLsync overflowFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			WaitForFence(overflowFence);
+			m_SegmentOffset = 0;
+		}
+
+		size_t bufferOffset = m_CurrentSegment * m_SegmentSize + m_SegmentOffset;
+		if (m_MappedMemory)
+		{
+			std::memcpy(m_MappedMemory + bufferOffset, data, byteSize);
+		}
+		else
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_BufferID);
+			glBufferSubData(GL_UNIFORM_BUFFER, bufferOffset, byteSize, data);
+		}
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, m_BufferID, bufferOffset, byteSize);
+		m_SegmentOffset += alignedSize;
+	}
+
+	void UniformRingBuffer::WaitForFence(GLsync& fence)
+	{
+		if (!fence)
+		{
+			return;
+		}
+
+		//Flush on the first wait so the fence is guaranteed to eventually signal.
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (true)
+		{
+			GLenum waitResult = glClientWaitSync(fence, waitFlags, 1000000); //1ms
+			if (waitResult == GL_ALREADY_SIGNALED || waitResult == GL_CONDITION_SATISFIED || waitResult == GL_WAIT_FAILED)
+			{
+				break;
+			}
+			waitFlags = 0;
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+
+namespace Crescent
+{
+	/*
+		A uniform buffer split into one segment per frame in flight. Data is written straight into persistently mapped memory and bound per draw with
+		glBindBufferRange, so per-object uniforms never go through individual glUniform calls.
+
+		Each segment is fenced once the frame using it has been submitted. A segment is only reused after its fence signals, so the CPU never overwrites
+		data the GPU may still be reading. Should a single frame outgrow its segment, we wait for the GPU to catch up and start over rather than corrupt
+		pending draws.
+
+		Persistent mapping requires GL 4.4 or ARB_buffer_storage. Without it, data is uploaded with glBufferSubData into the same fenced layout.
+	*/
+
+	class UniformRingBuffer
+	{
+	public:
+		UniformRingBuffer(size_t segmentSize, unsigned int segmentCount = 3);
+		~UniformRingBuffer();
+
+		UniformRingBuffer(const UniformRingBuffer&) = delete;
+		UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+		//Moves onto the next segment, waiting for the GPU should it still be reading from it.
+		void BeginFrame();
+		//Fences the current segment once all of its draws have been submitted.
+		void EndFrame();
+
+		//Copies the data into the ring and binds it to the given uniform block binding point. The data must fit within a single segment, which is a fatal error otherwise.
+		void BindUniformData(unsigned int bindingPoint, const void* data, size_t byteSize);
+
+		bool IsPersistentlyMapped() const { return m_MappedMemory != nullptr; }
+
+	private:
+		void WaitForFence(GLsync& fence);
+
+	private:
+		static constexpr unsigned int m_MaximumSegmentCount = 4;
+
+		unsigned int m_BufferID = 0;
+		unsigned char* m_MappedMemory = nullptr;
+
+		size_t m_SegmentSize = 0;
+		size_t m_OffsetAlignment = 256;
+		unsigned int m_SegmentCount = 0;
+		unsigned int m_CurrentSegment = 0;
+		size_t m_SegmentOffset = 0;
+
+		GLsync m_SegmentFences[m_MaximumSegmentCount] = {};
+	};
+}
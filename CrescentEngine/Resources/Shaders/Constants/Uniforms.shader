@@ -0,0 +1,20 @@
+//Shared uniform blocks. Their std140 layouts mirror the structures in Rendering/UniformBlocks.h and must be kept in sync.
+
+//Written once per frame (and whenever the active camera changes).
+layout (std140) uniform GlobalUniforms
+{
+	mat4 projection;
+	mat4 view;
+	vec4 cameraPosition; //xyz
+	mat4 lightShadowViewProjections[4];
+};
+
+//Per-draw data, streamed through a ring buffer.
+layout (std140) uniform ObjectUniforms
+{
+	mat4 model;
+	int instancingEnabled;
+	int packedVertexAttributes; //Normals and tangents are octahedral encoded, with the bitangent's sign stored in the tangent's z.
+	vec4 positionOffset; //Object space positions are positionOffset + aPos * positionScale, undoing quantization.
+	vec4 positionScale;
+};
\ No newline at end of file
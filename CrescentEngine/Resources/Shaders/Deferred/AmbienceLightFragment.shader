@@ -17,7 +17,7 @@ uniform sampler2D gAlbedoAO;
 
 uniform int SSAO;
 uniform sampler2D TexSSAO;
-uniform vec3 camPos;
+#include ../Constants/Uniforms.shader
 
 void main()
 {
@@ -40,7 +40,7 @@ void main()
 
     // lighting data
     vec3 N = normalize(normal);
-    vec3 V = normalize(camPos.xyz - worldPos);
+    vec3 V = normalize(cameraPosition.xyz - worldPos);
     vec3 R = reflect(-V, N);
 
     // calculate color/reflectance at normal incidence
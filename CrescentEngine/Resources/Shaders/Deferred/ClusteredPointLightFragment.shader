@@ -0,0 +1,102 @@
+#version 430 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+#include ../Constants/Constants.shader
+#include ../Constants/BRDF.shader
+
+uniform sampler2D gPositionMetallic;
+uniform sampler2D gNormalRoughness;
+uniform sampler2D gAlbedoAO;
+
+#include ../Constants/Uniforms.shader
+
+//Built on the CPU by LightClusterGrid. Bindings match StorageBufferBinding in Rendering/UniformBlocks.h.
+struct ClusterLight
+{
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer ClusterLights
+{
+    ClusterLight clusterLights[];
+};
+
+layout (std430, binding = 1) readonly buffer LightClusters
+{
+    uvec2 lightClusters[]; //Offset into the index list, light count.
+};
+
+layout (std430, binding = 2) readonly buffer ClusterLightIndices
+{
+    uint clusterLightIndices[];
+};
+
+uniform vec4 clusterGrid; //Tile count x, tile count y, depth slice count, near clip.
+uniform float clusterDepthSliceScale;
+
+void main()
+{
+    vec4 albedoAO = texture(gAlbedoAO, TexCoords);
+    vec4 normalRoughness = texture(gNormalRoughness, TexCoords);
+    vec4 positionMetallic = texture(gPositionMetallic, TexCoords);
+
+    vec3 worldPosition = positionMetallic.xyz;
+    vec3 albedo = albedoAO.rgb;
+    vec3 normal = normalRoughness.rgb;
+    float roughness = normalRoughness.a;
+    float metallic = positionMetallic.a;
+
+    //Find the cluster this pixel falls in.
+    float viewDepth = -(view * vec4(worldPosition, 1.0)).z;
+    uvec3 cluster;
+    cluster.xy = uvec2(min(TexCoords * clusterGrid.xy, clusterGrid.xy - 1.0));
+    cluster.z = uint(clamp(log(max(viewDepth, clusterGrid.w) / clusterGrid.w) * clusterDepthSliceScale, 0.0, clusterGrid.z - 1.0));
+    uint clusterIndex = (cluster.z * uint(clusterGrid.y) + cluster.y) * uint(clusterGrid.x) + cluster.x;
+    uvec2 lightCluster = lightClusters[clusterIndex];
+
+    //Lighting Input
+    vec3 N = normalize(normal);
+    vec3 V = normalize(cameraPosition.xyz - worldPosition);
+
+    vec3 F0 = vec3(0.04f);
+    F0 = mix(F0, albedo, metallic);
+
+    vec3 Lo = vec3(0.0);
+    for (uint i = 0; i < lightCluster.y; ++i)
+    {
+        ClusterLight light = clusterLights[clusterLightIndices[lightCluster.x + i]];
+        vec3 lightPosition = light.positionRadius.xyz;
+        float lightRadius = light.positionRadius.w;
+
+        vec3 L = normalize(lightPosition - worldPosition);
+        vec3 H = normalize(V + L);
+
+        //Calculate Light Radiance (Based on UE4's Light Attenuation Model)
+        float distance = length(worldPosition - lightPosition);
+        float attenuation = pow(clamp(1.0 - pow(distance / lightRadius, 1.0), 0.0, 1.0), 2.0) / (distance * distance + 1.0);
+        vec3 radiance = light.color.rgb * attenuation;
+
+        // cook-torrance brdf
+        float NDF = DistributionGGX(N, H, roughness);
+        float G = GeometryGGX(max(dot(N, V), 0.0), max(dot(N, L), 0.0), roughness);
+        vec3 F = FresnelSchlick(max(dot(H, V), 0.0), F0);
+
+        vec3 kS = F;
+        vec3 kD = vec3(1.0) - kS;
+        kD *= 1.0 - metallic;
+
+        vec3 nominator = NDF * G * F;
+        float denominator = 4 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.001;
+        vec3 specular = nominator / denominator;
+
+        // add to outgoing radiance Lo
+        float NdotL = max(dot(N, L), 0.0);
+        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    }
+
+    FragColor.rgb = Lo;
+    FragColor.a = 1.0;
+}
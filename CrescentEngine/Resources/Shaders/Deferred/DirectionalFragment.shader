@@ -13,34 +13,43 @@ uniform sampler2D gAlbedoAO;
 uniform vec3 lightDirection;
 uniform vec3 lightColor;
 
-uniform vec3 cameraPosition;
+#include ../Constants/Uniforms.shader
 
-uniform sampler2D lightShadowMap;
-uniform mat4 lightShadowViewProjection;
+uniform sampler2DArray lightShadowMap;
+uniform mat4 cascadeViewProjections[4];
+uniform vec4 cascadeSplitDepths; //Far view depth of each cascade.
 uniform bool ShadowsEnabled;
 
-float ShadowFactor(sampler2D shadowMap, vec4 fragPosLightSpace, vec3 N, vec3 L)
+float ShadowFactor(sampler2DArray shadowMap, vec3 worldPos, vec3 N, vec3 L)
 {
     if (ShadowsEnabled)
     {
+        // pick the nearest cascade containing the fragment
+        float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+        int cascade = 0;
+        while (cascade < 4 && viewDepth > cascadeSplitDepths[cascade])
+            ++cascade;
+        // beyond the shadow distance nothing is shadowed
+        if (cascade == 4)
+            return 0.0;
+
+        vec4 fragPosLightSpace = cascadeViewProjections[cascade] * vec4(worldPos, 1.0);
         // perspective divide
         vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
         // transform to [0,1] range
         projCoords = projCoords * 0.5 + 0.5;
-        // closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-        float closestDepth = texture(shadowMap, projCoords.xy).r;
         // depth of current fragment from light's perspective
         float currentDepth = projCoords.z;
         // shadow bias
         float bias = max(0.05 * (1.0 - dot(N, L)), 0.005);
         // PCF
         float shadow = 0.0;
-        vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+        vec2 texelSize = 1.0 / textureSize(shadowMap, 0).xy;
         for (int x = -2; x <= 2; ++x)
         {
             for (int y = -2; y <= 2; ++y)
             {
-                float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+                float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, cascade)).r;
                 shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
             }
         }
@@ -82,8 +91,7 @@ void main()
     vec3 radiance = lightColor;
 
     // light shadow
-    vec4 fragPosLightSpace = lightShadowViewProjection * vec4(worldPos, 1.0);
-    float shadow = ShadowFactor(lightShadowMap, fragPosLightSpace, N, L);
+    float shadow = ShadowFactor(lightShadowMap, worldPos, N, L);
 
     // cook-torrance brdf
     float NDF = DistributionGGX(N, H, roughness);
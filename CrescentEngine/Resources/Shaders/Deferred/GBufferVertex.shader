@@ -4,25 +4,50 @@ layout (location = 1) in vec2 aUV;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+layout (location = 9) in mat4 aInstanceModel; //Per-instance, spans locations 9 to 12.
+layout (location = 13) in vec4 aInstancePositionOffset; //Per-instance dequantization, as instances drawn together may come from different meshes.
+layout (location = 14) in vec4 aInstancePositionScale;
 
 out vec2 UV;
 out vec3 FragPos;
 out mat3 TBN;
 
-uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+#include ../Constants/Uniforms.shader
+
+//Unfolds a direction stored as a point on the octahedron, as written by Mesh's packed vertex formats.
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (direction.z < 0.0)
+	{
+		direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(direction);
+}
 
 void main()
 {
+	mat4 worldMatrix = instancingEnabled != 0 ? aInstanceModel : model;
+
+	vec3 position = instancingEnabled != 0 ? aInstancePositionOffset.xyz + aPos * aInstancePositionScale.xyz : positionOffset.xyz + aPos * positionScale.xyz;
+	vec3 normal = aNormal;
+	vec3 tangent = aTangent;
+	vec3 bitangent = aBitangent;
+	if (packedVertexAttributes != 0)
+	{
+		normal = DecodeOctahedral(aNormal.xy);
+		tangent = DecodeOctahedral(aTangent.xy);
+		bitangent = cross(normal, tangent) * aTangent.z;
+	}
+
 	UV = aUV;
-	FragPos = vec3(model * vec4(aPos, 1.0));
+	FragPos = vec3(worldMatrix * vec4(position, 1.0));
 
-	vec3 N = normalize(mat3(model) * aNormal);
-	vec3 T = normalize(mat3(model) * aTangent);
+	vec3 N = normalize(mat3(worldMatrix) * normal);
+	vec3 T = normalize(mat3(worldMatrix) * tangent);
 	T = normalize(T - dot(N, T) * N);
 
-	vec3 B = normalize(mat3(model) * aBitangent);
+	vec3 B = normalize(mat3(worldMatrix) * bitangent);
 
 	//TBN must form a right handed coordinate system.
 	//Some models have symetric UVs. Check and fix.
@@ -1,11 +1,16 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 9) in mat4 aInstanceModel; //Per-instance, spans locations 9 to 12.
+layout (location = 13) in vec4 aInstancePositionOffset; //Per-instance dequantization, as instances drawn together may come from different meshes.
+layout (location = 14) in vec4 aInstancePositionScale;
 
 uniform mat4 lightSpaceProjection;
 uniform mat4 lightSpaceView;
-uniform mat4 model;
+#include Constants/Uniforms.shader
 
 void main()
 {
-	gl_Position = lightSpaceProjection * lightSpaceView * model * vec4(aPos, 1.0f);
+	mat4 worldMatrix = instancingEnabled != 0 ? aInstanceModel : model;
+	vec3 position = instancingEnabled != 0 ? aInstancePositionOffset.xyz + aPos * aInstancePositionScale.xyz : positionOffset.xyz + aPos * positionScale.xyz;
+	gl_Position = lightSpaceProjection * lightSpaceView * worldMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
@@ -4,7 +4,12 @@ out vec4 FragColor;
 in vec3 WorldPos;
 
 uniform samplerCube background;
-uniform float lodLevel;
+
+//Filled from the skybox material's parameters. See MaterialParameterBlock.
+layout (std140) uniform MaterialUniforms
+{
+	float lodLevel;
+};
 
 void main()
 {
@@ -0,0 +1,422 @@
+#include "CrescentPCH.h"
+#include "DynamicAABBTree.h"
+#include "../Utilities/Frustum.h"
+#include <algorithm>
+
+namespace Crescent
+{
+	static BoundingBox CombineBounds(const BoundingBox& firstBounds, const BoundingBox& secondBounds)
+	{
+		BoundingBox combinedBounds;
+		combinedBounds.m_Minimum = glm::min(firstBounds.m_Minimum, secondBounds.m_Minimum);
+		combinedBounds.m_Maximum = glm::max(firstBounds.m_Maximum, secondBounds.m_Maximum);
+		return combinedBounds;
+	}
+
+	static float CalculateSurfaceArea(const BoundingBox& boundingBox)
+	{
+		glm::vec3 size = boundingBox.m_Maximum - boundingBox.m_Minimum;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	static bool ContainsBounds(const BoundingBox& outerBounds, const BoundingBox& innerBounds)
+	{
+		return glm::all(glm::lessThanEqual(outerBounds.m_Minimum, innerBounds.m_Minimum)) && glm::all(glm::greaterThanEqual(outerBounds.m_Maximum, innerBounds.m_Maximum));
+	}
+
+	static bool OverlapsBounds(const BoundingBox& firstBounds, const BoundingBox& secondBounds)
+	{
+		return glm::all(glm::lessThanEqual(firstBounds.m_Minimum, secondBounds.m_Maximum)) && glm::all(glm::greaterThanEqual(firstBounds.m_Maximum, secondBounds.m_Minimum));
+	}
+
+	//Slab test. Returns the distance at which the ray enters the box (0 when starting inside it), or a negative value if it misses.
+	static float IntersectRayBounds(const glm::vec3& rayOrigin, const glm::vec3& inverseDirection, const BoundingBox& boundingBox)
+	{
+		glm::vec3 firstDistances = (boundingBox.m_Minimum - rayOrigin) * inverseDirection;
+		glm::vec3 secondDistances = (boundingBox.m_Maximum - rayOrigin) * inverseDirection;
+		glm::vec3 nearDistances = glm::min(firstDistances, secondDistances);
+		glm::vec3 farDistances = glm::max(firstDistances, secondDistances);
+
+		float entryDistance = std::max(std::max(nearDistances.x, nearDistances.y), std::max(nearDistances.z, 0.0f));
+		float exitDistance = std::min(std::min(farDistances.x, farDistances.y), farDistances.z);
+		return entryDistance <= exitDistance ? entryDistance : -1.0f;
+	}
+
+	int32_t DynamicAABBTree::CreateProxy(const BoundingBox& boundingBox, void* userData)
+	{
+		int32_t proxyID = AllocateNode();
+		m_Nodes[proxyID].m_Bounds.m_Minimum = boundingBox.m_Minimum - glm::vec3(m_FatBoundsMargin);
+		m_Nodes[proxyID].m_Bounds.m_Maximum = boundingBox.m_Maximum + glm::vec3(m_FatBoundsMargin);
+		m_Nodes[proxyID].m_UserData = userData;
+		m_Nodes[proxyID].m_Height = 0;
+
+		InsertLeaf(proxyID);
+		m_ProxyCount++;
+		return proxyID;
+	}
+
+	void DynamicAABBTree::DestroyProxy(int32_t proxyID)
+	{
+		RemoveLeaf(proxyID);
+		FreeNode(proxyID);
+		m_ProxyCount--;
+	}
+
+	bool DynamicAABBTree::MoveProxy(int32_t proxyID, const BoundingBox& boundingBox)
+	{
+		if (ContainsBounds(m_Nodes[proxyID].m_Bounds, boundingBox))
+		{
+			return false;
+		}
+
+		RemoveLeaf(proxyID);
+		m_Nodes[proxyID].m_Bounds.m_Minimum = boundingBox.m_Minimum - glm::vec3(m_FatBoundsMargin);
+		m_Nodes[proxyID].m_Bounds.m_Maximum = boundingBox.m_Maximum + glm::vec3(m_FatBoundsMargin);
+		InsertLeaf(proxyID);
+		return true;
+	}
+
+	void DynamicAABBTree::QueryFrustum(const Frustum& frustum, std::vector<int32_t>& queryResults) const
+	{
+		if (m_RootIndex == NullNode)
+		{
+			return;
+		}
+
+		m_TraversalStack.clear();
+		m_TraversalStack.push_back(m_RootIndex);
+		while (!m_TraversalStack.empty())
+		{
+			int32_t nodeIndex = m_TraversalStack.back();
+			m_TraversalStack.pop_back();
+
+			const TreeNode& node = m_Nodes[nodeIndex];
+			if (!frustum.IntersectsBoundingBox(node.m_Bounds))
+			{
+				continue;
+			}
+
+			//A node fully inside hands over all of its leaves without testing any further planes.
+			if (node.IsLeaf() || frustum.ContainsBoundingBox(node.m_Bounds))
+			{
+				CollectLeaves(nodeIndex, queryResults);
+			}
+			else
+			{
+				m_TraversalStack.push_back(node.m_LeftChild);
+				m_TraversalStack.push_back(node.m_RightChild);
+			}
+		}
+	}
+
+	void DynamicAABBTree::QueryBoundingSphere(const BoundingSphere& boundingSphere, std::vector<int32_t>& queryResults) const
+	{
+		if (m_RootIndex == NullNode)
+		{
+			return;
+		}
+
+		float squaredRadius = boundingSphere.m_Radius * boundingSphere.m_Radius;
+		m_TraversalStack.clear();
+		m_TraversalStack.push_back(m_RootIndex);
+		while (!m_TraversalStack.empty())
+		{
+			int32_t nodeIndex = m_TraversalStack.back();
+			m_TraversalStack.pop_back();
+
+			const TreeNode& node = m_Nodes[nodeIndex];
+			//Distance from the sphere's center to the closest point of the box.
+			glm::vec3 closestPoint = glm::clamp(boundingSphere.m_Center, node.m_Bounds.m_Minimum, node.m_Bounds.m_Maximum);
+			glm::vec3 offset = closestPoint - boundingSphere.m_Center;
+			if (glm::dot(offset, offset) > squaredRadius)
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				queryResults.push_back(nodeIndex);
+			}
+			else
+			{
+				m_TraversalStack.push_back(node.m_LeftChild);
+				m_TraversalStack.push_back(node.m_RightChild);
+			}
+		}
+	}
+
+	void DynamicAABBTree::QueryBoundingBox(const BoundingBox& boundingBox, std::vector<int32_t>& queryResults) const
+	{
+		if (m_RootIndex == NullNode)
+		{
+			return;
+		}
+
+		m_TraversalStack.clear();
+		m_TraversalStack.push_back(m_RootIndex);
+		while (!m_TraversalStack.empty())
+		{
+			int32_t nodeIndex = m_TraversalStack.back();
+			m_TraversalStack.pop_back();
+
+			const TreeNode& node = m_Nodes[nodeIndex];
+			if (!OverlapsBounds(node.m_Bounds, boundingBox))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf() || ContainsBounds(boundingBox, node.m_Bounds))
+			{
+				CollectLeaves(nodeIndex, queryResults);
+			}
+			else
+			{
+				m_TraversalStack.push_back(node.m_LeftChild);
+				m_TraversalStack.push_back(node.m_RightChild);
+			}
+		}
+	}
+
+	int32_t DynamicAABBTree::RayCast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float maximumDistance, float* hitDistance) const
+	{
+		int32_t closestProxy = NullNode;
+		float closestDistance = maximumDistance;
+		if (m_RootIndex == NullNode)
+		{
+			return closestProxy;
+		}
+
+		//Division by zero components gives infinities, which the slab test handles as rays parallel to those slabs.
+		glm::vec3 inverseDirection = 1.0f / rayDirection;
+		m_TraversalStack.clear();
+		m_TraversalStack.push_back(m_RootIndex);
+		while (!m_TraversalStack.empty())
+		{
+			int32_t nodeIndex = m_TraversalStack.back();
+			m_TraversalStack.pop_back();
+
+			//Anything entered beyond the closest hit so far can't contain a closer one.
+			const TreeNode& node = m_Nodes[nodeIndex];
+			float entryDistance = IntersectRayBounds(rayOrigin, inverseDirection, node.m_Bounds);
+			if (entryDistance < 0.0f || entryDistance > closestDistance)
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				closestProxy = nodeIndex;
+				closestDistance = entryDistance;
+			}
+			else
+			{
+				m_TraversalStack.push_back(node.m_LeftChild);
+				m_TraversalStack.push_back(node.m_RightChild);
+			}
+		}
+
+		if (hitDistance && closestProxy != NullNode)
+		{
+			*hitDistance = closestDistance;
+		}
+		return closestProxy;
+	}
+
+	int32_t DynamicAABBTree::AllocateNode()
+	{
+		if (m_FreeList == NullNode)
+		{
+			m_Nodes.emplace_back();
+			return (int32_t)m_Nodes.size() - 1;
+		}
+
+		int32_t nodeIndex = m_FreeList;
+		m_FreeList = m_Nodes[nodeIndex].m_ParentIndex;
+		m_Nodes[nodeIndex] = TreeNode();
+		return nodeIndex;
+	}
+
+	void DynamicAABBTree::FreeNode(int32_t nodeIndex)
+	{
+		m_Nodes[nodeIndex].m_ParentIndex = m_FreeList;
+		m_Nodes[nodeIndex].m_Height = -1;
+		m_FreeList = nodeIndex;
+	}
+
+	void DynamicAABBTree::InsertLeaf(int32_t leafIndex)
+	{
+		if (m_RootIndex == NullNode)
+		{
+			m_RootIndex = leafIndex;
+			m_Nodes[leafIndex].m_ParentIndex = NullNode;
+			return;
+		}
+
+		//Walk down towards the cheapest sibling. Pairing with a node costs the area of the new parent, while every node above it grows by its added area.
+		//We stop once descending further can't beat pairing with the current node.
+		const BoundingBox leafBounds = m_Nodes[leafIndex].m_Bounds;
+		int32_t siblingIndex = m_RootIndex;
+		while (!m_Nodes[siblingIndex].IsLeaf())
+		{
+			const TreeNode& node = m_Nodes[siblingIndex];
+			float combinedArea = CalculateSurfaceArea(CombineBounds(node.m_Bounds, leafBounds));
+			float pairingCost = 2.0f * combinedArea;
+			float inheritedCost = 2.0f * (combinedArea - CalculateSurfaceArea(node.m_Bounds));
+
+			float childCosts[2];
+			int32_t children[2] = { node.m_LeftChild, node.m_RightChild };
+			for (int i = 0; i < 2; i++)
+			{
+				const TreeNode& childNode = m_Nodes[children[i]];
+				float childArea = CalculateSurfaceArea(CombineBounds(childNode.m_Bounds, leafBounds));
+				childCosts[i] = (childNode.IsLeaf() ? childArea : childArea - CalculateSurfaceArea(childNode.m_Bounds)) + inheritedCost;
+			}
+
+			if (pairingCost < childCosts[0] && pairingCost < childCosts[1])
+			{
+				break;
+			}
+			siblingIndex = childCosts[0] < childCosts[1] ? children[0] : children[1];
+		}
+
+		//Allocating may grow the node array, so nodes are only accessed by index from here on.
+		int32_t oldParentIndex = m_Nodes[siblingIndex].m_ParentIndex;
+		int32_t newParentIndex = AllocateNode();
+		m_Nodes[newParentIndex].m_ParentIndex = oldParentIndex;
+		m_Nodes[newParentIndex].m_Bounds = CombineBounds(m_Nodes[siblingIndex].m_Bounds, leafBounds);
+		m_Nodes[newParentIndex].m_Height = m_Nodes[siblingIndex].m_Height + 1;
+		m_Nodes[newParentIndex].m_LeftChild = siblingIndex;
+		m_Nodes[newParentIndex].m_RightChild = leafIndex;
+		m_Nodes[siblingIndex].m_ParentIndex = newParentIndex;
+		m_Nodes[leafIndex].m_ParentIndex = newParentIndex;
+
+		if (oldParentIndex == NullNode)
+		{
+			m_RootIndex = newParentIndex;
+		}
+		else if (m_Nodes[oldParentIndex].m_LeftChild == siblingIndex)
+		{
+			m_Nodes[oldParentIndex].m_LeftChild = newParentIndex;
+		}
+		else
+		{
+			m_Nodes[oldParentIndex].m_RightChild = newParentIndex;
+		}
+
+		RefitAncestors(oldParentIndex);
+	}
+
+	void DynamicAABBTree::RemoveLeaf(int32_t leafIndex)
+	{
+		if (leafIndex == m_RootIndex)
+		{
+			m_RootIndex = NullNode;
+			return;
+		}
+
+		//The leaf's parent goes with it, and the sibling takes the parent's place.
+		int32_t parentIndex = m_Nodes[leafIndex].m_ParentIndex;
+		int32_t grandParentIndex = m_Nodes[parentIndex].m_ParentIndex;
+		int32_t siblingIndex = m_Nodes[parentIndex].m_LeftChild == leafIndex ? m_Nodes[parentIndex].m_RightChild : m_Nodes[parentIndex].m_LeftChild;
+
+		m_Nodes[siblingIndex].m_ParentIndex = grandParentIndex;
+		if (grandParentIndex == NullNode)
+		{
+			m_RootIndex = siblingIndex;
+		}
+		else if (m_Nodes[grandParentIndex].m_LeftChild == parentIndex)
+		{
+			m_Nodes[grandParentIndex].m_LeftChild = siblingIndex;
+		}
+		else
+		{
+			m_Nodes[grandParentIndex].m_RightChild = siblingIndex;
+		}
+		FreeNode(parentIndex);
+
+		m_Nodes[leafIndex].m_ParentIndex = NullNode;
+		RefitAncestors(grandParentIndex);
+	}
+
+	void DynamicAABBTree::RefitAncestors(int32_t nodeIndex)
+	{
+		while (nodeIndex != NullNode)
+		{
+			nodeIndex = BalanceNode(nodeIndex);
+
+			TreeNode& node = m_Nodes[nodeIndex];
+			node.m_Bounds = CombineBounds(m_Nodes[node.m_LeftChild].m_Bounds, m_Nodes[node.m_RightChild].m_Bounds);
+			node.m_Height = 1 + std::max(m_Nodes[node.m_LeftChild].m_Height, m_Nodes[node.m_RightChild].m_Height);
+			nodeIndex = node.m_ParentIndex;
+		}
+	}
+
+	int32_t DynamicAABBTree::BalanceNode(int32_t nodeIndex)
+	{
+		TreeNode& node = m_Nodes[nodeIndex];
+		if (node.IsLeaf() || node.m_Height < 2)
+		{
+			return nodeIndex;
+		}
+
+		int32_t heightDifference = m_Nodes[node.m_RightChild].m_Height - m_Nodes[node.m_LeftChild].m_Height;
+		if (heightDifference >= -1 && heightDifference <= 1)
+		{
+			return nodeIndex;
+		}
+
+		//The taller child takes the node's place. The node keeps its shorter child and adopts the taller child's shorter child, while the taller
+		//child keeps its own taller child.
+		bool rightTaller = heightDifference > 1;
+		int32_t tallerIndex = rightTaller ? node.m_RightChild : node.m_LeftChild;
+		int32_t shorterIndex = rightTaller ? node.m_LeftChild : node.m_RightChild;
+		TreeNode& tallerNode = m_Nodes[tallerIndex];
+
+		tallerNode.m_ParentIndex = node.m_ParentIndex;
+		node.m_ParentIndex = tallerIndex;
+		if (tallerNode.m_ParentIndex == NullNode)
+		{
+			m_RootIndex = tallerIndex;
+		}
+		else if (m_Nodes[tallerNode.m_ParentIndex].m_LeftChild == nodeIndex)
+		{
+			m_Nodes[tallerNode.m_ParentIndex].m_LeftChild = tallerIndex;
+		}
+		else
+		{
+			m_Nodes[tallerNode.m_ParentIndex].m_RightChild = tallerIndex;
+		}
+
+		int32_t keptIndex = tallerNode.m_LeftChild;
+		int32_t movedIndex = tallerNode.m_RightChild;
+		if (m_Nodes[movedIndex].m_Height > m_Nodes[keptIndex].m_Height)
+		{
+			std::swap(keptIndex, movedIndex);
+		}
+
+		tallerNode.m_LeftChild = nodeIndex;
+		tallerNode.m_RightChild = keptIndex;
+		node.m_LeftChild = shorterIndex;
+		node.m_RightChild = movedIndex;
+		m_Nodes[movedIndex].m_ParentIndex = nodeIndex;
+
+		node.m_Bounds = CombineBounds(m_Nodes[shorterIndex].m_Bounds, m_Nodes[movedIndex].m_Bounds);
+		node.m_Height = 1 + std::max(m_Nodes[shorterIndex].m_Height, m_Nodes[movedIndex].m_Height);
+		tallerNode.m_Bounds = CombineBounds(node.m_Bounds, m_Nodes[keptIndex].m_Bounds);
+		tallerNode.m_Height = 1 + std::max(node.m_Height, m_Nodes[keptIndex].m_Height);
+		return tallerIndex;
+	}
+
+	void DynamicAABBTree::CollectLeaves(int32_t nodeIndex, std::vector<int32_t>& queryResults) const
+	{
+		const TreeNode& node = m_Nodes[nodeIndex];
+		if (node.IsLeaf())
+		{
+			queryResults.push_back(nodeIndex);
+			return;
+		}
+
+		CollectLeaves(node.m_LeftChild, queryResults);
+		CollectLeaves(node.m_RightChild, queryResults);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "../Utilities/Bounds.h"
+
+namespace Crescent
+{
+	class Frustum;
+
+	/*
+		Bounding volume hierarchy over proxies that come, go and move every frame. Each leaf stores a fat box, its tight bounds grown by a margin, so that
+		small movements don't touch the tree at all. A proxy leaving its fat box is removed and reinserted, which refits its old and new ancestors on the way
+		up. Insertion descends towards the sibling that grows the least in surface area, and rotations keep the tree height balanced as proxies churn.
+
+		Proxies are identified by their node index, which stays valid until the proxy is destroyed.
+	*/
+
+	class DynamicAABBTree
+	{
+	public:
+		int32_t CreateProxy(const BoundingBox& boundingBox, void* userData);
+		void DestroyProxy(int32_t proxyID);
+		//Updates a proxy's bounds. Returns whether it had to be reinserted, which only happens once it leaves its fat box.
+		bool MoveProxy(int32_t proxyID, const BoundingBox& boundingBox);
+
+		void* RetrieveUserData(int32_t proxyID) const { return m_Nodes[proxyID].m_UserData; }
+		const BoundingBox& RetrieveFatBounds(int32_t proxyID) const { return m_Nodes[proxyID].m_Bounds; }
+		//Bounds enclosing every proxy, or an invalid box for an empty tree.
+		BoundingBox RetrieveRootBounds() const { return m_RootIndex == NullNode ? BoundingBox() : m_Nodes[m_RootIndex].m_Bounds; }
+
+		//Each query appends the IDs of all proxies whose fat box intersects the volume to the results, in no particular order.
+		void QueryFrustum(const Frustum& frustum, std::vector<int32_t>& queryResults) const;
+		void QueryBoundingSphere(const BoundingSphere& boundingSphere, std::vector<int32_t>& queryResults) const;
+		void QueryBoundingBox(const BoundingBox& boundingBox, std::vector<int32_t>& queryResults) const;
+		//Returns the proxy whose fat box the ray enters first within maximumDistance, or NullNode. Direction needs not be normalized, in which case
+		//distances are in multiples of its length.
+		int32_t RayCast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float maximumDistance, float* hitDistance = nullptr) const;
+
+		size_t RetrieveProxyCount() const { return m_ProxyCount; }
+		int32_t RetrieveHeight() const { return m_RootIndex == NullNode ? 0 : m_Nodes[m_RootIndex].m_Height; }
+
+	public:
+		static constexpr int32_t NullNode = -1;
+
+	private:
+		struct TreeNode
+		{
+			BoundingBox m_Bounds;
+			void* m_UserData = nullptr;
+			int32_t m_ParentIndex = NullNode; //Links to the next free node while on the free list.
+			int32_t m_LeftChild = NullNode;
+			int32_t m_RightChild = NullNode;
+			int32_t m_Height = 0; //Leaves are at 0, free nodes at -1.
+
+			bool IsLeaf() const { return m_LeftChild == NullNode; }
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t nodeIndex);
+		void InsertLeaf(int32_t leafIndex);
+		void RemoveLeaf(int32_t leafIndex);
+		//Refits and rebalances every node from the given one up to the root.
+		void RefitAncestors(int32_t nodeIndex);
+		//Rotates the node's taller child up if its children's heights differ by more than one. Returns the index now in the node's place.
+		int32_t BalanceNode(int32_t nodeIndex);
+		void CollectLeaves(int32_t nodeIndex, std::vector<int32_t>& queryResults) const;
+
+	private:
+		static constexpr float m_FatBoundsMargin = 0.1f; //Added on every side of a leaf's tight bounds, in world units.
+
+		std::vector<TreeNode> m_Nodes;
+		int32_t m_RootIndex = NullNode;
+		int32_t m_FreeList = NullNode;
+		size_t m_ProxyCount = 0;
+
+		mutable std::vector<int32_t> m_TraversalStack;
+	};
+}
@@ -7,11 +7,12 @@
 
 namespace Crescent
 {
-	Skybox::Skybox() : SceneEntity("Skybox", Scene::m_SceneEntityCounterID++)
+	Skybox::Skybox() : SceneEntity("Skybox", InvalidPoolHandle)
 	{
 		m_CubeMapShader = Resources::LoadShader("Background", "Resources/Shaders/SkyboxVertex.shader", "Resources/Shaders/SkyboxFragment.shader");
 		m_Material = new Material(m_CubeMapShader);
 		m_Mesh = new Cube();
+		m_Mesh->ClearBounds(); //Drawn around the camera wherever it is, so it must never be culled.
 
 		//Default Material Configuration
 		m_Material->SetShaderFloat("Exposure", 1.0f);
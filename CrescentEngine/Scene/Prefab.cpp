@@ -0,0 +1,107 @@
+#include "CrescentPCH.h"
+#include "Prefab.h"
+#include "SceneEntity.h"
+#include "../Models/Mesh.h"
+#include "../Shading/Material.h"
+#include <algorithm>
+#include <utility>
+
+namespace Crescent
+{
+	Prefab::Prefab(const std::string& prefabName, const std::string& sourcePath, SceneEntity* rootEntity) : m_PrefabName(prefabName), m_SourcePath(sourcePath)
+	{
+		//World matrices of the source entities are brought into the root's space, and local transforms recovered from those of their parents.
+		rootEntity->UpdateEntityTransform();
+		glm::mat4 inverseRootTransform = glm::inverse(rootEntity->RetrieveEntityTransform());
+
+		std::vector<std::pair<SceneEntity*, uint32_t>> nodeStack;
+		nodeStack.push_back(std::make_pair(rootEntity, InvalidPrefabNode));
+		while (!nodeStack.empty())
+		{
+			SceneEntity* sceneEntity = nodeStack.back().first;
+			uint32_t parentIndex = nodeStack.back().second;
+			nodeStack.pop_back();
+
+			uint32_t nodeIndex = (uint32_t)m_Nodes.size();
+			glm::mat4 rootTransform = inverseRootTransform * sceneEntity->RetrieveEntityTransform();
+
+			PrefabNode prefabNode;
+			prefabNode.m_NodeName = sceneEntity->RetrieveEntityName();
+			prefabNode.m_Mesh = sceneEntity->m_Mesh;
+			prefabNode.m_Material = sceneEntity->m_Material;
+			prefabNode.m_ParentIndex = parentIndex;
+			prefabNode.m_LocalTransform = parentIndex == InvalidPrefabNode ? rootTransform : glm::inverse(m_RootTransforms[parentIndex]) * rootTransform;
+			m_Nodes.push_back(prefabNode);
+			m_RootTransforms.push_back(rootTransform);
+
+			//Pushed in reverse so children keep their order once popped.
+			size_t firstChild = nodeStack.size();
+			for (SceneEntity* childEntity = sceneEntity->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
+			{
+				nodeStack.push_back(std::make_pair(childEntity, nodeIndex));
+			}
+			std::reverse(nodeStack.begin() + firstChild, nodeStack.end());
+		}
+
+		GatherRenderableNodes();
+	}
+
+	Prefab::Prefab(const std::string& prefabName, const std::string& sourcePath, std::vector<PrefabNode> prefabNodes) : m_PrefabName(prefabName), m_SourcePath(sourcePath),
+		m_Nodes(std::move(prefabNodes))
+	{
+		ResolveRootTransforms(std::vector<PrefabOverride>(), m_RootTransforms);
+		GatherRenderableNodes();
+	}
+
+	void Prefab::ResolveRootTransforms(const std::vector<PrefabOverride>& prefabOverrides, std::vector<glm::mat4>& rootTransforms) const
+	{
+		rootTransforms.resize(m_Nodes.size());
+
+		//Both lists are in node order, so overrides are matched with a single cursor.
+		size_t overrideIndex = 0;
+		for (uint32_t i = 0; i < m_Nodes.size(); i++)
+		{
+			const glm::mat4* localTransform = &m_Nodes[i].m_LocalTransform;
+			if (overrideIndex < prefabOverrides.size() && prefabOverrides[overrideIndex].m_NodeIndex == i)
+			{
+				if (prefabOverrides[overrideIndex].m_TransformOverridden)
+				{
+					localTransform = &prefabOverrides[overrideIndex].m_LocalTransform;
+				}
+				overrideIndex++;
+			}
+
+			uint32_t parentIndex = m_Nodes[i].m_ParentIndex;
+			rootTransforms[i] = parentIndex == InvalidPrefabNode ? *localTransform : rootTransforms[parentIndex] * *localTransform;
+		}
+	}
+
+	void Prefab::GatherRenderableNodes()
+	{
+		for (uint32_t i = 0; i < m_Nodes.size(); i++)
+		{
+			if (m_Nodes[i].m_Mesh && m_Nodes[i].m_Material)
+			{
+				m_RenderableNodes.push_back(i);
+				m_ShadowCasting |= m_Nodes[i].m_Material->m_ShadowCasting;
+			}
+		}
+		m_Bounds = CalculateBounds(m_RootTransforms);
+	}
+
+	BoundingBox Prefab::CalculateBounds(const std::vector<glm::mat4>& rootTransforms) const
+	{
+		BoundingBox prefabBounds;
+		for (unsigned int i = 0; i < m_RenderableNodes.size(); i++)
+		{
+			const BoundingBox& meshBounds = m_Nodes[m_RenderableNodes[i]].m_Mesh->RetrieveLocalBoundingBox();
+			if (meshBounds.IsValid())
+			{
+				BoundingBox nodeBounds = meshBounds.Transform(rootTransforms[m_RenderableNodes[i]]);
+				prefabBounds.Merge(nodeBounds.m_Minimum);
+				prefabBounds.Merge(nodeBounds.m_Maximum);
+			}
+		}
+		return prefabBounds;
+	}
+}
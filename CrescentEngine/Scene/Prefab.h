@@ -0,0 +1,80 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../Utilities/Bounds.h"
+
+namespace Crescent
+{
+	class SceneEntity;
+	class Mesh;
+	class Material;
+
+	const uint32_t InvalidPrefabNode = 0xFFFFFFFF;
+
+	struct PrefabNode
+	{
+		std::string m_NodeName;
+		Mesh* m_Mesh = nullptr;
+		Material* m_Material = nullptr;
+		uint32_t m_ParentIndex = InvalidPrefabNode;
+		glm::mat4 m_LocalTransform = glm::mat4(1.0f); //Relative to the parent node.
+	};
+
+	//Per instance changes to a single prefab node, kept sorted by node index.
+	struct PrefabOverride
+	{
+		uint32_t m_NodeIndex = InvalidPrefabNode;
+		Material* m_Material = nullptr; //Owned by the instance. Nullptr if the prefab's material is used.
+		bool m_TransformOverridden = false;
+		glm::mat4 m_LocalTransform = glm::mat4(1.0f);
+	};
+
+	/*
+		An immutable model asset. The node hierarchy, meshes and materials are held once, while each placement in the scene is a single entity that
+		references the prefab and draws all of its nodes below its own transform. Instances only store the nodes they have changed, copying a node's
+		material on its first edit, so placing a model costs one entity regardless of how many nodes it has.
+
+		Nodes are stored depth first, with every node's parent preceding it.
+	*/
+
+	class Prefab
+	{
+	public:
+		//Flattens an entity hierarchy into a prefab. The entities are left untouched and can be destroyed afterwards, while their meshes and materials
+		//are now shared by the prefab.
+		Prefab(const std::string& prefabName, const std::string& sourcePath, SceneEntity* rootEntity);
+		//Takes over nodes that are already flattened depth first, such as those read back from a scene file.
+		Prefab(const std::string& prefabName, const std::string& sourcePath, std::vector<PrefabNode> prefabNodes);
+
+		const std::string& RetrievePrefabName() const { return m_PrefabName; }
+		//The model file the prefab was loaded from, so scenes can refer to it.
+		const std::string& RetrieveSourcePath() const { return m_SourcePath; }
+		const std::vector<PrefabNode>& RetrieveNodes() const { return m_Nodes; }
+		//Nodes with both a mesh and a material, in depth first order.
+		const std::vector<uint32_t>& RetrieveRenderableNodes() const { return m_RenderableNodes; }
+		//Transform of each node relative to the prefab's root.
+		const std::vector<glm::mat4>& RetrieveRootTransforms() const { return m_RootTransforms; }
+		//Bounds of all renderable nodes relative to the prefab's root.
+		const BoundingBox& RetrieveBounds() const { return m_Bounds; }
+		bool IsShadowCasting() const { return m_ShadowCasting; }
+
+		//Composes the root relative transform of every node, with an instance's transform overrides in place of the prefab's local transforms.
+		void ResolveRootTransforms(const std::vector<PrefabOverride>& prefabOverrides, std::vector<glm::mat4>& rootTransforms) const;
+		BoundingBox CalculateBounds(const std::vector<glm::mat4>& rootTransforms) const;
+
+	private:
+		//Lists the renderable nodes and computes our bounds, once every node and its root transform is in place.
+		void GatherRenderableNodes();
+
+	private:
+		std::string m_PrefabName;
+		std::string m_SourcePath;
+		std::vector<PrefabNode> m_Nodes;
+		std::vector<uint32_t> m_RenderableNodes;
+		std::vector<glm::mat4> m_RootTransforms;
+		BoundingBox m_Bounds;
+		bool m_ShadowCasting = false; //Whether any renderable node casts shadows.
+	};
+}
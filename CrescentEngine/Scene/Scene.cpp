@@ -2,12 +2,14 @@
 #include "Scene.h"
 #include "SceneEntity.h"
 #include "Entities/Skybox.h"
+#include "../Models/Mesh.h"
+#include "../Shading/Material.h"
+#include "../Utilities/Frustum.h"
 #include <stack>
+#include <algorithm>
 
 namespace Crescent
 {
-	unsigned int Scene::m_SceneEntityCounterID = 0;
-
 	Scene::Scene(bool isEmptyScene)
 	{
 		ConstructDefaultScene();
@@ -15,15 +17,15 @@ namespace Crescent
 
 	void Scene::ClearScene()
 	{
-		for (int i = 0; i < m_SceneEntities.size(); i++)
+		while (!m_SceneEntities.empty())
 		{
-			DeleteSceneEntity(m_SceneEntities[i]);
+			DeleteSceneEntity(m_SceneEntities.back());
 		}
 	}
 
 	SceneEntity* Scene::ConstructNewEntity()
 	{
-		SceneEntity* newEntity = new SceneEntity("Empty Entity", Scene::m_SceneEntityCounterID++);
+		SceneEntity* newEntity = SceneEntity::CreateEntity("Empty Entity");
 		m_SceneEntities.push_back(newEntity);
 
 		return newEntity;
@@ -31,7 +33,7 @@ namespace Crescent
 
 	SceneEntity* Scene::ConstructNewEntity(Mesh* mesh, Material* material)
 	{
-		SceneEntity* newEntity = new SceneEntity("Model", Scene::m_SceneEntityCounterID++);
+		SceneEntity* newEntity = SceneEntity::CreateEntity("Model");
 		
 		newEntity->m_Mesh = mesh;
 		newEntity->m_Material = material;
@@ -41,33 +43,45 @@ namespace Crescent
 		return newEntity;
 	}
 
+	SceneEntity* Scene::ConstructNewEntity(const Prefab* prefab)
+	{
+		SceneEntity* newEntity = SceneEntity::CreateEntity(prefab->RetrievePrefabName());
+		newEntity->SetPrefab(prefab);
+		m_SceneEntities.push_back(newEntity);
+
+		return newEntity;
+	}
+
 	SceneEntity* Scene::ConstructNewEntity(SceneEntity* sceneEntity)
 	{
-		SceneEntity* newEntity = new SceneEntity(sceneEntity->RetrieveEntityName(), Scene::m_SceneEntityCounterID++);
+		SceneEntity* newEntity = SceneEntity::CreateEntity(sceneEntity->RetrieveEntityName());
 
 		newEntity->m_Mesh = sceneEntity->m_Mesh;
 		newEntity->m_Material = sceneEntity->m_Material;
+		CopyPrefabInstance(sceneEntity, newEntity);
 
-		//Traverse through the list of children and add them accordingly.
-		std::stack<SceneEntity*> nodeStack;
-		for (unsigned int i = 0; i < sceneEntity->RetrieveChildCount(); i++)
+		//Traverse through the list of children and add them accordingly. Each copy is attached under the copy of its own parent.
+		std::stack<std::pair<SceneEntity*, SceneEntity*>> nodeStack;
+		for (SceneEntity* childEntity = sceneEntity->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
 		{
-			nodeStack.push(sceneEntity->RetrieveChildByIndex(i));
+			nodeStack.push(std::make_pair(childEntity, newEntity));
 		}
 		while (!nodeStack.empty())
 		{
-			SceneEntity* child = nodeStack.top();
+			SceneEntity* child = nodeStack.top().first;
+			SceneEntity* newParent = nodeStack.top().second;
 			nodeStack.pop();
 
 			//Similarly, create SceneNode for each child and push to scene node memory list.
-			SceneEntity* newChild = new SceneEntity(sceneEntity->RetrieveEntityName(), Scene::m_SceneEntityCounterID++);
+			SceneEntity* newChild = SceneEntity::CreateEntity(child->RetrieveEntityName());
 			newChild->m_Mesh = child->m_Mesh;
 			newChild->m_Material = child->m_Material;
-			newEntity->AddChildEntity(newChild);
+			CopyPrefabInstance(child, newChild);
+			newParent->AddChildEntity(newChild);
 
-			for (unsigned int i = 0; i < child->RetrieveChildCount(); i++)
+			for (SceneEntity* childEntity = child->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
 			{
-				nodeStack.push(child->RetrieveChildByIndex(i));
+				nodeStack.push(std::make_pair(childEntity, newChild));
 			}
 		}
 
@@ -82,7 +96,14 @@ namespace Crescent
 
 	void Scene::DeleteSceneEntity(SceneEntity* sceneEntity)
 	{
-		delete sceneEntity;
+		RemoveFromSpatialIndex(sceneEntity);
+
+		auto iterator = std::find(m_SceneEntities.begin(), m_SceneEntities.end(), sceneEntity);
+		if (iterator != m_SceneEntities.end())
+		{
+			m_SceneEntities.erase(iterator);
+		}
+		SceneEntity::DestroyEntityHierarchy(sceneEntity);
 	}
 
 	std::vector<SceneEntity*> Scene::RetrieveSceneEntities()
@@ -90,8 +111,174 @@ namespace Crescent
 		return m_SceneEntities;
 	}
 
+	void Scene::UpdateSpatialIndex()
+	{
+		TransformHierarchy& transformHierarchy = SceneEntity::RetrieveTransformHierarchy();
+		transformHierarchy.UpdateWorldTransforms();
+
+		if (transformHierarchy.RetrieveStructureVersion() != m_IndexedStructureVersion)
+		{
+			SynchronizeSpatialIndex();
+			m_IndexedStructureVersion = transformHierarchy.RetrieveStructureVersion();
+		}
+
+		//Moves within an entity's fat bounds are absorbed by MoveProxy without touching the tree.
+		transformHierarchy.ConsumeChangedTransforms(m_ChangedTransforms);
+		for (size_t i = 0; i < m_ChangedTransforms.size(); i++)
+		{
+			TransformHandle transformHandle = m_ChangedTransforms[i];
+			if (transformHandle < m_TransformProxies.size() && m_TransformProxies[transformHandle] != DynamicAABBTree::NullNode)
+			{
+				int32_t proxyID = m_TransformProxies[transformHandle];
+				m_SpatialIndex.MoveProxy(proxyID, ((SceneEntity*)m_SpatialIndex.RetrieveUserData(proxyID))->CalculateWorldBounds());
+			}
+		}
+	}
+
+	void Scene::QueryFrustum(const Frustum& frustum, std::vector<SceneEntity*>& queryResults)
+	{
+		m_ProxyQueryResults.clear();
+		m_SpatialIndex.QueryFrustum(frustum, m_ProxyQueryResults);
+		CollectQueryResults(queryResults);
+	}
+
+	void Scene::QueryBoundingSphere(const BoundingSphere& boundingSphere, std::vector<SceneEntity*>& queryResults)
+	{
+		m_ProxyQueryResults.clear();
+		m_SpatialIndex.QueryBoundingSphere(boundingSphere, m_ProxyQueryResults);
+		CollectQueryResults(queryResults);
+	}
+
+	void Scene::QueryBoundingBox(const BoundingBox& boundingBox, std::vector<SceneEntity*>& queryResults)
+	{
+		m_ProxyQueryResults.clear();
+		m_SpatialIndex.QueryBoundingBox(boundingBox, m_ProxyQueryResults);
+		CollectQueryResults(queryResults);
+	}
+
+	SceneEntity* Scene::RayCast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float maximumDistance, float* hitDistance)
+	{
+		int32_t proxyID = m_SpatialIndex.RayCast(rayOrigin, rayDirection, maximumDistance, hitDistance);
+		return proxyID == DynamicAABBTree::NullNode ? nullptr : (SceneEntity*)m_SpatialIndex.RetrieveUserData(proxyID);
+	}
+
+	void Scene::ConsumeRemovedShadowCasterBounds(std::vector<BoundingBox>& removedBounds)
+	{
+		removedBounds.swap(m_RemovedShadowCasterBounds);
+		m_RemovedShadowCasterBounds.clear();
+	}
+
 	void Scene::ConstructDefaultScene()
 	{
 		//To implement if we want default scenes. For future scene swapping support?
 	}
+
+	void Scene::SynchronizeSpatialIndex()
+	{
+		//Walk every entity reachable from the scene, indexing renderable ones that aren't yet. Proxies whose entity is no longer reachable are dropped.
+		m_TransformProxies.resize(SceneEntity::RetrieveTransformHierarchy().RetrieveHandleCount(), DynamicAABBTree::NullNode);
+		std::vector<uint8_t> reachedTransforms(m_TransformProxies.size(), 0);
+
+		std::stack<SceneEntity*> nodeStack;
+		for (unsigned int i = 0; i < m_SceneEntities.size(); i++)
+		{
+			nodeStack.push(m_SceneEntities[i]);
+		}
+		while (!nodeStack.empty())
+		{
+			SceneEntity* sceneEntity = nodeStack.top();
+			nodeStack.pop();
+			for (SceneEntity* childEntity = sceneEntity->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
+			{
+				nodeStack.push(childEntity);
+			}
+
+			//Skyboxes surround everything, so they are never culled or picked.
+			if (!sceneEntity->CalculateLocalBounds().IsValid() || dynamic_cast<Skybox*>(sceneEntity))
+			{
+				continue;
+			}
+
+			TransformHandle transformHandle = sceneEntity->RetrieveTransformHandle();
+			int32_t& proxyID = m_TransformProxies[transformHandle];
+			reachedTransforms[transformHandle] = 1;
+			if (proxyID != DynamicAABBTree::NullNode && m_SpatialIndex.RetrieveUserData(proxyID) != sceneEntity)
+			{
+				m_SpatialIndex.DestroyProxy(proxyID); //The handle was recycled by an entity deleted outside of the scene.
+				proxyID = DynamicAABBTree::NullNode;
+			}
+			if (proxyID == DynamicAABBTree::NullNode)
+			{
+				proxyID = m_SpatialIndex.CreateProxy(sceneEntity->CalculateWorldBounds(), sceneEntity);
+			}
+		}
+
+		for (size_t i = 0; i < m_TransformProxies.size(); i++)
+		{
+			if (m_TransformProxies[i] != DynamicAABBTree::NullNode && !reachedTransforms[i])
+			{
+				//The entity may already be deleted, so we can't tell whether it was a static caster and assume it was.
+				m_RemovedShadowCasterBounds.push_back(m_SpatialIndex.RetrieveFatBounds(m_TransformProxies[i]));
+				m_SpatialIndex.DestroyProxy(m_TransformProxies[i]);
+				m_TransformProxies[i] = DynamicAABBTree::NullNode;
+			}
+		}
+	}
+
+	void Scene::RemoveFromSpatialIndex(SceneEntity* sceneEntity)
+	{
+		std::stack<SceneEntity*> nodeStack;
+		nodeStack.push(sceneEntity);
+		while (!nodeStack.empty())
+		{
+			SceneEntity* node = nodeStack.top();
+			nodeStack.pop();
+			for (SceneEntity* childEntity = node->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
+			{
+				nodeStack.push(childEntity);
+			}
+
+			TransformHandle transformHandle = node->RetrieveTransformHandle();
+			if (transformHandle < m_TransformProxies.size() && m_TransformProxies[transformHandle] != DynamicAABBTree::NullNode)
+			{
+				if (node->m_StaticShadowCaster)
+				{
+					m_RemovedShadowCasterBounds.push_back(m_SpatialIndex.RetrieveFatBounds(m_TransformProxies[transformHandle]));
+				}
+				m_SpatialIndex.DestroyProxy(m_TransformProxies[transformHandle]);
+				m_TransformProxies[transformHandle] = DynamicAABBTree::NullNode;
+			}
+		}
+	}
+
+	void Scene::CopyPrefabInstance(SceneEntity* sourceEntity, SceneEntity* targetEntity)
+	{
+		if (!sourceEntity->RetrievePrefab())
+		{
+			return;
+		}
+
+		//Overridden materials are copied as well, as each instance owns its own.
+		targetEntity->SetPrefab(sourceEntity->RetrievePrefab());
+		const std::vector<PrefabOverride>& prefabOverrides = sourceEntity->RetrievePrefabOverrides();
+		for (unsigned int i = 0; i < prefabOverrides.size(); i++)
+		{
+			if (prefabOverrides[i].m_Material)
+			{
+				*targetEntity->OverridePrefabMaterial(prefabOverrides[i].m_NodeIndex) = prefabOverrides[i].m_Material->CopyMaterial();
+			}
+			if (prefabOverrides[i].m_TransformOverridden)
+			{
+				targetEntity->OverridePrefabTransform(prefabOverrides[i].m_NodeIndex, prefabOverrides[i].m_LocalTransform);
+			}
+		}
+	}
+
+	void Scene::CollectQueryResults(std::vector<SceneEntity*>& queryResults)
+	{
+		for (size_t i = 0; i < m_ProxyQueryResults.size(); i++)
+		{
+			queryResults.push_back((SceneEntity*)m_SpatialIndex.RetrieveUserData(m_ProxyQueryResults[i]));
+		}
+	}
 }
\ No newline at end of file
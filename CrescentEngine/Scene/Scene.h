@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include "DynamicAABBTree.h"
+#include "TransformHierarchy.h"
 
 /*
 	- This is our global scene object. There will always one global scene object which can be cleared and configured at will.
@@ -14,6 +16,8 @@ namespace Crescent
 	class PointLight;
 	class DirectionalLight;
 	class Skybox;
+	class Frustum;
+	class Prefab;
 
 	class Scene
 	{
@@ -31,6 +35,9 @@ namespace Crescent
 		SceneEntity* ConstructNewEntity(PointLight* pointLight); ///Take lighting positions from the scene entity.
 		SceneEntity* ConstructNewEntity(DirectionalLight* directionalLight); ///Take lighting rotations from the scene entity.
 
+		//Places an instance of a prefab. Instances share the prefab's nodes, meshes and materials until they override them.
+		SceneEntity* ConstructNewEntity(const Prefab* prefab);
+		//Copies an entity together with its children. Prefab instances are copied along with their overrides.
 		SceneEntity* ConstructNewEntity(SceneEntity* sceneEntity);
 
 		void ConstructSkyboxEntity(Skybox* skyBox);
@@ -40,14 +47,40 @@ namespace Crescent
 
 		std::vector<SceneEntity*> RetrieveSceneEntities();
 
-	public:
-		static unsigned int m_SceneEntityCounterID;
-	
+		//Brings the world bounds of every renderable entity in the spatial index up to date. Only entities whose transforms changed are touched,
+		//unless entities were added, removed or reparented since the last update.
+		void UpdateSpatialIndex();
+
+		//Spatial queries over renderable entities, testing their (slightly enlarged) world bounds. Results are appended in no particular order.
+		void QueryFrustum(const Frustum& frustum, std::vector<SceneEntity*>& queryResults);
+		void QueryBoundingSphere(const BoundingSphere& boundingSphere, std::vector<SceneEntity*>& queryResults);
+		void QueryBoundingBox(const BoundingBox& boundingBox, std::vector<SceneEntity*>& queryResults);
+		//Returns the entity whose bounds the ray enters first, or nullptr.
+		SceneEntity* RayCast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float maximumDistance = FLT_MAX, float* hitDistance = nullptr);
+
+		const DynamicAABBTree& RetrieveSpatialIndex() const { return m_SpatialIndex; }
+
+		//Hands over the bounds of static shadow casters removed from the spatial index since the last call, so the renderer can redraw the cached
+		//shadows they fell into. Removals neither move a transform nor show up in any later query, so they would go unnoticed otherwise.
+		void ConsumeRemovedShadowCasterBounds(std::vector<BoundingBox>& removedBounds);
+
 	private:
 		void ConstructDefaultScene();
+		void SynchronizeSpatialIndex();
+		void RemoveFromSpatialIndex(SceneEntity* sceneEntity);
+		void CopyPrefabInstance(SceneEntity* sourceEntity, SceneEntity* targetEntity);
+		void CollectQueryResults(std::vector<SceneEntity*>& queryResults);
 
 	private:
 		//Cache all scene entities part of the current scene.
 		std::vector<SceneEntity*> m_SceneEntities;
+
+		//Spatial Index
+		DynamicAABBTree m_SpatialIndex;
+		std::vector<int32_t> m_TransformProxies; //Proxy of each entity by transform handle, DynamicAABBTree::NullNode if it has none.
+		std::vector<TransformHandle> m_ChangedTransforms;
+		std::vector<int32_t> m_ProxyQueryResults;
+		std::vector<BoundingBox> m_RemovedShadowCasterBounds;
+		uint32_t m_IndexedStructureVersion = 0xFFFFFFFF;
 	};
 }
\ No newline at end of file
@@ -1,84 +1,203 @@
 #include "CrescentPCH.h"
 #include "SceneEntity.h"
-#include "glm/gtc/matrix_transform.hpp"
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/quaternion.hpp>
+#include "../Shading/Material.h"
+#include "../Models/Mesh.h"
+#include <algorithm>
 
 namespace Crescent
 {
+	TransformHierarchy& SceneEntity::RetrieveTransformHierarchy()
+	{
+		static TransformHierarchy transformHierarchy;
+		return transformHierarchy;
+	}
+
+	//The hierarchy has to outlive the pool, as destroying pooled entities releases their transforms. Statics are destroyed in reverse order of construction.
+	static ChunkedPool<SceneEntity>& RetrieveEntityPool()
+	{
+		SceneEntity::RetrieveTransformHierarchy();
+		static ChunkedPool<SceneEntity> entityPool;
+		return entityPool;
+	}
+
+	SceneEntity* SceneEntity::CreateEntity(const std::string& entityName)
+	{
+		return RetrieveEntityPool().Create(entityName);
+	}
+
+	void SceneEntity::DestroyEntity(SceneEntity* sceneEntity)
+	{
+		if (sceneEntity->IsPooled())
+		{
+			RetrieveEntityPool().Destroy(sceneEntity->m_EntityID);
+		}
+		else
+		{
+			delete sceneEntity;
+		}
+	}
+
+	void SceneEntity::DestroyEntityHierarchy(SceneEntity* sceneEntity)
+	{
+		//Children are destroyed leaves first, so no entity outlives its parent only to be detached as a root.
+		std::vector<SceneEntity*> subtreeEntities;
+		subtreeEntities.push_back(sceneEntity);
+		for (size_t i = 0; i < subtreeEntities.size(); i++)
+		{
+			for (SceneEntity* childEntity = subtreeEntities[i]->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
+			{
+				subtreeEntities.push_back(childEntity);
+			}
+		}
+		for (size_t i = subtreeEntities.size(); i-- > 0;)
+		{
+			DestroyEntity(subtreeEntities[i]);
+		}
+	}
+
+	SceneEntity* SceneEntity::RetrieveEntity(unsigned int entityID)
+	{
+		return RetrieveEntityPool().Resolve(entityID);
+	}
+
 	SceneEntity::SceneEntity(const std::string& entityName, const unsigned int& entityID) : m_EntityName(entityName), m_EntityID(entityID)
 	{
+		m_TransformHandle = RetrieveTransformHierarchy().CreateTransform();
+	}
+
+	SceneEntity::~SceneEntity()
+	{
+		if (SceneEntity* parentEntity = RetrieveParentEntity())
+		{
+			parentEntity->UnlinkChild(this);
+		}
+		while (SceneEntity* childEntity = RetrieveFirstChild())
+		{
+			UnlinkChild(childEntity);
+		}
+		RevertPrefabOverrides();
+		RetrieveTransformHierarchy().ReleaseTransform(m_TransformHandle);
+	}
 
+	bool SceneEntity::IsPooled() const
+	{
+		return RetrieveEntityPool().Resolve(m_EntityID) == this;
 	}
 
 	void SceneEntity::AddChildEntity(SceneEntity* childEntity)
 	{
+		//Links are pool indices, so entities outside of the pool can't take part.
+		if (!IsPooled() || !childEntity->IsPooled())
+		{
+			CrescentInfo("Only pooled scene entities can be parented. Ignoring " + childEntity->m_EntityName + ".");
+			return;
+		}
+
 		//Check if this child already has a parent. If so, first remove this scene node from its current parent. Scene nodes cannot exist under multiple parents.
-		if (childEntity->m_ParentEntity != nullptr)
+		if (SceneEntity* parentEntity = childEntity->RetrieveParentEntity())
 		{
-			childEntity->m_ParentEntity->RemoveChildEntity(childEntity->m_EntityID);
+			parentEntity->UnlinkChild(childEntity);
 		}
 
-		childEntity->m_ParentEntity = this;
-		m_ChildEntities.push_back(childEntity);
+		ChunkedPool<SceneEntity>& entityPool = RetrieveEntityPool();
+		uint32_t childIndex = entityPool.RetrieveIndex(childEntity->m_EntityID);
+		childEntity->m_ParentIndex = entityPool.RetrieveIndex(m_EntityID);
+		childEntity->m_PreviousSiblingIndex = m_LastChildIndex;
+		if (m_LastChildIndex != InvalidPoolIndex)
+		{
+			entityPool.RetrieveByIndex(m_LastChildIndex)->m_NextSiblingIndex = childIndex;
+		}
+		else
+		{
+			m_FirstChildIndex = childIndex;
+		}
+		m_LastChildIndex = childIndex;
+		m_ChildCount++;
+
+		RetrieveTransformHierarchy().SetParent(childEntity->m_TransformHandle, m_TransformHandle);
 	}
 
 	void SceneEntity::RemoveChildEntity(unsigned int entityID)
 	{
-		auto iterator = std::find(m_ChildEntities.begin(), m_ChildEntities.end(), RetrieveChildEntity(entityID));
-		if (iterator != m_ChildEntities.end())
+		if (SceneEntity* childEntity = RetrieveChildEntity(entityID))
 		{
-			m_ChildEntities.erase(iterator);
+			UnlinkChild(childEntity);
 		}
 	}
 
-	void SceneEntity::UpdateEntityTransform(bool updatePreviousTransform)
+	void SceneEntity::UnlinkChild(SceneEntity* childEntity)
 	{
-		if (m_IsTransformDirty)
+		ChunkedPool<SceneEntity>& entityPool = RetrieveEntityPool();
+		if (childEntity->m_PreviousSiblingIndex != InvalidPoolIndex)
 		{
-			glm::mat4 rotation = glm::toMat4(glm::quat(m_EntityRotation));
-			m_EntityTransform = glm::translate(glm::mat4(1.0f), m_EntityPosition) * rotation * glm::scale(glm::mat4(1.0f), m_EntityScale);
-
-			if (m_ParentEntity != nullptr)
-			{
-				m_EntityTransform = m_ParentEntity->m_EntityTransform * m_EntityTransform;
-			}
+			entityPool.RetrieveByIndex(childEntity->m_PreviousSiblingIndex)->m_NextSiblingIndex = childEntity->m_NextSiblingIndex;
+		}
+		else
+		{
+			m_FirstChildIndex = childEntity->m_NextSiblingIndex;
 		}
 
-		for (int i = 0; i < m_ChildEntities.size(); i++)
+		if (childEntity->m_NextSiblingIndex != InvalidPoolIndex)
 		{
-			if (m_IsTransformDirty)
-			{
-				m_ChildEntities[i]->m_IsTransformDirty = true;
-			}
-			m_ChildEntities[i]->UpdateEntityTransform(updatePreviousTransform);
+			entityPool.RetrieveByIndex(childEntity->m_NextSiblingIndex)->m_PreviousSiblingIndex = childEntity->m_PreviousSiblingIndex;
+		}
+		else
+		{
+			m_LastChildIndex = childEntity->m_PreviousSiblingIndex;
 		}
 
-		m_IsTransformDirty = false;
+		childEntity->m_ParentIndex = InvalidPoolIndex;
+		childEntity->m_PreviousSiblingIndex = InvalidPoolIndex;
+		childEntity->m_NextSiblingIndex = InvalidPoolIndex;
+		m_ChildCount--;
+
+		RetrieveTransformHierarchy().SetParent(childEntity->m_TransformHandle, InvalidTransformHandle);
+	}
+
+	void SceneEntity::UpdateEntityTransform(bool updatePreviousTransform)
+	{
+		//World matrices of every entity are resolved together. This is a no-op if nothing changed since the last update.
+		RetrieveTransformHierarchy().UpdateWorldTransforms();
+	}
+
+	void SceneEntity::MarkTransformDirty()
+	{
+		RetrieveTransformHierarchy().MarkTransformDirty(m_TransformHandle);
 	}
 
 	void SceneEntity::SetEntityPosition(glm::vec3 newPosition)
 	{
-		m_EntityPosition = newPosition;
-		m_IsTransformDirty = true;
+		glm::vec3& entityPosition = RetrieveEntityPosition();
+		if (entityPosition != newPosition)
+		{
+			entityPosition = newPosition;
+			MarkTransformDirty();
+		}
 	}
 
 	void SceneEntity::SetEntityScale(glm::vec3 newScale)
 	{
-		m_EntityScale = newScale;
-		m_IsTransformDirty = true;
+		glm::vec3& entityScale = RetrieveEntityScale();
+		if (entityScale != newScale)
+		{
+			entityScale = newScale;
+			MarkTransformDirty();
+		}
 	}
 
 	void SceneEntity::SetEntityScale(float newScalar)
 	{
-		m_EntityScale = glm::vec3(newScalar, newScalar, newScalar);
-		m_IsTransformDirty = true;
+		SetEntityScale(glm::vec3(newScalar, newScalar, newScalar));
 	}
 
 	void SceneEntity::SetEntityRotation(glm::vec3 newRotation)
 	{
-		m_EntityRotation = newRotation;
-		m_IsTransformDirty = true;
+		glm::vec3& entityRotation = RetrieveEntityRotation();
+		if (entityRotation != newRotation)
+		{
+			entityRotation = newRotation;
+			MarkTransformDirty();
+		}
 	}
 
 	void SceneEntity::SetEntityName(const std::string& newName)
@@ -88,44 +207,53 @@ namespace Crescent
 
 	glm::mat4& SceneEntity::RetrieveEntityTransform()
 	{
-		if (m_IsTransformDirty)
-		{
-			UpdateEntityTransform(true);
-		}
+		return RetrieveTransformHierarchy().RetrieveWorldTransform(m_TransformHandle);
+	}
 
-		return m_EntityTransform;
+	bool SceneEntity::ConsumeTransformChange()
+	{
+		return RetrieveTransformHierarchy().ConsumeWorldTransformChange(m_TransformHandle);
 	}
 
 	glm::vec3& SceneEntity::RetrieveEntityPosition()
 	{
-		return m_EntityPosition;
+		return RetrieveTransformHierarchy().RetrieveLocalPosition(m_TransformHandle);
 	}
 
 	glm::vec3& SceneEntity::RetrieveEntityScale()
 	{
-		return m_EntityScale;
+		return RetrieveTransformHierarchy().RetrieveLocalScale(m_TransformHandle);
 	}
 
 	glm::vec3& SceneEntity::RetrieveEntityRotation()
 	{
-		return m_EntityRotation;
+		return RetrieveTransformHierarchy().RetrieveLocalRotation(m_TransformHandle);
 	}
 
 	SceneEntity* SceneEntity::RetrieveChildEntity(unsigned int entityID)
 	{
-		for (unsigned int i = 0; i < m_ChildEntities.size(); i++)
+		//Stale IDs resolve to nullptr, and anything else is only our child if it links back to us.
+		SceneEntity* childEntity = RetrieveEntity(entityID);
+		if (childEntity && childEntity->RetrieveParentEntity() == this)
 		{
-			if (m_ChildEntities[i]->m_EntityID == entityID)
-			{
-				return m_ChildEntities[i];
-			}
+			return childEntity;
 		}
 		return nullptr;
 	}
 
-	SceneEntity* SceneEntity::RetrieveChildByIndex(unsigned int entityIndex)
+	SceneEntity* SceneEntity::RetrieveFirstChild() const
+	{
+		return RetrieveEntityPool().RetrieveByIndex(m_FirstChildIndex);
+	}
+
+	SceneEntity* SceneEntity::RetrieveNextSibling() const
+	{
+		return RetrieveEntityPool().RetrieveByIndex(m_NextSiblingIndex);
+	}
+
+	SceneEntity* SceneEntity::RetrieveParentEntity() const
 	{
-		return m_ChildEntities[entityIndex];
+		return RetrieveEntityPool().RetrieveByIndex(m_ParentIndex);
 	}
 
 	std::string SceneEntity::RetrieveEntityName() const
@@ -137,4 +265,102 @@ namespace Crescent
 	{
 		return m_EntityID;
 	}
+
+	void SceneEntity::SetPrefab(const Prefab* prefab)
+	{
+		RevertPrefabOverrides();
+		m_Prefab = prefab;
+		MarkTransformDirty(); //Our bounds changed with the prefab.
+	}
+
+	Material* SceneEntity::OverridePrefabMaterial(uint32_t nodeIndex)
+	{
+		PrefabOverride& prefabOverride = RetrievePrefabOverride(nodeIndex);
+		if (!prefabOverride.m_Material)
+		{
+			prefabOverride.m_Material = new Material(m_Prefab->RetrieveNodes()[nodeIndex].m_Material->CopyMaterial());
+		}
+		return prefabOverride.m_Material;
+	}
+
+	void SceneEntity::OverridePrefabTransform(uint32_t nodeIndex, const glm::mat4& localTransform)
+	{
+		PrefabOverride& prefabOverride = RetrievePrefabOverride(nodeIndex);
+		if (!prefabOverride.m_TransformOverridden)
+		{
+			prefabOverride.m_TransformOverridden = true;
+			m_PrefabTransformOverrideCount++;
+		}
+		prefabOverride.m_LocalTransform = localTransform;
+		MarkTransformDirty();
+	}
+
+	void SceneEntity::RevertPrefabOverrides()
+	{
+		for (unsigned int i = 0; i < m_PrefabOverrides.size(); i++)
+		{
+			delete m_PrefabOverrides[i].m_Material;
+		}
+
+		if (m_PrefabTransformOverrideCount != 0)
+		{
+			m_PrefabTransformOverrideCount = 0;
+			MarkTransformDirty();
+		}
+		std::vector<PrefabOverride>().swap(m_PrefabOverrides);
+	}
+
+	Material* SceneEntity::RetrievePrefabMaterial(uint32_t nodeIndex) const
+	{
+		auto iterator = std::lower_bound(m_PrefabOverrides.begin(), m_PrefabOverrides.end(), nodeIndex, [](const PrefabOverride& prefabOverride, uint32_t index) { return prefabOverride.m_NodeIndex < index; });
+		if (iterator != m_PrefabOverrides.end() && iterator->m_NodeIndex == nodeIndex && iterator->m_Material)
+		{
+			return iterator->m_Material;
+		}
+		return m_Prefab->RetrieveNodes()[nodeIndex].m_Material;
+	}
+
+	BoundingBox SceneEntity::CalculatePrefabBounds() const
+	{
+		if (!m_Prefab)
+		{
+			return BoundingBox();
+		}
+		if (!HasPrefabTransformOverrides())
+		{
+			return m_Prefab->RetrieveBounds();
+		}
+
+		std::vector<glm::mat4> rootTransforms;
+		m_Prefab->ResolveRootTransforms(m_PrefabOverrides, rootTransforms);
+		return m_Prefab->CalculateBounds(rootTransforms);
+	}
+
+	BoundingBox SceneEntity::CalculateLocalBounds() const
+	{
+		if (m_Prefab)
+		{
+			return CalculatePrefabBounds();
+		}
+		return m_Mesh ? m_Mesh->RetrieveLocalBoundingBox() : BoundingBox();
+	}
+
+	BoundingBox SceneEntity::CalculateWorldBounds()
+	{
+		return CalculateLocalBounds().Transform(RetrieveEntityTransform());
+	}
+
+	PrefabOverride& SceneEntity::RetrievePrefabOverride(uint32_t nodeIndex)
+	{
+		//Overrides are few and rarely added, so a sorted vector beats any map here.
+		auto iterator = std::lower_bound(m_PrefabOverrides.begin(), m_PrefabOverrides.end(), nodeIndex, [](const PrefabOverride& prefabOverride, uint32_t index) { return prefabOverride.m_NodeIndex < index; });
+		if (iterator == m_PrefabOverrides.end() || iterator->m_NodeIndex != nodeIndex)
+		{
+			PrefabOverride prefabOverride;
+			prefabOverride.m_NodeIndex = nodeIndex;
+			prefabOverride.m_LocalTransform = m_Prefab->RetrieveNodes()[nodeIndex].m_LocalTransform;
+			iterator = m_PrefabOverrides.insert(iterator, prefabOverride);
+		}
+		return *iterator;
+	}
 }
\ No newline at end of file
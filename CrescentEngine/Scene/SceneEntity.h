@@ -1,10 +1,14 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
+#include "TransformHierarchy.h"
+#include "Prefab.h"
+#include "../Memory/ChunkedPool.h"
 
 /*
 	- Symbolizes a scene entity with a respective UI component. A scene entity contains several default parameters such as a name and transforms.
 	- Each entity can have any number of child entities, but there can only ever be one parent. 
+	- Entities live in a shared chunked pool and are identified by their pool handle. Children are linked through the pool as an intrusive list.
 */
 
 namespace Crescent
@@ -15,10 +19,21 @@ namespace Crescent
 	class SceneEntity
 	{
 	public:
-		SceneEntity(const std::string& entityName, const unsigned int& entityID);
+		//Entities are created and destroyed through these rather than new and delete. Destroying an entity detaches its children, which become roots.
+		static SceneEntity* CreateEntity(const std::string& entityName);
+		static void DestroyEntity(SceneEntity* sceneEntity);
+		//Destroys the entity together with all of its descendants.
+		static void DestroyEntityHierarchy(SceneEntity* sceneEntity);
+		//Returns nullptr if the entity has since been destroyed.
+		static SceneEntity* RetrieveEntity(unsigned int entityID);
+
+		SceneEntity(const SceneEntity&) = delete;
+		SceneEntity& operator=(const SceneEntity&) = delete;
 
 		//Transforms
 		void UpdateEntityTransform(bool updatePreviousTransform = false);
+		//Call after editing a value returned by RetrieveEntityPosition/Scale/Rotation in place.
+		void MarkTransformDirty();
 
 		void SetEntityPosition(glm::vec3 newPosition);
 		void SetEntityScale(glm::vec3 newScale);
@@ -34,12 +49,41 @@ namespace Crescent
 		glm::vec3& RetrieveEntityScale();
 		glm::vec3& RetrieveEntityRotation();
 		SceneEntity* RetrieveChildEntity(unsigned int entityID);
-		unsigned int RetrieveChildCount() const { return m_ChildEntities.size(); }
-		SceneEntity* RetrieveChildByIndex(unsigned int entityIndex);
+		unsigned int RetrieveChildCount() const { return m_ChildCount; }
+		//Children are walked from the first child through its siblings, in the order they were added.
+		SceneEntity* RetrieveFirstChild() const;
+		SceneEntity* RetrieveNextSibling() const;
+		SceneEntity* RetrieveParentEntity() const;
 
 		std::string RetrieveEntityName() const;
 
+		//Returns whether the transform was recalculated since the last call. The renderer uses this to tell static entities apart from moving ones.
+		bool ConsumeTransformChange();
+
 		unsigned int RetrieveEntityID() const;
+		TransformHandle RetrieveTransformHandle() const { return m_TransformHandle; }
+
+		//The hierarchy shared by all entities.
+		static TransformHierarchy& RetrieveTransformHierarchy();
+
+		//Prefabs. An instance draws every node of its prefab below its own transform. Setting a prefab reverts all overrides.
+		void SetPrefab(const Prefab* prefab);
+		const Prefab* RetrievePrefab() const { return m_Prefab; }
+		//Returns a copy of the node's material owned by this instance, made on the first call. Edits to it only affect this instance.
+		Material* OverridePrefabMaterial(uint32_t nodeIndex);
+		//Replaces the node's transform relative to its parent node for this instance.
+		void OverridePrefabTransform(uint32_t nodeIndex, const glm::mat4& localTransform);
+		void RevertPrefabOverrides();
+		const std::vector<PrefabOverride>& RetrievePrefabOverrides() const { return m_PrefabOverrides; }
+		//The node's overridden material if there is one, or the prefab's otherwise.
+		Material* RetrievePrefabMaterial(uint32_t nodeIndex) const;
+		bool HasPrefabTransformOverrides() const { return m_PrefabTransformOverrideCount != 0; }
+		//Bounds of the instance relative to its own transform, with overrides applied.
+		BoundingBox CalculatePrefabBounds() const;
+
+		//Bounds relative to the entity's transform, or an invalid box for entities with nothing to render.
+		BoundingBox CalculateLocalBounds() const;
+		BoundingBox CalculateWorldBounds();
 
 		operator uint32_t() const
 		{
@@ -49,20 +93,42 @@ namespace Crescent
 	public:
 		Mesh* m_Mesh = nullptr;
 		Material* m_Material = nullptr;
-		std::vector<SceneEntity*> m_ChildEntities;
+		unsigned int m_StaticFrameCount = 0; //Consecutive rendered frames without a transform change. Maintained by the renderer.
+		bool m_StaticShadowCaster = false; //Whether the entity was last drawn into the cached static shadow layers. Maintained by the renderer.
+
+	protected:
+		//Pooled entities receive their handle as ID. Types deriving from SceneEntity live outside of the pool, pass InvalidPoolHandle and can't be parented.
+		SceneEntity(const std::string& entityName, const unsigned int& entityID);
+		virtual ~SceneEntity();
+
+	private:
+		friend class ChunkedPool<SceneEntity>;
+
+		bool IsPooled() const;
+		void UnlinkChild(SceneEntity* childEntity);
+		PrefabOverride& RetrievePrefabOverride(uint32_t nodeIndex);
 
 	private:
 		//Scene Information
 		std::string m_EntityName = "Entity";
-		SceneEntity* m_ParentEntity;
 
-		glm::mat4 m_EntityTransform = glm::mat4(1.0f);
-		glm::vec3 m_EntityPosition = glm::vec3(0.0f);
-		glm::vec3 m_EntityScale = glm::vec3(1.0f);
-		glm::vec3 m_EntityRotation = glm::vec3(0.0f);
+		//Pool slot indices of related entities, InvalidPoolIndex when absent.
+		uint32_t m_ParentIndex = InvalidPoolIndex;
+		uint32_t m_FirstChildIndex = InvalidPoolIndex;
+		uint32_t m_LastChildIndex = InvalidPoolIndex;
+		uint32_t m_PreviousSiblingIndex = InvalidPoolIndex;
+		uint32_t m_NextSiblingIndex = InvalidPoolIndex;
+		unsigned int m_ChildCount = 0;
+
+		//Our transform lives in the shared transform hierarchy, alongside every other entity's.
+		TransformHandle m_TransformHandle = InvalidTransformHandle;
+
+		//Prefab Instancing
+		const Prefab* m_Prefab = nullptr;
+		std::vector<PrefabOverride> m_PrefabOverrides; //Empty, and so unallocated, until a node is edited.
+		unsigned int m_PrefabTransformOverrideCount = 0;
 
-		//Each entity is uniquely identified by a 32-bit incrementing unsigned integer.
-		bool m_IsTransformDirty = true;
+		//Each entity is uniquely identified by its 32-bit pool handle. A destroyed entity's handle never resolves to another entity (up to 4096 reuses of its slot).
 		unsigned int m_EntityID;
 	};
 }
\ No newline at end of file
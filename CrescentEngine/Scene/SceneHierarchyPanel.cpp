@@ -9,6 +9,7 @@
 #include "../Shading/Material.h"
 #include "../Rendering/Resources.h"
 #include "../Models/Mesh.h"
+#include "../Utilities/Camera.h"
 #include <GLFW/glfw3.h>
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h> //Allows us to retrieve the Window handle.
@@ -71,6 +72,19 @@ namespace Crescent
 		}
 	}
 
+	void SceneHierarchyPanel::PickEntity(const Camera& viewportCamera, const glm::vec2& viewportPosition, const glm::vec2& viewportSize)
+	{
+		//Unproject the point onto the near and far planes. With the ray spanning exactly that segment, a maximum distance of 1 stops it at the far plane.
+		glm::vec2 deviceCoordinates = glm::vec2(viewportPosition.x / viewportSize.x * 2.0f - 1.0f, 1.0f - viewportPosition.y / viewportSize.y * 2.0f);
+		glm::mat4 inverseViewProjection = glm::inverse(viewportCamera.m_ProjectionMatrix * viewportCamera.m_ViewMatrix);
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(deviceCoordinates, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(deviceCoordinates, 1.0f, 1.0f);
+		glm::vec3 rayOrigin = glm::vec3(nearPoint) / nearPoint.w;
+		glm::vec3 rayDirection = glm::vec3(farPoint) / farPoint.w - rayOrigin;
+
+		m_CurrentlySelectedEntity = m_SceneContext->RayCast(rayOrigin, rayDirection, 1.0f);
+	}
+
 	static MeshAnimation* currentSelectedAnimation = nullptr;
 
 	void SceneHierarchyPanel::DrawSelectedEntityAnimationSettings(SceneEntity* selectedEntity)
@@ -152,12 +166,13 @@ namespace Crescent
 
 	void SceneHierarchyPanel::DrawSelectedEntityMaterialTextureComponent(SceneEntity* selectedEntity, const std::string& nodeName, const std::string& uniformTextureName, int uniformTextureUnit)
 	{
-		if (selectedEntity->m_Material->m_SamplerUniforms[uniformTextureName].m_Texture != nullptr)
+		Texture* materialTexture = selectedEntity->m_Material->RetrieveShaderTexture(uniformTextureName);
+		if (materialTexture != nullptr)
 		{
 			if (ImGui::CollapsingHeader(nodeName.c_str()))
 			{
 				ImGui::Spacing();
-				ImGui::Image((void*)selectedEntity->m_Material->m_SamplerUniforms[uniformTextureName].m_Texture->RetrieveTextureID(), { 100.0f, 100.0f }, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
+				ImGui::Image((void*)materialTexture->RetrieveTextureID(), { 100.0f, 100.0f }, ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
 				ImGui::SameLine();
 				if (ImGui::Button("Load New Texture"))
 				{
@@ -191,9 +206,8 @@ namespace Crescent
 
 		if (isExpanded)
 		{
-			for (int i = 0; i < sceneEntity->m_ChildEntities.size(); i++)
+			for (SceneEntity* childEntity = sceneEntity->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
 			{
-				SceneEntity* childEntity = sceneEntity->m_ChildEntities[i];
 				if (childEntity->m_Material != nullptr)
 				{
 					DrawEntityUI(childEntity);
@@ -222,6 +236,16 @@ namespace Crescent
 		selectedEntity->SetEntityRotation(glm::radians(rotation));
 
 		DrawVector3Controls("Scale", selectedEntity->RetrieveEntityScale(), selectedEntity);
+
+		if (const Prefab* prefab = selectedEntity->RetrievePrefab())
+		{
+			ImGui::Spacing();
+			ImGui::Text("Prefab: %s (%u Nodes, %u Overridden)", prefab->RetrievePrefabName().c_str(), (unsigned int)prefab->RetrieveNodes().size(), (unsigned int)selectedEntity->RetrievePrefabOverrides().size());
+			if (!selectedEntity->RetrievePrefabOverrides().empty() && ImGui::Button("Revert Overrides"))
+			{
+				selectedEntity->RevertPrefabOverrides();
+			}
+		}
 	}
 
 	void SceneHierarchyPanel::DrawVector3Controls(const std::string& uiLabel, glm::vec3& values, SceneEntity* selectedEntity, float resetValue, float columnWidth)
@@ -249,7 +273,7 @@ namespace Crescent
 		if (ImGui::Button("X", buttonSize))
 		{
 			values.x = resetValue;
-			selectedEntity->UpdateEntityTransform(true);
+			selectedEntity->MarkTransformDirty();
 		}
 
 		ImGui::PopFont();
@@ -258,7 +282,7 @@ namespace Crescent
 		ImGui::SameLine();
 		if (ImGui::DragFloat("##X", &values.x, 0.1f, 0.0f, 0.0f, "%.2f"))
 		{
-			selectedEntity->UpdateEntityTransform(true);
+			selectedEntity->MarkTransformDirty();
 		}
 		ImGui::PopItemWidth();
 		ImGui::SameLine();
@@ -271,7 +295,7 @@ namespace Crescent
 		if (ImGui::Button("Y", buttonSize))
 		{
 			values.y = resetValue;
-			selectedEntity->UpdateEntityTransform(true);
+			selectedEntity->MarkTransformDirty();
 		}
 
 		ImGui::PopFont();
@@ -280,7 +304,7 @@ namespace Crescent
 		ImGui::SameLine();
 		if (ImGui::DragFloat("##Y", &values.y, 0.1f, 0.0f, 0.0f, "%.2f"))
 		{
-			selectedEntity->UpdateEntityTransform(true);
+			selectedEntity->MarkTransformDirty();
 		}
 		ImGui::PopItemWidth();
 		ImGui::SameLine();
@@ -293,7 +317,7 @@ namespace Crescent
 		if (ImGui::Button("Z", buttonSize))
 		{
 			values.z = resetValue;
-			selectedEntity->UpdateEntityTransform(true);
+			selectedEntity->MarkTransformDirty();
 		}
 
 		ImGui::PopFont();
@@ -302,7 +326,7 @@ namespace Crescent
 		ImGui::SameLine();
 		if (ImGui::DragFloat("##Z", &values.z, 0.1f, 0.0f, 0.0f, "%.2f"))
 		{
-			selectedEntity->UpdateEntityTransform(true);
+			selectedEntity->MarkTransformDirty();
 		}
 		ImGui::PopItemWidth();
 
@@ -12,6 +12,7 @@ namespace Crescent
 	class Window;
 	class Scene;
 	class SceneEntity;
+	class Camera;
 
 	class SceneHierarchyPanel
 	{
@@ -21,6 +22,9 @@ namespace Crescent
 		//Renders all invidual entities of the scene with UI.
 		void RenderSceneEditorUI();
 
+		//Selects the entity under a point of the viewport, given in pixels from its top left corner. Picking empty space clears the selection.
+		void PickEntity(const Camera& viewportCamera, const glm::vec2& viewportPosition, const glm::vec2& viewportSize);
+
 	private:
 		void DrawEntityUI(SceneEntity* sceneEntity);
 		void DrawSelectedEntityComponents(SceneEntity* selectedEntity);
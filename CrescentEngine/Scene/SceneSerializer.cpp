@@ -0,0 +1,708 @@
+#include "CrescentPCH.h"
+#include "SceneSerializer.h"
+#include "Scene.h"
+#include "SceneEntity.h"
+#include "Prefab.h"
+#include "Entities/Skybox.h"
+#include "../Lighting/DirectionalLight.h"
+#include "../Lighting/PointLight.h"
+#include "../Memory/MappedFile.h"
+#include "../Rendering/Resources.h"
+#include "../Rendering/Renderer.h"
+#include "../Models/Mesh.h"
+#include "../Models/MeshBuilder.h"
+#include "../Memory/MeshLoader.h"
+#include "../Shading/Material.h"
+#include "../Shading/Texture.h"
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <cstring>
+#include <utility>
+
+namespace Crescent
+{
+	namespace
+	{
+		const size_t SectionAlignment = 16;
+
+		//Appends a table of records to the file buffer, aligned so records can be read in place once mapped.
+		template<typename T>
+		SceneFileSection WriteSection(std::vector<uint8_t>& fileBuffer, const std::vector<T>& records)
+		{
+			fileBuffer.resize((fileBuffer.size() + SectionAlignment - 1) & ~(SectionAlignment - 1), 0);
+
+			SceneFileSection fileSection;
+			fileSection.m_Offset = fileBuffer.size();
+			fileSection.m_Count = (uint32_t)records.size();
+			fileSection.m_Stride = sizeof(T);
+			if (!records.empty())
+			{
+				fileBuffer.resize(fileBuffer.size() + records.size() * sizeof(T));
+				memcpy(fileBuffer.data() + fileSection.m_Offset, records.data(), records.size() * sizeof(T));
+			}
+			return fileSection;
+		}
+
+		//Resolves a table's offset into a pointer within the mapped file. Returns nullptr if the table doesn't fit the file or its records don't match ours.
+		template<typename T>
+		const T* ResolveSection(const MappedFile& mappedFile, const SceneFileSection& fileSection)
+		{
+			if (fileSection.m_Stride != sizeof(T) || fileSection.m_Offset % alignof(T) != 0 || fileSection.m_Offset > mappedFile.RetrieveSize() ||
+				(mappedFile.RetrieveSize() - fileSection.m_Offset) / sizeof(T) < fileSection.m_Count)
+			{
+				return nullptr;
+			}
+			return (const T*)(mappedFile.RetrieveData() + fileSection.m_Offset);
+		}
+
+		SceneFileString WriteString(std::vector<char>& stringTable, const std::string& string)
+		{
+			SceneFileString fileString;
+			fileString.m_Offset = (uint32_t)stringTable.size();
+			fileString.m_Length = (uint32_t)string.size();
+			stringTable.insert(stringTable.end(), string.begin(), string.end());
+			return fileString;
+		}
+
+		std::string ReadString(const char* stringTable, uint32_t stringTableSize, const SceneFileString& fileString)
+		{
+			if (fileString.m_Offset > stringTableSize || stringTableSize - fileString.m_Offset < fileString.m_Length)
+			{
+				return std::string();
+			}
+			return std::string(stringTable + fileString.m_Offset, fileString.m_Length);
+		}
+
+		//Appends an array to the mesh data table, aligned as the tables are. Empty arrays aren't written.
+		template<typename T>
+		uint64_t WriteMeshData(std::vector<uint8_t>& meshData, const std::vector<T>& values)
+		{
+			if (values.empty())
+			{
+				return InvalidSceneFileOffset;
+			}
+
+			meshData.resize((meshData.size() + SectionAlignment - 1) & ~(SectionAlignment - 1), 0);
+			uint64_t dataOffset = meshData.size();
+			meshData.resize(meshData.size() + values.size() * sizeof(T));
+			memcpy(meshData.data() + dataOffset, values.data(), values.size() * sizeof(T));
+			return dataOffset;
+		}
+
+		//Prefab contents gathered while saving. Meshes and materials are written once, however many nodes share them.
+		struct PrefabTables
+		{
+			std::vector<SceneFilePrefabNode> m_Nodes;
+			std::vector<SceneFileMesh> m_Meshes;
+			std::vector<SceneFileMeshLOD> m_MeshLODs;
+			std::vector<SceneFileMeshlet> m_Meshlets;
+			std::vector<SceneFileMaterial> m_Materials;
+			std::vector<SceneFileMaterialTexture> m_MaterialTextures;
+			std::vector<uint8_t> m_MeshData;
+			std::map<const Mesh*, uint32_t> m_MeshIndices;
+			std::map<const Material*, uint32_t> m_MaterialIndices;
+		};
+
+		//Skinned and animated meshes point into the importer's scene, which we can't store.
+		bool IsPrefabStorable(const Prefab* prefab)
+		{
+			for (const PrefabNode& prefabNode : prefab->RetrieveNodes())
+			{
+				if (prefabNode.m_Mesh && (!prefabNode.m_Mesh->m_BoneIDs.empty() || !prefabNode.m_Mesh->m_Animations.empty()))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		uint32_t WriteMesh(PrefabTables& prefabTables, const Mesh* mesh)
+		{
+			auto iterator = prefabTables.m_MeshIndices.find(mesh);
+			if (iterator != prefabTables.m_MeshIndices.end())
+			{
+				return iterator->second;
+			}
+
+			SceneFileMesh fileMesh;
+			fileMesh.m_VertexCount = (uint32_t)mesh->m_Positions.size();
+			fileMesh.m_IndexCount = (uint32_t)mesh->m_Indices.size();
+			fileMesh.m_Topology = mesh->m_Topology;
+			fileMesh.m_VertexFormat = mesh->RetrieveVertexFormat();
+			fileMesh.m_PositionsOffset = WriteMeshData(prefabTables.m_MeshData, mesh->m_Positions);
+			fileMesh.m_UVOffset = WriteMeshData(prefabTables.m_MeshData, mesh->m_UV);
+			fileMesh.m_NormalsOffset = WriteMeshData(prefabTables.m_MeshData, mesh->m_Normals);
+			if (!mesh->m_Tangents.empty() && mesh->m_Bitangents.size() == mesh->m_Tangents.size())
+			{
+				fileMesh.m_TangentsOffset = WriteMeshData(prefabTables.m_MeshData, mesh->m_Tangents);
+				fileMesh.m_BitangentsOffset = WriteMeshData(prefabTables.m_MeshData, mesh->m_Bitangents);
+			}
+			fileMesh.m_IndicesOffset = WriteMeshData(prefabTables.m_MeshData, mesh->m_Indices);
+
+			fileMesh.m_FirstLOD = (uint32_t)prefabTables.m_MeshLODs.size();
+			fileMesh.m_LODCount = (uint32_t)mesh->m_LODs.size();
+			for (const MeshLOD& meshLOD : mesh->m_LODs)
+			{
+				SceneFileMeshLOD fileLOD;
+				fileLOD.m_IndicesOffset = WriteMeshData(prefabTables.m_MeshData, meshLOD.m_Indices);
+				fileLOD.m_IndexCount = (uint32_t)meshLOD.m_Indices.size();
+				fileLOD.m_GeometricError = meshLOD.m_GeometricError;
+				prefabTables.m_MeshLODs.push_back(fileLOD);
+			}
+
+			fileMesh.m_FirstMeshlet = (uint32_t)prefabTables.m_Meshlets.size();
+			fileMesh.m_MeshletCount = (uint32_t)mesh->m_Meshlets.size();
+			for (const Meshlet& meshlet : mesh->m_Meshlets)
+			{
+				SceneFileMeshlet fileMeshlet;
+				fileMeshlet.m_IndexOffset = meshlet.m_IndexOffset;
+				fileMeshlet.m_TriangleCount = meshlet.m_TriangleCount;
+				fileMeshlet.m_VertexCount = meshlet.m_VertexCount;
+				fileMeshlet.m_SphereCenter = meshlet.m_BoundingSphere.m_Center;
+				fileMeshlet.m_SphereRadius = meshlet.m_BoundingSphere.m_Radius;
+				fileMeshlet.m_ConeAxis = meshlet.m_ConeAxis;
+				fileMeshlet.m_ConeCutoff = meshlet.m_ConeCutoff;
+				prefabTables.m_Meshlets.push_back(fileMeshlet);
+			}
+
+			uint32_t meshIndex = (uint32_t)prefabTables.m_Meshes.size();
+			prefabTables.m_Meshes.push_back(fileMesh);
+			prefabTables.m_MeshIndices[mesh] = meshIndex;
+			return meshIndex;
+		}
+
+		uint32_t WriteMaterial(PrefabTables& prefabTables, std::vector<char>& stringTable, const Material* material)
+		{
+			auto iterator = prefabTables.m_MaterialIndices.find(material);
+			if (iterator != prefabTables.m_MaterialIndices.end())
+			{
+				return iterator->second;
+			}
+
+			SceneFileMaterial fileMaterial;
+			fileMaterial.m_FirstTexture = (uint32_t)prefabTables.m_MaterialTextures.size();
+			for (const MaterialSampler& materialSampler : material->RetrieveSamplers())
+			{
+				const UniformSamplerValue& samplerValue = materialSampler.m_SamplerValue;
+				if (samplerValue.m_UniformType == Shader_Type_SamplerCube || !samplerValue.m_Texture || samplerValue.m_Texture->m_TexturePath.empty())
+				{
+					CrescentInfo("Material texture " + materialSampler.m_UniformName + " wasn't loaded from an image file, which scene files don't store. It is saved without it.");
+					continue;
+				}
+
+				SceneFileMaterialTexture fileTexture;
+				fileTexture.m_UniformName = WriteString(stringTable, materialSampler.m_UniformName);
+				fileTexture.m_TexturePath = WriteString(stringTable, samplerValue.m_Texture->m_TexturePath);
+				fileTexture.m_TextureUnit = samplerValue.m_TextureUnit;
+				fileTexture.m_TextureTarget = samplerValue.m_Texture->m_TextureTarget;
+				fileTexture.m_TextureFormat = samplerValue.m_Texture->m_TextureInternalFormat;
+				prefabTables.m_MaterialTextures.push_back(fileTexture);
+			}
+			fileMaterial.m_TextureCount = (uint32_t)prefabTables.m_MaterialTextures.size() - fileMaterial.m_FirstTexture;
+
+			uint32_t materialIndex = (uint32_t)prefabTables.m_Materials.size();
+			prefabTables.m_Materials.push_back(fileMaterial);
+			prefabTables.m_MaterialIndices[material] = materialIndex;
+			return materialIndex;
+		}
+
+		void WritePrefab(PrefabTables& prefabTables, std::vector<char>& stringTable, const Prefab* prefab, SceneFileAsset& fileAsset)
+		{
+			if (!IsPrefabStorable(prefab))
+			{
+				CrescentInfo("Prefab " + prefab->RetrievePrefabName() + " has skinned or animated meshes, which scene files don't store. It is imported from " + prefab->RetrieveSourcePath() + " on load.");
+				return;
+			}
+
+			fileAsset.m_FirstNode = (uint32_t)prefabTables.m_Nodes.size();
+			fileAsset.m_NodeCount = (uint32_t)prefab->RetrieveNodes().size();
+			for (const PrefabNode& prefabNode : prefab->RetrieveNodes())
+			{
+				SceneFilePrefabNode fileNode;
+				fileNode.m_NodeName = WriteString(stringTable, prefabNode.m_NodeName);
+				fileNode.m_ParentIndex = prefabNode.m_ParentIndex;
+				fileNode.m_MeshIndex = prefabNode.m_Mesh ? WriteMesh(prefabTables, prefabNode.m_Mesh) : InvalidSceneFileIndex;
+				fileNode.m_MaterialIndex = prefabNode.m_Material ? WriteMaterial(prefabTables, stringTable, prefabNode.m_Material) : InvalidSceneFileIndex;
+				fileNode.m_LocalTransform = prefabNode.m_LocalTransform;
+				prefabTables.m_Nodes.push_back(fileNode);
+			}
+		}
+
+		//Every table of a mapped scene file, resolved and checked against the file's size.
+		struct SceneFileTables
+		{
+			const SceneFileHeader* m_Header = nullptr;
+			const SceneFilePrefabNode* m_PrefabNodes = nullptr;
+			const SceneFileMesh* m_Meshes = nullptr;
+			const SceneFileMeshLOD* m_MeshLODs = nullptr;
+			const SceneFileMeshlet* m_Meshlets = nullptr;
+			const SceneFileMaterial* m_Materials = nullptr;
+			const SceneFileMaterialTexture* m_MaterialTextures = nullptr;
+			const char* m_Strings = nullptr;
+			const uint8_t* m_MeshData = nullptr;
+		};
+
+		//Resolves an array of the mesh data table. Returns nullptr if it is missing or doesn't fit the table.
+		template<typename T>
+		const T* ResolveMeshData(const SceneFileTables& fileTables, uint64_t dataOffset, uint64_t valueCount)
+		{
+			uint64_t meshDataSize = fileTables.m_Header->m_MeshData.m_Count;
+			if (dataOffset == InvalidSceneFileOffset || dataOffset > meshDataSize || (meshDataSize - dataOffset) / sizeof(T) < valueCount ||
+				(fileTables.m_Header->m_MeshData.m_Offset + dataOffset) % alignof(T) != 0)
+			{
+				return nullptr;
+			}
+			return (const T*)(fileTables.m_MeshData + dataOffset);
+		}
+
+		bool IndicesValid(const unsigned int* indices, size_t indexCount, uint32_t vertexCount)
+		{
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				if (indices[i] >= vertexCount)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Copies a stored mesh into a new one and uploads it, just as the importer left it. Returns nullptr if the mesh's data is damaged.
+		Mesh* ReadMesh(const SceneFileTables& fileTables, const SceneFileMesh& fileMesh)
+		{
+			const SceneFileHeader* fileHeader = fileTables.m_Header;
+			bool hasUV = fileMesh.m_UVOffset != InvalidSceneFileOffset;
+			bool hasNormals = fileMesh.m_NormalsOffset != InvalidSceneFileOffset;
+			bool hasTangents = fileMesh.m_TangentsOffset != InvalidSceneFileOffset;
+			const glm::vec3* positions = ResolveMeshData<glm::vec3>(fileTables, fileMesh.m_PositionsOffset, fileMesh.m_VertexCount);
+			const glm::vec2* uv = ResolveMeshData<glm::vec2>(fileTables, fileMesh.m_UVOffset, fileMesh.m_VertexCount);
+			const glm::vec3* normals = ResolveMeshData<glm::vec3>(fileTables, fileMesh.m_NormalsOffset, fileMesh.m_VertexCount);
+			const glm::vec3* tangents = ResolveMeshData<glm::vec3>(fileTables, fileMesh.m_TangentsOffset, fileMesh.m_VertexCount);
+			const glm::vec3* bitangents = ResolveMeshData<glm::vec3>(fileTables, fileMesh.m_BitangentsOffset, fileMesh.m_VertexCount);
+			const unsigned int* indices = ResolveMeshData<unsigned int>(fileTables, fileMesh.m_IndicesOffset, fileMesh.m_IndexCount);
+			if (!positions || (hasUV && !uv) || (hasNormals && !normals) || (hasTangents && (!tangents || !bitangents)) || (fileMesh.m_IndexCount > 0 && !indices) ||
+				(fileMesh.m_IndexCount > 0 && !IndicesValid(indices, fileMesh.m_IndexCount, fileMesh.m_VertexCount)) || fileMesh.m_Topology > TriangleStrips ||
+				fileMesh.m_VertexFormat > VertexFormat_Quantized || fileMesh.m_FirstLOD > fileHeader->m_MeshLODs.m_Count || fileHeader->m_MeshLODs.m_Count - fileMesh.m_FirstLOD < fileMesh.m_LODCount ||
+				fileMesh.m_FirstMeshlet > fileHeader->m_Meshlets.m_Count || fileHeader->m_Meshlets.m_Count - fileMesh.m_FirstMeshlet < fileMesh.m_MeshletCount)
+			{
+				return nullptr;
+			}
+
+			std::vector<MeshLOD> meshLODs(fileMesh.m_LODCount);
+			for (uint32_t i = 0; i < fileMesh.m_LODCount; i++)
+			{
+				const SceneFileMeshLOD& fileLOD = fileTables.m_MeshLODs[fileMesh.m_FirstLOD + i];
+				const unsigned int* lodIndices = ResolveMeshData<unsigned int>(fileTables, fileLOD.m_IndicesOffset, fileLOD.m_IndexCount);
+				if (fileLOD.m_IndexCount > 0 && (!lodIndices || !IndicesValid(lodIndices, fileLOD.m_IndexCount, fileMesh.m_VertexCount)))
+				{
+					return nullptr;
+				}
+				if (fileLOD.m_IndexCount > 0)
+				{
+					meshLODs[i].m_Indices.assign(lodIndices, lodIndices + fileLOD.m_IndexCount);
+				}
+				meshLODs[i].m_GeometricError = fileLOD.m_GeometricError;
+			}
+
+			std::vector<Meshlet> meshlets(fileMesh.m_MeshletCount);
+			for (uint32_t i = 0; i < fileMesh.m_MeshletCount; i++)
+			{
+				const SceneFileMeshlet& fileMeshlet = fileTables.m_Meshlets[fileMesh.m_FirstMeshlet + i];
+				if (fileMeshlet.m_IndexOffset > fileMesh.m_IndexCount || (fileMesh.m_IndexCount - fileMeshlet.m_IndexOffset) / 3 < fileMeshlet.m_TriangleCount)
+				{
+					return nullptr;
+				}
+				meshlets[i].m_IndexOffset = (size_t)fileMeshlet.m_IndexOffset;
+				meshlets[i].m_TriangleCount = fileMeshlet.m_TriangleCount;
+				meshlets[i].m_VertexCount = fileMeshlet.m_VertexCount;
+				meshlets[i].m_BoundingSphere.m_Center = fileMeshlet.m_SphereCenter;
+				meshlets[i].m_BoundingSphere.m_Radius = fileMeshlet.m_SphereRadius;
+				meshlets[i].m_ConeAxis = fileMeshlet.m_ConeAxis;
+				meshlets[i].m_ConeCutoff = fileMeshlet.m_ConeCutoff;
+			}
+
+			MeshBuilder meshBuilder(fileMesh.m_VertexCount, fileMesh.m_IndexCount, hasUV, hasNormals, hasTangents);
+			memcpy(meshBuilder.RetrievePositions(), positions, fileMesh.m_VertexCount * sizeof(glm::vec3));
+			if (hasUV)
+			{
+				memcpy(meshBuilder.RetrieveUV(), uv, fileMesh.m_VertexCount * sizeof(glm::vec2));
+			}
+			if (hasNormals)
+			{
+				memcpy(meshBuilder.RetrieveNormals(), normals, fileMesh.m_VertexCount * sizeof(glm::vec3));
+			}
+			if (hasTangents)
+			{
+				memcpy(meshBuilder.RetrieveTangents(), tangents, fileMesh.m_VertexCount * sizeof(glm::vec3));
+				memcpy(meshBuilder.RetrieveBitangents(), bitangents, fileMesh.m_VertexCount * sizeof(glm::vec3));
+			}
+			if (fileMesh.m_IndexCount > 0)
+			{
+				memcpy(meshBuilder.RetrieveIndices(), indices, fileMesh.m_IndexCount * sizeof(unsigned int));
+			}
+
+			//Already optimized when first imported, so the mesh goes straight to the GPU. Meshes are interleaved, as the importer uploads them.
+			Mesh* mesh = meshBuilder.BuildMesh();
+			mesh->m_Topology = (Topology)fileMesh.m_Topology;
+			mesh->m_LODs = std::move(meshLODs);
+			mesh->m_Meshlets = std::move(meshlets);
+			mesh->FinalizeMesh(true, (VertexFormat)fileMesh.m_VertexFormat);
+			MeshLoader::StoreMesh(mesh);
+			return mesh;
+		}
+
+		//Recreates the importer's material: the renderer's default one with the stored textures in place of its own.
+		Material* ReadMaterial(const SceneFileTables& fileTables, const SceneFileMaterial& fileMaterial, Renderer* rendererContext)
+		{
+			const SceneFileHeader* fileHeader = fileTables.m_Header;
+			if (fileMaterial.m_FirstTexture > fileHeader->m_MaterialTextures.m_Count || fileHeader->m_MaterialTextures.m_Count - fileMaterial.m_FirstTexture < fileMaterial.m_TextureCount)
+			{
+				return nullptr;
+			}
+
+			Material* material = rendererContext->CreateMaterial();
+			for (uint32_t i = 0; i < fileMaterial.m_TextureCount; i++)
+			{
+				const SceneFileMaterialTexture& fileTexture = fileTables.m_MaterialTextures[fileMaterial.m_FirstTexture + i];
+				std::string uniformName = ReadString(fileTables.m_Strings, fileHeader->m_Strings.m_Count, fileTexture.m_UniformName);
+				std::string texturePath = ReadString(fileTables.m_Strings, fileHeader->m_Strings.m_Count, fileTexture.m_TexturePath);
+
+				//The default material's own textures are already bound under their own names, and must not be loaded a second time by path.
+				Texture* currentTexture = material->RetrieveShaderTexture(uniformName);
+				if (uniformName.empty() || texturePath.empty() || (currentTexture && currentTexture->m_TexturePath == texturePath))
+				{
+					continue;
+				}
+
+				//Named by their path, as the importer names them, so that textures shared with imported models are loaded once.
+				bool sRGB = fileTexture.m_TextureFormat == GL_SRGB || fileTexture.m_TextureFormat == GL_SRGB_ALPHA;
+				if (Texture* texture = Resources::LoadTexture(texturePath, texturePath, fileTexture.m_TextureTarget, fileTexture.m_TextureFormat, sRGB))
+				{
+					material->SetShaderTexture(uniformName, texture, fileTexture.m_TextureUnit);
+				}
+			}
+			return material;
+		}
+
+		//Builds a prefab from its stored nodes. Meshes and materials are cached by index, as several prefabs of the file may share them. Returns nullptr
+		//if the prefab's nodes are damaged.
+		Prefab* ReadPrefab(const SceneFileTables& fileTables, const SceneFileAsset& fileAsset, const std::string& prefabName, const std::string& sourcePath, Renderer* rendererContext,
+			std::vector<Mesh*>& loadedMeshes, std::vector<Material*>& loadedMaterials)
+		{
+			const SceneFileHeader* fileHeader = fileTables.m_Header;
+			if (fileAsset.m_FirstNode > fileHeader->m_PrefabNodes.m_Count || fileHeader->m_PrefabNodes.m_Count - fileAsset.m_FirstNode < fileAsset.m_NodeCount)
+			{
+				return nullptr;
+			}
+
+			//Checked up front, so that nothing is uploaded for a prefab we end up rejecting.
+			for (uint32_t i = 0; i < fileAsset.m_NodeCount; i++)
+			{
+				const SceneFilePrefabNode& fileNode = fileTables.m_PrefabNodes[fileAsset.m_FirstNode + i];
+				if ((fileNode.m_ParentIndex != InvalidSceneFileIndex && fileNode.m_ParentIndex >= i) ||
+					(fileNode.m_MeshIndex != InvalidSceneFileIndex && fileNode.m_MeshIndex >= fileHeader->m_Meshes.m_Count) ||
+					(fileNode.m_MaterialIndex != InvalidSceneFileIndex && fileNode.m_MaterialIndex >= fileHeader->m_Materials.m_Count))
+				{
+					return nullptr;
+				}
+			}
+
+			std::vector<PrefabNode> prefabNodes(fileAsset.m_NodeCount);
+			for (uint32_t i = 0; i < fileAsset.m_NodeCount; i++)
+			{
+				const SceneFilePrefabNode& fileNode = fileTables.m_PrefabNodes[fileAsset.m_FirstNode + i];
+				PrefabNode& prefabNode = prefabNodes[i];
+				prefabNode.m_NodeName = ReadString(fileTables.m_Strings, fileHeader->m_Strings.m_Count, fileNode.m_NodeName);
+				prefabNode.m_ParentIndex = fileNode.m_ParentIndex;
+				prefabNode.m_LocalTransform = fileNode.m_LocalTransform;
+
+				if (fileNode.m_MeshIndex != InvalidSceneFileIndex)
+				{
+					if (!loadedMeshes[fileNode.m_MeshIndex])
+					{
+						loadedMeshes[fileNode.m_MeshIndex] = ReadMesh(fileTables, fileTables.m_Meshes[fileNode.m_MeshIndex]);
+					}
+					prefabNode.m_Mesh = loadedMeshes[fileNode.m_MeshIndex];
+					if (!prefabNode.m_Mesh)
+					{
+						CrescentInfo("Mesh of prefab node " + prefabNode.m_NodeName + " is corrupted. The node is loaded without it.");
+					}
+				}
+
+				if (fileNode.m_MaterialIndex != InvalidSceneFileIndex)
+				{
+					if (!loadedMaterials[fileNode.m_MaterialIndex])
+					{
+						loadedMaterials[fileNode.m_MaterialIndex] = ReadMaterial(fileTables, fileTables.m_Materials[fileNode.m_MaterialIndex], rendererContext);
+					}
+					prefabNode.m_Material = loadedMaterials[fileNode.m_MaterialIndex];
+				}
+			}
+
+			return new Prefab(prefabName, sourcePath, std::move(prefabNodes));
+		}
+	}
+
+	bool SceneSerializer::SaveScene(const std::string& filePath, Scene* scene, const std::vector<DirectionalLight*>& directionalLights, const std::vector<PointLight*>& pointLights)
+	{
+		std::vector<SceneFileAsset> fileAssets;
+		std::vector<SceneFileEntity> fileEntities;
+		std::vector<SceneFileTransformOverride> fileTransformOverrides;
+		std::vector<SceneFileDirectionalLight> fileDirectionalLights;
+		std::vector<SceneFilePointLight> filePointLights;
+		std::vector<char> stringTable;
+		std::map<const Prefab*, uint32_t> assetIndices;
+		PrefabTables prefabTables;
+
+		//Walked depth first with children in order, so each entity's parent is written before it.
+		std::vector<SceneEntity*> sceneEntities = scene->RetrieveSceneEntities();
+		std::vector<std::pair<SceneEntity*, uint32_t>> nodeStack;
+		for (size_t i = sceneEntities.size(); i-- > 0;)
+		{
+			if (!dynamic_cast<Skybox*>(sceneEntities[i]))
+			{
+				nodeStack.push_back(std::make_pair(sceneEntities[i], InvalidSceneFileIndex));
+			}
+		}
+
+		while (!nodeStack.empty())
+		{
+			SceneEntity* sceneEntity = nodeStack.back().first;
+			uint32_t parentIndex = nodeStack.back().second;
+			nodeStack.pop_back();
+
+			uint32_t entityIndex = (uint32_t)fileEntities.size();
+			SceneFileEntity fileEntity;
+			fileEntity.m_EntityName = WriteString(stringTable, sceneEntity->RetrieveEntityName());
+			fileEntity.m_ParentIndex = parentIndex;
+			fileEntity.m_Position = sceneEntity->RetrieveEntityPosition();
+			fileEntity.m_Rotation = sceneEntity->RetrieveEntityRotation();
+			fileEntity.m_Scale = sceneEntity->RetrieveEntityScale();
+
+			if (const Prefab* prefab = sceneEntity->RetrievePrefab())
+			{
+				auto iterator = assetIndices.find(prefab);
+				if (iterator == assetIndices.end())
+				{
+					SceneFileAsset fileAsset;
+					fileAsset.m_AssetName = WriteString(stringTable, prefab->RetrievePrefabName());
+					fileAsset.m_SourcePath = WriteString(stringTable, prefab->RetrieveSourcePath());
+					WritePrefab(prefabTables, stringTable, prefab, fileAsset);
+					iterator = assetIndices.insert(std::make_pair(prefab, (uint32_t)fileAssets.size())).first;
+					fileAssets.push_back(fileAsset);
+				}
+				fileEntity.m_AssetIndex = iterator->second;
+
+				const std::vector<PrefabOverride>& prefabOverrides = sceneEntity->RetrievePrefabOverrides();
+				bool materialOverridden = false;
+				for (unsigned int i = 0; i < prefabOverrides.size(); i++)
+				{
+					materialOverridden |= prefabOverrides[i].m_Material != nullptr;
+					if (prefabOverrides[i].m_TransformOverridden)
+					{
+						SceneFileTransformOverride fileOverride;
+						fileOverride.m_EntityIndex = entityIndex;
+						fileOverride.m_NodeIndex = prefabOverrides[i].m_NodeIndex;
+						fileOverride.m_LocalTransform = prefabOverrides[i].m_LocalTransform;
+						fileTransformOverrides.push_back(fileOverride);
+					}
+				}
+
+				if (materialOverridden)
+				{
+					CrescentInfo("Entity " + sceneEntity->RetrieveEntityName() + " overrides its prefab's materials, which scene files don't store. It is saved with the prefab's materials.");
+				}
+			}
+			else if (sceneEntity->m_Mesh || sceneEntity->m_Material)
+			{
+				CrescentInfo("Entity " + sceneEntity->RetrieveEntityName() + " draws a mesh outside of any prefab, which scene files don't store. It is saved as an empty transform.");
+			}
+			fileEntities.push_back(fileEntity);
+
+			size_t firstChild = nodeStack.size();
+			for (SceneEntity* childEntity = sceneEntity->RetrieveFirstChild(); childEntity; childEntity = childEntity->RetrieveNextSibling())
+			{
+				nodeStack.push_back(std::make_pair(childEntity, entityIndex));
+			}
+			std::reverse(nodeStack.begin() + firstChild, nodeStack.end());
+		}
+
+		for (unsigned int i = 0; i < directionalLights.size(); i++)
+		{
+			SceneFileDirectionalLight fileLight;
+			fileLight.m_LightDirection = directionalLights[i]->m_LightDirection;
+			fileLight.m_LightColor = directionalLights[i]->m_LightColor;
+			fileLight.m_LightIntensity = directionalLights[i]->m_LightIntensity;
+			fileLight.m_ShadowCastingEnabled = directionalLights[i]->m_ShadowCastingEnabled;
+			fileDirectionalLights.push_back(fileLight);
+		}
+
+		for (unsigned int i = 0; i < pointLights.size(); i++)
+		{
+			SceneFilePointLight fileLight;
+			fileLight.m_LightPosition = pointLights[i]->m_LightPosition;
+			fileLight.m_LightColor = pointLights[i]->m_LightColor;
+			fileLight.m_LightIntensity = pointLights[i]->m_LightIntensity;
+			fileLight.m_LightRadius = pointLights[i]->m_LightRadius;
+			fileLight.m_RenderMesh = pointLights[i]->m_RenderMesh;
+			filePointLights.push_back(fileLight);
+		}
+
+		//The header is filled in last, once every table's offset is known.
+		std::vector<uint8_t> fileBuffer(sizeof(SceneFileHeader), 0);
+		SceneFileHeader fileHeader;
+		fileHeader.m_Assets = WriteSection(fileBuffer, fileAssets);
+		fileHeader.m_Entities = WriteSection(fileBuffer, fileEntities);
+		fileHeader.m_TransformOverrides = WriteSection(fileBuffer, fileTransformOverrides);
+		fileHeader.m_DirectionalLights = WriteSection(fileBuffer, fileDirectionalLights);
+		fileHeader.m_PointLights = WriteSection(fileBuffer, filePointLights);
+		fileHeader.m_PrefabNodes = WriteSection(fileBuffer, prefabTables.m_Nodes);
+		fileHeader.m_Meshes = WriteSection(fileBuffer, prefabTables.m_Meshes);
+		fileHeader.m_MeshLODs = WriteSection(fileBuffer, prefabTables.m_MeshLODs);
+		fileHeader.m_Meshlets = WriteSection(fileBuffer, prefabTables.m_Meshlets);
+		fileHeader.m_Materials = WriteSection(fileBuffer, prefabTables.m_Materials);
+		fileHeader.m_MaterialTextures = WriteSection(fileBuffer, prefabTables.m_MaterialTextures);
+		fileHeader.m_Strings = WriteSection(fileBuffer, stringTable);
+		fileHeader.m_MeshData = WriteSection(fileBuffer, prefabTables.m_MeshData);
+		fileHeader.m_FileSize = fileBuffer.size();
+		memcpy(fileBuffer.data(), &fileHeader, sizeof(SceneFileHeader));
+
+		std::ofstream fileStream(filePath, std::ios::binary | std::ios::trunc);
+		fileStream.write((const char*)fileBuffer.data(), fileBuffer.size());
+		if (!fileStream)
+		{
+			CrescentInfo("Failed to write scene file: " + filePath + ".");
+			return false;
+		}
+		return true;
+	}
+
+	bool SceneSerializer::LoadScene(const std::string& filePath, Renderer* rendererContext, Scene* scene, std::vector<DirectionalLight>& directionalLights, std::vector<PointLight>& pointLights)
+	{
+		MappedFile mappedFile;
+		if (!mappedFile.OpenFile(filePath) || mappedFile.RetrieveSize() < sizeof(SceneFileHeader))
+		{
+			return false;
+		}
+
+		const SceneFileHeader* fileHeader = (const SceneFileHeader*)mappedFile.RetrieveData();
+		if (fileHeader->m_Magic != SceneFileMagic || fileHeader->m_Version != SceneFileVersion || fileHeader->m_FileSize != mappedFile.RetrieveSize())
+		{
+			CrescentInfo("Scene file " + filePath + " is invalid or of an older version.");
+			return false;
+		}
+
+		const SceneFileAsset* fileAssets = ResolveSection<SceneFileAsset>(mappedFile, fileHeader->m_Assets);
+		const SceneFileEntity* fileEntities = ResolveSection<SceneFileEntity>(mappedFile, fileHeader->m_Entities);
+		const SceneFileTransformOverride* fileTransformOverrides = ResolveSection<SceneFileTransformOverride>(mappedFile, fileHeader->m_TransformOverrides);
+		const SceneFileDirectionalLight* fileDirectionalLights = ResolveSection<SceneFileDirectionalLight>(mappedFile, fileHeader->m_DirectionalLights);
+		const SceneFilePointLight* filePointLights = ResolveSection<SceneFilePointLight>(mappedFile, fileHeader->m_PointLights);
+		const char* stringTable = ResolveSection<char>(mappedFile, fileHeader->m_Strings);
+		SceneFileTables fileTables;
+		fileTables.m_Header = fileHeader;
+		fileTables.m_PrefabNodes = ResolveSection<SceneFilePrefabNode>(mappedFile, fileHeader->m_PrefabNodes);
+		fileTables.m_Meshes = ResolveSection<SceneFileMesh>(mappedFile, fileHeader->m_Meshes);
+		fileTables.m_MeshLODs = ResolveSection<SceneFileMeshLOD>(mappedFile, fileHeader->m_MeshLODs);
+		fileTables.m_Meshlets = ResolveSection<SceneFileMeshlet>(mappedFile, fileHeader->m_Meshlets);
+		fileTables.m_Materials = ResolveSection<SceneFileMaterial>(mappedFile, fileHeader->m_Materials);
+		fileTables.m_MaterialTextures = ResolveSection<SceneFileMaterialTexture>(mappedFile, fileHeader->m_MaterialTextures);
+		fileTables.m_Strings = stringTable;
+		fileTables.m_MeshData = ResolveSection<uint8_t>(mappedFile, fileHeader->m_MeshData);
+		if (!fileAssets || !fileEntities || !fileTransformOverrides || !fileDirectionalLights || !filePointLights || !stringTable || !fileTables.m_PrefabNodes || !fileTables.m_Meshes ||
+			!fileTables.m_MeshLODs || !fileTables.m_Meshlets || !fileTables.m_Materials || !fileTables.m_MaterialTextures || !fileTables.m_MeshData)
+		{
+			CrescentInfo("Scene file " + filePath + " is corrupted.");
+			return false;
+		}
+		uint32_t stringTableSize = fileHeader->m_Strings.m_Count;
+
+		//Prefabs already loaded are shared. The others are built from their stored nodes when we have them, and imported from their source otherwise.
+		std::vector<Prefab*> prefabs(fileHeader->m_Assets.m_Count, nullptr);
+		std::vector<Mesh*> loadedMeshes(fileHeader->m_Meshes.m_Count, nullptr);
+		std::vector<Material*> loadedMaterials(fileHeader->m_Materials.m_Count, nullptr);
+		for (uint32_t i = 0; i < fileHeader->m_Assets.m_Count; i++)
+		{
+			std::string prefabName = ReadString(stringTable, stringTableSize, fileAssets[i].m_AssetName);
+			std::string sourcePath = ReadString(stringTable, stringTableSize, fileAssets[i].m_SourcePath);
+			prefabs[i] = Resources::RetrievePrefab(prefabName);
+			if (!prefabs[i] && fileAssets[i].m_NodeCount > 0 && rendererContext)
+			{
+				if (Prefab* prefab = ReadPrefab(fileTables, fileAssets[i], prefabName, sourcePath, rendererContext, loadedMeshes, loadedMaterials))
+				{
+					prefabs[i] = Resources::AddPrefab(prefab);
+				}
+				else
+				{
+					CrescentInfo("Prefab " + prefabName + " is corrupted in scene file " + filePath + ". It is imported from " + sourcePath + " instead.");
+				}
+			}
+			if (!prefabs[i])
+			{
+				prefabs[i] = Resources::LoadPrefab(rendererContext, prefabName, sourcePath);
+			}
+		}
+
+		std::vector<SceneEntity*> sceneEntities(fileHeader->m_Entities.m_Count, nullptr);
+		for (uint32_t i = 0; i < fileHeader->m_Entities.m_Count; i++)
+		{
+			const SceneFileEntity& fileEntity = fileEntities[i];
+
+			//Only earlier entities can be parents, which also rules out cycles in a damaged file.
+			SceneEntity* sceneEntity;
+			if (fileEntity.m_ParentIndex < i)
+			{
+				sceneEntity = SceneEntity::CreateEntity(ReadString(stringTable, stringTableSize, fileEntity.m_EntityName));
+				sceneEntities[fileEntity.m_ParentIndex]->AddChildEntity(sceneEntity);
+			}
+			else
+			{
+				sceneEntity = scene->ConstructNewEntity();
+				sceneEntity->SetEntityName(ReadString(stringTable, stringTableSize, fileEntity.m_EntityName));
+			}
+
+			sceneEntity->SetEntityPosition(fileEntity.m_Position);
+			sceneEntity->SetEntityRotation(fileEntity.m_Rotation);
+			sceneEntity->SetEntityScale(fileEntity.m_Scale);
+			if (fileEntity.m_AssetIndex < prefabs.size() && prefabs[fileEntity.m_AssetIndex])
+			{
+				sceneEntity->SetPrefab(prefabs[fileEntity.m_AssetIndex]);
+			}
+			sceneEntities[i] = sceneEntity;
+		}
+
+		for (uint32_t i = 0; i < fileHeader->m_TransformOverrides.m_Count; i++)
+		{
+			const SceneFileTransformOverride& fileOverride = fileTransformOverrides[i];
+			SceneEntity* sceneEntity = fileOverride.m_EntityIndex < sceneEntities.size() ? sceneEntities[fileOverride.m_EntityIndex] : nullptr;
+			if (sceneEntity && sceneEntity->RetrievePrefab() && fileOverride.m_NodeIndex < sceneEntity->RetrievePrefab()->RetrieveNodes().size())
+			{
+				sceneEntity->OverridePrefabTransform(fileOverride.m_NodeIndex, fileOverride.m_LocalTransform);
+			}
+		}
+
+		for (uint32_t i = 0; i < fileHeader->m_DirectionalLights.m_Count; i++)
+		{
+			DirectionalLight directionalLight;
+			directionalLight.m_LightDirection = fileDirectionalLights[i].m_LightDirection;
+			directionalLight.m_LightColor = fileDirectionalLights[i].m_LightColor;
+			directionalLight.m_LightIntensity = fileDirectionalLights[i].m_LightIntensity;
+			directionalLight.m_ShadowCastingEnabled = fileDirectionalLights[i].m_ShadowCastingEnabled != 0;
+			directionalLights.push_back(directionalLight);
+		}
+
+		for (uint32_t i = 0; i < fileHeader->m_PointLights.m_Count; i++)
+		{
+			PointLight pointLight;
+			pointLight.m_LightPosition = filePointLights[i].m_LightPosition;
+			pointLight.m_LightColor = filePointLights[i].m_LightColor;
+			pointLight.m_LightIntensity = filePointLights[i].m_LightIntensity;
+			pointLight.m_LightRadius = filePointLights[i].m_LightRadius;
+			pointLight.m_RenderMesh = filePointLights[i].m_RenderMesh != 0;
+			pointLights.push_back(pointLight);
+		}
+
+		CrescentLoad("Succesfully loaded scene: " + filePath + ".");
+		return true;
+	}
+}
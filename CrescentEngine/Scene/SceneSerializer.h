@@ -0,0 +1,186 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Crescent
+{
+	class Scene;
+	class Renderer;
+	class DirectionalLight;
+	class PointLight;
+
+	/*
+		Scene files are a header followed by flat tables of fixed size records, each aligned to 16 bytes and addressed by its offset from the start of the
+		file. Loading maps the file and resolves each table's offset to a pointer into the mapping, so records are read where they lie rather than parsed.
+		Strings are stored once in a trailing table and referenced by offset and length.
+
+		Entities are stored depth first, with every entity's parent preceding it. Their meshes and materials are referenced through the prefab assets
+		they instance. Entities drawing a mesh directly, and material overrides, are not stored. Saving logs each entity losing either.
+
+		Prefabs are stored whole: their nodes, and the meshes and materials those draw. Meshes are saved as their importer left them, optimized and
+		with their LODs and meshlets, and raw vertex and index arrays are kept in a trailing data table. Loading copies them straight into new meshes,
+		so no model file is read or processed. Materials are stored as the textures the importer assigns to the renderer's default material, and
+		reloaded by path, so image files are still decoded. Prefabs with skinned or animated meshes, which refer to the importer's own data, are
+		stored by source path only and imported again through Assimp on load.
+
+		Records are written in the machine's own byte order. Any change to a record's layout must bump SceneFileVersion.
+	*/
+
+	const uint32_t SceneFileMagic = 0x4E435343; //"CSCN"
+	const uint32_t SceneFileVersion = 2;
+	const uint32_t InvalidSceneFileIndex = 0xFFFFFFFF;
+	const uint64_t InvalidSceneFileOffset = 0xFFFFFFFFFFFFFFFF;
+
+	struct SceneFileSection
+	{
+		uint64_t m_Offset = 0;
+		uint32_t m_Count = 0;
+		uint32_t m_Stride = 0; //Size of a record, checked against ours when loading.
+	};
+
+	struct SceneFileHeader
+	{
+		uint32_t m_Magic = SceneFileMagic;
+		uint32_t m_Version = SceneFileVersion;
+		uint64_t m_FileSize = 0;
+		SceneFileSection m_Assets;
+		SceneFileSection m_Entities;
+		SceneFileSection m_TransformOverrides;
+		SceneFileSection m_DirectionalLights;
+		SceneFileSection m_PointLights;
+		SceneFileSection m_PrefabNodes;
+		SceneFileSection m_Meshes;
+		SceneFileSection m_MeshLODs;
+		SceneFileSection m_Meshlets;
+		SceneFileSection m_Materials;
+		SceneFileSection m_MaterialTextures;
+		SceneFileSection m_Strings; //Stride of 1, the count is in bytes.
+		SceneFileSection m_MeshData; //Stride of 1, the count is in bytes.
+	};
+
+	struct SceneFileString
+	{
+		uint32_t m_Offset = 0; //Relative to the string table.
+		uint32_t m_Length = 0;
+	};
+
+	struct SceneFileAsset
+	{
+		SceneFileString m_AssetName;
+		SceneFileString m_SourcePath;
+		uint32_t m_FirstNode = 0;
+		uint32_t m_NodeCount = 0; //0 if the prefab is imported from its source path instead.
+	};
+
+	struct SceneFilePrefabNode
+	{
+		SceneFileString m_NodeName;
+		uint32_t m_ParentIndex = InvalidSceneFileIndex; //Within the nodes of the same asset.
+		uint32_t m_MeshIndex = InvalidSceneFileIndex;
+		uint32_t m_MaterialIndex = InvalidSceneFileIndex;
+		glm::mat4 m_LocalTransform;
+	};
+
+	//Attribute arrays are addressed by their offset into the mesh data table, or InvalidSceneFileOffset if the mesh has none.
+	struct SceneFileMesh
+	{
+		uint64_t m_PositionsOffset = InvalidSceneFileOffset;
+		uint64_t m_UVOffset = InvalidSceneFileOffset;
+		uint64_t m_NormalsOffset = InvalidSceneFileOffset;
+		uint64_t m_TangentsOffset = InvalidSceneFileOffset; //Present along with the bitangents or not at all.
+		uint64_t m_BitangentsOffset = InvalidSceneFileOffset;
+		uint64_t m_IndicesOffset = InvalidSceneFileOffset;
+		uint32_t m_VertexCount = 0;
+		uint32_t m_IndexCount = 0;
+		uint32_t m_Topology = 0;
+		uint32_t m_VertexFormat = 0;
+		uint32_t m_FirstLOD = 0;
+		uint32_t m_LODCount = 0;
+		uint32_t m_FirstMeshlet = 0;
+		uint32_t m_MeshletCount = 0;
+	};
+
+	struct SceneFileMeshLOD
+	{
+		uint64_t m_IndicesOffset = InvalidSceneFileOffset;
+		uint32_t m_IndexCount = 0;
+		float m_GeometricError = 0.0f;
+	};
+
+	struct SceneFileMeshlet
+	{
+		uint64_t m_IndexOffset;
+		uint32_t m_TriangleCount;
+		uint32_t m_VertexCount;
+		glm::vec3 m_SphereCenter;
+		float m_SphereRadius;
+		glm::vec3 m_ConeAxis;
+		float m_ConeCutoff;
+	};
+
+	struct SceneFileMaterial
+	{
+		uint32_t m_FirstTexture = 0;
+		uint32_t m_TextureCount = 0;
+	};
+
+	struct SceneFileMaterialTexture
+	{
+		SceneFileString m_UniformName;
+		SceneFileString m_TexturePath;
+		uint32_t m_TextureUnit;
+		uint32_t m_TextureTarget;
+		uint32_t m_TextureFormat; //As requested when loading, sRGB formats included.
+	};
+
+	struct SceneFileEntity
+	{
+		SceneFileString m_EntityName;
+		uint32_t m_ParentIndex = InvalidSceneFileIndex;
+		uint32_t m_AssetIndex = InvalidSceneFileIndex;
+		glm::vec3 m_Position;
+		glm::vec3 m_Rotation;
+		glm::vec3 m_Scale;
+	};
+
+	struct SceneFileTransformOverride
+	{
+		uint32_t m_EntityIndex;
+		uint32_t m_NodeIndex;
+		glm::mat4 m_LocalTransform;
+	};
+
+	struct SceneFileDirectionalLight
+	{
+		glm::vec3 m_LightDirection;
+		glm::vec3 m_LightColor;
+		float m_LightIntensity;
+		uint32_t m_ShadowCastingEnabled;
+	};
+
+	struct SceneFilePointLight
+	{
+		glm::vec3 m_LightPosition;
+		glm::vec3 m_LightColor;
+		float m_LightIntensity;
+		float m_LightRadius;
+		uint32_t m_RenderMesh;
+	};
+
+	class SceneSerializer
+	{
+	public:
+		//Writes every entity of the scene except skyboxes, along with the given lights.
+		static bool SaveScene(const std::string& filePath, Scene* scene, const std::vector<DirectionalLight*>& directionalLights, const std::vector<PointLight*>& pointLights);
+
+		//Appends the file's entities to the scene, loading the prefabs they refer to, and its lights to the given lists. Returns false if the file is
+		//missing, or isn't a valid scene file of the current version.
+		static bool LoadScene(const std::string& filePath, Renderer* rendererContext, Scene* scene, std::vector<DirectionalLight>& directionalLights, std::vector<PointLight>& pointLights);
+
+	private:
+		//Disallow creation of any SceneSerializer object. This is a static object.
+		SceneSerializer();
+	};
+}
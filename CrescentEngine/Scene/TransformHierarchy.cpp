@@ -0,0 +1,349 @@
+#include "CrescentPCH.h"
+#include "TransformHierarchy.h"
+#include <glm/gtc/quaternion.hpp>
+#include <xmmintrin.h>
+#include <algorithm>
+
+namespace Crescent
+{
+	static const uint32_t InvalidNodeIndex = 0xFFFFFFFF;
+
+	//Translation * Rotation * Scale, written out directly rather than through three full matrix products.
+	static void ComposeLocalTransform(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale, glm::mat4& localTransform)
+	{
+		glm::mat3 rotationMatrix = glm::mat3_cast(glm::quat(rotation));
+		localTransform[0] = glm::vec4(rotationMatrix[0] * scale.x, 0.0f);
+		localTransform[1] = glm::vec4(rotationMatrix[1] * scale.y, 0.0f);
+		localTransform[2] = glm::vec4(rotationMatrix[2] * scale.z, 0.0f);
+		localTransform[3] = glm::vec4(position, 1.0f);
+	}
+
+	//Each column of the product is a linear combination of the parent's columns, weighted by the matching local column's components.
+	static void MultiplyTransforms(const glm::mat4& parentTransform, const glm::mat4& localTransform, glm::mat4& worldTransform)
+	{
+		__m128 parentColumn0 = _mm_loadu_ps(&parentTransform[0][0]);
+		__m128 parentColumn1 = _mm_loadu_ps(&parentTransform[1][0]);
+		__m128 parentColumn2 = _mm_loadu_ps(&parentTransform[2][0]);
+		__m128 parentColumn3 = _mm_loadu_ps(&parentTransform[3][0]);
+
+		for (int i = 0; i < 4; i++)
+		{
+			__m128 column = _mm_mul_ps(parentColumn0, _mm_set1_ps(localTransform[i][0]));
+			column = _mm_add_ps(column, _mm_mul_ps(parentColumn1, _mm_set1_ps(localTransform[i][1])));
+			column = _mm_add_ps(column, _mm_mul_ps(parentColumn2, _mm_set1_ps(localTransform[i][2])));
+			column = _mm_add_ps(column, _mm_mul_ps(parentColumn3, _mm_set1_ps(localTransform[i][3])));
+			_mm_storeu_ps(&worldTransform[i][0], column);
+		}
+	}
+
+	//Reorders a node array so that entry i holds what was previously at nodeOrder[i].
+	template<typename T>
+	static void PermuteNodes(std::vector<T>& nodeValues, const std::vector<uint32_t>& nodeOrder)
+	{
+		std::vector<T> permutedValues(nodeOrder.size());
+		for (size_t i = 0; i < nodeOrder.size(); i++)
+		{
+			permutedValues[i] = nodeValues[nodeOrder[i]];
+		}
+		nodeValues.swap(permutedValues);
+	}
+
+	TransformHandle TransformHierarchy::CreateTransform()
+	{
+		TransformHandle transformHandle;
+		if (!m_FreeHandles.empty())
+		{
+			transformHandle = m_FreeHandles.back();
+			m_FreeHandles.pop_back();
+		}
+		else
+		{
+			transformHandle = (TransformHandle)m_HandleIndices.size();
+			m_HandleIndices.push_back(InvalidNodeIndex);
+			m_ParentHandles.push_back(InvalidTransformHandle);
+		}
+
+		//New nodes are roots, which may sit anywhere in the order. Appending them keeps it valid.
+		uint32_t nodeIndex = AllocateNode();
+		m_NodeHandles[nodeIndex] = transformHandle;
+		m_HandleIndices[transformHandle] = nodeIndex;
+		m_ParentHandles[transformHandle] = InvalidTransformHandle;
+		m_TransformsDirty = true;
+		m_StructureVersion++;
+		return transformHandle;
+	}
+
+	void TransformHierarchy::ReleaseTransform(TransformHandle transformHandle)
+	{
+		//The node stays in the arrays, orphaned, until the order is rebuilt. Its handle is only recycled then, once its children have been detached.
+		m_NodeHandles[m_HandleIndices[transformHandle]] = InvalidTransformHandle;
+		m_HandleIndices[transformHandle] = InvalidNodeIndex;
+		m_ReleasedHandles.push_back(transformHandle);
+		m_OrderDirty = true;
+		m_StructureVersion++;
+	}
+
+	void TransformHierarchy::SetParent(TransformHandle transformHandle, TransformHandle parentHandle)
+	{
+		m_ParentHandles[transformHandle] = parentHandle;
+		m_OrderDirty = true;
+		m_StructureVersion++;
+		MarkTransformDirty(transformHandle);
+	}
+
+	void TransformHierarchy::MarkTransformDirty(TransformHandle transformHandle)
+	{
+		uint32_t nodeIndex = m_HandleIndices[transformHandle];
+		m_LocalDirty[nodeIndex] = 1;
+		m_TransformsDirty = true;
+
+		//Flag every ancestor as leading to a dirty node, stopping at the first one already flagged. Parent indices are stale while the order is, but
+		//the rebuild derives these flags from scratch anyway.
+		if (m_OrderDirty)
+		{
+			return;
+		}
+		for (int32_t parentIndex = m_ParentIndices[nodeIndex]; parentIndex >= 0 && !m_DescendantDirty[parentIndex]; parentIndex = m_ParentIndices[parentIndex])
+		{
+			m_DescendantDirty[parentIndex] = 1;
+		}
+	}
+
+	void TransformHierarchy::UpdateWorldTransforms()
+	{
+		if (m_OrderDirty)
+		{
+			RebuildOrder();
+		}
+		if (!m_TransformsDirty)
+		{
+			return;
+		}
+
+		//Parents always precede their children, so by the time we reach a node its parent's world matrix is final. As subtrees are contiguous, a node
+		//that is neither dirty nor leads to one lets us jump over its whole subtree. Once a node's world matrix changes, everything up to the end of its
+		//subtree has to follow.
+		const uint32_t nodeCount = (uint32_t)m_WorldTransforms.size();
+		uint32_t recomputeEnd = 0;
+		uint32_t nodeIndex = 0;
+		while (nodeIndex < nodeCount)
+		{
+			bool worldDirty = nodeIndex < recomputeEnd;
+			if (m_LocalDirty[nodeIndex])
+			{
+				ComposeLocalTransform(m_LocalPositions[nodeIndex], m_LocalRotations[nodeIndex], m_LocalScales[nodeIndex], m_LocalTransforms[nodeIndex]);
+				m_LocalDirty[nodeIndex] = 0;
+				recomputeEnd = std::max(recomputeEnd, nodeIndex + m_SubtreeSizes[nodeIndex]);
+				worldDirty = true;
+			}
+			else if (!worldDirty && !m_DescendantDirty[nodeIndex])
+			{
+				nodeIndex += m_SubtreeSizes[nodeIndex];
+				continue;
+			}
+			m_DescendantDirty[nodeIndex] = 0;
+
+			if (worldDirty)
+			{
+				int32_t parentIndex = m_ParentIndices[nodeIndex];
+				if (parentIndex >= 0)
+				{
+					MultiplyTransforms(m_WorldTransforms[parentIndex], m_LocalTransforms[nodeIndex], m_WorldTransforms[nodeIndex]);
+				}
+				else
+				{
+					m_WorldTransforms[nodeIndex] = m_LocalTransforms[nodeIndex];
+				}
+				m_WorldChanged[nodeIndex] = 1;
+				m_RecomputedTransformCount++;
+				if (!m_ChangeRecorded[nodeIndex])
+				{
+					m_ChangeRecorded[nodeIndex] = 1;
+					m_ChangedHandles.push_back(m_NodeHandles[nodeIndex]);
+				}
+			}
+			nodeIndex++;
+		}
+		m_TransformsDirty = false;
+	}
+
+	glm::mat4& TransformHierarchy::RetrieveWorldTransform(TransformHandle transformHandle)
+	{
+		if (m_OrderDirty || m_TransformsDirty)
+		{
+			UpdateWorldTransforms();
+		}
+		return m_WorldTransforms[m_HandleIndices[transformHandle]];
+	}
+
+	bool TransformHierarchy::ConsumeWorldTransformChange(TransformHandle transformHandle)
+	{
+		uint32_t nodeIndex = m_HandleIndices[transformHandle];
+		bool worldChanged = m_WorldChanged[nodeIndex] != 0;
+		m_WorldChanged[nodeIndex] = 0;
+		return worldChanged;
+	}
+
+	void TransformHierarchy::ConsumeChangedTransforms(std::vector<TransformHandle>& changedHandles)
+	{
+		changedHandles.swap(m_ChangedHandles);
+		m_ChangedHandles.clear();
+		for (size_t i = 0; i < changedHandles.size(); i++)
+		{
+			//Released nodes may still be listed.
+			uint32_t nodeIndex = m_HandleIndices[changedHandles[i]];
+			if (nodeIndex != InvalidNodeIndex)
+			{
+				m_ChangeRecorded[nodeIndex] = 0;
+			}
+		}
+	}
+
+	size_t TransformHierarchy::ConsumeRecomputedTransformCount()
+	{
+		size_t recomputedTransformCount = m_RecomputedTransformCount;
+		m_RecomputedTransformCount = 0;
+		return recomputedTransformCount;
+	}
+
+	uint32_t TransformHierarchy::AllocateNode()
+	{
+		m_LocalPositions.push_back(glm::vec3(0.0f));
+		m_LocalRotations.push_back(glm::vec3(0.0f));
+		m_LocalScales.push_back(glm::vec3(1.0f));
+		m_LocalTransforms.push_back(glm::mat4(1.0f));
+		m_WorldTransforms.push_back(glm::mat4(1.0f));
+		m_ParentIndices.push_back(-1);
+		m_LocalDirty.push_back(1);
+		m_DescendantDirty.push_back(0);
+		m_SubtreeSizes.push_back(1);
+		m_WorldChanged.push_back(0);
+		m_ChangeRecorded.push_back(0);
+		m_NodeHandles.push_back(InvalidTransformHandle);
+		return (uint32_t)m_WorldTransforms.size() - 1;
+	}
+
+	void TransformHierarchy::RebuildOrder()
+	{
+		const uint32_t nodeCount = (uint32_t)m_NodeHandles.size();
+
+		//1) Gather each node's children, compacted by a counting pass. Children of released nodes become roots.
+		m_ChildOffsets.assign(nodeCount + 1, 0);
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			TransformHandle transformHandle = m_NodeHandles[i];
+			if (transformHandle == InvalidTransformHandle)
+			{
+				continue;
+			}
+
+			TransformHandle& parentHandle = m_ParentHandles[transformHandle];
+			if (parentHandle != InvalidTransformHandle && m_HandleIndices[parentHandle] == InvalidNodeIndex)
+			{
+				parentHandle = InvalidTransformHandle;
+				m_LocalDirty[i] = 1;
+			}
+			if (parentHandle != InvalidTransformHandle)
+			{
+				m_ChildOffsets[m_HandleIndices[parentHandle] + 1]++;
+			}
+		}
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			m_ChildOffsets[i + 1] += m_ChildOffsets[i];
+		}
+
+		m_ChildNodes.resize(m_ChildOffsets[nodeCount]);
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			TransformHandle transformHandle = m_NodeHandles[i];
+			if (transformHandle != InvalidTransformHandle && m_ParentHandles[transformHandle] != InvalidTransformHandle)
+			{
+				m_ChildNodes[m_ChildOffsets[m_HandleIndices[m_ParentHandles[transformHandle]]]++] = i;
+			}
+		}
+		//Each offset now marks the end of its node's children, which is where the next node's begin.
+
+		//2) Walk every root depth first. Nodes caught in a parenting cycle are never reached from a root, so we break the cycle and walk them as roots too.
+		m_NodeOrder.clear();
+		std::vector<uint8_t> visitedNodes(nodeCount, 0);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (uint32_t i = 0; i < nodeCount; i++)
+			{
+				TransformHandle transformHandle = m_NodeHandles[i];
+				if (transformHandle == InvalidTransformHandle || visitedNodes[i] || (pass == 0 && m_ParentHandles[transformHandle] != InvalidTransformHandle))
+				{
+					continue;
+				}
+				if (pass == 1)
+				{
+					m_ParentHandles[transformHandle] = InvalidTransformHandle;
+					m_LocalDirty[i] = 1;
+				}
+
+				m_TraversalStack.push_back(i);
+				while (!m_TraversalStack.empty())
+				{
+					uint32_t nodeIndex = m_TraversalStack.back();
+					m_TraversalStack.pop_back();
+					visitedNodes[nodeIndex] = 1;
+					m_NodeOrder.push_back(nodeIndex);
+
+					//Pushed in reverse so that children come out in the order they were added.
+					uint32_t firstChild = nodeIndex == 0 ? 0 : m_ChildOffsets[nodeIndex - 1];
+					for (uint32_t j = m_ChildOffsets[nodeIndex]; j > firstChild; j--)
+					{
+						if (!visitedNodes[m_ChildNodes[j - 1]])
+						{
+							m_TraversalStack.push_back(m_ChildNodes[j - 1]);
+						}
+					}
+				}
+			}
+		}
+
+		//3) Move every array into the new order, dropping released nodes.
+		PermuteNodes(m_LocalPositions, m_NodeOrder);
+		PermuteNodes(m_LocalRotations, m_NodeOrder);
+		PermuteNodes(m_LocalScales, m_NodeOrder);
+		PermuteNodes(m_LocalTransforms, m_NodeOrder);
+		PermuteNodes(m_WorldTransforms, m_NodeOrder);
+		PermuteNodes(m_LocalDirty, m_NodeOrder);
+		PermuteNodes(m_WorldChanged, m_NodeOrder);
+		PermuteNodes(m_ChangeRecorded, m_NodeOrder);
+		PermuteNodes(m_NodeHandles, m_NodeOrder);
+
+		for (uint32_t i = 0; i < m_NodeHandles.size(); i++)
+		{
+			m_HandleIndices[m_NodeHandles[i]] = i;
+		}
+
+		m_ParentIndices.resize(m_NodeHandles.size());
+		for (uint32_t i = 0; i < m_NodeHandles.size(); i++)
+		{
+			TransformHandle parentHandle = m_ParentHandles[m_NodeHandles[i]];
+			m_ParentIndices[i] = parentHandle == InvalidTransformHandle ? -1 : (int32_t)m_HandleIndices[parentHandle];
+		}
+
+		//Children follow their parents, so walking backwards accumulates subtree sizes and dirty flags bottom up.
+		m_SubtreeSizes.assign(m_NodeHandles.size(), 1);
+		m_DescendantDirty.assign(m_NodeHandles.size(), 0);
+		for (uint32_t i = (uint32_t)m_NodeHandles.size(); i-- > 0;)
+		{
+			int32_t parentIndex = m_ParentIndices[i];
+			if (parentIndex >= 0)
+			{
+				m_SubtreeSizes[parentIndex] += m_SubtreeSizes[i];
+				m_DescendantDirty[parentIndex] |= m_LocalDirty[i] | m_DescendantDirty[i];
+			}
+		}
+
+		//4) Handles of released nodes are safe to hand out again, as nothing refers to them anymore.
+		m_FreeHandles.insert(m_FreeHandles.end(), m_ReleasedHandles.begin(), m_ReleasedHandles.end());
+		m_ReleasedHandles.clear();
+
+		m_OrderDirty = false;
+		m_TransformsDirty = true;
+	}
+}
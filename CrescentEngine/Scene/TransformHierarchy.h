@@ -0,0 +1,91 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace Crescent
+{
+	typedef uint32_t TransformHandle;
+	const TransformHandle InvalidTransformHandle = 0xFFFFFFFF;
+
+	/*
+		Stores every entity transform in flat structure of arrays, ordered depth first such that each node's parent precedes it. Resolving world matrices
+		is then a single linear pass where a node's parent is always already up to date, instead of a recursive walk over scattered entities. Each
+		multiply is vectorized within the node, a column per SSE register, rather than across nodes, as a node is mostly followed by its own children.
+
+		Entities hold a stable handle, which maps to the node's current position in the arrays. Structural changes (creating, releasing and reparenting)
+		only mark the order as stale. It is rebuilt in one go before the next update, so building a hierarchy of N nodes costs O(N) rather than O(N^2).
+		References handed out by this class are only valid until the next structural change.
+	*/
+
+	class TransformHierarchy
+	{
+	public:
+		TransformHandle CreateTransform();
+		void ReleaseTransform(TransformHandle transformHandle);
+		//Passing InvalidTransformHandle as the parent turns the node into a root.
+		void SetParent(TransformHandle transformHandle, TransformHandle parentHandle);
+
+		//Local values are editable in place. Call MarkTransformDirty once done.
+		glm::vec3& RetrieveLocalPosition(TransformHandle transformHandle) { return m_LocalPositions[m_HandleIndices[transformHandle]]; }
+		glm::vec3& RetrieveLocalRotation(TransformHandle transformHandle) { return m_LocalRotations[m_HandleIndices[transformHandle]]; }
+		glm::vec3& RetrieveLocalScale(TransformHandle transformHandle) { return m_LocalScales[m_HandleIndices[transformHandle]]; }
+		void MarkTransformDirty(TransformHandle transformHandle);
+
+		//Recomputes the world matrices of all dirty nodes and their descendants. Only subtrees containing a dirty node are visited.
+		void UpdateWorldTransforms();
+		//Brings the hierarchy up to date first, should anything be pending.
+		glm::mat4& RetrieveWorldTransform(TransformHandle transformHandle);
+
+		//Returns whether the node's world matrix was recomputed since the last call.
+		bool ConsumeWorldTransformChange(TransformHandle transformHandle);
+
+		size_t RetrieveTransformCount() const { return m_WorldTransforms.size(); }
+		//Handles are below this count.
+		size_t RetrieveHandleCount() const { return m_HandleIndices.size(); }
+		//Returns how many world matrices were recomputed since the last call.
+		size_t ConsumeRecomputedTransformCount();
+		//Swaps out the handles of all nodes whose world matrix was recomputed since the last call, each listed once. Independent of the per node
+		//change flags above, so both can be consumed by different systems.
+		void ConsumeChangedTransforms(std::vector<TransformHandle>& changedHandles);
+		//Incremented whenever nodes are created, released or reparented.
+		uint32_t RetrieveStructureVersion() const { return m_StructureVersion; }
+
+	private:
+		void RebuildOrder();
+		uint32_t AllocateNode(); //Appends a node to the arrays and returns its index.
+
+	private:
+		//Per node, in depth first order.
+		std::vector<glm::vec3> m_LocalPositions;
+		std::vector<glm::vec3> m_LocalRotations; //Euler angles in radians.
+		std::vector<glm::vec3> m_LocalScales;
+		std::vector<glm::mat4> m_LocalTransforms;
+		std::vector<glm::mat4> m_WorldTransforms;
+		std::vector<int32_t> m_ParentIndices; //-1 for roots.
+		std::vector<uint8_t> m_LocalDirty;
+		std::vector<uint8_t> m_DescendantDirty; //Set when any node below is locally dirty.
+		std::vector<uint32_t> m_SubtreeSizes; //Including the node itself, so a subtree spans [index, index + size).
+		std::vector<uint8_t> m_WorldChanged;
+		std::vector<uint8_t> m_ChangeRecorded; //Whether the node is already in m_ChangedHandles.
+		std::vector<TransformHandle> m_NodeHandles;
+
+		//Per handle.
+		std::vector<uint32_t> m_HandleIndices;
+		std::vector<TransformHandle> m_ParentHandles;
+		std::vector<TransformHandle> m_FreeHandles;
+		std::vector<TransformHandle> m_ReleasedHandles; //Not reusable until the next rebuild, as children may still refer to them.
+
+		bool m_OrderDirty = false;
+		bool m_TransformsDirty = false;
+		size_t m_RecomputedTransformCount = 0;
+		std::vector<TransformHandle> m_ChangedHandles;
+		uint32_t m_StructureVersion = 0;
+
+		//Scratch used when rebuilding the order.
+		std::vector<uint32_t> m_ChildOffsets;
+		std::vector<uint32_t> m_ChildNodes;
+		std::vector<uint32_t> m_NodeOrder;
+		std::vector<uint32_t> m_TraversalStack;
+	};
+}
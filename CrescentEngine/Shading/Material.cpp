@@ -33,61 +33,116 @@ namespace Crescent
 		copy.m_BlendDestination = m_BlendDestination;
 		copy.m_BlendEquation = m_BlendEquation;
 
-		copy.m_Uniforms = m_Uniforms;
-		copy.m_SamplerUniforms = m_SamplerUniforms;
+		copy.m_Parameters = m_Parameters;
+		copy.m_Samplers = m_Samplers;
 
 		return copy;
 	}
 
-	std::map<std::string, UniformValue>* Material::GetUniforms()
+	Texture* Material::RetrieveShaderTexture(const std::string& uniformName) const
 	{
-		return &m_Uniforms;
+		UniformID uniformID(uniformName);
+		for (const MaterialSampler& sampler : m_Samplers)
+		{
+			if (sampler.m_UniformID == uniformID && sampler.m_SamplerValue.m_UniformType != Shader_Type_SamplerCube)
+			{
+				return sampler.m_SamplerValue.m_Texture;
+			}
+		}
+		return nullptr;
+	}
+
+	void Material::ApplyParameters()
+	{
+		if (m_ParameterBlock.RequiresCompile(m_Shader))
+		{
+			m_ParameterBlock.Compile(m_Shader, m_Parameters, m_Samplers);
+		}
+		m_ParameterBlock.Apply(m_Parameters);
+	}
+
+	UniformValue& Material::RetrieveParameterValue(const std::string& uniformName)
+	{
+		//Materials rarely hold more than a handful of parameters, so a linear search over a contiguous array beats a map here.
+		UniformID uniformID(uniformName);
+		m_ParameterBlock.MarkValuesDirty();
+		for (MaterialParameter& parameter : m_Parameters)
+		{
+			if (parameter.m_UniformID == uniformID)
+			{
+				return parameter.m_UniformValue;
+			}
+		}
+
+		m_ParameterBlock.MarkLayoutDirty();
+		m_Parameters.push_back({ uniformName, uniformID, UniformValue() });
+		return m_Parameters.back().m_UniformValue;
 	}
 
-	std::map<std::string, UniformSamplerValue>* Material::GetSamplerUniforms()
+	UniformSamplerValue& Material::RetrieveSamplerValue(const std::string& uniformName)
 	{
-		return &m_SamplerUniforms;
+		UniformID uniformID(uniformName);
+		for (MaterialSampler& sampler : m_Samplers)
+		{
+			if (sampler.m_UniformID == uniformID)
+			{
+				return sampler.m_SamplerValue;
+			}
+		}
+
+		m_ParameterBlock.MarkLayoutDirty();
+		m_Samplers.push_back({ uniformName, uniformID, UniformSamplerValue() });
+		return m_Samplers.back().m_SamplerValue;
 	}
 
 	void Material::SetShaderBool(const std::string& uniformName, const bool& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Boolean;
-		m_Uniforms[uniformName].m_BoolValue = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Boolean;
+		uniformValue.m_BoolValue = value;
 	}
 
 	void Material::SetShaderInt(const std::string& uniformName, const int& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Integer;
-		m_Uniforms[uniformName].m_IntValue = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Integer;
+		uniformValue.m_IntValue = value;
 	}
 
 	void Material::SetShaderFloat(const std::string& uniformName, const float& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Float;
-		m_Uniforms[uniformName].m_FloatValue = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Float;
+		uniformValue.m_FloatValue = value;
 	}
 
 	void Material::SetShaderTexture(const std::string& uniformName, Texture* value, unsigned int textureUnit)
 	{
-		m_SamplerUniforms[uniformName].m_TextureUnit = textureUnit; 
-		m_SamplerUniforms[uniformName].m_Texture = value;
+		//Texture assignments are baked into the compiled texture table, so any change requires a recompile.
+		UniformSamplerValue& samplerValue = RetrieveSamplerValue(uniformName);
+		if (samplerValue.m_Texture != value || samplerValue.m_TextureUnit != textureUnit)
+		{
+			m_ParameterBlock.MarkLayoutDirty();
+		}
+		samplerValue.m_TextureUnit = textureUnit; 
+		samplerValue.m_Texture = value;
 		
 		switch (value->m_TextureTarget)
 		{
 			case GL_TEXTURE_1D:
-				m_SamplerUniforms[uniformName].m_UniformType = Shader_Type_Sampler1D;
+				samplerValue.m_UniformType = Shader_Type_Sampler1D;
 				break;
 
 			case GL_TEXTURE_2D:
-				m_SamplerUniforms[uniformName].m_UniformType = Shader_Type_Sampler2D;
+				samplerValue.m_UniformType = Shader_Type_Sampler2D;
 				break;
 
 			case GL_TEXTURE_3D:
-				m_SamplerUniforms[uniformName].m_UniformType = Shader_Type_Sampler3D;
+				samplerValue.m_UniformType = Shader_Type_Sampler3D;
 				break;
 
 			case GL_TEXTURE_CUBE_MAP:
-				m_SamplerUniforms[uniformName].m_UniformType = Shader_Type_SamplerCube;
+				samplerValue.m_UniformType = Shader_Type_SamplerCube;
 				break;
 		}
 
@@ -100,9 +155,14 @@ namespace Crescent
 
 	void Material::SetShaderTextureCube(const std::string& uniformName, TextureCube* value, unsigned int textureUnit)
 	{
-		m_SamplerUniforms[uniformName].m_TextureUnit = textureUnit;
-		m_SamplerUniforms[uniformName].m_UniformType = Shader_Type_SamplerCube;
-		m_SamplerUniforms[uniformName].m_TextureCube = value;
+		UniformSamplerValue& samplerValue = RetrieveSamplerValue(uniformName);
+		if (samplerValue.m_TextureCube != value || samplerValue.m_TextureUnit != textureUnit)
+		{
+			m_ParameterBlock.MarkLayoutDirty();
+		}
+		samplerValue.m_TextureUnit = textureUnit;
+		samplerValue.m_UniformType = Shader_Type_SamplerCube;
+		samplerValue.m_TextureCube = value;
 
 		if (m_Shader)
 		{
@@ -113,37 +173,43 @@ namespace Crescent
 
 	void Material::SetShaderVector2(const std::string& uniformName, const glm::vec2& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Vector2;
-		m_Uniforms[uniformName].m_Vector2Value = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Vector2;
+		uniformValue.m_Vector2Value = value;
 	}
 
 	void Material::SetShaderVector3(const std::string& uniformName, const glm::vec3& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Vector3;
-		m_Uniforms[uniformName].m_Vector3Value = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Vector3;
+		uniformValue.m_Vector3Value = value;
 	}
 
 	void Material::SetShaderVector3(const std::string& uniformName, const glm::vec4& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Vector4;
-		m_Uniforms[uniformName].m_Vector4Value = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Vector4;
+		uniformValue.m_Vector4Value = value;
 	}
 
 	void Material::SetShaderMat2(const std::string& uniformName, const glm::mat2& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Matrix2;
-		m_Uniforms[uniformName].m_Mat2Value = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Matrix2;
+		uniformValue.m_Mat2Value = value;
 	}
 
 	void Material::SetShaderMat3(const std::string& uniformName, const glm::mat3& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Matrix3;
-		m_Uniforms[uniformName].m_Mat3Value = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Matrix3;
+		uniformValue.m_Mat3Value = value;
 	}
 
 	void Material::SetShaderMat4(const std::string& uniformName, const glm::mat4& value)
 	{
-		m_Uniforms[uniformName].m_UniformType = Shader_Type_Matrix4;
-		m_Uniforms[uniformName].m_Mat4Value = value;
+		UniformValue& uniformValue = RetrieveParameterValue(uniformName);
+		uniformValue.m_UniformType = Shader_Type_Matrix4;
+		uniformValue.m_Mat4Value = value;
 	}
 }
\ No newline at end of file
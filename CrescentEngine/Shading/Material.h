@@ -4,7 +4,8 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include "../Shading/ShaderUtilities.h"
-#include <map>
+#include "MaterialParameterBlock.h"
+#include <vector>
 
 namespace Crescent
 {
@@ -36,8 +37,12 @@ namespace Crescent
 		Material CopyMaterial();
 
 		//Uniforms
-		std::map<std::string, UniformValue>* GetUniforms();
-		std::map<std::string, UniformSamplerValue>* GetSamplerUniforms();
+		const std::vector<MaterialParameter>& RetrieveParameters() const { return m_Parameters; }
+		const std::vector<MaterialSampler>& RetrieveSamplers() const { return m_Samplers; }
+		Texture* RetrieveShaderTexture(const std::string& uniformName) const; //Nullptr if no texture is assigned to the sampler.
+
+		//Binds the material's textures and parameters to its shader, compiling its parameter block first if its layout has changed.
+		void ApplyParameters();
 
 		void SetShaderBool(const std::string& uniformName, const bool& value);
 		void SetShaderInt(const std::string& uniformName, const int& value);
@@ -75,10 +80,14 @@ namespace Crescent
 		bool m_ShadowCasting = true;
 		bool m_ShadowReceiving = true;
 
-		std::map<std::string, UniformSamplerValue> m_SamplerUniforms;
+	private:
+		UniformValue& RetrieveParameterValue(const std::string& uniformName);
+		UniformSamplerValue& RetrieveSamplerValue(const std::string& uniformName);
 
 	private:
 		Shader* m_Shader;
-		std::map<std::string, UniformValue> m_Uniforms;
+		std::vector<MaterialParameter> m_Parameters;
+		std::vector<MaterialSampler> m_Samplers;
+		MaterialParameterBlock m_ParameterBlock;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "CrescentPCH.h"
+#include "MaterialParameterBlock.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "TextureCube.h"
+#include "../Rendering/UniformBlocks.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Crescent
+{
+	//The GL type a parameter of the given type fills. Samplers never live in uniform blocks.
+	static GLenum RetrieveBlockMemberType(Shader_Type uniformType)
+	{
+		switch (uniformType)
+		{
+		case Shader_Type_Boolean:
+			return GL_BOOL;
+		case Shader_Type_Integer:
+			return GL_INT;
+		case Shader_Type_Float:
+			return GL_FLOAT;
+		case Shader_Type_Vector2:
+			return GL_FLOAT_VEC2;
+		case Shader_Type_Vector3:
+			return GL_FLOAT_VEC3;
+		case Shader_Type_Vector4:
+			return GL_FLOAT_VEC4;
+		case Shader_Type_Matrix2:
+			return GL_FLOAT_MAT2;
+		case Shader_Type_Matrix3:
+			return GL_FLOAT_MAT3;
+		case Shader_Type_Matrix4:
+			return GL_FLOAT_MAT4;
+		default:
+			return GL_NONE;
+		}
+	}
+
+	MaterialParameterBlock::MaterialParameterBlock(const MaterialParameterBlock&)
+	{
+		//GPU resources and compiled state are never shared. The copy compiles itself against its own parameters when first applied.
+	}
+
+	MaterialParameterBlock& MaterialParameterBlock::operator=(const MaterialParameterBlock& other)
+	{
+		if (this != &other)
+		{
+			ReleaseUniformBuffer();
+			m_CompiledShader = nullptr;
+			m_LayoutDirty = true;
+			m_BlockDirty = true;
+		}
+		return *this;
+	}
+
+	MaterialParameterBlock::~MaterialParameterBlock()
+	{
+		ReleaseUniformBuffer();
+	}
+
+	void MaterialParameterBlock::Compile(Shader* shader, const std::vector<MaterialParameter>& parameters, const std::vector<MaterialSampler>& samplers)
+	{
+		m_LooseUniforms.clear();
+		m_BlockMembers.clear();
+		m_TextureTable.clear();
+
+		for (unsigned int i = 0; i < parameters.size(); i++)
+		{
+			if (const MaterialBlockMember* blockMember = shader->RetrieveMaterialBlockMember(parameters[i].m_UniformID))
+			{
+				//Packing a value of another type would write the wrong number of bytes over the member and its neighbours. A parameter holds a single
+				//value, so array members can't be filled either.
+				if (blockMember->m_UniformType != RetrieveBlockMemberType(parameters[i].m_UniformValue.m_UniformType) || blockMember->m_ArraySize != 1)
+				{
+					CrescentInfo("Material parameter " + parameters[i].m_UniformName + " doesn't match the type of its uniform in shader " + shader->RetrieveShaderName() + ". It will be ignored.");
+					continue;
+				}
+				m_BlockMembers.push_back({ i, (unsigned int)blockMember->m_BlockOffset, parameters[i].m_UniformValue.m_UniformType });
+				continue;
+			}
+
+			//Parameters the shader doesn't use are dropped here rather than being looked up on every draw.
+			int uniformLocation = shader->RetrieveUniformLocation(parameters[i].m_UniformID);
+			if (uniformLocation >= 0)
+			{
+				m_LooseUniforms.push_back({ i, uniformLocation });
+			}
+		}
+
+		for (const MaterialSampler& sampler : samplers)
+		{
+			if (sampler.m_SamplerValue.m_Texture != nullptr)
+			{
+				m_TextureTable.push_back(sampler.m_SamplerValue);
+			}
+		}
+		std::sort(m_TextureTable.begin(), m_TextureTable.end(), [](const UniformSamplerValue& a, const UniformSamplerValue& b) { return a.m_TextureUnit < b.m_TextureUnit; });
+
+		size_t blockSize = shader->UsesMaterialUniforms() ? (size_t)shader->RetrieveMaterialBlockSize() : 0;
+		if (blockSize != m_BlockData.size())
+		{
+			ReleaseUniformBuffer();
+			m_BlockData.assign(blockSize, 0);
+
+			if (blockSize > 0)
+			{
+				glGenBuffers(1, &m_UniformBufferID);
+				glBindBuffer(GL_UNIFORM_BUFFER, m_UniformBufferID);
+				glBufferData(GL_UNIFORM_BUFFER, blockSize, nullptr, GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			}
+		}
+
+		m_CompiledShader = shader;
+		m_LayoutDirty = false;
+		m_BlockDirty = true;
+	}
+
+	void MaterialParameterBlock::Apply(const std::vector<MaterialParameter>& parameters)
+	{
+		for (const UniformSamplerValue& textureEntry : m_TextureTable)
+		{
+			if (textureEntry.m_UniformType == Shader_Type_SamplerCube)
+			{
+				textureEntry.m_TextureCube->BindTextureCube(textureEntry.m_TextureUnit);
+			}
+			else
+			{
+				textureEntry.m_Texture->BindTexture(textureEntry.m_TextureUnit);
+			}
+		}
+
+		if (m_UniformBufferID != 0)
+		{
+			if (m_BlockDirty)
+			{
+				PackBlockData(parameters);
+				glBindBuffer(GL_UNIFORM_BUFFER, m_UniformBufferID);
+				glBufferSubData(GL_UNIFORM_BUFFER, 0, m_BlockData.size(), m_BlockData.data());
+				m_BlockDirty = false;
+			}
+			glBindBufferBase(GL_UNIFORM_BUFFER, UniformBinding_Material, m_UniformBufferID);
+		}
+
+		for (const CompiledUniform& compiledUniform : m_LooseUniforms)
+		{
+			const UniformValue& uniformValue = parameters[compiledUniform.m_ParameterIndex].m_UniformValue;
+			switch (uniformValue.m_UniformType)
+			{
+			case Shader_Type_Boolean:
+				glUniform1i(compiledUniform.m_UniformLocation, (int)uniformValue.m_BoolValue);
+				break;
+			case Shader_Type_Integer:
+				glUniform1i(compiledUniform.m_UniformLocation, uniformValue.m_IntValue);
+				break;
+			case Shader_Type_Float:
+				glUniform1f(compiledUniform.m_UniformLocation, uniformValue.m_FloatValue);
+				break;
+			case Shader_Type_Vector2:
+				glUniform2fv(compiledUniform.m_UniformLocation, 1, &uniformValue.m_Vector2Value[0]);
+				break;
+			case Shader_Type_Vector3:
+				glUniform3fv(compiledUniform.m_UniformLocation, 1, &uniformValue.m_Vector3Value[0]);
+				break;
+			case Shader_Type_Vector4:
+				glUniform4fv(compiledUniform.m_UniformLocation, 1, &uniformValue.m_Vector4Value[0]);
+				break;
+			case Shader_Type_Matrix2:
+				glUniformMatrix2fv(compiledUniform.m_UniformLocation, 1, GL_FALSE, &uniformValue.m_Mat2Value[0][0]);
+				break;
+			case Shader_Type_Matrix3:
+				glUniformMatrix3fv(compiledUniform.m_UniformLocation, 1, GL_FALSE, &uniformValue.m_Mat3Value[0][0]);
+				break;
+			case Shader_Type_Matrix4:
+				glUniformMatrix4fv(compiledUniform.m_UniformLocation, 1, GL_FALSE, &uniformValue.m_Mat4Value[0][0]);
+				break;
+			default:
+				CrescentError("You tried to set an unidentified uniform data type and value. Please check.");
+				break;
+			}
+		}
+	}
+
+	void MaterialParameterBlock::PackBlockData(const std::vector<MaterialParameter>& parameters)
+	{
+		for (const CompiledBlockMember& blockMember : m_BlockMembers)
+		{
+			//Setting a value of another type to an existing parameter only marks values dirty, so it may no longer match what was compiled.
+			const UniformValue& uniformValue = parameters[blockMember.m_ParameterIndex].m_UniformValue;
+			if (uniformValue.m_UniformType != blockMember.m_UniformType)
+			{
+				continue;
+			}
+			unsigned char* destination = m_BlockData.data() + blockMember.m_BlockOffset;
+
+			//std140 stores booleans as 4 byte integers, and every matrix column with a 16 byte stride.
+			switch (uniformValue.m_UniformType)
+			{
+			case Shader_Type_Boolean:
+			{
+				int boolValue = uniformValue.m_BoolValue ? 1 : 0;
+				std::memcpy(destination, &boolValue, sizeof(int));
+				break;
+			}
+			case Shader_Type_Integer:
+				std::memcpy(destination, &uniformValue.m_IntValue, sizeof(int));
+				break;
+			case Shader_Type_Float:
+				std::memcpy(destination, &uniformValue.m_FloatValue, sizeof(float));
+				break;
+			case Shader_Type_Vector2:
+				std::memcpy(destination, &uniformValue.m_Vector2Value[0], sizeof(glm::vec2));
+				break;
+			case Shader_Type_Vector3:
+				std::memcpy(destination, &uniformValue.m_Vector3Value[0], sizeof(glm::vec3));
+				break;
+			case Shader_Type_Vector4:
+				std::memcpy(destination, &uniformValue.m_Vector4Value[0], sizeof(glm::vec4));
+				break;
+			case Shader_Type_Matrix2:
+				for (int column = 0; column < 2; column++)
+				{
+					std::memcpy(destination + column * 16, &uniformValue.m_Mat2Value[column][0], sizeof(glm::vec2));
+				}
+				break;
+			case Shader_Type_Matrix3:
+				for (int column = 0; column < 3; column++)
+				{
+					std::memcpy(destination + column * 16, &uniformValue.m_Mat3Value[column][0], sizeof(glm::vec3));
+				}
+				break;
+			case Shader_Type_Matrix4:
+				std::memcpy(destination, &uniformValue.m_Mat4Value[0][0], sizeof(glm::mat4));
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void MaterialParameterBlock::ReleaseUniformBuffer()
+	{
+		if (m_UniformBufferID != 0)
+		{
+			glDeleteBuffers(1, &m_UniformBufferID);
+			m_UniformBufferID = 0;
+		}
+		m_BlockData.clear();
+	}
+}
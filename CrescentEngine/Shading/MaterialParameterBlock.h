@@ -0,0 +1,83 @@
+#pragma once
+#include "ShaderUtilities.h"
+#include "UniformID.h"
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+namespace Crescent
+{
+	class Shader;
+
+	struct MaterialParameter
+	{
+		std::string m_UniformName;
+		UniformID m_UniformID;
+		UniformValue m_UniformValue;
+	};
+
+	struct MaterialSampler
+	{
+		std::string m_UniformName;
+		UniformID m_UniformID;
+		UniformSamplerValue m_SamplerValue;
+	};
+
+	/*
+		A material's parameters compiled against its shader. Uniform locations are resolved once, textures are gathered into a table ordered by
+		texture unit, and parameters living in the shader's MaterialUniforms block are packed into a std140 buffer that is only re-uploaded once
+		a value has changed. Parameters outside of the block are still set individually, as their values are program state shared by every material
+		using the same shader.
+
+		Copies start out uncompiled and create their own uniform buffer when first applied.
+	*/
+
+	class MaterialParameterBlock
+	{
+	public:
+		MaterialParameterBlock() = default;
+		MaterialParameterBlock(const MaterialParameterBlock& other);
+		MaterialParameterBlock& operator=(const MaterialParameterBlock& other);
+		~MaterialParameterBlock();
+
+		bool RequiresCompile(Shader* shader) const { return m_LayoutDirty || shader != m_CompiledShader; }
+		void Compile(Shader* shader, const std::vector<MaterialParameter>& parameters, const std::vector<MaterialSampler>& samplers);
+
+		//Binds textures and the material uniform buffer, and sets any parameters the block doesn't hold. Expects the shader to be in use.
+		void Apply(const std::vector<MaterialParameter>& parameters);
+
+		//Parameters or samplers were added, or a different texture was assigned.
+		void MarkLayoutDirty() { m_LayoutDirty = true; }
+		//An existing parameter changed value.
+		void MarkValuesDirty() { m_BlockDirty = true; }
+
+	private:
+		void PackBlockData(const std::vector<MaterialParameter>& parameters);
+		void ReleaseUniformBuffer();
+
+	private:
+		struct CompiledUniform
+		{
+			unsigned int m_ParameterIndex;
+			int m_UniformLocation;
+		};
+
+		struct CompiledBlockMember
+		{
+			unsigned int m_ParameterIndex;
+			unsigned int m_BlockOffset;
+			Shader_Type m_UniformType; //As checked against the shader when compiling.
+		};
+
+		Shader* m_CompiledShader = nullptr;
+		bool m_LayoutDirty = true;
+		bool m_BlockDirty = true;
+
+		std::vector<CompiledUniform> m_LooseUniforms;
+		std::vector<CompiledBlockMember> m_BlockMembers;
+		std::vector<UniformSamplerValue> m_TextureTable;
+
+		std::vector<unsigned char> m_BlockData;
+		unsigned int m_UniformBufferID = 0;
+	};
+}
@@ -2,6 +2,9 @@
 #include "Shader.h"
 #include "GL/glew.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <cassert>
+#include "../Rendering/UniformBlocks.h"
+#include "../Rendering/GLStateCache.h"
 
 namespace Crescent
 {
@@ -65,11 +68,9 @@ namespace Crescent
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
 
-		//Query the number of active uniforms and attributes.
-		int numberOfAttributes, numberOfUniforms;
+		//Query the number of active attributes.
+		int numberOfAttributes;
 		glGetProgramiv(m_ShaderID, GL_ACTIVE_ATTRIBUTES, &numberOfAttributes);
-		glGetProgramiv(m_ShaderID, GL_ACTIVE_UNIFORMS, &numberOfUniforms);
-		m_Uniforms.resize(numberOfUniforms);
 		m_Attributes.resize(numberOfAttributes);
 
 		//Iterate over all active attributes.
@@ -85,119 +86,241 @@ namespace Crescent
 		}
 
 		//Iterate over all active uniforms.
-		for (unsigned int i = 0; i < numberOfUniforms; i++)
+		QueryActiveUniforms();
+
+		//Link any shared uniform blocks to their fixed binding points. Blocks the shader doesn't actually use are reported as invalid.
+		unsigned int globalBlockIndex = glGetUniformBlockIndex(m_ShaderID, "GlobalUniforms");
+		if (globalBlockIndex != GL_INVALID_INDEX)
 		{
-			GLenum glType;
-			glGetActiveUniform(m_ShaderID, i, sizeof(buffer), 0, &m_Uniforms[i].m_UniformSize, &glType, buffer);
-			m_Uniforms[i].m_UniformName = std::string(buffer);
-			m_Uniforms[i].m_UniformType = Shader_Type_Boolean; ///To be converted properly.
+			glUniformBlockBinding(m_ShaderID, globalBlockIndex, UniformBinding_Global);
+			m_UsesGlobalUniforms = true;
+		}
 
-			m_Uniforms[i].m_UniformLocation = glGetUniformLocation(m_ShaderID, buffer);
+		unsigned int objectBlockIndex = glGetUniformBlockIndex(m_ShaderID, "ObjectUniforms");
+		if (objectBlockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(m_ShaderID, objectBlockIndex, UniformBinding_Object);
+			m_UsesObjectUniforms = true;
 		}
-	}
 
-	void Shader::UseShader()
-	{
-		glUseProgram(m_ShaderID);
+		//Material blocks differ per shader. Record where each member lives so materials can pack their parameters to match.
+		unsigned int materialBlockIndex = glGetUniformBlockIndex(m_ShaderID, "MaterialUniforms");
+		if (materialBlockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(m_ShaderID, materialBlockIndex, UniformBinding_Material);
+			glGetActiveUniformBlockiv(m_ShaderID, materialBlockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &m_MaterialBlockSize);
+
+			for (unsigned int i = 0; i < m_Uniforms.size(); i++)
+			{
+				int uniformBlockIndex = -1, uniformOffset = -1;
+				glGetActiveUniformsiv(m_ShaderID, 1, &i, GL_UNIFORM_BLOCK_INDEX, &uniformBlockIndex);
+				if (uniformBlockIndex != (int)materialBlockIndex)
+				{
+					continue;
+				}
+
+				int uniformType = 0, arraySize = 1;
+				glGetActiveUniformsiv(m_ShaderID, 1, &i, GL_UNIFORM_OFFSET, &uniformOffset);
+				glGetActiveUniformsiv(m_ShaderID, 1, &i, GL_UNIFORM_TYPE, &uniformType);
+				glGetActiveUniformsiv(m_ShaderID, 1, &i, GL_UNIFORM_SIZE, &arraySize);
+				UniformID uniformID(m_Uniforms[i].m_UniformName);
+				assert(RetrieveUniformLocation(uniformID) < 0 && RetrieveMaterialBlockMember(uniformID) == nullptr && "Uniform name hash collision. Rename one of the uniforms.");
+				m_MaterialBlockMembers.push_back({ uniformID, uniformOffset, (unsigned int)uniformType, arraySize });
+			}
+		}
 	}
 
-	bool Shader::HasUniform(const std::string& uniformName)
+	const MaterialBlockMember* Shader::RetrieveMaterialBlockMember(UniformID uniformID) const
 	{
-		for (unsigned int i = 0; i < m_Uniforms.size(); i++)
+		for (const MaterialBlockMember& blockMember : m_MaterialBlockMembers)
 		{
-			if (m_Uniforms[i].m_UniformName == uniformName)
+			if (blockMember.m_UniformID == uniformID)
 			{
-				return true;
+				return &blockMember;
 			}
 		}
-		return false;
+		return nullptr;
+	}
+
+	void Shader::UseShader()
+	{
+		GLStateCache::UseProgram(GLStateCache::RetrieveActiveCache(), m_ShaderID);
 	}
 
-	void Shader::SetUniformFloat(std::string name, float value) 
+	bool Shader::HasUniform(const std::string& uniformName)
+	{
+		return RetrieveUniformLocation(UniformID(uniformName)) >= 0;
+	}
+
+	void Shader::SetUniform(UniformID uniformID, float value)
 	{
-		int location = RetrieveUniformLocation(name);
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
 			glUniform1f(location, value);
 		}
 	}
 
-	void Shader::SetUniformInteger(std::string name, int value) 
+	void Shader::SetUniform(UniformID uniformID, int value)
 	{
-		int location = RetrieveUniformLocation(name);
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
 			glUniform1i(location, value);
 		}
 	}
 
-	void Shader::SetUniformBool(std::string name, bool value) 
+	void Shader::SetUniform(UniformID uniformID, bool value)
 	{
-		int location = RetrieveUniformLocation(name);
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
 			glUniform1i(location, (int)value);
 		}
 	}
 
-	void Shader::SetUniformVector2(std::string name, glm::vec2 value)
+	void Shader::SetUniform(UniformID uniformID, const glm::vec2& value)
 	{
-		int location = RetrieveUniformLocation(name);
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
 			glUniform2fv(location, 1, &value[0]);
 		}
 	}
 
-	void Shader::SetUniformVector3(std::string name, glm::vec3 value)
+	void Shader::SetUniform(UniformID uniformID, const glm::vec3& value)
 	{
-		int location = RetrieveUniformLocation(name);
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
 			glUniform3fv(location, 1, &value[0]);
 		}
 	}
 
-	void Shader::SetUniformMat4(std::string name, glm::mat4 value)
+	void Shader::SetUniform(UniformID uniformID, const glm::vec4& value)
 	{
-		int location = RetrieveUniformLocation(name);
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
-			glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+			glUniform4fv(location, 1, &value[0]);
 		}
 	}
 
-	void Shader::SetUniformVectorArray(std::string name, int size, const std::vector<glm::vec3>& values)
+	void Shader::SetUniform(UniformID uniformID, const glm::mat4& value)
 	{
-		unsigned int location = glGetUniformLocation(m_ShaderID, name.c_str());
+		int location = RetrieveUniformLocation(uniformID);
 		if (location >= 0)
 		{
-			glUniform3fv(location, size, (float*)(&values[0].x));
+			glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
 		}
 	}
 
-	int Shader::RetrieveUniformLocation(const std::string& uniformName)
+	void Shader::SetUniformArray(UniformID uniformID, const glm::vec3* values, int count)
+	{
+		int location = RetrieveUniformLocation(uniformID);
+		if (location >= 0 && count > 0)
+		{
+			glUniform3fv(location, count, &values[0].x);
+		}
+	}
+
+	void Shader::SetUniformArray(UniformID uniformID, const glm::mat4* values, int count)
+	{
+		int location = RetrieveUniformLocation(uniformID);
+		if (location >= 0 && count > 0)
+		{
+			glUniformMatrix4fv(location, count, GL_FALSE, value_ptr(values[0]));
+		}
+	}
+
+	//String based setters, for names only known at runtime (such as material uniforms). These hash the name and take the same path as above.
+	void Shader::SetUniformFloat(const std::string& name, float value) 
+	{
+		SetUniform(UniformID(name), value);
+	}
+
+	void Shader::SetUniformInteger(const std::string& name, int value) 
+	{
+		SetUniform(UniformID(name), value);
+	}
+
+	void Shader::SetUniformBool(const std::string& name, bool value) 
+	{
+		SetUniform(UniformID(name), value);
+	}
+
+	void Shader::SetUniformVector2(const std::string& name, const glm::vec2& value)
 	{
+		SetUniform(UniformID(name), value);
+	}
+
+	void Shader::SetUniformVector3(const std::string& name, const glm::vec3& value)
+	{
+		SetUniform(UniformID(name), value);
+	}
+
+	void Shader::SetUniformMat4(const std::string& name, const glm::mat4& value)
+	{
+		SetUniform(UniformID(name), value);
+	}
+
+	void Shader::SetUniformVectorArray(const std::string& name, int size, const std::vector<glm::vec3>& values)
+	{
+		SetUniformArray(UniformID(name), values.data(), size);
+	}
+
+	void Shader::SetUniformVectorMat4(const std::string& identifier, const std::vector<glm::mat4>& value)
+	{
+		SetUniformArray(UniformID(identifier), value.data(), (int)value.size());
+	}
+
+	int Shader::RetrieveUniformLocation(UniformID uniformID) const
+	{
+		return m_UniformTable.RetrieveUniformLocation(uniformID);
+	}
+
+	void Shader::BuildUniformTable()
+	{
+		m_UniformTable.ResetTable(m_Uniforms.size() * 2); //Arrays may register under two names.
+
 		for (unsigned int i = 0; i < m_Uniforms.size(); i++)
 		{
-			if (m_Uniforms[i].m_UniformName == uniformName)
+			//Members of uniform blocks have no location and are set through buffers instead.
+			int location = (int)m_Uniforms[i].m_UniformLocation;
+			if (location < 0)
 			{
-				return m_Uniforms[i].m_UniformLocation;
+				continue;
+			}
+
+			const std::string& uniformName = m_Uniforms[i].m_UniformName;
+			InsertUniformLocation(uniformName, location);
+
+			//Arrays are reported as "name[0]". We also register them as "name" so whole arrays can be set at once.
+			if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+			{
+				InsertUniformLocation(uniformName.substr(0, uniformName.size() - 3), location);
 			}
 		}
-		return -1;
 	}
 
-	//====================================================================================================
-	void Shader::DeleteShader()
+	void Shader::InsertUniformLocation(const std::string& uniformName, int uniformLocation)
 	{
-		glDeleteProgram(m_ShaderID);
+		//Names of a shader are unique, so a refused insertion is always two different names sharing a hash. Renaming either uniform resolves it.
+		if (!m_UniformTable.InsertUniformLocation(UniformID(uniformName), uniformLocation))
+		{
+			CrescentInfo("Uniform name hash collision in shader: " + m_ShaderName + " (" + uniformName + "). Only the first uniform will be settable.");
+			assert(!"Uniform name hash collision. Rename one of the uniforms.");
+		}
 	}
 
-	void Shader::SetUniformVectorMat4(std::string identifier, std::vector<glm::mat4> value)
+	//====================================================================================================
+	void Shader::DeleteShader()
 	{
-		auto location = glGetUniformLocation(m_ShaderID, identifier.c_str());
-		glUniformMatrix4fv(location, value.size(), GL_FALSE, value_ptr(value[0]));
+		if (GLStateCache* stateCache = GLStateCache::RetrieveActiveCache())
+		{
+			stateCache->InvalidateProgram(m_ShaderID);
+		}
+		glDeleteProgram(m_ShaderID);
 	}
 
 	void Shader::CheckCompileErrors(unsigned int shader, std::string type)
@@ -289,6 +412,27 @@ namespace Crescent
 		//Delete the shaders once they've been linked into our program.
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
+
+		QueryActiveUniforms();
+	}
+
+	void Shader::QueryActiveUniforms()
+	{
+		int numberOfUniforms = 0;
+		glGetProgramiv(m_ShaderID, GL_ACTIVE_UNIFORMS, &numberOfUniforms);
+		m_Uniforms.resize(numberOfUniforms);
+
+		char buffer[128];
+		for (unsigned int i = 0; i < numberOfUniforms; i++)
+		{
+			GLenum glType;
+			glGetActiveUniform(m_ShaderID, i, sizeof(buffer), 0, &m_Uniforms[i].m_UniformSize, &glType, buffer);
+			m_Uniforms[i].m_UniformName = std::string(buffer);
+			m_Uniforms[i].m_UniformType = Shader_Type_Boolean; ///To be converted properly.
+
+			m_Uniforms[i].m_UniformLocation = glGetUniformLocation(m_ShaderID, buffer);
+		}
+		BuildUniformTable();
 	}
 }
 
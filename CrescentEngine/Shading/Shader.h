@@ -2,9 +2,19 @@
 #include <string>
 #include <glm/glm.hpp>
 #include "ShaderUtilities.h"
+#include "UniformTable.h"
 
 namespace Crescent
 {
+	//A uniform inside a shader's MaterialUniforms block, as laid out by the driver.
+	struct MaterialBlockMember
+	{
+		UniformID m_UniformID;
+		int m_BlockOffset = 0;
+		unsigned int m_UniformType = 0; //GL type, such as GL_FLOAT_VEC3.
+		int m_ArraySize = 1;
+	};
+
 	/*
 		Shader object for quickly creating and using a GPU shader program. When compiling/linking a shader object frokm source code, all vertex attributes and shaders
 		are extracted for saving unnecessary additional CPU-GPU roundtrip cycles.
@@ -21,16 +31,40 @@ namespace Crescent
 
 		void DeleteShader();
 
-		void SetUniformFloat(const std::string name, float value);
-		void SetUniformInteger(std::string name, int value);
-		void SetUniformBool(std::string name, bool value);
-		void SetUniformVector2(std::string name, glm::vec2 value);
-		void SetUniformVector3(std::string name, glm::vec3 value);
-		void SetUniformMat4(std::string name, glm::mat4 value);
-		void SetUniformVectorArray(std::string name, int size, const std::vector<glm::vec3>& values);
-		void SetUniformVectorMat4(std::string identifier, std::vector<glm::mat4> value);
+		//Preferred setters. Pass names known at compile time through UID("name").
+		void SetUniform(UniformID uniformID, float value);
+		void SetUniform(UniformID uniformID, int value);
+		void SetUniform(UniformID uniformID, bool value);
+		void SetUniform(UniformID uniformID, const glm::vec2& value);
+		void SetUniform(UniformID uniformID, const glm::vec3& value);
+		void SetUniform(UniformID uniformID, const glm::vec4& value);
+		void SetUniform(UniformID uniformID, const glm::mat4& value);
+		void SetUniformArray(UniformID uniformID, const glm::vec3* values, int count);
+		void SetUniformArray(UniformID uniformID, const glm::mat4* values, int count);
+
+		void SetUniformFloat(const std::string& name, float value);
+		void SetUniformInteger(const std::string& name, int value);
+		void SetUniformBool(const std::string& name, bool value);
+		void SetUniformVector2(const std::string& name, const glm::vec2& value);
+		void SetUniformVector3(const std::string& name, const glm::vec3& value);
+		void SetUniformMat4(const std::string& name, const glm::mat4& value);
+		void SetUniformVectorArray(const std::string& name, int size, const std::vector<glm::vec3>& values);
+		void SetUniformVectorMat4(const std::string& identifier, const std::vector<glm::mat4>& value);
 
 		inline unsigned int GetShaderID() const { return m_ShaderID; }
+		const std::string& RetrieveShaderName() const { return m_ShaderName; }
+
+		//Whether the shader reads from the shared uniform blocks (see UniformBlocks.h). If not, these values have to be set as individual uniforms.
+		bool UsesGlobalUniforms() const { return m_UsesGlobalUniforms; }
+		bool UsesObjectUniforms() const { return m_UsesObjectUniforms; }
+
+		//Shaders may declare their own MaterialUniforms block, which materials fill and upload themselves. Returns nullptr for uniforms outside of it.
+		bool UsesMaterialUniforms() const { return m_MaterialBlockSize > 0; }
+		int RetrieveMaterialBlockSize() const { return m_MaterialBlockSize; }
+		const MaterialBlockMember* RetrieveMaterialBlockMember(UniformID uniformID) const;
+
+		//Retrieves uniform location from our hashed uniform table. Returns -1 for unknown uniforms.
+		int RetrieveUniformLocation(UniformID uniformID) const;
 
 	public:
 		//Defunct
@@ -40,13 +74,21 @@ namespace Crescent
 	private:
 		void CheckCompileErrors(unsigned int shader, std::string type);
 		
-		//Retrieves uniform location from pre-stored uniform locations and reports an error if a non-uniform is set.
-		int RetrieveUniformLocation(const std::string& uniformName);
-		unsigned int m_ShaderID;
+		void QueryActiveUniforms();
+		void BuildUniformTable();
+		void InsertUniformLocation(const std::string& uniformName, int uniformLocation);
+		unsigned int m_ShaderID = 0;
 
 	private:
 		std::string m_ShaderName;
 		std::vector<Uniform> m_Uniforms;
 		std::vector<VertexAttribute> m_Attributes;
+
+		UniformTable m_UniformTable;
+		bool m_UsesGlobalUniforms = false;
+		bool m_UsesObjectUniforms = false;
+
+		std::vector<MaterialBlockMember> m_MaterialBlockMembers;
+		int m_MaterialBlockSize = 0;
 	};
 }
\ No newline at end of file
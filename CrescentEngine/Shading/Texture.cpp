@@ -1,5 +1,6 @@
 #include "CrescentPCH.h"
 #include "Texture.h"
+#include "../Rendering/GLStateCache.h"
 #include <stb_image/stb_image.h>
 
 namespace Crescent
@@ -175,15 +176,11 @@ namespace Crescent
 
 	void Texture::BindTexture(int textureUnit)
 	{
-		if (textureUnit >= 0)
-		{
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-		}
-		glBindTexture(m_TextureTarget, m_TextureID);
+		GLStateCache::BindTexture(GLStateCache::RetrieveActiveCache(), textureUnit, m_TextureTarget, m_TextureID);
 	}
 
 	void Texture::UnbindTexture()
 	{
-		glBindTexture(m_TextureTarget, 0);
+		GLStateCache::BindTexture(GLStateCache::RetrieveActiveCache(), -1, m_TextureTarget, 0);
 	}
 }
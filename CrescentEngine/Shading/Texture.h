@@ -1,5 +1,6 @@
 #pragma once
 #include <GL/glew.h>
+#include <string>
 
 namespace Crescent
 {
@@ -48,6 +49,8 @@ namespace Crescent
 		unsigned int m_TextureHeight = 0;
 		unsigned int m_TextureDepth = 0;
 
+		std::string m_TexturePath; //The image file the texture was loaded from, so it can be loaded again by path. Empty for generated textures.
+
 	private:
 		unsigned int m_TextureID = 0;
 	};
@@ -1,5 +1,6 @@
 #include "CrescentPCH.h"
 #include "TextureCube.h"
+#include "../Rendering/GLStateCache.h"
 
 namespace Crescent
 {
@@ -105,15 +106,11 @@ namespace Crescent
 
 	void TextureCube::BindTextureCube(int textureUnit)
 	{
-		if (textureUnit >= 0)
-		{
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-		}
-		glBindTexture(GL_TEXTURE_CUBE_MAP, m_TextureCubeID);
+		GLStateCache::BindTexture(GLStateCache::RetrieveActiveCache(), textureUnit, GL_TEXTURE_CUBE_MAP, m_TextureCubeID);
 	}
 
 	void TextureCube::UnbindTextureCube()
 	{
-		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		GLStateCache::BindTexture(GLStateCache::RetrieveActiveCache(), -1, GL_TEXTURE_CUBE_MAP, 0);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace Crescent
+{
+	//32-bit FNV-1a. Usable at compile time, so uniform names written in code never need to be hashed at runtime.
+	constexpr uint32_t HashUniformName(const char* name, size_t length)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= static_cast<uint8_t>(name[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	constexpr uint32_t HashUniformName(const char* name)
+	{
+		size_t length = 0;
+		while (name[length] != '\0')
+		{
+			length++;
+		}
+		return HashUniformName(name, length);
+	}
+
+	/*
+		A uniform identified by the hash of its name. Shaders map these to locations when they are loaded, so setting a uniform is a single hash table probe.
+		Use the UID macro for names known at compile time.
+	*/
+
+	struct UniformID
+	{
+		uint32_t m_Hash = 0;
+
+		constexpr UniformID() = default;
+		constexpr explicit UniformID(uint32_t hash) : m_Hash(hash) { }
+		explicit UniformID(const std::string& name) : m_Hash(HashUniformName(name.c_str(), name.size())) { }
+
+		constexpr bool operator==(const UniformID& other) const { return m_Hash == other.m_Hash; }
+		constexpr bool operator!=(const UniformID& other) const { return m_Hash != other.m_Hash; }
+	};
+}
+
+//Hashes a uniform name literal at compile time.
+#define UID(name) Crescent::UniformID(std::integral_constant<uint32_t, Crescent::HashUniformName(name)>::value)
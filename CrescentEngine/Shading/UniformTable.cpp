@@ -0,0 +1,58 @@
+#include "CrescentPCH.h"
+#include "UniformTable.h"
+
+namespace Crescent
+{
+	void UniformTable::ResetTable(size_t uniformCount)
+	{
+		uint32_t tableSize = 8;
+		while (tableSize < uniformCount * 2)
+		{
+			tableSize *= 2;
+		}
+
+		m_UniformSlots.assign(tableSize, UniformSlot());
+		m_SlotMask = tableSize - 1;
+	}
+
+	bool UniformTable::InsertUniformLocation(UniformID uniformID, int uniformLocation)
+	{
+		uint32_t slotIndex = uniformID.m_Hash & m_SlotMask;
+		while (m_UniformSlots[slotIndex].m_UniformLocation >= 0)
+		{
+			if (m_UniformSlots[slotIndex].m_UniformHash == uniformID.m_Hash)
+			{
+				return false;
+			}
+			slotIndex = (slotIndex + 1) & m_SlotMask;
+		}
+
+		m_UniformSlots[slotIndex].m_UniformHash = uniformID.m_Hash;
+		m_UniformSlots[slotIndex].m_UniformLocation = uniformLocation;
+		return true;
+	}
+
+	int UniformTable::RetrieveUniformLocation(UniformID uniformID) const
+	{
+		if (m_UniformSlots.empty())
+		{
+			return -1;
+		}
+
+		//The table is never full, so we will always reach an empty slot.
+		uint32_t slotIndex = uniformID.m_Hash & m_SlotMask;
+		while (true)
+		{
+			const UniformSlot& uniformSlot = m_UniformSlots[slotIndex];
+			if (uniformSlot.m_UniformLocation < 0)
+			{
+				return -1;
+			}
+			if (uniformSlot.m_UniformHash == uniformID.m_Hash)
+			{
+				return uniformSlot.m_UniformLocation;
+			}
+			slotIndex = (slotIndex + 1) & m_SlotMask;
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "UniformID.h"
+
+namespace Crescent
+{
+	/*
+		Open addressing table from uniform name hashes to locations, probed linearly. It is kept at most half full so probes stay short, and as only hashes
+		are stored, two names sharing a hash can't be told apart. Such a collision is refused on insertion rather than silently shadowing a uniform.
+	*/
+
+	class UniformTable
+	{
+	public:
+		//Empties the table and sizes it for the given number of names.
+		void ResetTable(size_t uniformCount);
+
+		//Returns false, leaving the table untouched, if a name with the same hash was inserted before.
+		bool InsertUniformLocation(UniformID uniformID, int uniformLocation);
+		//Returns -1 for unknown uniforms.
+		int RetrieveUniformLocation(UniformID uniformID) const;
+
+	private:
+		//Empty slots have a negative location.
+		struct UniformSlot
+		{
+			uint32_t m_UniformHash = 0;
+			int m_UniformLocation = -1;
+		};
+		std::vector<UniformSlot> m_UniformSlots;
+		uint32_t m_SlotMask = 0;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+
+namespace Crescent
+{
+	/*
+		Axis aligned bounding box stored as its minimum and maximum corners. A default constructed box is empty (inverted) so that points can simply be
+		merged into it.
+	*/
+
+	struct BoundingBox
+	{
+		glm::vec3 m_Minimum = glm::vec3(FLT_MAX);
+		glm::vec3 m_Maximum = glm::vec3(-FLT_MAX);
+
+		bool IsValid() const { return m_Minimum.x <= m_Maximum.x && m_Minimum.y <= m_Maximum.y && m_Minimum.z <= m_Maximum.z; }
+		glm::vec3 RetrieveCenter() const { return (m_Minimum + m_Maximum) * 0.5f; }
+		glm::vec3 RetrieveExtents() const { return (m_Maximum - m_Minimum) * 0.5f; }
+
+		void Merge(const glm::vec3& point)
+		{
+			m_Minimum = glm::min(m_Minimum, point);
+			m_Maximum = glm::max(m_Maximum, point);
+		}
+
+		//Transforms the box and returns the axis aligned box enclosing the result. The extents are projected onto the absolute matrix axes (Arvo's method),
+		//which avoids transforming all 8 corners.
+		BoundingBox Transform(const glm::mat4& transform) const
+		{
+			glm::vec3 center = glm::vec3(transform * glm::vec4(RetrieveCenter(), 1.0f));
+			glm::vec3 extents = RetrieveExtents();
+			glm::vec3 transformedExtents = glm::abs(glm::vec3(transform[0])) * extents.x + glm::abs(glm::vec3(transform[1])) * extents.y + glm::abs(glm::vec3(transform[2])) * extents.z;
+
+			BoundingBox boundingBox;
+			boundingBox.m_Minimum = center - transformedExtents;
+			boundingBox.m_Maximum = center + transformedExtents;
+			return boundingBox;
+		}
+	};
+
+	struct BoundingSphere
+	{
+		glm::vec3 m_Center = glm::vec3(0.0f);
+		float m_Radius = 0.0f;
+
+		//Scales the radius by the largest axis scale so the sphere still encloses non-uniformly scaled geometry.
+		BoundingSphere Transform(const glm::mat4& transform) const
+		{
+			float maximumScale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+			BoundingSphere boundingSphere;
+			boundingSphere.m_Center = glm::vec3(transform * glm::vec4(m_Center, 1.0f));
+			boundingSphere.m_Radius = m_Radius * maximumScale;
+			return boundingSphere;
+		}
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "Frustum.h"
 
 namespace Crescent
 {
@@ -33,6 +34,9 @@ namespace Crescent
 
 		void UpdateViewMatrix();
 
+		//Frustum of the current projection and view matrices, in world space.
+		Frustum RetrieveViewFrustum() const { return Frustum(m_ProjectionMatrix * m_ViewMatrix); }
+
 	public:
 		float m_CameraYaw;
 		float m_CameraPitch;
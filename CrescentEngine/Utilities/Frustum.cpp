@@ -0,0 +1,187 @@
+#include "CrescentPCH.h"
+#include "Frustum.h"
+#include <xmmintrin.h>
+
+namespace Crescent
+{
+	void BoundingBoxStream::Clear()
+	{
+		//Keep our capacity around for the next frame.
+		m_CenterX.clear(); m_CenterY.clear(); m_CenterZ.clear();
+		m_ExtentX.clear(); m_ExtentY.clear(); m_ExtentZ.clear();
+		m_BoxCount = 0;
+	}
+
+	void BoundingBoxStream::PushBoundingBox(const BoundingBox& boundingBox)
+	{
+		//Geometry without bounds is never culled.
+		if (!boundingBox.IsValid())
+		{
+			PushUnboundedBox();
+			m_BoxCount++;
+			return;
+		}
+
+		glm::vec3 center = boundingBox.RetrieveCenter();
+		glm::vec3 extents = boundingBox.RetrieveExtents();
+
+		m_CenterX.push_back(center.x); m_CenterY.push_back(center.y); m_CenterZ.push_back(center.z);
+		m_ExtentX.push_back(extents.x); m_ExtentY.push_back(extents.y); m_ExtentZ.push_back(extents.z);
+		m_BoxCount++;
+	}
+
+	void BoundingBoxStream::PadToBatchSize()
+	{
+		while (m_CenterX.size() % 4 != 0)
+		{
+			PushUnboundedBox();
+		}
+	}
+
+	void BoundingBoxStream::PushUnboundedBox()
+	{
+		//Centered at the origin with enormous extents, meaning it always ends up on the inner side of every plane.
+		m_CenterX.push_back(0.0f); m_CenterY.push_back(0.0f); m_CenterZ.push_back(0.0f);
+		m_ExtentX.push_back(1e30f); m_ExtentY.push_back(1e30f); m_ExtentZ.push_back(1e30f);
+	}
+
+	Frustum::Frustum()
+	{
+		ExtractPlanes(glm::mat4(1.0f));
+	}
+
+	Frustum::Frustum(const glm::mat4& viewProjectionMatrix)
+	{
+		ExtractPlanes(viewProjectionMatrix);
+	}
+
+	void Frustum::ExtractPlanes(const glm::mat4& viewProjectionMatrix)
+	{
+		//GLM matrices are column major, so we gather the rows ourselves. Clip space depth is in the range [-1, 1] as per OpenGL.
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4(viewProjectionMatrix[0][i], viewProjectionMatrix[1][i], viewProjectionMatrix[2][i], viewProjectionMatrix[3][i]);
+		}
+
+		m_Planes[Plane_Left] = rows[3] + rows[0];
+		m_Planes[Plane_Right] = rows[3] - rows[0];
+		m_Planes[Plane_Bottom] = rows[3] + rows[1];
+		m_Planes[Plane_Top] = rows[3] - rows[1];
+		m_Planes[Plane_Near] = rows[3] + rows[2];
+		m_Planes[Plane_Far] = rows[3] - rows[2];
+
+		for (int i = 0; i < Plane_Count; i++)
+		{
+			float normalLength = glm::length(glm::vec3(m_Planes[i]));
+			if (normalLength > 0.0f)
+			{
+				m_Planes[i] /= normalLength;
+			}
+		}
+	}
+
+	bool Frustum::IntersectsBoundingBox(const BoundingBox& boundingBox) const
+	{
+		glm::vec3 center = boundingBox.RetrieveCenter();
+		glm::vec3 extents = boundingBox.RetrieveExtents();
+
+		for (int i = 0; i < Plane_Count; i++)
+		{
+			glm::vec3 planeNormal = glm::vec3(m_Planes[i]);
+			//Project the extents onto the plane normal to find the box's "radius" along it.
+			float projectedRadius = glm::dot(extents, glm::abs(planeNormal));
+			if (glm::dot(planeNormal, center) + m_Planes[i].w + projectedRadius < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Frustum::ContainsBoundingBox(const BoundingBox& boundingBox) const
+	{
+		glm::vec3 center = boundingBox.RetrieveCenter();
+		glm::vec3 extents = boundingBox.RetrieveExtents();
+
+		for (int i = 0; i < Plane_Count; i++)
+		{
+			glm::vec3 planeNormal = glm::vec3(m_Planes[i]);
+			float projectedRadius = glm::dot(extents, glm::abs(planeNormal));
+			if (glm::dot(planeNormal, center) + m_Planes[i].w - projectedRadius < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Frustum::IntersectsBoundingSphere(const BoundingSphere& boundingSphere) const
+	{
+		for (int i = 0; i < Plane_Count; i++)
+		{
+			if (glm::dot(glm::vec3(m_Planes[i]), boundingSphere.m_Center) + m_Planes[i].w + boundingSphere.m_Radius < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t Frustum::CullBoundingBoxes(BoundingBoxStream& boundingBoxes, std::vector<uint8_t>& visibilityResults) const
+	{
+		boundingBoxes.PadToBatchSize();
+		const size_t paddedCount = boundingBoxes.m_CenterX.size();
+		visibilityResults.resize(paddedCount);
+
+		//Splat each plane once up front. The absolute normal is what the extents are projected onto.
+		__m128 planeX[Plane_Count], planeY[Plane_Count], planeZ[Plane_Count], planeW[Plane_Count];
+		__m128 absolutePlaneX[Plane_Count], absolutePlaneY[Plane_Count], absolutePlaneZ[Plane_Count];
+		for (int i = 0; i < Plane_Count; i++)
+		{
+			planeX[i] = _mm_set1_ps(m_Planes[i].x);
+			planeY[i] = _mm_set1_ps(m_Planes[i].y);
+			planeZ[i] = _mm_set1_ps(m_Planes[i].z);
+			planeW[i] = _mm_set1_ps(m_Planes[i].w);
+			absolutePlaneX[i] = _mm_set1_ps(glm::abs(m_Planes[i].x));
+			absolutePlaneY[i] = _mm_set1_ps(glm::abs(m_Planes[i].y));
+			absolutePlaneZ[i] = _mm_set1_ps(glm::abs(m_Planes[i].z));
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		size_t visibleCount = 0;
+
+		for (size_t i = 0; i < paddedCount; i += 4)
+		{
+			__m128 centerX = _mm_loadu_ps(&boundingBoxes.m_CenterX[i]);
+			__m128 centerY = _mm_loadu_ps(&boundingBoxes.m_CenterY[i]);
+			__m128 centerZ = _mm_loadu_ps(&boundingBoxes.m_CenterZ[i]);
+			__m128 extentX = _mm_loadu_ps(&boundingBoxes.m_ExtentX[i]);
+			__m128 extentY = _mm_loadu_ps(&boundingBoxes.m_ExtentY[i]);
+			__m128 extentZ = _mm_loadu_ps(&boundingBoxes.m_ExtentZ[i]);
+
+			//All lanes start visible and are knocked out by any plane they lie fully behind.
+			__m128 visibleMask = _mm_cmpeq_ps(zero, zero);
+			for (int j = 0; j < Plane_Count; j++)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, planeX[j]), _mm_mul_ps(centerY, planeY[j])), _mm_add_ps(_mm_mul_ps(centerZ, planeZ[j]), planeW[j]));
+				__m128 projectedRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, absolutePlaneX[j]), _mm_mul_ps(extentY, absolutePlaneY[j])), _mm_mul_ps(extentZ, absolutePlaneZ[j]));
+				visibleMask = _mm_and_ps(visibleMask, _mm_cmpge_ps(_mm_add_ps(distance, projectedRadius), zero));
+			}
+
+			int laneMask = _mm_movemask_ps(visibleMask);
+			visibilityResults[i + 0] = (laneMask >> 0) & 1;
+			visibilityResults[i + 1] = (laneMask >> 1) & 1;
+			visibilityResults[i + 2] = (laneMask >> 2) & 1;
+			visibilityResults[i + 3] = (laneMask >> 3) & 1;
+		}
+
+		//Padding lanes always pass, so only count the real boxes.
+		visibilityResults.resize(boundingBoxes.m_BoxCount);
+		for (size_t i = 0; i < visibilityResults.size(); i++)
+		{
+			visibleCount += visibilityResults[i];
+		}
+		return visibleCount;
+	}
+}
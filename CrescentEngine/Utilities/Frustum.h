@@ -0,0 +1,65 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Bounds.h"
+
+namespace Crescent
+{
+	/*
+		Bounding boxes laid out as separate center/extent streams so that the frustum test can load 4 boxes at once into SSE registers. Streams are padded
+		to a multiple of 4 with boxes that always pass, so the batch loop never needs a scalar tail.
+	*/
+
+	struct BoundingBoxStream
+	{
+		std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+		std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+		size_t m_BoxCount = 0;
+
+		void Clear();
+		void PushBoundingBox(const BoundingBox& boundingBox);
+		void PadToBatchSize();
+
+	private:
+		void PushUnboundedBox();
+	};
+
+	/*
+		The 6 clipping planes of a view projection matrix, extracted with the Gribb/Hartmann method. Plane normals point into the frustum and are normalized,
+		such that dot(normal, point) + distance is the signed distance of a point to the plane.
+	*/
+
+	class Frustum
+	{
+	public:
+		enum FrustumPlane
+		{
+			Plane_Left,
+			Plane_Right,
+			Plane_Bottom,
+			Plane_Top,
+			Plane_Near,
+			Plane_Far,
+			Plane_Count
+		};
+
+		Frustum();
+		Frustum(const glm::mat4& viewProjectionMatrix);
+
+		void ExtractPlanes(const glm::mat4& viewProjectionMatrix);
+
+		bool IntersectsBoundingBox(const BoundingBox& boundingBox) const;
+		//Whether the box lies entirely on the inner side of every plane.
+		bool ContainsBoundingBox(const BoundingBox& boundingBox) const;
+		bool IntersectsBoundingSphere(const BoundingSphere& boundingSphere) const;
+
+		//Tests every box in the stream, 4 per iteration. Writes 1 (visible) or 0 (culled) per box into visibilityResults and returns the visible count.
+		size_t CullBoundingBoxes(BoundingBoxStream& boundingBoxes, std::vector<uint8_t>& visibilityResults) const;
+
+		const glm::vec4& RetrievePlane(FrustumPlane plane) const { return m_Planes[plane]; }
+
+	private:
+		glm::vec4 m_Planes[Plane_Count];
+	};
+}
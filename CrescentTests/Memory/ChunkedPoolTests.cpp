@@ -0,0 +1,109 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Memory/ChunkedPool.h"
+#include "Scene/SceneEntity.h"
+#include <vector>
+
+namespace Crescent
+{
+	namespace
+	{
+		int g_LiveObjectCount = 0;
+
+		struct PooledObject
+		{
+			PooledObject(int objectValue, PoolHandle objectHandle) : m_Value(objectValue), m_Handle(objectHandle) { g_LiveObjectCount++; }
+			~PooledObject() { g_LiveObjectCount--; }
+
+			int m_Value;
+			PoolHandle m_Handle;
+		};
+
+		typedef ChunkedPool<PooledObject, 16> ObjectPool;
+	}
+
+	CrescentTest(ChunkedPool_StaleHandlesResolveToNullptr)
+	{
+		ObjectPool objectPool;
+		PooledObject* firstObject = objectPool.Create(1);
+		PoolHandle firstHandle = firstObject->m_Handle;
+		CrescentCheck(objectPool.Resolve(firstHandle) == firstObject);
+
+		//The freed slot is the next one handed out, under a new handle.
+		objectPool.Destroy(firstHandle);
+		CrescentCheck(objectPool.Resolve(firstHandle) == nullptr && g_LiveObjectCount == 0);
+		PooledObject* secondObject = objectPool.Create(2);
+		PoolHandle secondHandle = secondObject->m_Handle;
+		CrescentCheck(secondObject == firstObject && ObjectPool::RetrieveIndex(secondHandle) == ObjectPool::RetrieveIndex(firstHandle));
+		CrescentCheck(secondHandle != firstHandle);
+		CrescentCheck(objectPool.Resolve(firstHandle) == nullptr && objectPool.Resolve(secondHandle) == secondObject && secondObject->m_Value == 2);
+
+		//Destroying through the stale handle leaves the slot's new object alone.
+		objectPool.Destroy(firstHandle);
+		CrescentCheck(objectPool.Resolve(secondHandle) == secondObject && objectPool.RetrieveLiveCount() == 1 && g_LiveObjectCount == 1);
+
+		CrescentCheck(objectPool.Resolve(InvalidPoolHandle) == nullptr && objectPool.Resolve(1000) == nullptr);
+		objectPool.Destroy(secondHandle);
+
+		//Entities are pooled the same way, so an entity's ID stops resolving once it is destroyed, even after its slot is reused.
+		SceneEntity* firstEntity = SceneEntity::CreateEntity("First");
+		unsigned int firstEntityID = firstEntity->RetrieveEntityID();
+		SceneEntity::DestroyEntity(firstEntity);
+		SceneEntity* secondEntity = SceneEntity::CreateEntity("Second");
+		CrescentCheck(secondEntity == firstEntity && SceneEntity::RetrieveEntity(firstEntityID) == nullptr);
+		CrescentCheck(SceneEntity::RetrieveEntity(secondEntity->RetrieveEntityID()) == secondEntity);
+		SceneEntity::DestroyEntity(secondEntity);
+	}
+
+	CrescentTest(ChunkedPool_AddressesStayStableAcrossGrowth)
+	{
+		{
+			ObjectPool objectPool;
+			std::vector<PooledObject*> objects;
+			for (int i = 0; i < 1000; i++)
+			{
+				objects.push_back(objectPool.Create(i));
+			}
+			CrescentCheck(objectPool.RetrieveChunkCount() == (1000 + 15) / 16 && objectPool.RetrieveLiveCount() == 1000);
+
+			bool objectsIntact = true;
+			for (int i = 0; i < 1000; i++)
+			{
+				objectsIntact &= objectPool.Resolve(objects[i]->m_Handle) == objects[i] && objects[i]->m_Value == i;
+			}
+			CrescentCheck(objectsIntact);
+
+			//Churn only recycles slots the pool already owns.
+			size_t chunkCount = objectPool.RetrieveChunkCount();
+			for (int i = 0; i < 10000; i++)
+			{
+				int replacedIndex = (i * 7919) % 1000;
+				objectPool.Destroy(objects[replacedIndex]->m_Handle);
+				objects[replacedIndex] = objectPool.Create(i);
+			}
+			CrescentCheck(objectPool.RetrieveChunkCount() == chunkCount && objectPool.RetrieveLiveCount() == 1000);
+		}
+
+		//Objects still alive when the pool goes away are destroyed along with it.
+		CrescentCheck(g_LiveObjectCount == 0);
+	}
+
+	CrescentTest(ChunkedPool_GenerationsWrapAfter4096Reuses)
+	{
+		//Detection of stale handles holds for 4095 reuses of a slot, after which its handles repeat.
+		ObjectPool objectPool;
+		PoolHandle firstHandle = objectPool.Create(0)->m_Handle;
+		PoolHandle handle = firstHandle;
+		bool staleHandlesRejected = true;
+		for (uint32_t i = 1; i < 4096; i++)
+		{
+			objectPool.Destroy(handle);
+			handle = objectPool.Create((int)i)->m_Handle;
+			staleHandlesRejected &= objectPool.Resolve(firstHandle) == nullptr;
+		}
+		CrescentCheck(staleHandlesRejected);
+
+		objectPool.Destroy(handle);
+		CrescentCheck(objectPool.Create(4096)->m_Handle == firstHandle);
+	}
+}
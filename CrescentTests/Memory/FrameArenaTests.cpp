@@ -0,0 +1,37 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Memory/FrameArena.h"
+#include <cstdint>
+
+namespace Crescent
+{
+	CrescentTest(FrameArena_SettlesAfterOutgrowingItsBlock)
+	{
+		FrameArena frameArena(1024);
+		CrescentCheck(frameArena.RetrieveHeapAllocationCount() == 1);
+
+		//A frame well beyond the initial block chains on further blocks, which the reset merges into one.
+		for (unsigned int i = 0; i < 100; i++)
+		{
+			uintptr_t address = (uintptr_t)frameArena.Allocate(100, 16);
+			CrescentCheck(address % 16 == 0);
+		}
+		CrescentCheck(frameArena.RetrieveHeapAllocationCount() > 1);
+		frameArena.Reset();
+		size_t settledAllocationCount = frameArena.RetrieveHeapAllocationCount();
+		CrescentCheck(frameArena.RetrieveCapacity() >= 100 * 100);
+
+		//Frames of the same size or smaller now fit into the merged block.
+		size_t processAllocationCount = Tests::TestRegistry::RetrieveHeapAllocationCount();
+		for (unsigned int frame = 0; frame < 50; frame++)
+		{
+			for (unsigned int i = 0; i < 100 - frame; i++)
+			{
+				frameArena.Allocate(100, 16);
+			}
+			frameArena.Reset();
+		}
+		CrescentCheck(frameArena.RetrieveHeapAllocationCount() == settledAllocationCount);
+		CrescentCheck(Tests::TestRegistry::RetrieveHeapAllocationCount() == processAllocationCount);
+	}
+}
@@ -0,0 +1,141 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Memory/FreeListAllocator.h"
+
+namespace Crescent
+{
+	CrescentTest(FreeListAllocator_AllocateFreeAndCoalesce)
+	{
+		FreeListAllocator allocator(100);
+		size_t first = allocator.Allocate(10);
+		size_t second = allocator.Allocate(20);
+		size_t third = allocator.Allocate(30);
+		CrescentCheck(first == 0 && second == 10 && third == 30);
+		CrescentCheck(allocator.RetrieveFreeSize() == 40);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 1);
+
+		//Freeing the middle range leaves a hole, which merges with its neighbours once they are freed too.
+		allocator.Free(second, 20);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 2);
+		allocator.Free(first, 10);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 2);
+		CrescentCheck(allocator.RetrieveLargestFreeRange() == 40);
+		allocator.Free(third, 30);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 1);
+		CrescentCheck(allocator.RetrieveFreeSize() == 100 && allocator.RetrieveLargestFreeRange() == 100);
+
+		CrescentCheck(allocator.Allocate(0) == InvalidAllocationOffset);
+		CrescentCheck(allocator.Allocate(101) == InvalidAllocationOffset);
+		CrescentCheck(allocator.Allocate(100) == 0);
+		CrescentCheck(allocator.Allocate(1) == InvalidAllocationOffset);
+	}
+
+	CrescentTest(FreeListAllocator_ReusesFreedRanges)
+	{
+		FreeListAllocator allocator(1000);
+		size_t ranges[5];
+		for (unsigned int i = 0; i < 5; i++)
+		{
+			ranges[i] = allocator.Allocate(100);
+		}
+
+		//Best fit picks the smallest hole that fits, rather than the first one or the large range at the end.
+		allocator.Free(ranges[1], 100);
+		allocator.Free(ranges[3], 100);
+		allocator.Allocate(40); //Splits the hole at 100, leaving 60 free behind it.
+		CrescentCheck(allocator.Allocate(60) == 140);
+		CrescentCheck(allocator.Allocate(100) == ranges[3]);
+		CrescentCheck(allocator.Allocate(100) == 500);
+
+		//Equally sized holes are handed out lowest offset first.
+		allocator.Free(ranges[4], 100);
+		allocator.Free(ranges[0], 100);
+		CrescentCheck(allocator.Allocate(100) == ranges[0]);
+	}
+
+	CrescentTest(FreeListAllocator_FragmentationAfterGrowing)
+	{
+		FreeListAllocator allocator(64);
+		std::vector<size_t> ranges;
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			ranges.push_back(allocator.Allocate(8));
+		}
+		CrescentCheck(allocator.Allocate(8) == InvalidAllocationOffset);
+
+		//Every other range is freed, leaving four holes that no larger allocation fits into.
+		for (unsigned int i = 0; i < 8; i += 2)
+		{
+			allocator.Free(ranges[i], 8);
+		}
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 4);
+		CrescentCheck(allocator.Allocate(16) == InvalidAllocationOffset);
+
+		//Growing adds a single range at the end, as a pool does when it doubles. The last range is still in use, so nothing merges with it.
+		allocator.Grow(128);
+		CrescentCheck(allocator.RetrieveCapacity() == 128);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 5);
+		CrescentCheck(allocator.RetrieveFreeSize() == 96);
+		CrescentCheck(allocator.Allocate(64) == 64);
+
+		//Small allocations still fill the old holes rather than the grown space.
+		CrescentCheck(allocator.Allocate(8) == 0);
+
+		//Freeing the last range of the old capacity joins the hole before it with the grown space behind it.
+		allocator.Free(64, 64);
+		allocator.Free(ranges[7], 8);
+		CrescentCheck(allocator.RetrieveLargestFreeRange() == 80);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 3);
+
+		//Shrinking is ignored.
+		allocator.Grow(32);
+		CrescentCheck(allocator.RetrieveCapacity() == 128);
+	}
+
+	CrescentTest(FreeListAllocator_RandomAllocationsKeepInvariants)
+	{
+		FreeListAllocator allocator(1 << 16);
+		std::vector<std::pair<size_t, size_t>> liveRanges;
+		uint32_t randomState = 12345;
+		auto nextRandom = [&]() { randomState = randomState * 1664525u + 1013904223u; return randomState >> 8; };
+
+		bool rangesOverlap = false;
+		for (unsigned int i = 0; i < 20000; i++)
+		{
+			if (liveRanges.empty() || nextRandom() % 3 != 0)
+			{
+				size_t size = 1 + nextRandom() % 512;
+				size_t offset = allocator.Allocate(size);
+				if (offset == InvalidAllocationOffset)
+				{
+					allocator.Grow(allocator.RetrieveCapacity() * 2);
+					offset = allocator.Allocate(size);
+				}
+
+				for (const std::pair<size_t, size_t>& liveRange : liveRanges)
+				{
+					rangesOverlap |= offset < liveRange.first + liveRange.second && liveRange.first < offset + size;
+				}
+				liveRanges.push_back(std::make_pair(offset, size));
+			}
+			else
+			{
+				size_t rangeIndex = nextRandom() % liveRanges.size();
+				allocator.Free(liveRanges[rangeIndex].first, liveRanges[rangeIndex].second);
+				liveRanges[rangeIndex] = liveRanges.back();
+				liveRanges.pop_back();
+			}
+		}
+		CrescentCheck(!rangesOverlap);
+
+		size_t usedSize = 0;
+		for (const std::pair<size_t, size_t>& liveRange : liveRanges)
+		{
+			usedSize += liveRange.second;
+			allocator.Free(liveRange.first, liveRange.second);
+		}
+		CrescentCheck(usedSize > 0);
+		CrescentCheck(allocator.RetrieveFreeRangeCount() == 1);
+		CrescentCheck(allocator.RetrieveFreeSize() == allocator.RetrieveCapacity());
+	}
+}
@@ -0,0 +1,167 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Models/MeshOptimizer.h"
+#include "Models/Mesh.h"
+#include <random>
+#include <array>
+#include <algorithm>
+
+namespace Crescent
+{
+	namespace
+	{
+		typedef std::array<float, 15> TriangleCorners; //Position and UV of each corner.
+
+		//Every triangle's corners, rotated to start at its smallest one so that winding is kept, then sorted. Equal for meshes drawing the same surface
+		//whatever their vertex numbering and triangle order.
+		std::vector<TriangleCorners> CollectTriangles(const Mesh* mesh)
+		{
+			std::vector<TriangleCorners> triangles;
+			for (size_t i = 0; i + 2 < mesh->m_Indices.size(); i += 3)
+			{
+				std::array<std::array<float, 5>, 3> corners;
+				for (int j = 0; j < 3; j++)
+				{
+					const glm::vec3& position = mesh->m_Positions[mesh->m_Indices[i + j]];
+					const glm::vec2& uv = mesh->m_UV[mesh->m_Indices[i + j]];
+					corners[j] = { position.x, position.y, position.z, uv.x, uv.y };
+				}
+				std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+				TriangleCorners triangle;
+				for (int j = 0; j < 3; j++)
+				{
+					std::copy(corners[j].begin(), corners[j].end(), triangle.begin() + j * 5);
+				}
+				triangles.push_back(triangle);
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		//A grid of quads as an importer leaves it, with every triangle owning its three vertices and triangles in random order.
+		Mesh* CreateUnweldedGrid(int gridSize, unsigned int seed)
+		{
+			std::vector<std::array<glm::ivec2, 3>> gridTriangles;
+			for (int y = 0; y < gridSize; y++)
+			{
+				for (int x = 0; x < gridSize; x++)
+				{
+					gridTriangles.push_back({ glm::ivec2(x, y), glm::ivec2(x, y + 1), glm::ivec2(x + 1, y) });
+					gridTriangles.push_back({ glm::ivec2(x + 1, y), glm::ivec2(x, y + 1), glm::ivec2(x + 1, y + 1) });
+				}
+			}
+			std::mt19937 randomEngine(seed);
+			std::shuffle(gridTriangles.begin(), gridTriangles.end(), randomEngine);
+
+			Mesh* mesh = new Mesh;
+			for (const std::array<glm::ivec2, 3>& gridTriangle : gridTriangles)
+			{
+				for (const glm::ivec2& gridPoint : gridTriangle)
+				{
+					mesh->m_Indices.push_back((unsigned int)mesh->m_Positions.size());
+					mesh->m_Positions.push_back(glm::vec3((float)gridPoint.x, 0.0f, (float)gridPoint.y));
+					mesh->m_UV.push_back(glm::vec2(gridPoint) / (float)gridSize);
+					mesh->m_Normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+				}
+			}
+			return mesh;
+		}
+	}
+
+	CrescentTest(MeshOptimizer_WeldsWithoutChangingTriangles)
+	{
+		Mesh* mesh = CreateUnweldedGrid(100, 21);
+		std::vector<TriangleCorners> trianglesBefore = CollectTriangles(mesh);
+		CrescentCheck(mesh->m_Positions.size() == 60000);
+
+		CrescentCheck(MeshOptimizer::WeldVertices(mesh) == 60000 - 101 * 101);
+		CrescentCheck(mesh->m_Positions.size() == 101 * 101 && mesh->m_UV.size() == 101 * 101 && mesh->m_Normals.size() == 101 * 101);
+		CrescentCheck(CollectTriangles(mesh) == trianglesBefore);
+
+		//Vertices sharing a position but not a UV, as along a texture seam, are kept apart.
+		Mesh* seamMesh = new Mesh;
+		seamMesh->m_Positions = { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+		seamMesh->m_UV = { glm::vec2(0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec2(0.5f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f) };
+		seamMesh->m_Indices = { 0, 1, 2, 3, 5, 4 };
+		std::vector<TriangleCorners> seamTrianglesBefore = CollectTriangles(seamMesh);
+		CrescentCheck(MeshOptimizer::WeldVertices(seamMesh) == 1);
+		CrescentCheck(seamMesh->m_Positions.size() == 5 && CollectTriangles(seamMesh) == seamTrianglesBefore);
+
+		delete mesh;
+		delete seamMesh;
+	}
+
+	CrescentTest(MeshOptimizer_FullPassImprovesVertexCache)
+	{
+		Mesh* mesh = CreateUnweldedGrid(100, 22);
+		std::vector<TriangleCorners> trianglesBefore = CollectTriangles(mesh);
+
+		MeshOptimizationReport optimizationReport = MeshOptimizer::OptimizeMesh(mesh);
+		CrescentCheck(optimizationReport.m_VertexCountBefore == 60000 && optimizationReport.m_VertexCountAfter == 101 * 101);
+		CrescentCheck(optimizationReport.m_CacheStatisticsBefore.m_ACMR == 3.0f);
+		CrescentCheck(optimizationReport.m_CacheStatisticsAfter.m_ACMR < 0.8f);
+		CrescentCheck(CollectTriangles(mesh) == trianglesBefore);
+
+		//Welding alone leaves the shuffled order, which the cache passes improve on.
+		Mesh* weldedMesh = CreateUnweldedGrid(100, 22);
+		MeshOptimizer::WeldVertices(weldedMesh);
+		VertexCacheStatistics weldedStatistics = MeshOptimizer::AnalyzeVertexCache(weldedMesh->m_Indices, weldedMesh->m_Positions.size());
+		CrescentCheck(optimizationReport.m_CacheStatisticsAfter.m_ACMR < weldedStatistics.m_ACMR && optimizationReport.m_CacheStatisticsAfter.m_ATVR < weldedStatistics.m_ATVR);
+
+		delete mesh;
+		delete weldedMesh;
+	}
+
+	CrescentTest(MeshOptimizer_VertexFetchFollowsFirstUse)
+	{
+		//Vertex 4 is never referenced.
+		Mesh* mesh = new Mesh;
+		mesh->m_Positions = { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(5.0f), glm::vec3(2.0f, 0.0f, 0.0f) };
+		mesh->m_UV = { glm::vec2(0.0f), glm::vec2(0.1f), glm::vec2(0.2f), glm::vec2(0.3f), glm::vec2(0.4f), glm::vec2(0.5f) };
+		mesh->m_Indices = { 3, 1, 2, 5, 1, 3, 0, 1, 2 };
+		std::vector<TriangleCorners> trianglesBefore = CollectTriangles(mesh);
+
+		MeshOptimizer::OptimizeVertexFetch(mesh);
+		CrescentCheck(mesh->m_Indices == std::vector<unsigned int>({ 0, 1, 2, 3, 1, 0, 4, 1, 2 }));
+		CrescentCheck(mesh->m_Positions.size() == 5 && mesh->m_UV.size() == 5);
+		CrescentCheck(CollectTriangles(mesh) == trianglesBefore);
+
+		//On a larger mesh, every index is either one seen before or the next unused one.
+		Mesh* gridMesh = CreateUnweldedGrid(20, 23);
+		MeshOptimizer::WeldVertices(gridMesh);
+		std::shuffle(gridMesh->m_Indices.begin(), gridMesh->m_Indices.end(), std::mt19937(24));
+		MeshOptimizer::OptimizeVertexFetch(gridMesh);
+		unsigned int nextVertex = 0;
+		bool firstUseOrder = true;
+		for (unsigned int index : gridMesh->m_Indices)
+		{
+			firstUseOrder &= index <= nextVertex;
+			nextVertex += index == nextVertex;
+		}
+		CrescentCheck(firstUseOrder && nextVertex == gridMesh->m_Positions.size());
+
+		delete mesh;
+		delete gridMesh;
+	}
+
+	CrescentTest(MeshOptimizer_LeavesStripsAndUnindexedMeshesAlone)
+	{
+		Mesh* stripMesh = CreateUnweldedGrid(4, 25);
+		stripMesh->m_Topology = TriangleStrips;
+		std::vector<glm::vec3> stripPositions = stripMesh->m_Positions;
+		std::vector<unsigned int> stripIndices = stripMesh->m_Indices;
+		MeshOptimizationReport stripReport = MeshOptimizer::OptimizeMesh(stripMesh);
+		CrescentCheck(stripMesh->m_Positions == stripPositions && stripMesh->m_Indices == stripIndices);
+		CrescentCheck(stripReport.m_VertexCountBefore == stripReport.m_VertexCountAfter);
+
+		Mesh* unindexedMesh = CreateUnweldedGrid(4, 26);
+		unindexedMesh->m_Indices.clear();
+		std::vector<glm::vec3> unindexedPositions = unindexedMesh->m_Positions;
+		MeshOptimizer::OptimizeMesh(unindexedMesh);
+		CrescentCheck(unindexedMesh->m_Positions == unindexedPositions && unindexedMesh->m_Indices.empty());
+
+		delete stripMesh;
+		delete unindexedMesh;
+	}
+}
@@ -0,0 +1,101 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Models/MeshSimplifier.h"
+#include "Models/Mesh.h"
+#include "TestMeshes.h"
+#include <set>
+
+namespace Crescent
+{
+	namespace
+	{
+		bool TrianglesValid(const std::vector<unsigned int>& indices, size_t vertexCount)
+		{
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				if (indices[i] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount ||
+					indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] || indices[i] == indices[i + 2])
+				{
+					return false;
+				}
+			}
+			return indices.size() % 3 == 0;
+		}
+	}
+
+	CrescentTest(MeshSimplifier_LODsShrinkAsErrorGrows)
+	{
+		Mesh* mesh = Tests::CreateSphere(128, 256);
+		std::vector<unsigned int> fullIndices = mesh->m_Indices;
+		MeshSimplifier::GenerateLODs(mesh);
+		CrescentCheck(mesh->m_Indices == fullIndices);
+		CrescentCheck(mesh->m_LODs.size() >= 2 && mesh->m_LODs.size() < MeshSimplifier::m_MaximumLODCount);
+
+		//The sphere's bounds span 2 on every axis.
+		float maximumError = std::sqrt(12.0f) * MeshSimplifier::m_MaximumRelativeError;
+		size_t previousIndexCount = fullIndices.size();
+		float previousError = 0.0f;
+		bool levelsShrink = true;
+		bool errorsGrow = true;
+		bool trianglesValid = true;
+		for (const MeshLOD& meshLOD : mesh->m_LODs)
+		{
+			levelsShrink &= meshLOD.m_Indices.size() <= previousIndexCount * MeshSimplifier::m_MinimumReduction;
+			errorsGrow &= meshLOD.m_GeometricError > previousError && meshLOD.m_GeometricError <= maximumError;
+			trianglesValid &= TrianglesValid(meshLOD.m_Indices, mesh->m_Positions.size());
+			previousIndexCount = meshLOD.m_Indices.size();
+			previousError = meshLOD.m_GeometricError;
+		}
+		CrescentCheck(levelsShrink && errorsGrow && trianglesValid);
+
+		//Strips and unindexed meshes get no levels.
+		mesh->m_Topology = TriangleStrips;
+		MeshSimplifier::GenerateLODs(mesh);
+		CrescentCheck(mesh->m_LODs.empty());
+		mesh->m_Topology = Triangles;
+		mesh->m_Indices.clear();
+		MeshSimplifier::GenerateLODs(mesh);
+		CrescentCheck(mesh->m_LODs.empty());
+
+		delete mesh;
+	}
+
+	CrescentTest(MeshSimplifier_FlatGridKeepsItsBorder)
+	{
+		//Collapses inside a plane cost nothing, while the open border stays locked.
+		const unsigned int gridSize = 32;
+		std::vector<glm::vec3> positions;
+		std::vector<unsigned int> indices;
+		for (unsigned int y = 0; y <= gridSize; y++)
+		{
+			for (unsigned int x = 0; x <= gridSize; x++)
+			{
+				positions.push_back(glm::vec3((float)x, 0.0f, (float)y));
+			}
+		}
+		for (unsigned int y = 0; y < gridSize; y++)
+		{
+			for (unsigned int x = 0; x < gridSize; x++)
+			{
+				unsigned int corner = y * (gridSize + 1) + x;
+				indices.insert(indices.end(), { corner, corner + gridSize + 1, corner + 1, corner + 1, corner + gridSize + 1, corner + gridSize + 2 });
+			}
+		}
+
+		float resultError = -1.0f;
+		std::vector<unsigned int> simplifiedIndices = MeshSimplifier::SimplifyIndices(indices, positions, indices.size() / 4, 0.001f, &resultError);
+		CrescentCheck(simplifiedIndices.size() <= indices.size() / 4 && TrianglesValid(simplifiedIndices, positions.size()));
+		CrescentCheck(resultError >= 0.0f && resultError <= 0.001f);
+
+		std::set<unsigned int> usedVertices(simplifiedIndices.begin(), simplifiedIndices.end());
+		bool borderKept = true;
+		for (unsigned int i = 0; i <= gridSize; i++)
+		{
+			borderKept &= usedVertices.count(i) && usedVertices.count(gridSize * (gridSize + 1) + i) && usedVertices.count(i * (gridSize + 1)) && usedVertices.count(i * (gridSize + 1) + gridSize);
+		}
+		CrescentCheck(borderKept);
+
+		//A zero error budget leaves the indices untouched.
+		CrescentCheck(MeshSimplifier::SimplifyIndices(indices, positions, indices.size() / 4, 0.0f) == indices);
+	}
+}
@@ -0,0 +1,148 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Models/MeshletBuilder.h"
+#include "Models/Mesh.h"
+#include "TestMeshes.h"
+#include <random>
+#include <array>
+#include <algorithm>
+#include <unordered_set>
+
+namespace Crescent
+{
+	namespace
+	{
+		std::vector<std::array<unsigned int, 3>> CollectTriangles(const std::vector<unsigned int>& indices)
+		{
+			std::vector<std::array<unsigned int, 3>> triangles;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				triangles.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		//Meshlets must run back to back over every index, within their limits, each sphere enclosing the meshlet's vertices.
+		bool MeshletsValid(const Mesh* mesh)
+		{
+			size_t nextIndexOffset = 0;
+			for (const Meshlet& meshlet : mesh->m_Meshlets)
+			{
+				if (meshlet.m_IndexOffset != nextIndexOffset || meshlet.m_TriangleCount == 0 || meshlet.m_TriangleCount > MeshletBuilder::m_MaximumTriangles)
+				{
+					return false;
+				}
+				nextIndexOffset += meshlet.m_TriangleCount * 3;
+
+				std::unordered_set<unsigned int> meshletVertices;
+				for (size_t i = meshlet.m_IndexOffset; i < nextIndexOffset; i++)
+				{
+					meshletVertices.insert(mesh->m_Indices[i]);
+					float vertexDistance = glm::length(mesh->m_Positions[mesh->m_Indices[i]] - meshlet.m_BoundingSphere.m_Center);
+					if (vertexDistance > meshlet.m_BoundingSphere.m_Radius * 1.0001f)
+					{
+						return false;
+					}
+				}
+				if (meshletVertices.size() != meshlet.m_VertexCount || meshlet.m_VertexCount > MeshletBuilder::m_MaximumVertices)
+				{
+					return false;
+				}
+			}
+			return nextIndexOffset == mesh->m_Indices.size();
+		}
+
+		//A meshlet culled by its cone from a viewpoint may hold no triangle facing that viewpoint.
+		bool ConesOnlyCullBackFaces(const Mesh* mesh, const std::vector<glm::vec3>& viewpoints)
+		{
+			for (const Meshlet& meshlet : mesh->m_Meshlets)
+			{
+				for (const glm::vec3& viewpoint : viewpoints)
+				{
+					glm::vec3 viewOffset = meshlet.m_BoundingSphere.m_Center - viewpoint;
+					if (glm::dot(viewOffset, meshlet.m_ConeAxis) < meshlet.m_ConeCutoff * glm::length(viewOffset) + meshlet.m_BoundingSphere.m_Radius)
+					{
+						continue;
+					}
+					for (size_t i = meshlet.m_IndexOffset; i < meshlet.m_IndexOffset + meshlet.m_TriangleCount * 3; i += 3)
+					{
+						const glm::vec3& a = mesh->m_Positions[mesh->m_Indices[i]];
+						glm::vec3 normal = glm::normalize(glm::cross(mesh->m_Positions[mesh->m_Indices[i + 1]] - a, mesh->m_Positions[mesh->m_Indices[i + 2]] - a));
+						if (glm::dot(a - viewpoint, normal) < -0.0001f * glm::length(a - viewpoint))
+						{
+							return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	CrescentTest(MeshletBuilder_MeshletsStayWithinLimitsAndBounds)
+	{
+		Mesh* sphereMesh = Tests::CreateSphere(64, 128);
+		std::vector<std::array<unsigned int, 3>> sphereTriangles = CollectTriangles(sphereMesh->m_Indices);
+		MeshletBuilder::BuildMeshlets(sphereMesh);
+		CrescentCheck(MeshletsValid(sphereMesh) && CollectTriangles(sphereMesh->m_Indices) == sphereTriangles);
+
+		//A welded surface shares vertices across triangles, so meshlets fill well beyond a third of the vertex limit.
+		CrescentCheck(sphereMesh->m_Meshlets.size() < sphereTriangles.size() / 60);
+
+		std::mt19937 randomEngine(23);
+		std::uniform_real_distribution<float> coordinateDistribution(-4.0f, 4.0f);
+		std::vector<glm::vec3> viewpoints;
+		for (int i = 0; i < 64; i++)
+		{
+			glm::vec3 viewpoint = glm::vec3(coordinateDistribution(randomEngine), coordinateDistribution(randomEngine), coordinateDistribution(randomEngine));
+			viewpoints.push_back(glm::length(viewpoint) > 1.0f ? viewpoint : glm::normalize(viewpoint) * 2.0f);
+		}
+		CrescentCheck(ConesOnlyCullBackFaces(sphereMesh, viewpoints));
+
+		//A ribbon where each triangle brings one new vertex, so the vertex limit is reached well before the triangle limit.
+		Mesh* ribbonMesh = new Mesh;
+		for (unsigned int i = 0; i < 1002; i++)
+		{
+			ribbonMesh->m_Positions.push_back(glm::vec3((float)(i / 2), 0.0f, (float)(i % 2)));
+		}
+		for (unsigned int i = 0; i < 1000; i++)
+		{
+			ribbonMesh->m_Indices.insert(ribbonMesh->m_Indices.end(), { i, i + 1 + i % 2, i + 2 - i % 2 });
+		}
+		std::vector<std::array<unsigned int, 3>> ribbonTriangles = CollectTriangles(ribbonMesh->m_Indices);
+		MeshletBuilder::BuildMeshlets(ribbonMesh);
+		CrescentCheck(MeshletsValid(ribbonMesh) && CollectTriangles(ribbonMesh->m_Indices) == ribbonTriangles);
+		unsigned int largestVertexCount = 0;
+		for (const Meshlet& meshlet : ribbonMesh->m_Meshlets)
+		{
+			largestVertexCount = std::max(largestVertexCount, meshlet.m_VertexCount);
+		}
+		CrescentCheck(largestVertexCount == MeshletBuilder::m_MaximumVertices);
+
+		//Unconnected triangles never share a meshlet, which would only widen its bounds.
+		Mesh* soupMesh = new Mesh;
+		for (unsigned int i = 0; i < 3000; i++)
+		{
+			soupMesh->m_Positions.push_back(glm::vec3(coordinateDistribution(randomEngine), coordinateDistribution(randomEngine), coordinateDistribution(randomEngine)));
+			soupMesh->m_Indices.push_back(i);
+		}
+		std::vector<std::array<unsigned int, 3>> soupTriangles = CollectTriangles(soupMesh->m_Indices);
+		MeshletBuilder::BuildMeshlets(soupMesh);
+		CrescentCheck(MeshletsValid(soupMesh) && CollectTriangles(soupMesh->m_Indices) == soupTriangles);
+		CrescentCheck(soupMesh->m_Meshlets.size() == 1000);
+
+		//Strips and meshes without indices get no meshlets.
+		soupMesh->m_Topology = TriangleStrips;
+		MeshletBuilder::BuildMeshlets(soupMesh);
+		CrescentCheck(soupMesh->m_Meshlets.empty());
+		soupMesh->m_Topology = Triangles;
+		soupMesh->m_Indices.clear();
+		MeshletBuilder::BuildMeshlets(soupMesh);
+		CrescentCheck(soupMesh->m_Meshlets.empty());
+
+		delete sphereMesh;
+		delete ribbonMesh;
+		delete soupMesh;
+	}
+}
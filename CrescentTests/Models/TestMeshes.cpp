@@ -0,0 +1,43 @@
+#include "CrescentPCH.h"
+#include "TestMeshes.h"
+#include "Models/Mesh.h"
+#include <cmath>
+
+namespace Crescent
+{
+	namespace Tests
+	{
+		Mesh* CreateSphere(unsigned int ringCount, unsigned int segmentCount)
+		{
+			Mesh* mesh = new Mesh;
+			mesh->m_Positions.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+			for (unsigned int ring = 1; ring < ringCount; ring++)
+			{
+				float polarAngle = 3.14159265f * (float)ring / (float)ringCount;
+				for (unsigned int segment = 0; segment < segmentCount; segment++)
+				{
+					float azimuthAngle = 6.2831853f * (float)segment / (float)segmentCount;
+					mesh->m_Positions.push_back(glm::vec3(std::sin(polarAngle) * std::cos(azimuthAngle), std::cos(polarAngle), std::sin(polarAngle) * std::sin(azimuthAngle)));
+				}
+			}
+			mesh->m_Positions.push_back(glm::vec3(0.0f, -1.0f, 0.0f));
+
+			unsigned int southPole = (unsigned int)mesh->m_Positions.size() - 1;
+			for (unsigned int segment = 0; segment < segmentCount; segment++)
+			{
+				unsigned int nextSegment = (segment + 1) % segmentCount;
+				mesh->m_Indices.insert(mesh->m_Indices.end(), { 0, 1 + nextSegment, 1 + segment });
+				for (unsigned int ring = 1; ring + 1 < ringCount; ring++)
+				{
+					unsigned int ringStart = 1 + (ring - 1) * segmentCount;
+					unsigned int nextRingStart = ringStart + segmentCount;
+					mesh->m_Indices.insert(mesh->m_Indices.end(), { ringStart + segment, ringStart + nextSegment, nextRingStart + segment });
+					mesh->m_Indices.insert(mesh->m_Indices.end(), { ringStart + nextSegment, nextRingStart + nextSegment, nextRingStart + segment });
+				}
+				unsigned int lastRingStart = 1 + (ringCount - 2) * segmentCount;
+				mesh->m_Indices.insert(mesh->m_Indices.end(), { lastRingStart + segment, lastRingStart + nextSegment, southPole });
+			}
+			return mesh;
+		}
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace Crescent
+{
+	class Mesh;
+
+	namespace Tests
+	{
+		//A closed unit sphere of welded vertices, with a single vertex at either pole. The caller owns the returned mesh.
+		Mesh* CreateSphere(unsigned int ringCount, unsigned int segmentCount);
+	}
+}
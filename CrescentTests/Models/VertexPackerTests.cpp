@@ -0,0 +1,395 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Models/VertexPacker.h"
+#include "Models/MeshBuilder.h"
+#include "Models/Mesh.h"
+#include <glm/gtc/packing.hpp>
+#include <random>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+
+namespace Crescent
+{
+	namespace
+	{
+		glm::vec3 RandomDirection(std::mt19937& randomEngine)
+		{
+			std::normal_distribution<float> componentDistribution(0.0f, 1.0f);
+			glm::vec3 direction;
+			do
+			{
+				direction = glm::vec3(componentDistribution(randomEngine), componentDistribution(randomEngine), componentDistribution(randomEngine));
+			} while (glm::dot(direction, direction) < 1e-4f);
+			return glm::normalize(direction);
+		}
+
+		//A vertex as packed by glm one at a time, which is how meshes were packed before the vertex packer.
+		void PackVertexWithGlm(const Mesh* mesh, const PackedVertexLayout& vertexLayout, const glm::vec3& positionOffset, const glm::vec3& inversePositionScale,
+			size_t vertexIndex, uint8_t* vertexData)
+		{
+			if (vertexLayout.m_QuantizedPositions)
+			{
+				uint64_t position = glm::packUnorm4x16(glm::vec4((mesh->m_Positions[vertexIndex] - positionOffset) * inversePositionScale, 0.0f));
+				std::memcpy(vertexData, &position, sizeof(position));
+			}
+			else
+			{
+				std::memcpy(vertexData, &mesh->m_Positions[vertexIndex], sizeof(glm::vec3));
+			}
+			vertexData += vertexLayout.RetrievePositionSize();
+
+			if (vertexLayout.m_HasUV)
+			{
+				uint32_t uv = glm::packHalf2x16(mesh->m_UV[vertexIndex]);
+				std::memcpy(vertexData, &uv, sizeof(uv));
+				vertexData += sizeof(uv);
+			}
+			if (vertexLayout.m_HasNormals)
+			{
+				uint32_t normal = glm::packSnorm2x16(VertexPacker::EncodeOctahedral(mesh->m_Normals[vertexIndex]));
+				std::memcpy(vertexData, &normal, sizeof(normal));
+				vertexData += sizeof(normal);
+			}
+			if (vertexLayout.m_HasTangents)
+			{
+				float bitangentSign = 1.0f;
+				if (!mesh->m_Bitangents.empty() && !mesh->m_Normals.empty() &&
+					glm::dot(glm::cross(mesh->m_Normals[vertexIndex], mesh->m_Tangents[vertexIndex]), mesh->m_Bitangents[vertexIndex]) < 0.0f)
+				{
+					bitangentSign = -1.0f;
+				}
+				uint64_t tangent = glm::packSnorm4x16(glm::vec4(VertexPacker::EncodeOctahedral(mesh->m_Tangents[vertexIndex]), bitangentSign, 0.0f));
+				std::memcpy(vertexData, &tangent, sizeof(tangent));
+			}
+		}
+
+		//Flat axes map every position onto the box's minimum, as they do in the packer.
+		glm::vec3 RetrieveInversePositionScale(const glm::vec3& positionScale)
+		{
+			glm::vec3 inversePositionScale = glm::vec3(0.0f);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				inversePositionScale[axis] = positionScale[axis] > 0.0f ? 1.0f / positionScale[axis] : 0.0f;
+			}
+			return inversePositionScale;
+		}
+
+		//Quantized positions may differ from glm's by 1, all other bytes must be equal.
+		bool PackedVerticesMatch(const uint8_t* packedVertices, const uint8_t* referenceVertices, size_t vertexCount, const PackedVertexLayout& vertexLayout)
+		{
+			const size_t stride = vertexLayout.RetrieveStride();
+			const size_t positionSize = vertexLayout.RetrievePositionSize();
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				const uint8_t* packedVertex = packedVertices + i * stride;
+				const uint8_t* referenceVertex = referenceVertices + i * stride;
+				if (vertexLayout.m_QuantizedPositions)
+				{
+					uint16_t packedPosition[4], referencePosition[4];
+					std::memcpy(packedPosition, packedVertex, sizeof(packedPosition));
+					std::memcpy(referencePosition, referenceVertex, sizeof(referencePosition));
+					for (int axis = 0; axis < 4; axis++)
+					{
+						if (std::abs((int)packedPosition[axis] - (int)referencePosition[axis]) > 1)
+						{
+							return false;
+						}
+					}
+				}
+				else if (std::memcmp(packedVertex, referenceVertex, positionSize) != 0)
+				{
+					return false;
+				}
+
+				if (std::memcmp(packedVertex + positionSize, referenceVertex + positionSize, stride - positionSize) != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Flat arrays as an importer hands them over, with UVs stored as 3 components and faces as index triplets.
+		struct SyntheticImport
+		{
+			std::vector<glm::vec3> m_Positions;
+			std::vector<glm::vec3> m_TextureCoordinates;
+			std::vector<glm::vec3> m_Normals;
+			std::vector<glm::vec3> m_Tangents;
+			std::vector<glm::vec3> m_Bitangents;
+			std::vector<unsigned int> m_FaceIndices;
+		};
+
+		void GenerateSyntheticImport(SyntheticImport& syntheticImport, size_t vertexCount)
+		{
+			std::mt19937 randomEngine(25);
+			std::uniform_real_distribution<float> positionDistribution(-40.0f, 40.0f);
+			std::uniform_real_distribution<float> uvDistribution(0.0f, 1.0f);
+			syntheticImport.m_Positions.resize(vertexCount);
+			syntheticImport.m_TextureCoordinates.resize(vertexCount);
+			syntheticImport.m_Normals.resize(vertexCount);
+			syntheticImport.m_Tangents.resize(vertexCount);
+			syntheticImport.m_Bitangents.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				syntheticImport.m_Positions[i] = glm::vec3(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine));
+				syntheticImport.m_TextureCoordinates[i] = glm::vec3(uvDistribution(randomEngine), uvDistribution(randomEngine), 0.0f);
+				syntheticImport.m_Normals[i] = RandomDirection(randomEngine);
+				syntheticImport.m_Tangents[i] = glm::normalize(glm::cross(syntheticImport.m_Normals[i], RandomDirection(randomEngine)));
+				syntheticImport.m_Bitangents[i] = glm::cross(syntheticImport.m_Normals[i], syntheticImport.m_Tangents[i]) * ((i % 7) == 0 ? -1.0f : 1.0f);
+			}
+
+			//Every triangle has vertices of its own, as importers leave them before any welding.
+			syntheticImport.m_FaceIndices.resize(vertexCount - vertexCount % 3);
+			for (size_t i = 0; i < syntheticImport.m_FaceIndices.size(); i++)
+			{
+				syntheticImport.m_FaceIndices[i] = (unsigned int)i;
+			}
+		}
+	}
+
+	CrescentTest(VertexPacker_MatchesGlmPacking)
+	{
+		//Not a multiple of 4, so the last vertices go through the scalar path.
+		const size_t vertexCount = 1003;
+		std::mt19937 randomEngine(7);
+		std::uniform_real_distribution<float> positionDistribution(-20.0f, 30.0f);
+		std::uniform_real_distribution<float> uvDistribution(-2.0f, 3.0f);
+
+		Mesh* fullMesh = new Mesh;
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			fullMesh->m_Positions.push_back(glm::vec3(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine)));
+			fullMesh->m_UV.push_back(glm::vec2(uvDistribution(randomEngine), uvDistribution(randomEngine)));
+			fullMesh->m_Normals.push_back(RandomDirection(randomEngine));
+			fullMesh->m_Tangents.push_back(RandomDirection(randomEngine));
+			float handedness = (randomEngine() & 1) ? 1.0f : -1.0f;
+			fullMesh->m_Bitangents.push_back(glm::cross(fullMesh->m_Normals.back(), fullMesh->m_Tangents.back()) * handedness);
+		}
+
+		//UVs on either side of half's limits and rounding points, some in batches and some in the tail. Denormal, infinite and NaN halves are left to glm.
+		const float specialValues[] = { 0.0f, -0.0f, 1.0f, -1.0f, 1e-6f, -3e-5f, 6.1035156e-5f, 6.09e-5f, 65504.0f, 65519.0f, 65520.0f, 70000.0f, -1e9f,
+			1.00048828125f, 1.00146484375f, 2049.0f, 2051.0f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN() };
+		const size_t specialValueCount = sizeof(specialValues) / sizeof(specialValues[0]);
+		for (size_t i = 0; i < specialValueCount; i++)
+		{
+			fullMesh->m_UV[i * 3] = glm::vec2(specialValues[i], 0.5f);
+			fullMesh->m_UV[i * 3 + 1] = glm::vec2(0.25f, specialValues[specialValueCount - 1 - i]);
+		}
+		fullMesh->m_UV[vertexCount - 1] = glm::vec2(specialValues[4], specialValues[8]);
+		fullMesh->m_UV[vertexCount - 2] = glm::vec2(specialValues[12], specialValues[2]);
+
+		//Directions lying on the octahedron's edges and folds, along with zero vectors and bitangents.
+		const glm::vec3 specialDirections[] = { glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f), glm::normalize(glm::vec3(1.0f, -1.0f, -1.0f)), glm::normalize(glm::vec3(-1.0f, 1.0f, 0.0f)), glm::vec3(0.0f, 0.0f, -0.0f) };
+		const size_t specialDirectionCount = sizeof(specialDirections) / sizeof(specialDirections[0]);
+		for (size_t i = 0; i < specialDirectionCount; i++)
+		{
+			fullMesh->m_Normals[100 + i] = specialDirections[i];
+			fullMesh->m_Tangents[200 + i] = specialDirections[i];
+			fullMesh->m_Normals[vertexCount - 1 - i % 3] = specialDirections[i];
+		}
+		fullMesh->m_Bitangents[300] = glm::vec3(0.0f);
+
+		//Every combination of attributes, with and without quantization, and with an axis along which the mesh is flat.
+		bool packingsMatch = true;
+		for (int attributeMask = 0; attributeMask < 8; attributeMask++)
+		{
+			for (int flatMesh = 0; flatMesh < 2; flatMesh++)
+			{
+				Mesh* mesh = new Mesh;
+				mesh->m_Positions = fullMesh->m_Positions;
+				if (attributeMask & 1) mesh->m_UV = fullMesh->m_UV;
+				if (attributeMask & 2) mesh->m_Normals = fullMesh->m_Normals;
+				if (attributeMask & 4) mesh->m_Tangents = fullMesh->m_Tangents;
+				if (attributeMask & 6) mesh->m_Bitangents = fullMesh->m_Bitangents;
+				if (flatMesh)
+				{
+					for (glm::vec3& position : mesh->m_Positions)
+					{
+						position.y = 4.0f;
+					}
+				}
+				mesh->CalculateBounds();
+
+				for (int quantizedPositions = 0; quantizedPositions < 2; quantizedPositions++)
+				{
+					PackedVertexLayout vertexLayout = VertexPacker::RetrievePackedLayout(mesh, quantizedPositions != 0);
+					glm::vec3 positionOffset = glm::vec3(0.0f);
+					glm::vec3 positionScale = glm::vec3(1.0f);
+					if (quantizedPositions)
+					{
+						positionOffset = mesh->RetrieveLocalBoundingBox().m_Minimum;
+						positionScale = mesh->RetrieveLocalBoundingBox().m_Maximum - mesh->RetrieveLocalBoundingBox().m_Minimum;
+					}
+
+					std::vector<uint8_t> packedVertices(VertexPacker::RetrievePackedSize(mesh, vertexLayout), 0xCD);
+					VertexPacker::PackVertices(mesh, vertexLayout, positionOffset, positionScale, packedVertices.data());
+
+					std::vector<uint8_t> referenceVertices(packedVertices.size(), 0xCD);
+					glm::vec3 inversePositionScale = RetrieveInversePositionScale(positionScale);
+					for (size_t i = 0; i < vertexCount; i++)
+					{
+						PackVertexWithGlm(mesh, vertexLayout, positionOffset, inversePositionScale, i, referenceVertices.data() + i * vertexLayout.RetrieveStride());
+					}
+					packingsMatch &= PackedVerticesMatch(packedVertices.data(), referenceVertices.data(), vertexCount, vertexLayout);
+				}
+				delete mesh;
+			}
+		}
+		CrescentCheck(packingsMatch);
+		delete fullMesh;
+	}
+
+	CrescentTest(VertexPacker_NarrowsEveryLevelsIndices)
+	{
+		std::mt19937 randomEngine(11);
+		std::uniform_int_distribution<unsigned int> indexDistribution(0, 65535);
+		Mesh* mesh = new Mesh;
+		mesh->m_Indices.resize(1001);
+		mesh->m_LODs.resize(2);
+		mesh->m_LODs[0].m_Indices.resize(37);
+		mesh->m_LODs[1].m_Indices.resize(8);
+
+		std::vector<unsigned int> expectedIndices;
+		for (std::vector<unsigned int>* indices : { &mesh->m_Indices, &mesh->m_LODs[0].m_Indices, &mesh->m_LODs[1].m_Indices })
+		{
+			for (unsigned int& index : *indices)
+			{
+				index = indexDistribution(randomEngine);
+				expectedIndices.push_back(index);
+			}
+		}
+		mesh->m_Indices[0] = 65535;
+		expectedIndices[0] = 65535;
+		CrescentCheck(VertexPacker::RetrieveIndexCount(mesh) == expectedIndices.size());
+
+		std::vector<uint16_t> shortIndices(expectedIndices.size() + 1, 0xCDCD);
+		VertexPacker::PackIndices(mesh, true, (uint8_t*)shortIndices.data());
+		std::vector<unsigned int> longIndices(expectedIndices.size() + 1, 0xCDCDCDCD);
+		VertexPacker::PackIndices(mesh, false, (uint8_t*)longIndices.data());
+
+		bool indicesMatch = true;
+		for (size_t i = 0; i < expectedIndices.size(); i++)
+		{
+			indicesMatch &= shortIndices[i] == (uint16_t)expectedIndices[i] && longIndices[i] == expectedIndices[i];
+		}
+		CrescentCheck(indicesMatch);
+		CrescentCheck(shortIndices.back() == 0xCDCD && longIndices.back() == 0xCDCDCDCD);
+		delete mesh;
+	}
+
+	CrescentBenchmark(VertexPacker_IngestAgainstCopyingPath)
+	{
+		//From the importer's arrays to bytes in a GPU buffer, with the buffer stood in for by memory written once per run.
+		const size_t vertexCount = 10000000;
+		SyntheticImport syntheticImport;
+		GenerateSyntheticImport(syntheticImport, vertexCount);
+		const size_t indexCount = syntheticImport.m_FaceIndices.size();
+		const PackedVertexLayout ingestLayout = { true, true, true, true };
+		const size_t stride = ingestLayout.RetrieveStride();
+
+		//Previously, arrays were filled element by element, copied into the mesh, packed vertex by vertex into a staging block and then uploaded.
+		std::vector<uint8_t> copiedVertexBuffer(vertexCount * stride);
+		std::vector<unsigned int> copiedIndexBuffer(indexCount);
+		double copyingTime = Tests::MeasureMilliseconds([&]()
+		{
+			std::vector<glm::vec3> positions(vertexCount), normals(vertexCount), tangents(vertexCount), bitangents(vertexCount);
+			std::vector<glm::vec2> uv(vertexCount);
+			std::vector<unsigned int> indices(indexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				positions[i] = glm::vec3(syntheticImport.m_Positions[i].x, syntheticImport.m_Positions[i].y, syntheticImport.m_Positions[i].z);
+				normals[i] = glm::vec3(syntheticImport.m_Normals[i].x, syntheticImport.m_Normals[i].y, syntheticImport.m_Normals[i].z);
+				uv[i] = glm::vec2(syntheticImport.m_TextureCoordinates[i].x, syntheticImport.m_TextureCoordinates[i].y);
+				tangents[i] = glm::vec3(syntheticImport.m_Tangents[i].x, syntheticImport.m_Tangents[i].y, syntheticImport.m_Tangents[i].z);
+				bitangents[i] = glm::vec3(syntheticImport.m_Bitangents[i].x, syntheticImport.m_Bitangents[i].y, syntheticImport.m_Bitangents[i].z);
+			}
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				indices[i] = syntheticImport.m_FaceIndices[i];
+			}
+
+			Mesh* mesh = new Mesh;
+			mesh->m_Positions = positions;
+			mesh->m_UV = uv;
+			mesh->m_Normals = normals;
+			mesh->m_Tangents = tangents;
+			mesh->m_Bitangents = bitangents;
+			mesh->m_Indices = indices;
+			mesh->CalculateBounds();
+
+			PackedVertexLayout vertexLayout = VertexPacker::RetrievePackedLayout(mesh, true);
+			glm::vec3 positionOffset = mesh->RetrieveLocalBoundingBox().m_Minimum;
+			glm::vec3 inversePositionScale = RetrieveInversePositionScale(mesh->RetrieveLocalBoundingBox().m_Maximum - positionOffset);
+			std::vector<uint8_t> bufferData(vertexCount * stride);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				PackVertexWithGlm(mesh, vertexLayout, positionOffset, inversePositionScale, i, bufferData.data() + i * stride);
+			}
+			std::memcpy(copiedVertexBuffer.data(), bufferData.data(), bufferData.size());
+			std::memcpy(copiedIndexBuffer.data(), mesh->m_Indices.data(), indexCount * sizeof(unsigned int));
+			delete mesh;
+		}, 3);
+
+		//Now, arrays are copied in bulk into a builder whose storage the mesh takes over, and packed straight into the buffer.
+		std::vector<uint8_t> packedVertexBuffer(vertexCount * stride);
+		std::vector<unsigned int> packedIndexBuffer(indexCount);
+		double packingTime = Tests::MeasureMilliseconds([&]()
+		{
+			MeshBuilder meshBuilder(vertexCount, indexCount, true, true, true);
+			std::memcpy(meshBuilder.RetrievePositions(), syntheticImport.m_Positions.data(), vertexCount * sizeof(glm::vec3));
+			std::memcpy(meshBuilder.RetrieveNormals(), syntheticImport.m_Normals.data(), vertexCount * sizeof(glm::vec3));
+			std::memcpy(meshBuilder.RetrieveTangents(), syntheticImport.m_Tangents.data(), vertexCount * sizeof(glm::vec3));
+			std::memcpy(meshBuilder.RetrieveBitangents(), syntheticImport.m_Bitangents.data(), vertexCount * sizeof(glm::vec3));
+			glm::vec2* uv = meshBuilder.RetrieveUV();
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				uv[i] = glm::vec2(syntheticImport.m_TextureCoordinates[i].x, syntheticImport.m_TextureCoordinates[i].y);
+			}
+			unsigned int* indices = meshBuilder.RetrieveIndices();
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				indices[i] = syntheticImport.m_FaceIndices[i];
+			}
+
+			Mesh* mesh = meshBuilder.BuildMesh();
+			mesh->CalculateBounds();
+			PackedVertexLayout vertexLayout = VertexPacker::RetrievePackedLayout(mesh, true);
+			glm::vec3 positionOffset = mesh->RetrieveLocalBoundingBox().m_Minimum;
+			VertexPacker::PackVertices(mesh, vertexLayout, positionOffset, mesh->RetrieveLocalBoundingBox().m_Maximum - positionOffset, packedVertexBuffer.data());
+			VertexPacker::PackIndices(mesh, false, (uint8_t*)packedIndexBuffer.data());
+			delete mesh;
+		}, 3);
+
+		CrescentCheck(PackedVerticesMatch(packedVertexBuffer.data(), copiedVertexBuffer.data(), vertexCount, ingestLayout));
+		CrescentCheck(packedIndexBuffer == copiedIndexBuffer);
+		Tests::ReportTimings(std::to_string(vertexCount) + " quantized vertices with UVs, normals and tangents", copyingTime, packingTime);
+
+		//Meshes under 65536 vertices had their indices narrowed into a temporary array before being uploaded.
+		Mesh* shortIndexMesh = new Mesh;
+		shortIndexMesh->m_Indices.resize(indexCount);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			shortIndexMesh->m_Indices[i] = syntheticImport.m_FaceIndices[i] & 0xFFFF;
+		}
+		std::vector<uint16_t> copiedShortIndexBuffer(indexCount);
+		double narrowingCopyTime = Tests::MeasureMilliseconds([&]()
+		{
+			std::vector<uint16_t> shortIndices;
+			shortIndices.assign(shortIndexMesh->m_Indices.begin(), shortIndexMesh->m_Indices.end());
+			std::memcpy(copiedShortIndexBuffer.data(), shortIndices.data(), indexCount * sizeof(uint16_t));
+		});
+
+		std::vector<uint16_t> packedShortIndexBuffer(indexCount);
+		double narrowingPackTime = Tests::MeasureMilliseconds([&]()
+		{
+			VertexPacker::PackIndices(shortIndexMesh, true, (uint8_t*)packedShortIndexBuffer.data());
+		});
+
+		CrescentCheck(packedShortIndexBuffer == copiedShortIndexBuffer);
+		Tests::ReportTimings(std::to_string(indexCount) + " indices narrowed to 16 bits", narrowingCopyTime, narrowingPackTime);
+		delete shortIndexMesh;
+	}
+}
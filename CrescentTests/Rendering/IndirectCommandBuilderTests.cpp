@@ -0,0 +1,105 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/IndirectCommandBuilder.h"
+
+namespace Crescent
+{
+	namespace
+	{
+		//A mesh's level of detail as the renderer finds it, with indices following the mesh's first index in the pool.
+		struct TestMeshLOD
+		{
+			uint32_t m_BaseVertex;
+			uint32_t m_FirstIndex;
+			uint32_t m_LODIndexOffset;
+			uint32_t m_IndexCount;
+		};
+
+		DrawElementsIndirectCommand CreateDrawCommand(const TestMeshLOD& meshLOD, uint32_t baseInstance, uint32_t instanceCount)
+		{
+			DrawElementsIndirectCommand drawCommand;
+			drawCommand.m_IndexCount = meshLOD.m_IndexCount;
+			drawCommand.m_InstanceCount = instanceCount;
+			drawCommand.m_FirstIndex = meshLOD.m_FirstIndex + meshLOD.m_LODIndexOffset;
+			drawCommand.m_BaseVertex = (int32_t)meshLOD.m_BaseVertex;
+			drawCommand.m_BaseInstance = baseInstance;
+			return drawCommand;
+		}
+
+		bool CommandsMatch(const DrawElementsIndirectCommand& drawCommand, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t baseInstance)
+		{
+			return drawCommand.m_IndexCount == indexCount && drawCommand.m_InstanceCount == instanceCount && drawCommand.m_FirstIndex == firstIndex &&
+				drawCommand.m_BaseVertex == baseVertex && drawCommand.m_BaseInstance == baseInstance;
+		}
+	}
+
+	CrescentTest(IndirectCommandBuilder_MixedLODsAndBaseVertices)
+	{
+		//Handles are never dereferenced by the builder, only compared.
+		Material* firstMaterial = (Material*)0x10;
+		Material* secondMaterial = (Material*)0x20;
+		GeometryPool* firstPool = (GeometryPool*)0x100;
+		GeometryPool* secondPool = (GeometryPool*)0x200;
+		Mesh* firstMesh = (Mesh*)0x1000;
+		Mesh* secondMesh = (Mesh*)0x2000;
+
+		//Two meshes sharing a pool, the second placed behind the first. Their levels of detail follow their full resolution indices.
+		TestMeshLOD firstMeshLODs[2] = { { 0, 0, 0, 300 }, { 0, 0, 300, 120 } };
+		TestMeshLOD secondMeshLODs[2] = { { 500, 420, 0, 900 }, { 500, 420, 900, 240 } };
+
+		IndirectCommandBuilder commandBuilder;
+		commandBuilder.PushDraw(firstMaterial, firstMesh, firstPool, CreateDrawCommand(firstMeshLODs[0], 0, 2));
+		commandBuilder.PushDraw(firstMaterial, firstMesh, firstPool, CreateDrawCommand(firstMeshLODs[0], 2, 3)); //Continues the previous instances.
+		commandBuilder.PushDraw(firstMaterial, firstMesh, firstPool, CreateDrawCommand(firstMeshLODs[1], 5, 1)); //Same mesh, coarser level.
+		commandBuilder.PushDraw(firstMaterial, secondMesh, firstPool, CreateDrawCommand(secondMeshLODs[1], 6, 4));
+		commandBuilder.PushDraw(firstMaterial, secondMesh, firstPool, CreateDrawCommand(secondMeshLODs[1], 11, 1)); //Gap in instances.
+		commandBuilder.PushDraw(firstMaterial, secondMesh, firstPool, CreateDrawCommand(secondMeshLODs[0], 12, 0)); //Empty, dropped.
+		commandBuilder.PushDraw(secondMaterial, secondMesh, firstPool, CreateDrawCommand(secondMeshLODs[0], 12, 1));
+		commandBuilder.PushDraw(secondMaterial, firstMesh, secondPool, CreateDrawCommand(firstMeshLODs[0], 13, 1));
+
+		const std::vector<DrawElementsIndirectCommand>& drawCommands = commandBuilder.RetrieveCommands();
+		const std::vector<IndirectDrawGroup>& drawGroups = commandBuilder.RetrieveGroups();
+		CrescentCheck(drawCommands.size() == 6);
+		CrescentCheck(drawGroups.size() == 3);
+		if (drawCommands.size() != 6 || drawGroups.size() != 3)
+		{
+			return;
+		}
+
+		CrescentCheck(CommandsMatch(drawCommands[0], 300, 5, 0, 0, 0));
+		CrescentCheck(CommandsMatch(drawCommands[1], 120, 1, 300, 0, 5));
+		CrescentCheck(CommandsMatch(drawCommands[2], 240, 4, 1320, 500, 6));
+		CrescentCheck(CommandsMatch(drawCommands[3], 240, 1, 1320, 500, 11));
+		CrescentCheck(CommandsMatch(drawCommands[4], 900, 1, 420, 500, 12));
+		CrescentCheck(CommandsMatch(drawCommands[5], 300, 1, 0, 0, 13));
+
+		CrescentCheck(drawGroups[0].m_Material == firstMaterial && drawGroups[0].m_GeometryPool == firstPool && drawGroups[0].m_Mesh == firstMesh);
+		CrescentCheck(drawGroups[0].m_FirstCommand == 0 && drawGroups[0].m_CommandCount == 4);
+		CrescentCheck(drawGroups[1].m_Material == secondMaterial && drawGroups[1].m_GeometryPool == firstPool && drawGroups[1].m_Mesh == secondMesh);
+		CrescentCheck(drawGroups[1].m_FirstCommand == 4 && drawGroups[1].m_CommandCount == 1);
+		CrescentCheck(drawGroups[2].m_GeometryPool == secondPool && drawGroups[2].m_FirstCommand == 5 && drawGroups[2].m_CommandCount == 1);
+
+		commandBuilder.Clear();
+		CrescentCheck(commandBuilder.RetrieveCommands().empty() && commandBuilder.RetrieveGroups().empty());
+	}
+
+	CrescentTest(IndirectCommandBuilder_MeshletRangesShareAnInstance)
+	{
+		//Visible meshlet ranges of a lone mesh each become a command drawing the same single instance, and are never folded together.
+		IndirectCommandBuilder commandBuilder;
+		TestMeshLOD meshletRanges[3] = { { 64, 1000, 0, 372 }, { 64, 1000, 744, 372 }, { 64, 1000, 1488, 120 } };
+		for (const TestMeshLOD& meshletRange : meshletRanges)
+		{
+			commandBuilder.PushDraw((Material*)0x10, (Mesh*)0x1000, (GeometryPool*)0x100, CreateDrawCommand(meshletRange, 7, 1));
+		}
+
+		const std::vector<DrawElementsIndirectCommand>& drawCommands = commandBuilder.RetrieveCommands();
+		CrescentCheck(drawCommands.size() == 3 && commandBuilder.RetrieveGroups().size() == 1);
+		if (drawCommands.size() == 3)
+		{
+			CrescentCheck(CommandsMatch(drawCommands[0], 372, 1, 1000, 64, 7));
+			CrescentCheck(CommandsMatch(drawCommands[1], 372, 1, 1744, 64, 7));
+			CrescentCheck(CommandsMatch(drawCommands[2], 120, 1, 2488, 64, 7));
+		}
+	}
+}
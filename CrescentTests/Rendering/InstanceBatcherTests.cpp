@@ -0,0 +1,123 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/InstanceBatcher.h"
+#include "Models/Mesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace Crescent
+{
+	namespace
+	{
+		struct ExpectedBatch
+		{
+			uint32_t m_FirstCommand;
+			uint32_t m_InstanceCount;
+		};
+
+		bool BatchesMatch(const std::vector<InstanceBatch>& instanceBatches, const std::vector<ExpectedBatch>& expectedBatches)
+		{
+			if (instanceBatches.size() != expectedBatches.size())
+			{
+				return false;
+			}
+			for (size_t i = 0; i < instanceBatches.size(); i++)
+			{
+				if (instanceBatches[i].m_FirstCommand != expectedBatches[i].m_FirstCommand || instanceBatches[i].m_InstanceCount != expectedBatches[i].m_InstanceCount)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//Every batch's instances must sit at its first command's index onwards, in command order, carrying their own mesh's dequantization.
+		bool InstanceDataMatches(const RenderCommandList& renderCommands, const std::vector<InstanceBatch>& instanceBatches, const std::vector<InstanceData>& instanceData)
+		{
+			if (instanceData.size() != renderCommands.size())
+			{
+				return false;
+			}
+			for (const InstanceBatch& instanceBatch : instanceBatches)
+			{
+				for (uint32_t i = 0; i < instanceBatch.m_InstanceCount; i++)
+				{
+					const RenderCommand& renderCommand = renderCommands[instanceBatch.m_FirstCommand + i];
+					const InstanceData& instance = instanceData[instanceBatch.m_FirstCommand + i];
+					if (instance.m_Transform != renderCommand.m_Transform || instance.m_PositionOffset != glm::vec4(renderCommand.m_Mesh->RetrievePositionOffset(), 0.0f) ||
+						instance.m_PositionScale != glm::vec4(renderCommand.m_Mesh->RetrievePositionScale(), 0.0f))
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	CrescentTest(InstanceBatcher_BatchesAdjacentCommands)
+	{
+		//Two quantized meshes with different bounds and one float mesh, whose positions need no dequantizing.
+		Mesh firstMesh({ glm::vec3(-1.0f), glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(1.0f) }, { 0, 1, 2 });
+		Mesh secondMesh({ glm::vec3(2.0f, 0.0f, -4.0f), glm::vec3(6.0f, 1.0f, 0.0f), glm::vec3(3.0f, 8.0f, -1.0f) }, { 0, 1, 2 });
+		Mesh floatMesh({ glm::vec3(-5.0f), glm::vec3(5.0f, -5.0f, 5.0f), glm::vec3(5.0f) }, { 0, 1, 2 });
+		for (Mesh* mesh : { &firstMesh, &secondMesh, &floatMesh })
+		{
+			mesh->CalculateBounds();
+		}
+		firstMesh.ConfigureVertexFormat(VertexFormat_Quantized);
+		secondMesh.ConfigureVertexFormat(VertexFormat_Quantized);
+		floatMesh.ConfigureVertexFormat(VertexFormat_Float);
+		CrescentCheck(firstMesh.RetrievePositionOffset() == glm::vec3(-1.0f) && firstMesh.RetrievePositionScale() == glm::vec3(2.0f));
+		CrescentCheck(secondMesh.RetrievePositionOffset() == glm::vec3(2.0f, 0.0f, -4.0f) && secondMesh.RetrievePositionScale() == glm::vec3(4.0f, 8.0f, 4.0f));
+
+		//Handles are never dereferenced by the batcher, only compared.
+		Material* firstMaterial = (Material*)0x10;
+		Material* secondMaterial = (Material*)0x20;
+
+		//As sorted by the render queue: a run at LOD 0, the same mesh at LOD 1 under two materials, another mesh, the float mesh, and a repeat of
+		//the first run that isn't adjacent to it.
+		struct CommandState { Mesh* m_Mesh; Material* m_Material; unsigned int m_LODIndex; };
+		const CommandState commandStates[] = {
+			{ &firstMesh, firstMaterial, 0 }, { &firstMesh, firstMaterial, 0 }, { &firstMesh, firstMaterial, 0 },
+			{ &firstMesh, firstMaterial, 1 }, { &firstMesh, firstMaterial, 1 }, { &firstMesh, secondMaterial, 1 },
+			{ &secondMesh, secondMaterial, 1 }, { &secondMesh, secondMaterial, 1 },
+			{ &floatMesh, firstMaterial, 0 },
+			{ &firstMesh, firstMaterial, 0 } };
+		const size_t commandCount = sizeof(commandStates) / sizeof(commandStates[0]);
+
+		std::vector<RenderCommand> commandStorage(commandCount);
+		std::vector<RenderCommand*> commandPointers(commandCount);
+		for (size_t i = 0; i < commandCount; i++)
+		{
+			commandStorage[i].m_Mesh = commandStates[i].m_Mesh;
+			commandStorage[i].m_Material = commandStates[i].m_Material;
+			commandStorage[i].m_LODIndex = commandStates[i].m_LODIndex;
+			commandStorage[i].m_Transform = glm::translate(glm::mat4(1.0f), glm::vec3((float)i, 0.0f, -(float)i));
+			commandPointers[i] = &commandStorage[i];
+		}
+		RenderCommandList renderCommands;
+		renderCommands.m_Commands = commandPointers.data();
+		renderCommands.m_CommandCount = commandCount;
+
+		std::vector<InstanceBatch> instanceBatches;
+		std::vector<InstanceData> instanceData;
+		InstanceBatcher::FormInstanceBatches(renderCommands, true, instanceBatches, instanceData);
+		CrescentCheck(BatchesMatch(instanceBatches, { { 0, 3 }, { 3, 2 }, { 5, 1 }, { 6, 2 }, { 8, 1 }, { 9, 1 } }));
+		CrescentCheck(InstanceDataMatches(renderCommands, instanceBatches, instanceData));
+
+		//Depth only passes ignore materials, merging the LOD 1 run across both.
+		InstanceBatcher::FormInstanceBatches(renderCommands, false, instanceBatches, instanceData);
+		CrescentCheck(BatchesMatch(instanceBatches, { { 0, 3 }, { 3, 3 }, { 6, 2 }, { 8, 1 }, { 9, 1 } }));
+		CrescentCheck(InstanceDataMatches(renderCommands, instanceBatches, instanceData));
+
+		//Outputs are reused across calls, leaving nothing behind from the previous list.
+		renderCommands.m_CommandCount = 4;
+		InstanceBatcher::FormInstanceBatches(renderCommands, true, instanceBatches, instanceData);
+		CrescentCheck(BatchesMatch(instanceBatches, { { 0, 3 }, { 3, 1 } }));
+		CrescentCheck(InstanceDataMatches(renderCommands, instanceBatches, instanceData));
+
+		renderCommands.m_CommandCount = 0;
+		InstanceBatcher::FormInstanceBatches(renderCommands, true, instanceBatches, instanceData);
+		CrescentCheck(instanceBatches.empty() && instanceData.empty());
+	}
+}
@@ -0,0 +1,144 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/LightBVH.h"
+#include "../Utilities/TestFrustums.h"
+#include <random>
+#include <algorithm>
+
+namespace Crescent
+{
+	namespace
+	{
+		//Point lights scattered across a 1 km wide level, with radii from lamps to floodlights.
+		std::vector<BoundingSphere> GenerateLightSpheres(size_t lightCount, std::mt19937& randomEngine)
+		{
+			std::uniform_real_distribution<float> planarDistribution(-500.0f, 500.0f);
+			std::uniform_real_distribution<float> heightDistribution(0.0f, 30.0f);
+			std::uniform_real_distribution<float> radiusDistribution(1.0f, 25.0f);
+			std::vector<BoundingSphere> lightSpheres(lightCount);
+			for (BoundingSphere& lightSphere : lightSpheres)
+			{
+				lightSphere.m_Center = glm::vec3(planarDistribution(randomEngine), heightDistribution(randomEngine), planarDistribution(randomEngine));
+				lightSphere.m_Radius = radiusDistribution(randomEngine);
+			}
+			return lightSpheres;
+		}
+
+		//What the renderer did before the hierarchy, testing every light's sphere in turn.
+		void QueryBruteForce(const Frustum& frustum, const std::vector<BoundingSphere>& lightSpheres, std::vector<uint32_t>& visibleLights)
+		{
+			visibleLights.clear();
+			for (uint32_t i = 0; i < lightSpheres.size(); i++)
+			{
+				if (frustum.IntersectsBoundingSphere(lightSpheres[i]))
+				{
+					visibleLights.push_back(i);
+				}
+			}
+		}
+
+		bool QueriesMatch(const LightBVH& lightBVH, const std::vector<BoundingSphere>& lightSpheres, const std::vector<Frustum>& frustums)
+		{
+			std::vector<uint32_t> visibleLights, expectedLights;
+			for (const Frustum& frustum : frustums)
+			{
+				lightBVH.QueryFrustum(frustum, visibleLights);
+				QueryBruteForce(frustum, lightSpheres, expectedLights);
+				std::sort(visibleLights.begin(), visibleLights.end());
+				if (visibleLights != expectedLights)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	CrescentTest(LightBVH_QueriesMatchBruteForceAfterBuildAndRefit)
+	{
+		std::mt19937 randomEngine(13);
+		std::vector<Frustum> frustums;
+		for (int i = 0; i < 32; i++)
+		{
+			frustums.push_back(Tests::GenerateFrustum(randomEngine, 300.0f));
+		}
+
+		for (size_t lightCount : { (size_t)1, (size_t)5, (size_t)1000, (size_t)10000 })
+		{
+			LightBVH lightBVH;
+			std::vector<BoundingSphere> lightSpheres = GenerateLightSpheres(lightCount, randomEngine);
+			lightBVH.UpdateHierarchy(lightSpheres);
+			CrescentCheck(QueriesMatch(lightBVH, lightSpheres, frustums));
+
+			//Moving and resizing lights keeps the light count, so the hierarchy is refit rather than rebuilt. Some lights travel far from their
+			//original node.
+			std::uniform_real_distribution<float> offsetDistribution(-20.0f, 20.0f);
+			size_t nodeCount = lightBVH.RetrieveNodeCount();
+			for (int frame = 0; frame < 3; frame++)
+			{
+				for (size_t i = 0; i < lightSpheres.size(); i += 3)
+				{
+					lightSpheres[i].m_Center += glm::vec3(offsetDistribution(randomEngine), 0.0f, offsetDistribution(randomEngine)) * (i % 10 == 0 ? 10.0f : 1.0f);
+					lightSpheres[i].m_Radius *= 1.1f;
+				}
+				lightBVH.UpdateHierarchy(lightSpheres);
+				CrescentCheck(lightBVH.RetrieveNodeCount() == nodeCount);
+				CrescentCheck(QueriesMatch(lightBVH, lightSpheres, frustums));
+			}
+
+			//Adding a light rebuilds it.
+			lightSpheres.push_back(GenerateLightSpheres(1, randomEngine)[0]);
+			lightBVH.UpdateHierarchy(lightSpheres);
+			CrescentCheck(QueriesMatch(lightBVH, lightSpheres, frustums));
+		}
+
+		LightBVH emptyBVH;
+		emptyBVH.UpdateHierarchy({});
+		std::vector<uint32_t> visibleLights = { 7 };
+		emptyBVH.QueryFrustum(frustums[0], visibleLights);
+		CrescentCheck(visibleLights.empty());
+	}
+
+	CrescentBenchmark(LightBVH_QueryAgainstBruteForce)
+	{
+		std::mt19937 randomEngine(14);
+		std::vector<Frustum> frustums;
+		for (int i = 0; i < 64; i++)
+		{
+			frustums.push_back(Tests::GenerateFrustum(randomEngine, 300.0f));
+		}
+
+		for (size_t lightCount : { (size_t)1000, (size_t)10000, (size_t)100000 })
+		{
+			std::vector<BoundingSphere> lightSpheres = GenerateLightSpheres(lightCount, randomEngine);
+			LightBVH lightBVH;
+			lightBVH.UpdateHierarchy(lightSpheres);
+
+			std::vector<uint32_t> visibleLights;
+			size_t bruteForceVisibleCount = 0;
+			double bruteForceTime = Tests::MeasureMilliseconds([&]()
+			{
+				bruteForceVisibleCount = 0;
+				for (const Frustum& frustum : frustums)
+				{
+					QueryBruteForce(frustum, lightSpheres, visibleLights);
+					bruteForceVisibleCount += visibleLights.size();
+				}
+			});
+
+			size_t hierarchyVisibleCount = 0;
+			double hierarchyTime = Tests::MeasureMilliseconds([&]()
+			{
+				hierarchyVisibleCount = 0;
+				for (const Frustum& frustum : frustums)
+				{
+					lightBVH.QueryFrustum(frustum, visibleLights);
+					hierarchyVisibleCount += visibleLights.size();
+				}
+			});
+
+			CrescentCheck(hierarchyVisibleCount == bruteForceVisibleCount);
+			Tests::ReportTimings(std::to_string(lightCount) + " lights, " + std::to_string(frustums.size()) + " queries", bruteForceTime, hierarchyTime);
+		}
+	}
+}
@@ -0,0 +1,258 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/LightClusterGrid.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <cmath>
+
+namespace Crescent
+{
+	namespace
+	{
+		const float NearClip = 0.1f;
+		const float FarClip = 100.0f;
+
+		glm::mat4 ConstructProjection()
+		{
+			return glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, NearClip, FarClip);
+		}
+
+		std::vector<ClusterLight> GenerateLights(unsigned int lightCount, unsigned int seed)
+		{
+			std::mt19937 randomEngine(seed);
+			std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+			//Spread over the view out to 60 units, with a few straddling the near plane or the frustum's sides.
+			std::vector<ClusterLight> lights(lightCount);
+			for (ClusterLight& light : lights)
+			{
+				float depth = 0.5f + 60.0f * unitDistribution(randomEngine);
+				glm::vec3 position = glm::vec3((unitDistribution(randomEngine) * 2.4f - 1.2f) * depth, (unitDistribution(randomEngine) * 1.4f - 0.7f) * depth, -depth);
+				light.m_PositionRadius = glm::vec4(position, 1.0f + 5.0f * unitDistribution(randomEngine));
+				light.m_Color = glm::vec4(unitDistribution(randomEngine), unitDistribution(randomEngine), unitDistribution(randomEngine), 0.0f);
+			}
+			return lights;
+		}
+
+		//The cluster a view space point is shaded with, found the way ClusteredPointLightFragment.shader does it. Returns false outside of the frustum.
+		bool LocateCluster(const LightClusterGrid& clusterGrid, const glm::mat4& projectionMatrix, const glm::vec3& viewPosition, unsigned int& clusterIndex)
+		{
+			float viewDepth = -viewPosition.z;
+			glm::vec4 clipPosition = projectionMatrix * glm::vec4(viewPosition, 1.0f);
+			glm::vec2 screenPosition = glm::vec2(clipPosition) / clipPosition.w * 0.5f + 0.5f;
+			if (viewDepth < NearClip || viewDepth > FarClip || glm::any(glm::lessThan(screenPosition, glm::vec2(0.0f))) || glm::any(glm::greaterThanEqual(screenPosition, glm::vec2(1.0f))))
+			{
+				return false;
+			}
+
+			glm::uvec3 gridDimensions = clusterGrid.RetrieveGridDimensions();
+			unsigned int tileX = (unsigned int)(screenPosition.x * gridDimensions.x);
+			unsigned int tileY = (unsigned int)(screenPosition.y * gridDimensions.y);
+			int depthSlice = (int)(std::log(viewDepth / clusterGrid.RetrieveNearClip()) * clusterGrid.RetrieveDepthSliceScale());
+			depthSlice = std::min(std::max(depthSlice, 0), (int)gridDimensions.z - 1);
+			clusterIndex = ((unsigned int)depthSlice * gridDimensions.y + tileY) * gridDimensions.x + tileX;
+			return true;
+		}
+
+		bool ClusterListsLight(const LightClusterGrid& clusterGrid, unsigned int clusterIndex, uint32_t lightIndex)
+		{
+			const LightCluster& lightCluster = clusterGrid.RetrieveClusters()[clusterIndex];
+			for (uint32_t i = 0; i < lightCluster.m_LightCount; i++)
+			{
+				if (clusterGrid.RetrieveLightIndices()[lightCluster.m_LightOffset + i] == lightIndex)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		float Attenuate(const ClusterLight& light, const glm::vec3& viewPosition)
+		{
+			float lightDistance = glm::length(viewPosition - glm::vec3(light.m_PositionRadius));
+			float falloff = std::max(1.0f - lightDistance / light.m_PositionRadius.w, 0.0f);
+			return falloff * falloff;
+		}
+	}
+
+	CrescentTest(LightClusterGrid_AssignsLightsToExpectedClusters)
+	{
+		//With a camera at the origin, a small light straight ahead at a depth of 10 straddles the middle column boundary (tiles 7 and 8), fits in row 4,
+		//and spans the depth slices of 9.5 and 10.5, which are 15 and 16.
+		LightClusterGrid clusterGrid;
+		std::vector<ClusterLight> lights(3);
+		lights[0].m_PositionRadius = glm::vec4(0.0f, 0.0f, -10.0f, 0.5f);
+		lights[1].m_PositionRadius = glm::vec4(0.0f, 0.0f, 5.0f, 1.0f); //Behind the camera.
+		lights[2].m_PositionRadius = glm::vec4(100.0f, 0.0f, -10.0f, 1.0f); //Far off to the side.
+		clusterGrid.AssignLights(glm::mat4(1.0f), ConstructProjection(), NearClip, FarClip, lights);
+
+		glm::uvec3 gridDimensions = clusterGrid.RetrieveGridDimensions();
+		CrescentCheck(gridDimensions == glm::uvec3(16, 9, 24));
+		CrescentCheck(clusterGrid.RetrieveLightIndices().size() == 4);
+
+		const std::vector<LightCluster>& clusters = clusterGrid.RetrieveClusters();
+		for (unsigned int z = 0; z < gridDimensions.z; z++)
+		{
+			for (unsigned int y = 0; y < gridDimensions.y; y++)
+			{
+				for (unsigned int x = 0; x < gridDimensions.x; x++)
+				{
+					const LightCluster& lightCluster = clusters[(z * gridDimensions.y + y) * gridDimensions.x + x];
+					bool expectedCluster = (x == 7 || x == 8) && y == 4 && (z == 15 || z == 16);
+					CrescentCheck(lightCluster.m_LightCount == (expectedCluster ? 1u : 0u));
+					if (expectedCluster && lightCluster.m_LightCount == 1)
+					{
+						CrescentCheck(clusterGrid.RetrieveLightIndices()[lightCluster.m_LightOffset] == 0);
+					}
+				}
+			}
+		}
+
+		//Lights sharing clusters are listed in ascending order.
+		lights[1].m_PositionRadius = glm::vec4(0.2f, 0.0f, -10.0f, 0.5f);
+		clusterGrid.AssignLights(glm::mat4(1.0f), ConstructProjection(), NearClip, FarClip, lights);
+		const LightCluster& sharedCluster = clusterGrid.RetrieveClusters()[(15 * gridDimensions.y + 4) * gridDimensions.x + 8];
+		CrescentCheck(sharedCluster.m_LightCount == 2);
+		if (sharedCluster.m_LightCount == 2)
+		{
+			CrescentCheck(clusterGrid.RetrieveLightIndices()[sharedCluster.m_LightOffset] == 0 && clusterGrid.RetrieveLightIndices()[sharedCluster.m_LightOffset + 1] == 1);
+		}
+	}
+
+	CrescentTest(LightClusterGrid_ListsEveryLightReachingACluster)
+	{
+		//Points inside each light's volume are located the way shaders do it. Whichever cluster they land in must list the light.
+		glm::mat4 viewMatrix = glm::lookAt(glm::vec3(3.0f, 2.0f, 5.0f), glm::vec3(3.5f, 1.5f, -5.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projectionMatrix = ConstructProjection();
+		std::vector<ClusterLight> lights = GenerateLights(300, 7);
+		for (ClusterLight& light : lights)
+		{
+			light.m_PositionRadius = glm::vec4(glm::vec3(glm::inverse(viewMatrix) * glm::vec4(glm::vec3(light.m_PositionRadius), 1.0f)), light.m_PositionRadius.w);
+		}
+
+		LightClusterGrid clusterGrid;
+		clusterGrid.AssignLights(viewMatrix, projectionMatrix, NearClip, FarClip, lights);
+
+		std::mt19937 randomEngine(11);
+		std::uniform_real_distribution<float> signedDistribution(-1.0f, 1.0f);
+		unsigned int missedCount = 0, sampleCount = 0;
+		for (uint32_t i = 0; i < lights.size(); i++)
+		{
+			for (unsigned int j = 0; j < 200; j++)
+			{
+				glm::vec3 offset = glm::vec3(signedDistribution(randomEngine), signedDistribution(randomEngine), signedDistribution(randomEngine));
+				if (glm::length(offset) > 1.0f)
+				{
+					continue;
+				}
+
+				glm::vec3 viewPosition = glm::vec3(viewMatrix * glm::vec4(glm::vec3(lights[i].m_PositionRadius) + offset * lights[i].m_PositionRadius.w, 1.0f));
+				unsigned int clusterIndex;
+				if (LocateCluster(clusterGrid, projectionMatrix, viewPosition, clusterIndex))
+				{
+					sampleCount++;
+					missedCount += ClusterListsLight(clusterGrid, clusterIndex, i) ? 0 : 1;
+				}
+			}
+		}
+		CrescentCheck(sampleCount > 10000);
+		CrescentCheck(missedCount == 0);
+	}
+
+	CrescentBenchmark(LightClusterGrid_ClusteredAgainstPerLightShading)
+	{
+		//A CPU model of both lighting passes over a 480x270 G-buffer. The removed pass drew each light's volume, shading every pixel within the volume's
+		//screen bounds. The clustered pass assigns lights first, then shades each pixel with its cluster's lights only. Both sum the same attenuation.
+		const unsigned int bufferWidth = 480, bufferHeight = 270;
+		glm::mat4 projectionMatrix = ConstructProjection();
+		float tanHalfFovX = 1.0f / projectionMatrix[0][0];
+		float tanHalfFovY = 1.0f / projectionMatrix[1][1];
+
+		//Blocky depths, like a scene's surfaces, between 1 and 70 units.
+		std::vector<glm::vec3> viewPositions(bufferWidth * bufferHeight);
+		for (unsigned int y = 0; y < bufferHeight; y++)
+		{
+			for (unsigned int x = 0; x < bufferWidth; x++)
+			{
+				unsigned int blockHash = ((x / 24) * 73856093u) ^ ((y / 18) * 19349663u);
+				float depth = 1.0f + (float)(blockHash % 1000) * 0.069f;
+				glm::vec2 ndc = glm::vec2((x + 0.5f) / bufferWidth, (y + 0.5f) / bufferHeight) * 2.0f - 1.0f;
+				viewPositions[y * bufferWidth + x] = glm::vec3(ndc.x * tanHalfFovX * depth, ndc.y * tanHalfFovY * depth, -depth);
+			}
+		}
+
+		std::vector<float> perLightLighting(viewPositions.size()), clusteredLighting(viewPositions.size());
+		const unsigned int lightCounts[] = { 64, 256, 1024 };
+		for (unsigned int lightCount : lightCounts)
+		{
+			std::vector<ClusterLight> lights = GenerateLights(lightCount, lightCount);
+
+			double perLightTime = Tests::MeasureMilliseconds([&]()
+			{
+				std::fill(perLightLighting.begin(), perLightLighting.end(), 0.0f);
+				for (const ClusterLight& light : lights)
+				{
+					//Screen bounds of the light's volume, from the corners of its view space box. Volumes crossing the near plane cover the screen.
+					glm::vec3 center = glm::vec3(light.m_PositionRadius);
+					float radius = light.m_PositionRadius.w;
+					glm::vec2 minimumScreen = glm::vec2(0.0f), maximumScreen = glm::vec2(1.0f);
+					if (-center.z - radius > NearClip)
+					{
+						minimumScreen = glm::vec2(1.0f);
+						maximumScreen = glm::vec2(0.0f);
+						for (unsigned int corner = 0; corner < 8; corner++)
+						{
+							glm::vec3 cornerPosition = center + glm::vec3(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius);
+							glm::vec4 clipPosition = projectionMatrix * glm::vec4(cornerPosition, 1.0f);
+							glm::vec2 screenPosition = glm::clamp(glm::vec2(clipPosition) / clipPosition.w * 0.5f + 0.5f, 0.0f, 1.0f);
+							minimumScreen = glm::min(minimumScreen, screenPosition);
+							maximumScreen = glm::max(maximumScreen, screenPosition);
+						}
+					}
+
+					unsigned int minimumX = (unsigned int)(minimumScreen.x * (bufferWidth - 1)), maximumX = (unsigned int)std::ceil(maximumScreen.x * (bufferWidth - 1));
+					unsigned int minimumY = (unsigned int)(minimumScreen.y * (bufferHeight - 1)), maximumY = (unsigned int)std::ceil(maximumScreen.y * (bufferHeight - 1));
+					for (unsigned int y = minimumY; y <= maximumY && maximumScreen.y >= minimumScreen.y; y++)
+					{
+						for (unsigned int x = minimumX; x <= maximumX && maximumScreen.x >= minimumScreen.x; x++)
+						{
+							perLightLighting[y * bufferWidth + x] += Attenuate(light, viewPositions[y * bufferWidth + x]);
+						}
+					}
+				}
+			}, 3);
+
+			LightClusterGrid clusterGrid;
+			double clusteredTime = Tests::MeasureMilliseconds([&]()
+			{
+				clusterGrid.AssignLights(glm::mat4(1.0f), projectionMatrix, NearClip, FarClip, lights);
+				const std::vector<LightCluster>& clusters = clusterGrid.RetrieveClusters();
+				const std::vector<uint32_t>& lightIndices = clusterGrid.RetrieveLightIndices();
+				for (unsigned int i = 0; i < viewPositions.size(); i++)
+				{
+					unsigned int clusterIndex;
+					float lighting = 0.0f;
+					if (LocateCluster(clusterGrid, projectionMatrix, viewPositions[i], clusterIndex))
+					{
+						const LightCluster& lightCluster = clusters[clusterIndex];
+						for (uint32_t j = 0; j < lightCluster.m_LightCount; j++)
+						{
+							lighting += Attenuate(lights[lightIndices[lightCluster.m_LightOffset + j]], viewPositions[i]);
+						}
+					}
+					clusteredLighting[i] = lighting;
+				}
+			}, 3);
+
+			double perLightTotal = 0.0, clusteredTotal = 0.0;
+			for (unsigned int i = 0; i < viewPositions.size(); i++)
+			{
+				perLightTotal += perLightLighting[i];
+				clusteredTotal += clusteredLighting[i];
+			}
+			CrescentCheck(std::abs(perLightTotal - clusteredTotal) <= perLightTotal * 1e-3);
+
+			Tests::ReportTimings(std::to_string(lightCount) + " lights", perLightTime, clusteredTime);
+		}
+	}
+}
@@ -0,0 +1,199 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/Renderer.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/InstanceBatcher.h"
+#include "Models/Mesh.h"
+#include "Shading/Shader.h"
+#include "Shading/Material.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <iostream>
+
+namespace Crescent
+{
+	CrescentTest(RenderQueue_SteadyStateFramesMakeNoHeapAllocations)
+	{
+		//Neither is finalized, so nothing here calls into OpenGL. The renderer is never initialized, so it holds no GL objects to release either.
+		Renderer renderer;
+		RenderQueue renderQueue(&renderer);
+		Shader shader;
+		Material deferredMaterial(&shader);
+		deferredMaterial.m_MaterialType = Material_Default;
+		Material customMaterial(&shader);
+
+		std::vector<Mesh> meshes;
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			float size = 1.0f + i;
+			meshes.push_back(Mesh({ glm::vec3(-size), glm::vec3(size, -size, size), glm::vec3(size) }, { 0, 1, 2 }));
+			meshes.back().CalculateBounds();
+		}
+
+		Frustum viewFrustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f) * glm::lookAt(glm::vec3(0.0f, 0.0f, 50.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		Frustum shadowFrustum(glm::ortho(-60.0f, 60.0f, -60.0f, 60.0f, -100.0f, 100.0f));
+
+		//The first frame is the largest. Later frames queue fewer commands in varying orders, spread over the view and outside of it.
+		const unsigned int warmUpFrameCount = 3;
+		size_t queueAllocationCount = 0;
+		size_t processAllocationCount = 0;
+		for (unsigned int frame = 0; frame < 60; frame++)
+		{
+			if (frame == warmUpFrameCount)
+			{
+				queueAllocationCount = renderQueue.RetrieveHeapAllocationCount();
+				processAllocationCount = Tests::TestRegistry::RetrieveHeapAllocationCount();
+			}
+
+			unsigned int commandCount = frame == 0 ? 5000 : 5000 - (frame * 379) % 2000;
+			for (unsigned int i = 0; i < commandCount; i++)
+			{
+				unsigned int seed = (i * 2654435761u) ^ (frame * 40503u);
+				glm::vec3 position = glm::vec3((float)(seed % 200) - 100.0f, (float)((seed >> 8) % 100) - 50.0f, (float)((seed >> 16) % 100) - 50.0f);
+				Material* material = (seed >> 24) % 8 == 0 ? &customMaterial : &deferredMaterial;
+				renderQueue.PushToRenderQueue(&meshes[seed % meshes.size()], material, glm::translate(glm::mat4(1.0f), position), nullptr, (seed & 1) != 0);
+			}
+
+			renderQueue.CullQueuedCommands(viewFrustum);
+			renderQueue.SortQueuedCommands();
+			RenderCommandList deferredCommands = renderQueue.RetrieveDeferredRenderingCommands();
+			RenderCommandList customCommands = renderQueue.RetrieveCustomRenderCommands(nullptr, true);
+			RenderCommandList staticCasters = renderQueue.RetrieveShadowCastingRenderCommands(shadowFrustum, ShadowCaster_Static);
+			RenderCommandList dynamicCasters = renderQueue.RetrieveShadowCastingRenderCommands(shadowFrustum, ShadowCaster_Dynamic);
+			CrescentCheck(deferredCommands.size() > 0 && customCommands.size() > 0 && staticCasters.size() > 0 && dynamicCasters.size() > 0);
+			CrescentCheck(renderQueue.RetrieveQueuedCommandCount() == commandCount);
+
+			bool keysSorted = true;
+			for (size_t i = 1; i < deferredCommands.size(); i++)
+			{
+				keysSorted &= deferredCommands[i - 1].m_SortKey <= deferredCommands[i].m_SortKey;
+			}
+			CrescentCheck(keysSorted);
+
+			renderQueue.ClearQueuedCommands();
+			CrescentCheck(renderQueue.RetrieveQueuedCommandCount() == 0);
+		}
+
+		CrescentCheck(renderQueue.RetrieveHeapAllocationCount() == queueAllocationCount);
+		CrescentCheck(Tests::TestRegistry::RetrieveHeapAllocationCount() == processAllocationCount);
+	}
+
+	CrescentTest(RenderQueue_CullsCustomCommandsOnTheMainTarget)
+	{
+		Renderer renderer;
+		RenderQueue renderQueue(&renderer);
+		Shader shader;
+		Material customMaterial(&shader);
+
+		Mesh boundedMesh({ glm::vec3(-1.0f), glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(1.0f) }, { 0, 1, 2 });
+		boundedMesh.CalculateBounds();
+		Mesh unboundedMesh({ glm::vec3(-1.0f), glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(1.0f) }, { 0, 1, 2 });
+		unboundedMesh.CalculateBounds();
+		unboundedMesh.ClearBounds();
+
+		//One command in view, one behind the camera, and an unbounded one (like the skybox) far outside of the view.
+		renderQueue.PushToRenderQueue(&boundedMesh, &customMaterial, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)));
+		renderQueue.PushToRenderQueue(&boundedMesh, &customMaterial, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 10.0f)));
+		renderQueue.PushToRenderQueue(&unboundedMesh, &customMaterial, glm::translate(glm::mat4(1.0f), glm::vec3(500.0f)));
+
+		renderQueue.CullQueuedCommands(Frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)));
+		renderQueue.SortQueuedCommands();
+		CrescentCheck(renderQueue.RetrieveCustomRenderCommands(nullptr, true).size() == 2);
+		CrescentCheck(renderQueue.RetrieveCustomRenderCommands(nullptr, false).size() == 3);
+		renderQueue.ClearQueuedCommands();
+	}
+
+	CrescentBenchmark(RenderQueue_StressSceneCullingAgainstSubmittingEverything)
+	{
+		Renderer renderer;
+		RenderQueue renderQueue(&renderer);
+		Shader shader;
+		std::vector<Material> materials(16, Material(&shader));
+		for (Material& material : materials)
+		{
+			material.m_MaterialType = Material_Default;
+		}
+
+		std::vector<Mesh> meshes;
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			float size = 0.5f + i * 0.25f;
+			meshes.push_back(Mesh({ glm::vec3(-size), glm::vec3(size, -size, size), glm::vec3(size) }, { 0, 1, 2 }));
+			meshes.back().CalculateBounds();
+		}
+
+		//A field of objects around the camera, most of which fall outside of its view. Seeded, so runs are comparable.
+		const size_t objectCount = 50000;
+		std::mt19937 randomEngine(50000);
+		std::uniform_real_distribution<float> horizontalDistribution(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> verticalDistribution(-20.0f, 40.0f);
+		std::vector<glm::mat4> transforms(objectCount);
+		std::vector<unsigned int> meshIndices(objectCount);
+		std::vector<unsigned int> materialIndices(objectCount);
+		for (size_t i = 0; i < objectCount; i++)
+		{
+			transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(horizontalDistribution(randomEngine), verticalDistribution(randomEngine), horizontalDistribution(randomEngine)));
+			meshIndices[i] = randomEngine() % meshes.size();
+			materialIndices[i] = randomEngine() % materials.size();
+		}
+		Frustum viewFrustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f) * glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, 10.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		//What a frame hands to OpenGL, counted by a mock submission loop standing in for the G-buffer pass.
+		struct SubmissionCounts
+		{
+			size_t m_CommandCount = 0; //Also the draw count when instancing is disabled.
+			size_t m_InstancedDrawCount = 0;
+			size_t m_TriangleCount = 0;
+		};
+
+		//A frame as the renderer drives it: queue everything, cull against the camera if asked to, sort, gather the deferred commands, form instance
+		//batches and walk them as the G-buffer pass would. Only the CPU side is timed, so the draws and triangles are reported separately.
+		std::vector<InstanceBatch> instanceBatches;
+		std::vector<InstanceData> instanceData;
+		auto renderFrame = [&](bool cullingEnabled)
+		{
+			for (size_t i = 0; i < objectCount; i++)
+			{
+				renderQueue.PushToRenderQueue(&meshes[meshIndices[i]], &materials[materialIndices[i]], transforms[i], nullptr, false);
+			}
+			if (cullingEnabled)
+			{
+				renderQueue.CullQueuedCommands(viewFrustum);
+			}
+			renderQueue.SortQueuedCommands();
+			RenderCommandList deferredCommands = renderQueue.RetrieveDeferredRenderingCommands();
+			InstanceBatcher::FormInstanceBatches(deferredCommands, true, instanceBatches, instanceData);
+
+			SubmissionCounts submissionCounts;
+			submissionCounts.m_CommandCount = deferredCommands.size();
+			submissionCounts.m_InstancedDrawCount = instanceBatches.size();
+			for (const InstanceBatch& instanceBatch : instanceBatches)
+			{
+				const RenderCommand& batchCommand = deferredCommands[instanceBatch.m_FirstCommand];
+				submissionCounts.m_TriangleCount += batchCommand.m_Mesh->RetrieveIndexCount(batchCommand.m_LODIndex) / 3 * instanceBatch.m_InstanceCount;
+			}
+			renderQueue.ClearQueuedCommands();
+			return submissionCounts;
+		};
+
+		SubmissionCounts everythingCounts;
+		double submitEverythingTime = Tests::MeasureMilliseconds([&]() { everythingCounts = renderFrame(false); }, 20);
+		CrescentCheck(everythingCounts.m_CommandCount == objectCount);
+
+		SubmissionCounts culledCounts;
+		double cullingTime = Tests::MeasureMilliseconds([&]() { culledCounts = renderFrame(true); }, 20);
+		size_t visibleCommandCount = renderQueue.RetrieveVisibleCommandCount();
+		size_t culledCommandCount = renderQueue.RetrieveCulledCommandCount();
+		CrescentCheck(culledCounts.m_CommandCount == visibleCommandCount && visibleCommandCount + culledCommandCount == objectCount);
+		CrescentCheck(visibleCommandCount > 0 && culledCommandCount > 0);
+		CrescentCheck(culledCounts.m_TriangleCount < everythingCounts.m_TriangleCount);
+
+		//Culling pays off on the GPU, in the draws and triangles it never receives. The CPU timings only show what finding them costs.
+		std::cout << "    " << visibleCommandCount << " of " << objectCount << " objects visible, " << culledCommandCount << " culled\n";
+		std::cout << "    per frame without culling: " << everythingCounts.m_CommandCount << " commands, " << everythingCounts.m_InstancedDrawCount << " instanced draws, "
+			<< everythingCounts.m_TriangleCount << " triangles\n";
+		std::cout << "    per frame with culling:    " << culledCounts.m_CommandCount << " commands, " << culledCounts.m_InstancedDrawCount << " instanced draws, "
+			<< culledCounts.m_TriangleCount << " triangles\n";
+		Tests::ReportTimings(std::to_string(objectCount) + " objects queued, sorted and batched, submitting all against culling first", submitEverythingTime, cullingTime);
+	}
+}
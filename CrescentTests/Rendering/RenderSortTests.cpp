@@ -0,0 +1,110 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/RenderSort.h"
+#include <random>
+
+namespace Crescent
+{
+	namespace
+	{
+		//Keys spread like a frame's: a single target, a handful of shaders, more materials and many meshes, at any depth. Seeded, so runs are comparable.
+		std::vector<RenderSortEntry> GenerateSortEntries(size_t entryCount, unsigned int seed)
+		{
+			std::mt19937 randomEngine(seed);
+			std::uniform_int_distribution<unsigned int> shaderDistribution(1, 8);
+			std::uniform_int_distribution<unsigned int> materialDistribution(0, 63);
+			std::uniform_int_distribution<unsigned int> meshDistribution(1, 512);
+			std::uniform_real_distribution<float> depthDistribution(0.1f, 100.0f);
+
+			std::vector<RenderSortEntry> sortEntries(entryCount);
+			for (size_t i = 0; i < entryCount; i++)
+			{
+				//Only the address of a material is folded into its key, so spaced out fake addresses stand in for real ones.
+				const Material* material = (const Material*)(uintptr_t)(0x100000 + materialDistribution(randomEngine) * 0x140);
+				sortEntries[i].m_SortKey = RenderSort::GenerateSortKey(0, shaderDistribution(randomEngine), material, meshDistribution(randomEngine), depthDistribution(randomEngine), 100.0f);
+				sortEntries[i].m_CommandIndex = (uint32_t)i;
+			}
+			return sortEntries;
+		}
+
+		bool CompareSortEntries(const RenderSortEntry& firstEntry, const RenderSortEntry& secondEntry)
+		{
+			return firstEntry.m_SortKey < secondEntry.m_SortKey;
+		}
+	}
+
+	CrescentTest(RenderSort_RadixSortMatchesStableSort)
+	{
+		const size_t entryCounts[] = { 0, 1, 2, 255, 256, 257, 5000 };
+		for (size_t entryCount : entryCounts)
+		{
+			std::vector<RenderSortEntry> radixEntries = GenerateSortEntries(entryCount, (unsigned int)entryCount);
+			std::vector<RenderSortEntry> stableEntries = radixEntries;
+			std::vector<RenderSortEntry> scratchEntries;
+
+			RenderSort::RadixSort(radixEntries, scratchEntries);
+			std::stable_sort(stableEntries.begin(), stableEntries.end(), CompareSortEntries);
+
+			bool entriesMatch = true;
+			for (size_t i = 0; i < entryCount; i++)
+			{
+				entriesMatch &= radixEntries[i].m_SortKey == stableEntries[i].m_SortKey && radixEntries[i].m_CommandIndex == stableEntries[i].m_CommandIndex;
+			}
+			CrescentCheck(radixEntries.size() == entryCount && entriesMatch);
+		}
+
+		//Shadow keys leave the upper digits empty, which the sort skips.
+		std::vector<RenderSortEntry> shadowEntries(1000);
+		for (uint32_t i = 0; i < shadowEntries.size(); i++)
+		{
+			shadowEntries[i].m_SortKey = RenderSort::GenerateShadowSortKey(i % 7, (float)(i % 13), 100.0f);
+			shadowEntries[i].m_CommandIndex = i;
+		}
+		std::vector<RenderSortEntry> stableShadowEntries = shadowEntries;
+		std::vector<RenderSortEntry> scratchEntries;
+		RenderSort::RadixSort(shadowEntries, scratchEntries);
+		std::stable_sort(stableShadowEntries.begin(), stableShadowEntries.end(), CompareSortEntries);
+
+		bool shadowEntriesMatch = true;
+		for (size_t i = 0; i < shadowEntries.size(); i++)
+		{
+			shadowEntriesMatch &= shadowEntries[i].m_CommandIndex == stableShadowEntries[i].m_CommandIndex;
+		}
+		CrescentCheck(shadowEntriesMatch);
+	}
+
+	CrescentBenchmark(RenderSort_RadixSortAgainstStdSort)
+	{
+		//Both sides start from the same unsorted copy each run, and reuse their buffers as the render queue does between frames.
+		const size_t entryCounts[] = { 500, 2000, 10000, 50000, 200000 };
+		for (size_t entryCount : entryCounts)
+		{
+			const std::vector<RenderSortEntry> unsortedEntries = GenerateSortEntries(entryCount, 1337);
+			std::vector<RenderSortEntry> sortEntries(entryCount);
+			std::vector<RenderSortEntry> scratchEntries(entryCount);
+			unsigned int runCount = entryCount < 10000 ? 200 : 20;
+
+			double stdSortTime = Tests::MeasureMilliseconds([&]()
+			{
+				sortEntries.assign(unsortedEntries.begin(), unsortedEntries.end());
+				std::sort(sortEntries.begin(), sortEntries.end(), CompareSortEntries);
+			}, runCount);
+			std::vector<RenderSortEntry> stdSortedEntries = sortEntries;
+
+			double radixSortTime = Tests::MeasureMilliseconds([&]()
+			{
+				sortEntries.assign(unsortedEntries.begin(), unsortedEntries.end());
+				RenderSort::RadixSort(sortEntries, scratchEntries);
+			}, runCount);
+
+			bool keysMatch = true;
+			for (size_t i = 0; i < entryCount; i++)
+			{
+				keysMatch &= sortEntries[i].m_SortKey == stdSortedEntries[i].m_SortKey;
+			}
+			CrescentCheck(keysMatch);
+
+			Tests::ReportTimings(std::to_string(entryCount) + " commands", stdSortTime, radixSortTime);
+		}
+	}
+}
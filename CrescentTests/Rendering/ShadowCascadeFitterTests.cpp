@@ -0,0 +1,100 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Rendering/ShadowCascadeFitter.h"
+#include "Utilities/Camera.h"
+#include <cmath>
+
+namespace Crescent
+{
+	namespace
+	{
+		const unsigned int ShadowMapResolution = 2048;
+		const float SliceNear = 0.1f;
+		const float SliceFar = 15.0f;
+
+		Camera ConstructTestCamera(const glm::vec3& cameraPosition)
+		{
+			Camera camera(cameraPosition, glm::normalize(glm::vec3(0.2f, -0.3f, -1.0f)), glm::vec3(0.0f, 1.0f, 0.0f));
+			camera.SetPerspectiveMatrix(glm::radians(60.0f), 16.0f / 9.0f, SliceNear, 100.0f);
+			return camera;
+		}
+
+		//Whether every corner of the camera's slice lands inside of the cascade's clip volume.
+		bool CascadeContainsSlice(const Camera& camera, const ShadowCascade& shadowCascade)
+		{
+			glm::mat4 inverseViewProjection = glm::inverse(camera.m_ProjectionMatrix * camera.m_ViewMatrix);
+			glm::mat4 lightSpaceViewProjection = shadowCascade.m_LightProjectionMatrix * shadowCascade.m_LightViewMatrix;
+			float sliceDepth = (SliceFar - camera.m_NearClip) / (camera.m_FarClip - camera.m_NearClip);
+			for (float x = -1.0f; x <= 1.0f; x += 2.0f)
+			{
+				for (float y = -1.0f; y <= 1.0f; y += 2.0f)
+				{
+					glm::vec4 nearCorner = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+					glm::vec4 farCorner = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+					glm::vec3 nearPoint = glm::vec3(nearCorner) / nearCorner.w;
+					glm::vec3 slicePoint = glm::mix(nearPoint, glm::vec3(farCorner) / farCorner.w, sliceDepth);
+
+					glm::vec4 clipPoints[2] = { lightSpaceViewProjection * glm::vec4(nearPoint, 1.0f), lightSpaceViewProjection * glm::vec4(slicePoint, 1.0f) };
+					for (unsigned int i = 0; i < 2; i++)
+					{
+						if (glm::any(glm::greaterThan(glm::abs(glm::vec3(clipPoints[i])), glm::vec3(1.0f))))
+						{
+							return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		//The projected world origin lies on a texel corner when the cascade has only moved in whole texels.
+		bool IsTexelAligned(const ShadowCascade& shadowCascade)
+		{
+			glm::vec4 shadowOrigin = shadowCascade.m_LightProjectionMatrix * shadowCascade.m_LightViewMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			glm::vec2 texelOrigin = glm::vec2(shadowOrigin) * (ShadowMapResolution * 0.5f);
+			return glm::all(glm::lessThan(glm::abs(texelOrigin - glm::round(texelOrigin)), glm::vec2(0.01f)));
+		}
+	}
+
+	CrescentTest(ShadowCascadeFitter_VolumeHoldsStillWithinPadding)
+	{
+		glm::vec3 lightDirection = glm::vec3(0.3f, -1.0f, 0.2f);
+		BoundingBox casterBounds;
+		casterBounds.Merge(glm::vec3(-40.0f, -1.0f, -40.0f));
+		casterBounds.Merge(glm::vec3(40.0f, 10.0f, 40.0f));
+
+		Camera camera = ConstructTestCamera(glm::vec3(0.0f, 5.0f, 20.0f));
+		ShadowCascadeVolume cascadeVolume;
+		ShadowCascade firstCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(camera, SliceNear, SliceFar, lightDirection, casterBounds, ShadowMapResolution, 0.25f, &cascadeVolume);
+		CrescentCheck(CascadeContainsSlice(camera, firstCascade));
+		CrescentCheck(IsTexelAligned(firstCascade));
+
+		//Small steps in every direction keep the exact same matrices, which is what the static shadow cache is keyed on. A fit without the previous volume moves every step.
+		unsigned int unpaddedChangeCount = 0;
+		ShadowCascade previousUnpaddedCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(camera, SliceNear, SliceFar, lightDirection, casterBounds, ShadowMapResolution);
+		for (unsigned int i = 1; i <= 20; i++)
+		{
+			Camera movedCamera = ConstructTestCamera(glm::vec3(0.0f, 5.0f, 20.0f) + glm::vec3(0.05f, -0.02f, 0.04f) * (float)i);
+			ShadowCascade shadowCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(movedCamera, SliceNear, SliceFar, lightDirection, casterBounds, ShadowMapResolution, 0.25f, &cascadeVolume);
+			CrescentCheck(shadowCascade.m_LightViewMatrix == firstCascade.m_LightViewMatrix && shadowCascade.m_LightProjectionMatrix == firstCascade.m_LightProjectionMatrix);
+			CrescentCheck(CascadeContainsSlice(movedCamera, shadowCascade));
+
+			ShadowCascade unpaddedCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(movedCamera, SliceNear, SliceFar, lightDirection, casterBounds, ShadowMapResolution);
+			unpaddedChangeCount += unpaddedCascade.m_LightViewMatrix != previousUnpaddedCascade.m_LightViewMatrix || unpaddedCascade.m_LightProjectionMatrix != previousUnpaddedCascade.m_LightProjectionMatrix;
+			previousUnpaddedCascade = unpaddedCascade;
+		}
+		CrescentCheck(unpaddedChangeCount > 10);
+
+		//Leaving the padding refits the volume around the slice, again on whole texels.
+		Camera distantCamera = ConstructTestCamera(glm::vec3(12.0f, 5.0f, 0.0f));
+		ShadowCascade refitCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(distantCamera, SliceNear, SliceFar, lightDirection, casterBounds, ShadowMapResolution, 0.25f, &cascadeVolume);
+		CrescentCheck(refitCascade.m_LightViewMatrix != firstCascade.m_LightViewMatrix);
+		CrescentCheck(CascadeContainsSlice(distantCamera, refitCascade));
+		CrescentCheck(IsTexelAligned(refitCascade));
+
+		//So does turning the light.
+		ShadowCascade turnedCascade = ShadowCascadeFitter::FitCascadeToFrustumSlice(distantCamera, SliceNear, SliceFar, glm::vec3(-0.3f, -1.0f, 0.2f), casterBounds, ShadowMapResolution, 0.25f, &cascadeVolume);
+		CrescentCheck(turnedCascade.m_LightViewMatrix != refitCascade.m_LightViewMatrix);
+		CrescentCheck(CascadeContainsSlice(distantCamera, turnedCascade));
+	}
+}
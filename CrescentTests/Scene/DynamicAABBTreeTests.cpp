@@ -0,0 +1,330 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Scene/DynamicAABBTree.h"
+#include "../Utilities/TestFrustums.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <unordered_map>
+#include <random>
+#include <cmath>
+#include <iostream>
+
+namespace Crescent
+{
+	namespace
+	{
+		//Boxes of 0.5 to 4 units, scattered over a 1000x1000 unit level up to 20 units high.
+		BoundingBox GenerateBoundingBox(std::mt19937& randomEngine)
+		{
+			std::uniform_real_distribution<float> planarDistribution(-500.0f, 500.0f);
+			std::uniform_real_distribution<float> heightDistribution(0.0f, 20.0f);
+			std::uniform_real_distribution<float> sizeDistribution(0.5f, 4.0f);
+
+			BoundingBox boundingBox;
+			boundingBox.m_Minimum = glm::vec3(planarDistribution(randomEngine), heightDistribution(randomEngine), planarDistribution(randomEngine));
+			boundingBox.m_Maximum = boundingBox.m_Minimum + glm::vec3(sizeDistribution(randomEngine), sizeDistribution(randomEngine), sizeDistribution(randomEngine));
+			return boundingBox;
+		}
+
+		BoundingBox OffsetBoundingBox(const BoundingBox& boundingBox, const glm::vec3& offset)
+		{
+			BoundingBox offsetBox;
+			offsetBox.m_Minimum = boundingBox.m_Minimum + offset;
+			offsetBox.m_Maximum = boundingBox.m_Maximum + offset;
+			return offsetBox;
+		}
+
+		bool OverlapsBounds(const BoundingBox& firstBounds, const BoundingBox& secondBounds)
+		{
+			return glm::all(glm::lessThanEqual(firstBounds.m_Minimum, secondBounds.m_Maximum)) && glm::all(glm::greaterThanEqual(firstBounds.m_Maximum, secondBounds.m_Minimum));
+		}
+
+		bool ContainsBounds(const BoundingBox& outerBounds, const BoundingBox& innerBounds)
+		{
+			return glm::all(glm::lessThanEqual(outerBounds.m_Minimum, innerBounds.m_Minimum)) && glm::all(glm::greaterThanEqual(outerBounds.m_Maximum, innerBounds.m_Maximum));
+		}
+
+		//The same slab test as the tree's, so that hit distances compare exactly.
+		float IntersectRayBounds(const glm::vec3& rayOrigin, const glm::vec3& inverseDirection, const BoundingBox& boundingBox)
+		{
+			glm::vec3 firstDistances = (boundingBox.m_Minimum - rayOrigin) * inverseDirection;
+			glm::vec3 secondDistances = (boundingBox.m_Maximum - rayOrigin) * inverseDirection;
+			glm::vec3 nearDistances = glm::min(firstDistances, secondDistances);
+			glm::vec3 farDistances = glm::max(firstDistances, secondDistances);
+			float entryDistance = std::max(std::max(nearDistances.x, nearDistances.y), std::max(nearDistances.z, 0.0f));
+			float exitDistance = std::min(std::min(farDistances.x, farDistances.y), farDistances.z);
+			return entryDistance <= exitDistance ? entryDistance : -1.0f;
+		}
+
+		bool ResultsMatch(std::vector<int32_t> queryResults, std::vector<int32_t> expectedResults)
+		{
+			std::sort(queryResults.begin(), queryResults.end());
+			std::sort(expectedResults.begin(), expectedResults.end());
+			return queryResults == expectedResults;
+		}
+	}
+
+	CrescentTest(DynamicAABBTree_QueriesMatchBruteForceAcrossChurn)
+	{
+		//Queries report every proxy whose fat box passes, which a scan over the fat boxes finds too. The tight boxes must always be among them.
+		std::mt19937 randomEngine(21);
+		DynamicAABBTree aabbTree;
+		std::unordered_map<int32_t, BoundingBox> tightBounds;
+		std::unordered_map<int32_t, BoundingBox> insertedBounds; //What each proxy's fat box was last built around.
+		for (unsigned int i = 0; i < 3000; i++)
+		{
+			BoundingBox boundingBox = GenerateBoundingBox(randomEngine);
+			int32_t proxyID = aabbTree.CreateProxy(boundingBox, nullptr);
+			tightBounds[proxyID] = insertedBounds[proxyID] = boundingBox;
+		}
+
+		std::uniform_real_distribution<float> nudgeDistribution(-0.05f, 0.05f);
+		std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+		std::vector<int32_t> queryResults, expectedResults, tightResults;
+		unsigned int nudgeReinsertCount = 0, jumpReinsertCount = 0, jumpCount = 0;
+		for (unsigned int round = 0; round < 10; round++)
+		{
+			//Nudges stay inside of the fat box, jumps leave it. Then some proxies come and go.
+			std::vector<int32_t> proxyIDs;
+			for (const auto& proxyBounds : tightBounds)
+			{
+				proxyIDs.push_back(proxyBounds.first);
+			}
+			std::sort(proxyIDs.begin(), proxyIDs.end());
+			for (unsigned int i = 0; i < 600; i++)
+			{
+				int32_t proxyID = proxyIDs[randomEngine() % proxyIDs.size()];
+				bool isJump = i % 2 == 0;
+				glm::vec3 nudgeOffset = glm::vec3(nudgeDistribution(randomEngine), nudgeDistribution(randomEngine), nudgeDistribution(randomEngine));
+				BoundingBox movedBounds = isJump ? GenerateBoundingBox(randomEngine) : OffsetBoundingBox(insertedBounds[proxyID], nudgeOffset);
+				bool reinserted = aabbTree.MoveProxy(proxyID, movedBounds);
+				if (reinserted)
+				{
+					insertedBounds[proxyID] = movedBounds;
+				}
+				nudgeReinsertCount += !isJump && reinserted;
+				jumpReinsertCount += isJump && reinserted;
+				jumpCount += isJump;
+				tightBounds[proxyID] = movedBounds;
+			}
+			for (unsigned int i = 0; i < 100; i++)
+			{
+				int32_t proxyID = proxyIDs[(round * 100 + i * 29) % proxyIDs.size()];
+				if (tightBounds.erase(proxyID))
+				{
+					aabbTree.DestroyProxy(proxyID);
+				}
+				BoundingBox boundingBox = GenerateBoundingBox(randomEngine);
+				int32_t createdID = aabbTree.CreateProxy(boundingBox, nullptr);
+				tightBounds[createdID] = insertedBounds[createdID] = boundingBox;
+			}
+			CrescentCheck(aabbTree.RetrieveProxyCount() == tightBounds.size());
+
+			bool fatBoundsEnclose = true;
+			for (const auto& proxyBounds : tightBounds)
+			{
+				fatBoundsEnclose &= ContainsBounds(aabbTree.RetrieveFatBounds(proxyBounds.first), proxyBounds.second);
+			}
+			CrescentCheck(fatBoundsEnclose);
+
+			for (unsigned int i = 0; i < 5; i++)
+			{
+				Frustum frustum = Tests::GenerateFrustum(randomEngine, 200.0f);
+				queryResults.clear();
+				expectedResults.clear();
+				tightResults.clear();
+				aabbTree.QueryFrustum(frustum, queryResults);
+				for (const auto& proxyBounds : tightBounds)
+				{
+					if (frustum.IntersectsBoundingBox(aabbTree.RetrieveFatBounds(proxyBounds.first)))
+					{
+						expectedResults.push_back(proxyBounds.first);
+					}
+					if (frustum.IntersectsBoundingBox(proxyBounds.second))
+					{
+						tightResults.push_back(proxyBounds.first);
+					}
+				}
+				CrescentCheck(!expectedResults.empty() && ResultsMatch(queryResults, expectedResults));
+				std::sort(queryResults.begin(), queryResults.end());
+				std::sort(tightResults.begin(), tightResults.end());
+				CrescentCheck(std::includes(queryResults.begin(), queryResults.end(), tightResults.begin(), tightResults.end()));
+
+				BoundingSphere boundingSphere;
+				boundingSphere.m_Center = glm::vec3(unitDistribution(randomEngine) * 400.0f, 10.0f, unitDistribution(randomEngine) * 400.0f);
+				boundingSphere.m_Radius = 40.0f;
+				BoundingBox queryBox;
+				queryBox.m_Minimum = boundingSphere.m_Center - glm::vec3(30.0f, 5.0f, 30.0f);
+				queryBox.m_Maximum = boundingSphere.m_Center + glm::vec3(30.0f, 5.0f, 30.0f);
+
+				std::vector<int32_t> sphereResults, boxResults, expectedSphereResults, expectedBoxResults;
+				aabbTree.QueryBoundingSphere(boundingSphere, sphereResults);
+				aabbTree.QueryBoundingBox(queryBox, boxResults);
+				for (const auto& proxyBounds : tightBounds)
+				{
+					const BoundingBox& fatBounds = aabbTree.RetrieveFatBounds(proxyBounds.first);
+					glm::vec3 offset = glm::clamp(boundingSphere.m_Center, fatBounds.m_Minimum, fatBounds.m_Maximum) - boundingSphere.m_Center;
+					if (glm::dot(offset, offset) <= boundingSphere.m_Radius * boundingSphere.m_Radius)
+					{
+						expectedSphereResults.push_back(proxyBounds.first);
+					}
+					if (OverlapsBounds(fatBounds, queryBox))
+					{
+						expectedBoxResults.push_back(proxyBounds.first);
+					}
+				}
+				CrescentCheck(ResultsMatch(sphereResults, expectedSphereResults));
+				CrescentCheck(ResultsMatch(boxResults, expectedBoxResults));
+
+				//The closest hit along a ray skimming over the level.
+				glm::vec3 rayOrigin = glm::vec3(unitDistribution(randomEngine) * 500.0f, 2.0f + 10.0f * (unitDistribution(randomEngine) + 1.0f), -510.0f);
+				glm::vec3 rayDirection = glm::vec3(unitDistribution(randomEngine) * 0.2f, 0.0f, 1.0f);
+				float hitDistance = -1.0f, expectedHitDistance = 2000.0f;
+				int32_t hitProxy = aabbTree.RayCast(rayOrigin, rayDirection, 2000.0f, &hitDistance);
+				for (const auto& proxyBounds : tightBounds)
+				{
+					float entryDistance = IntersectRayBounds(rayOrigin, 1.0f / rayDirection, aabbTree.RetrieveFatBounds(proxyBounds.first));
+					expectedHitDistance = entryDistance >= 0.0f ? std::min(expectedHitDistance, entryDistance) : expectedHitDistance;
+				}
+				CrescentCheck(hitProxy == DynamicAABBTree::NullNode ? expectedHitDistance == 2000.0f : hitDistance == expectedHitDistance);
+			}
+		}
+
+		CrescentCheck(nudgeReinsertCount == 0);
+		CrescentCheck(jumpReinsertCount > jumpCount * 9 / 10);
+		CrescentCheck(aabbTree.RetrieveHeight() < 40);
+	}
+
+	CrescentBenchmark(DynamicAABBTree_AgainstLinearScan)
+	{
+		//100k proxies. Each frame moves a share of them, mostly by a little, then culls as the renderer does: once for the camera and once per shadow
+		//cascade. The scans are what Scene did before the tree, per entity through Frustum::IntersectsBoundingBox, and the batched SSE test over a box
+		//stream rebuilt once per frame.
+		const unsigned int proxyCount = 100000, frameCount = 16;
+		std::mt19937 randomEngine(5);
+		std::vector<BoundingBox> tightBounds(proxyCount);
+		for (BoundingBox& boundingBox : tightBounds)
+		{
+			boundingBox = GenerateBoundingBox(randomEngine);
+		}
+
+		DynamicAABBTree aabbTree;
+		std::vector<int32_t> proxyIDs(proxyCount);
+		double insertTime = Tests::MeasureMilliseconds([&]()
+		{
+			aabbTree = DynamicAABBTree();
+			for (unsigned int i = 0; i < proxyCount; i++)
+			{
+				proxyIDs[i] = aabbTree.CreateProxy(tightBounds[i], nullptr);
+			}
+		}, 3);
+		std::cout << "    building the tree from " << proxyCount << " proxies: " << insertTime << " ms\n";
+
+		//Cascades are orthographic boxes of growing size ahead of the camera, seen from the light.
+		std::vector<std::vector<Frustum>> frameFrustums(frameCount);
+		glm::vec3 lightDirection = glm::normalize(glm::vec3(0.3f, -1.0f, 0.2f));
+		for (std::vector<Frustum>& frustums : frameFrustums)
+		{
+			std::uniform_real_distribution<float> planarDistribution(-400.0f, 400.0f);
+			glm::vec3 cameraPosition = glm::vec3(planarDistribution(randomEngine), 10.0f, planarDistribution(randomEngine));
+			glm::vec3 cameraForward = glm::normalize(glm::vec3(planarDistribution(randomEngine), 0.0f, planarDistribution(randomEngine)));
+			frustums.push_back(Frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f) * glm::lookAt(cameraPosition, cameraPosition + cameraForward, glm::vec3(0.0f, 1.0f, 0.0f))));
+
+			const float cascadeRadii[] = { 10.0f, 25.0f, 60.0f, 150.0f };
+			for (float cascadeRadius : cascadeRadii)
+			{
+				glm::vec3 cascadeCenter = cameraPosition + cameraForward * cascadeRadius;
+				glm::mat4 lightView = glm::lookAt(cascadeCenter - lightDirection * (cascadeRadius + 50.0f), cascadeCenter, glm::vec3(0.0f, 1.0f, 0.0f));
+				frustums.push_back(Frustum(glm::ortho(-cascadeRadius, cascadeRadius, -cascadeRadius, cascadeRadius, 0.0f, 2.0f * cascadeRadius + 100.0f) * lightView));
+			}
+		}
+
+		const unsigned int movingPercentages[] = { 1, 10 };
+		for (unsigned int movingPercentage : movingPercentages)
+		{
+			//Prepared up front, so every side applies the same movements and none pays for the random numbers. One in twenty moves far.
+			std::uniform_real_distribution<float> nudgeDistribution(-0.02f, 0.02f);
+			std::vector<std::pair<unsigned int, glm::vec3>> frameMovements;
+			for (unsigned int i = 0; i < proxyCount * movingPercentage / 100; i++)
+			{
+				glm::vec3 offset = glm::vec3(nudgeDistribution(randomEngine), 0.0f, nudgeDistribution(randomEngine)) * (i % 20 == 0 ? 200.0f : 1.0f);
+				frameMovements.push_back(std::make_pair((unsigned int)(randomEngine() % proxyCount), offset));
+			}
+
+			std::vector<BoundingBox> scanBounds = tightBounds;
+			size_t scanVisibleCount = 0;
+			double scalarScanTime = Tests::MeasureMilliseconds([&]()
+			{
+				for (const std::vector<Frustum>& frustums : frameFrustums)
+				{
+					for (const auto& frameMovement : frameMovements)
+					{
+						scanBounds[frameMovement.first] = OffsetBoundingBox(scanBounds[frameMovement.first], frameMovement.second);
+					}
+					scanVisibleCount = 0;
+					for (const Frustum& frustum : frustums)
+					{
+						for (unsigned int i = 0; i < proxyCount; i++)
+						{
+							scanVisibleCount += frustum.IntersectsBoundingBox(scanBounds[i]);
+						}
+					}
+				}
+			}, 3);
+
+			BoundingBoxStream boundingBoxStream;
+			std::vector<uint8_t> visibilityResults;
+			size_t streamVisibleCount = 0;
+			scanBounds = tightBounds;
+			double streamScanTime = Tests::MeasureMilliseconds([&]()
+			{
+				for (const std::vector<Frustum>& frustums : frameFrustums)
+				{
+					for (const auto& frameMovement : frameMovements)
+					{
+						scanBounds[frameMovement.first] = OffsetBoundingBox(scanBounds[frameMovement.first], frameMovement.second);
+					}
+					boundingBoxStream.Clear();
+					for (const BoundingBox& boundingBox : scanBounds)
+					{
+						boundingBoxStream.PushBoundingBox(boundingBox);
+					}
+					boundingBoxStream.PadToBatchSize();
+					streamVisibleCount = 0;
+					for (const Frustum& frustum : frustums)
+					{
+						streamVisibleCount += frustum.CullBoundingBoxes(boundingBoxStream, visibilityResults);
+					}
+				}
+			}, 3);
+
+			std::vector<BoundingBox> treeBounds = tightBounds;
+			std::vector<int32_t> treeResults;
+			unsigned int reinsertCount = 0;
+			double treeTime = Tests::MeasureMilliseconds([&]()
+			{
+				reinsertCount = 0;
+				for (const std::vector<Frustum>& frustums : frameFrustums)
+				{
+					for (const auto& frameMovement : frameMovements)
+					{
+						BoundingBox& boundingBox = treeBounds[frameMovement.first];
+						boundingBox = OffsetBoundingBox(boundingBox, frameMovement.second);
+						reinsertCount += aabbTree.MoveProxy(proxyIDs[frameMovement.first], boundingBox);
+					}
+					treeResults.clear();
+					for (const Frustum& frustum : frustums)
+					{
+						aabbTree.QueryFrustum(frustum, treeResults);
+					}
+				}
+			}, 3);
+
+			//Every side ends on the same bounds and cameras. Querying fat boxes finds a superset of what the tight scans find.
+			CrescentCheck(scanVisibleCount > 0 && treeResults.size() >= scanVisibleCount && streamVisibleCount >= scanVisibleCount);
+
+			std::string caseName = std::to_string(movingPercentage) + "% moving, " + std::to_string(reinsertCount / frameCount) + " reinserted per frame";
+			Tests::ReportTimings(caseName + ", against scalar scan", scalarScanTime / frameCount, treeTime / frameCount);
+			Tests::ReportTimings(caseName + ", against SSE stream scan", streamScanTime / frameCount, treeTime / frameCount);
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Scene/Prefab.h"
+#include "Scene/Scene.h"
+#include "Scene/SceneEntity.h"
+#include "Models/Mesh.h"
+#include "Shading/Shader.h"
+#include "Shading/Material.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace Crescent
+{
+	namespace
+	{
+		//A model as the mesh loader leaves it: a tree of nodes, each drawing its own mesh, 3 children to a node.
+		SceneEntity* CreateModelHierarchy(unsigned int nodeCount, Mesh* mesh, Material* material)
+		{
+			std::vector<SceneEntity*> nodeEntities;
+			for (unsigned int i = 0; i < nodeCount; i++)
+			{
+				SceneEntity* nodeEntity = SceneEntity::CreateEntity("Node" + std::to_string(i));
+				nodeEntity->m_Mesh = mesh;
+				nodeEntity->m_Material = material;
+				nodeEntity->SetEntityPosition(glm::vec3((float)i, 0.0f, 0.0f));
+				if (i > 0)
+				{
+					nodeEntities[(i - 1) / 3]->AddChildEntity(nodeEntity);
+				}
+				nodeEntities.push_back(nodeEntity);
+			}
+			return nodeEntities[0];
+		}
+	}
+
+	CrescentTest(Prefab_InstancesShareNodesUntilOverridden)
+	{
+		static Shader shader;
+		static Material prefabMaterial(&shader);
+		static Mesh prefabMesh({ glm::vec3(-1.0f), glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(1.0f) }, { 0, 1, 2 });
+		prefabMesh.CalculateBounds();
+
+		SceneEntity* modelEntity = CreateModelHierarchy(40, &prefabMesh, &prefabMaterial);
+		Prefab prefab("PrefabTestModel", "Resources/Models/PrefabTestModel.obj", modelEntity);
+		CrescentCheck(prefab.RetrieveNodes().size() == 40 && prefab.RetrieveRenderableNodes().size() == 40);
+		bool parentsPrecedeNodes = true;
+		for (uint32_t i = 1; i < prefab.RetrieveNodes().size(); i++)
+		{
+			parentsPrecedeNodes &= prefab.RetrieveNodes()[i].m_ParentIndex < i;
+		}
+		CrescentCheck(parentsPrecedeNodes);
+
+		//Instances are a single entity each, whatever the model's node count. Every byte requested while placing them counts, including pool chunks
+		//and vector growth, so this overstates what stays allocated.
+		const unsigned int placementCount = 10000;
+		Scene instanceScene;
+		size_t bytesBefore = Tests::TestRegistry::RetrieveHeapAllocatedBytes();
+		for (unsigned int i = 0; i < placementCount; i++)
+		{
+			instanceScene.ConstructNewEntity(&prefab)->SetEntityPosition(glm::vec3((float)i, 0.0f, 0.0f));
+		}
+		size_t instanceBytes = (Tests::TestRegistry::RetrieveHeapAllocatedBytes() - bytesBefore) / placementCount;
+		CrescentCheck(instanceScene.RetrieveSceneEntities().size() == placementCount && instanceScene.RetrieveSceneEntities()[0]->RetrieveChildCount() == 0);
+		CrescentCheck(instanceBytes < 1024);
+
+		//What placing the model cost before prefabs, copying its whole entity hierarchy.
+		const unsigned int copyCount = 1000;
+		Scene copyScene;
+		bytesBefore = Tests::TestRegistry::RetrieveHeapAllocatedBytes();
+		for (unsigned int i = 0; i < copyCount; i++)
+		{
+			copyScene.ConstructNewEntity(modelEntity);
+		}
+		size_t copyBytes = (Tests::TestRegistry::RetrieveHeapAllocatedBytes() - bytesBefore) / copyCount;
+		CrescentCheck(copyBytes > instanceBytes * 20);
+
+		//A material edit copies the node's material for that instance alone. Transform overrides move only the instance's node.
+		SceneEntity* editedInstance = instanceScene.RetrieveSceneEntities()[0];
+		SceneEntity* otherInstance = instanceScene.RetrieveSceneEntities()[1];
+		Material* overriddenMaterial = editedInstance->OverridePrefabMaterial(5);
+		CrescentCheck(overriddenMaterial != &prefabMaterial && editedInstance->OverridePrefabMaterial(5) == overriddenMaterial);
+		CrescentCheck(editedInstance->RetrievePrefabMaterial(5) == overriddenMaterial && editedInstance->RetrievePrefabMaterial(4) == &prefabMaterial);
+		CrescentCheck(otherInstance->RetrievePrefabMaterial(5) == &prefabMaterial && otherInstance->RetrievePrefabOverrides().empty());
+
+		glm::mat4 movedTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 10.0f, 0.0f));
+		editedInstance->OverridePrefabTransform(1, movedTransform);
+		std::vector<glm::mat4> editedTransforms;
+		prefab.ResolveRootTransforms(editedInstance->RetrievePrefabOverrides(), editedTransforms);
+		CrescentCheck(editedTransforms[1] == movedTransform && editedTransforms[0] == prefab.RetrieveRootTransforms()[0]);
+		CrescentCheck(prefab.RetrieveNodes()[1].m_LocalTransform != movedTransform);
+
+		//Copying an instance carries its overrides along, with a material of its own.
+		SceneEntity* copiedInstance = instanceScene.ConstructNewEntity(editedInstance);
+		CrescentCheck(copiedInstance->RetrievePrefab() == &prefab && copiedInstance->RetrievePrefabOverrides().size() == editedInstance->RetrievePrefabOverrides().size());
+		CrescentCheck(copiedInstance->RetrievePrefabMaterial(5) != overriddenMaterial && copiedInstance->RetrievePrefabMaterial(5) != &prefabMaterial);
+
+		editedInstance->RevertPrefabOverrides();
+		CrescentCheck(editedInstance->RetrievePrefabOverrides().empty() && editedInstance->RetrievePrefabMaterial(5) == &prefabMaterial);
+
+		instanceScene.ClearScene();
+		copyScene.ClearScene();
+		SceneEntity::DestroyEntityHierarchy(modelEntity);
+	}
+}
@@ -0,0 +1,422 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Scene/SceneSerializer.h"
+#include "Scene/Scene.h"
+#include "Scene/SceneEntity.h"
+#include "Scene/Prefab.h"
+#include "Rendering/Resources.h"
+#include "Lighting/DirectionalLight.h"
+#include "Lighting/PointLight.h"
+#include "Models/Mesh.h"
+#include "Shading/Shader.h"
+#include "Shading/Material.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <random>
+#include <iostream>
+
+namespace Crescent
+{
+	namespace
+	{
+		//Registered with the resource manager up front, so loading a scene finds them by name rather than reading their model files.
+		Prefab* ConstructTestPrefab(const std::string& prefabName, Mesh* mesh, Material* material)
+		{
+			SceneEntity* rootEntity = SceneEntity::CreateEntity(prefabName);
+			SceneEntity* bodyEntity = SceneEntity::CreateEntity("Body");
+			bodyEntity->m_Mesh = mesh;
+			bodyEntity->m_Material = material;
+			bodyEntity->SetEntityPosition(glm::vec3(0.0f, 1.0f, 0.0f));
+			rootEntity->AddChildEntity(bodyEntity);
+
+			Prefab* prefab = Resources::AddPrefab(new Prefab(prefabName, "Resources/Models/" + prefabName + ".obj", rootEntity));
+			SceneEntity::DestroyEntityHierarchy(rootEntity);
+			return prefab;
+		}
+
+		std::vector<char> ReadFileBytes(const std::string& filePath)
+		{
+			std::ifstream fileStream(filePath, std::ios::binary);
+			return std::vector<char>(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+		}
+
+		void WriteFileBytes(const std::string& filePath, const std::vector<char>& fileBytes)
+		{
+			std::ofstream fileStream(filePath, std::ios::binary | std::ios::trunc);
+			fileStream.write(fileBytes.data(), fileBytes.size());
+		}
+
+		//Walks both hierarchies side by side, comparing everything a scene file stores.
+		bool CompareEntities(SceneEntity* savedEntity, SceneEntity* loadedEntity)
+		{
+			if (savedEntity->RetrieveEntityName() != loadedEntity->RetrieveEntityName() || savedEntity->RetrieveEntityPosition() != loadedEntity->RetrieveEntityPosition() ||
+				savedEntity->RetrieveEntityRotation() != loadedEntity->RetrieveEntityRotation() || savedEntity->RetrieveEntityScale() != loadedEntity->RetrieveEntityScale() ||
+				savedEntity->RetrievePrefab() != loadedEntity->RetrievePrefab() || savedEntity->RetrieveChildCount() != loadedEntity->RetrieveChildCount())
+			{
+				return false;
+			}
+
+			const std::vector<PrefabOverride>& savedOverrides = savedEntity->RetrievePrefabOverrides();
+			const std::vector<PrefabOverride>& loadedOverrides = loadedEntity->RetrievePrefabOverrides();
+			if (savedOverrides.size() != loadedOverrides.size())
+			{
+				return false;
+			}
+			for (size_t i = 0; i < savedOverrides.size(); i++)
+			{
+				if (savedOverrides[i].m_NodeIndex != loadedOverrides[i].m_NodeIndex || savedOverrides[i].m_LocalTransform != loadedOverrides[i].m_LocalTransform)
+				{
+					return false;
+				}
+			}
+
+			SceneEntity* loadedChild = loadedEntity->RetrieveFirstChild();
+			for (SceneEntity* savedChild = savedEntity->RetrieveFirstChild(); savedChild; savedChild = savedChild->RetrieveNextSibling())
+			{
+				if (!CompareEntities(savedChild, loadedChild))
+				{
+					return false;
+				}
+				loadedChild = loadedChild->RetrieveNextSibling();
+			}
+			return true;
+		}
+
+		//An entity of the generated benchmark scene, parented to an earlier one or to none.
+		struct GeneratedEntity
+		{
+			std::string m_EntityName;
+			uint32_t m_ParentIndex = InvalidSceneFileIndex;
+			int m_PrefabIndex = -1;
+			glm::vec3 m_Position;
+			glm::vec3 m_Rotation;
+			glm::vec3 m_Scale;
+			bool m_TransformOverridden = false;
+			glm::mat4 m_OverrideTransform = glm::mat4(1.0f);
+		};
+
+		std::vector<GeneratedEntity> GenerateEntities(size_t entityCount, int prefabCount)
+		{
+			std::mt19937 randomEngine(19);
+			std::uniform_real_distribution<float> positionDistribution(-100.0f, 100.0f);
+			std::uniform_real_distribution<float> angleDistribution(0.0f, 360.0f);
+			std::uniform_real_distribution<float> scaleDistribution(0.5f, 2.0f);
+			std::uniform_int_distribution<int> percentDistribution(0, 99);
+
+			std::vector<GeneratedEntity> generatedEntities(entityCount);
+			for (size_t i = 0; i < entityCount; i++)
+			{
+				GeneratedEntity& generatedEntity = generatedEntities[i];
+				generatedEntity.m_EntityName = "Entity" + std::to_string(i);
+				if (i > 0 && percentDistribution(randomEngine) >= 30)
+				{
+					generatedEntity.m_ParentIndex = std::uniform_int_distribution<uint32_t>(0, (uint32_t)i - 1)(randomEngine);
+				}
+				generatedEntity.m_Position = glm::vec3(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine));
+				generatedEntity.m_Rotation = glm::vec3(angleDistribution(randomEngine), angleDistribution(randomEngine), 0.0f);
+				generatedEntity.m_Scale = glm::vec3(scaleDistribution(randomEngine));
+
+				//Half of all entities instance a prefab, a fifth of which move its body node.
+				if (percentDistribution(randomEngine) < 50)
+				{
+					generatedEntity.m_PrefabIndex = percentDistribution(randomEngine) % prefabCount;
+					if (percentDistribution(randomEngine) < 20)
+					{
+						generatedEntity.m_TransformOverridden = true;
+						generatedEntity.m_OverrideTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, positionDistribution(randomEngine), 0.0f));
+					}
+				}
+			}
+			return generatedEntities;
+		}
+
+		//Creates the generated entities through the same calls loading a scene makes.
+		void ConstructGeneratedEntities(Scene* scene, const std::vector<GeneratedEntity>& generatedEntities, const std::vector<Prefab*>& prefabs)
+		{
+			std::vector<SceneEntity*> sceneEntities(generatedEntities.size(), nullptr);
+			for (size_t i = 0; i < generatedEntities.size(); i++)
+			{
+				const GeneratedEntity& generatedEntity = generatedEntities[i];
+				SceneEntity* sceneEntity;
+				if (generatedEntity.m_ParentIndex != InvalidSceneFileIndex)
+				{
+					sceneEntity = SceneEntity::CreateEntity(generatedEntity.m_EntityName);
+					sceneEntities[generatedEntity.m_ParentIndex]->AddChildEntity(sceneEntity);
+				}
+				else
+				{
+					sceneEntity = scene->ConstructNewEntity();
+					sceneEntity->SetEntityName(generatedEntity.m_EntityName);
+				}
+
+				sceneEntity->SetEntityPosition(generatedEntity.m_Position);
+				sceneEntity->SetEntityRotation(generatedEntity.m_Rotation);
+				sceneEntity->SetEntityScale(generatedEntity.m_Scale);
+				if (generatedEntity.m_PrefabIndex >= 0)
+				{
+					sceneEntity->SetPrefab(prefabs[generatedEntity.m_PrefabIndex]);
+					if (generatedEntity.m_TransformOverridden)
+					{
+						sceneEntity->OverridePrefabTransform(1, generatedEntity.m_OverrideTransform);
+					}
+				}
+				sceneEntities[i] = sceneEntity;
+			}
+		}
+	}
+
+	CrescentTest(SceneSerializer_RoundTripsHierarchyPrefabsAndLights)
+	{
+		//The prefabs stay registered after the test, so what they reference outlives it.
+		static Shader shader;
+		static Material crateMaterial(&shader);
+		static Material lampMaterial(&shader);
+		static Mesh crateMesh({ glm::vec3(-1.0f), glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(1.0f) }, { 0, 1, 2 });
+		static Mesh lampMesh({ glm::vec3(-0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f) }, { 0, 1, 2 });
+		crateMesh.CalculateBounds();
+		lampMesh.CalculateBounds();
+		Prefab* cratePrefab = ConstructTestPrefab("SerializerTestCrate", &crateMesh, &crateMaterial);
+		Prefab* lampPrefab = ConstructTestPrefab("SerializerTestLamp", &lampMesh, &lampMaterial);
+
+		//Two roots, one holding a prefab child which in turn holds an empty grandchild. Entities are given distinct transforms and one node override.
+		Scene savedScene;
+		SceneEntity* crateEntity = savedScene.ConstructNewEntity(cratePrefab);
+		crateEntity->SetEntityPosition(glm::vec3(3.0f, -2.0f, 7.5f));
+		crateEntity->SetEntityRotation(glm::vec3(0.0f, 45.0f, 10.0f));
+		crateEntity->SetEntityScale(glm::vec3(2.0f, 1.0f, 0.5f));
+		crateEntity->OverridePrefabTransform(1, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 4.0f, 0.0f)));
+
+		SceneEntity* lampEntity = SceneEntity::CreateEntity("Lamp");
+		lampEntity->SetPrefab(lampPrefab);
+		lampEntity->SetEntityPosition(glm::vec3(0.0f, 2.0f, 0.0f));
+		crateEntity->AddChildEntity(lampEntity);
+
+		SceneEntity* anchorEntity = SceneEntity::CreateEntity("Anchor");
+		anchorEntity->SetEntityRotation(glm::vec3(90.0f, 0.0f, 0.0f));
+		lampEntity->AddChildEntity(anchorEntity);
+
+		SceneEntity* emptyEntity = savedScene.ConstructNewEntity();
+		emptyEntity->SetEntityName("Empty");
+		emptyEntity->SetEntityScale(3.0f);
+
+		DirectionalLight directionalLight;
+		directionalLight.m_LightDirection = glm::vec3(0.2f, -1.0f, 0.3f);
+		directionalLight.m_LightColor = glm::vec3(1.0f, 0.9f, 0.8f);
+		directionalLight.m_LightIntensity = 3.5f;
+		directionalLight.m_ShadowCastingEnabled = false;
+
+		PointLight pointLight;
+		pointLight.m_LightPosition = glm::vec3(-4.0f, 1.0f, 6.0f);
+		pointLight.m_LightColor = glm::vec3(0.1f, 0.5f, 1.0f);
+		pointLight.m_LightIntensity = 12.0f;
+		pointLight.m_LightRadius = 9.0f;
+		pointLight.m_RenderMesh = true;
+
+		const std::string scenePath = "SceneSerializerTest.scene";
+		CrescentCheck(SceneSerializer::SaveScene(scenePath, &savedScene, { &directionalLight }, { &pointLight }));
+
+		Scene loadedScene;
+		std::vector<DirectionalLight> loadedDirectionalLights;
+		std::vector<PointLight> loadedPointLights;
+		CrescentCheck(SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, loadedDirectionalLights, loadedPointLights));
+
+		//Prefabs are resolved through the resource manager, so loaded instances share the saved instances' meshes and materials.
+		std::vector<SceneEntity*> savedEntities = savedScene.RetrieveSceneEntities();
+		std::vector<SceneEntity*> loadedEntities = loadedScene.RetrieveSceneEntities();
+		CrescentCheck(loadedEntities.size() == savedEntities.size());
+		for (size_t i = 0; i < savedEntities.size() && i < loadedEntities.size(); i++)
+		{
+			CrescentCheck(loadedEntities[i]->RetrieveParentEntity() == nullptr);
+			CrescentCheck(CompareEntities(savedEntities[i], loadedEntities[i]));
+		}
+
+		SceneEntity* loadedCrate = loadedEntities.empty() ? nullptr : loadedEntities[0];
+		if (loadedCrate && loadedCrate->RetrieveFirstChild())
+		{
+			SceneEntity* loadedLamp = loadedCrate->RetrieveFirstChild();
+			CrescentCheck(loadedCrate->RetrievePrefabMaterial(1) == &crateMaterial && loadedCrate->RetrievePrefab()->RetrieveNodes()[1].m_Mesh == &crateMesh);
+			CrescentCheck(loadedLamp->RetrievePrefabMaterial(1) == &lampMaterial && loadedLamp->RetrievePrefab()->RetrieveNodes()[1].m_Mesh == &lampMesh);
+			CrescentCheck(loadedLamp->RetrieveParentEntity() == loadedCrate && loadedLamp->RetrieveFirstChild()->RetrieveEntityName() == "Anchor");
+		}
+
+		CrescentCheck(loadedDirectionalLights.size() == 1 && loadedPointLights.size() == 1);
+		if (loadedDirectionalLights.size() == 1 && loadedPointLights.size() == 1)
+		{
+			CrescentCheck(loadedDirectionalLights[0].m_LightDirection == directionalLight.m_LightDirection && loadedDirectionalLights[0].m_LightColor == directionalLight.m_LightColor);
+			CrescentCheck(loadedDirectionalLights[0].m_LightIntensity == directionalLight.m_LightIntensity && !loadedDirectionalLights[0].m_ShadowCastingEnabled);
+			CrescentCheck(loadedPointLights[0].m_LightPosition == pointLight.m_LightPosition && loadedPointLights[0].m_LightColor == pointLight.m_LightColor);
+			CrescentCheck(loadedPointLights[0].m_LightIntensity == pointLight.m_LightIntensity && loadedPointLights[0].m_LightRadius == pointLight.m_LightRadius);
+			CrescentCheck(loadedPointLights[0].m_RenderMesh);
+		}
+
+		savedScene.ClearScene();
+		loadedScene.ClearScene();
+		std::remove(scenePath.c_str());
+	}
+
+	CrescentTest(SceneSerializer_RejectsTruncatedAndMismatchedFiles)
+	{
+		Scene savedScene;
+		SceneEntity* sceneEntity = savedScene.ConstructNewEntity();
+		sceneEntity->AddChildEntity(SceneEntity::CreateEntity("Child"));
+		PointLight pointLight;
+
+		const std::string scenePath = "SceneSerializerRejectTest.scene";
+		CrescentCheck(SceneSerializer::SaveScene(scenePath, &savedScene, {}, { &pointLight }));
+		std::vector<char> fileBytes = ReadFileBytes(scenePath);
+		CrescentCheck(fileBytes.size() > sizeof(SceneFileHeader));
+
+		//A rejected file must leave the scene and light lists untouched.
+		Scene loadedScene;
+		std::vector<DirectionalLight> directionalLights;
+		std::vector<PointLight> pointLights;
+
+		std::vector<char> truncatedBytes(fileBytes.begin(), fileBytes.end() - 8);
+		WriteFileBytes(scenePath, truncatedBytes);
+		CrescentCheck(!SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, directionalLights, pointLights));
+
+		truncatedBytes.resize(sizeof(SceneFileHeader) / 2);
+		WriteFileBytes(scenePath, truncatedBytes);
+		CrescentCheck(!SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, directionalLights, pointLights));
+
+		std::vector<char> mismatchedBytes = fileBytes;
+		uint32_t olderVersion = SceneFileVersion - 1;
+		memcpy(mismatchedBytes.data() + offsetof(SceneFileHeader, m_Version), &olderVersion, sizeof(uint32_t));
+		WriteFileBytes(scenePath, mismatchedBytes);
+		CrescentCheck(!SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, directionalLights, pointLights));
+
+		mismatchedBytes = fileBytes;
+		mismatchedBytes[offsetof(SceneFileHeader, m_Magic)] ^= 0xFF;
+		WriteFileBytes(scenePath, mismatchedBytes);
+		CrescentCheck(!SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, directionalLights, pointLights));
+
+		CrescentCheck(loadedScene.RetrieveSceneEntities().empty() && directionalLights.empty() && pointLights.empty());
+
+		//The untouched file still loads.
+		WriteFileBytes(scenePath, fileBytes);
+		CrescentCheck(SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, directionalLights, pointLights));
+		CrescentCheck(loadedScene.RetrieveSceneEntities().size() == 1 && loadedScene.RetrieveSceneEntities()[0]->RetrieveChildCount() == 1 && pointLights.size() == 1);
+
+		savedScene.ClearScene();
+		loadedScene.ClearScene();
+		std::remove(scenePath.c_str());
+	}
+
+	CrescentTest(SceneSerializer_StoresPrefabMeshData)
+	{
+		static Shader shader;
+		static Material meshMaterial(&shader);
+		static Mesh storedMesh({ glm::vec3(-2.0f, 0.0f, 0.0f), glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }, { 0, 1, 2, 0, 2, 3 });
+		storedMesh.CalculateBounds();
+		Prefab* firstPrefab = ConstructTestPrefab("SerializerTestStoredFirst", &storedMesh, &meshMaterial);
+		Prefab* secondPrefab = ConstructTestPrefab("SerializerTestStoredSecond", &storedMesh, &meshMaterial);
+
+		Scene savedScene;
+		savedScene.ConstructNewEntity(firstPrefab);
+		savedScene.ConstructNewEntity(secondPrefab);
+
+		const std::string scenePath = "SceneSerializerMeshDataTest.scene";
+		CrescentCheck(SceneSerializer::SaveScene(scenePath, &savedScene, {}, {}));
+		std::vector<char> fileBytes = ReadFileBytes(scenePath);
+		CrescentCheck(fileBytes.size() > sizeof(SceneFileHeader));
+		if (fileBytes.size() <= sizeof(SceneFileHeader))
+		{
+			savedScene.ClearScene();
+			std::remove(scenePath.c_str());
+			return;
+		}
+
+		//Both prefabs keep their nodes, while the mesh and material they share are written once.
+		SceneFileHeader fileHeader;
+		memcpy(&fileHeader, fileBytes.data(), sizeof(SceneFileHeader));
+		CrescentCheck(fileHeader.m_Assets.m_Count == 2 && fileHeader.m_PrefabNodes.m_Count == 4);
+		CrescentCheck(fileHeader.m_Meshes.m_Count == 1 && fileHeader.m_Materials.m_Count == 1);
+		if (fileHeader.m_Meshes.m_Count == 1)
+		{
+			SceneFileMesh fileMesh;
+			memcpy(&fileMesh, fileBytes.data() + fileHeader.m_Meshes.m_Offset, sizeof(SceneFileMesh));
+			CrescentCheck(fileMesh.m_VertexCount == storedMesh.m_Positions.size() && fileMesh.m_IndexCount == storedMesh.m_Indices.size());
+			CrescentCheck(fileMesh.m_UVOffset == InvalidSceneFileOffset && fileMesh.m_NormalsOffset == InvalidSceneFileOffset && fileMesh.m_TangentsOffset == InvalidSceneFileOffset);
+
+			const char* meshData = fileBytes.data() + fileHeader.m_MeshData.m_Offset;
+			CrescentCheck(memcmp(meshData + fileMesh.m_PositionsOffset, storedMesh.m_Positions.data(), storedMesh.m_Positions.size() * sizeof(glm::vec3)) == 0);
+			CrescentCheck(memcmp(meshData + fileMesh.m_IndicesOffset, storedMesh.m_Indices.data(), storedMesh.m_Indices.size() * sizeof(unsigned int)) == 0);
+		}
+
+		savedScene.ClearScene();
+		std::remove(scenePath.c_str());
+	}
+
+	CrescentBenchmark(SceneSerializer_LoadAgainstConstructingInCode)
+	{
+		static Shader shader;
+		static Material benchmarkMaterial(&shader);
+		static Mesh benchmarkMesh({ glm::vec3(-1.0f), glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(1.0f) }, { 0, 1, 2 });
+		benchmarkMesh.CalculateBounds();
+		std::vector<Prefab*> prefabs;
+		for (int i = 0; i < 4; i++)
+		{
+			prefabs.push_back(ConstructTestPrefab("SerializerBenchmarkPrefab" + std::to_string(i), &benchmarkMesh, &benchmarkMaterial));
+		}
+
+		const size_t entityCount = 100000;
+		std::vector<GeneratedEntity> generatedEntities = GenerateEntities(entityCount, (int)prefabs.size());
+		Scene savedScene;
+		ConstructGeneratedEntities(&savedScene, generatedEntities, prefabs);
+
+		const std::string scenePath = "SceneSerializerBenchmark.scene";
+		bool sceneSaved = true;
+		double saveTime = Tests::MeasureMilliseconds([&]()
+		{
+			sceneSaved &= SceneSerializer::SaveScene(scenePath, &savedScene, {}, {});
+		}, 3);
+		CrescentCheck(sceneSaved);
+
+		//Scenes are cleared between runs, outside of the timings.
+		double constructionTime = 0.0;
+		double loadTime = 0.0;
+		for (int i = 0; i < 3; i++)
+		{
+			Scene constructedScene;
+			double runConstructionTime = Tests::MeasureMilliseconds([&]()
+			{
+				ConstructGeneratedEntities(&constructedScene, generatedEntities, prefabs);
+			}, 1);
+			constructionTime = i == 0 ? runConstructionTime : std::min(constructionTime, runConstructionTime);
+			constructedScene.ClearScene();
+
+			Scene loadedScene;
+			std::vector<DirectionalLight> directionalLights;
+			std::vector<PointLight> pointLights;
+			bool sceneLoaded = false;
+			double runLoadTime = Tests::MeasureMilliseconds([&]()
+			{
+				sceneLoaded = SceneSerializer::LoadScene(scenePath, nullptr, &loadedScene, directionalLights, pointLights);
+			}, 1);
+			loadTime = i == 0 ? runLoadTime : std::min(loadTime, runLoadTime);
+			CrescentCheck(sceneLoaded);
+
+			if (i == 0)
+			{
+				std::vector<SceneEntity*> savedEntities = savedScene.RetrieveSceneEntities();
+				std::vector<SceneEntity*> loadedEntities = loadedScene.RetrieveSceneEntities();
+				bool entitiesMatch = loadedEntities.size() == savedEntities.size();
+				for (size_t j = 0; j < savedEntities.size() && entitiesMatch; j++)
+				{
+					entitiesMatch = CompareEntities(savedEntities[j], loadedEntities[j]);
+				}
+				CrescentCheck(entitiesMatch);
+			}
+			loadedScene.ClearScene();
+		}
+
+		std::cout << "    saving " << entityCount << " entities: " << saveTime << " ms\n";
+		Tests::ReportTimings("loading " + std::to_string(entityCount) + " entities against constructing them in code", constructionTime, loadTime);
+		savedScene.ClearScene();
+		std::remove(scenePath.c_str());
+	}
+}
@@ -0,0 +1,301 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Scene/TransformHierarchy.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <random>
+#include <memory>
+
+namespace Crescent
+{
+	namespace
+	{
+		//Parent of each node, always an earlier node or -1 for roots.
+		std::vector<int32_t> GenerateDeepHierarchy(uint32_t chainCount, uint32_t chainLength)
+		{
+			std::vector<int32_t> parentIndices(chainCount * chainLength);
+			for (uint32_t i = 0; i < parentIndices.size(); i++)
+			{
+				parentIndices[i] = i % chainLength == 0 ? -1 : (int32_t)i - 1;
+			}
+			return parentIndices;
+		}
+
+		std::vector<int32_t> GenerateWideHierarchy(uint32_t nodeCount)
+		{
+			std::vector<int32_t> parentIndices(nodeCount, 0);
+			parentIndices[0] = -1;
+			return parentIndices;
+		}
+
+		std::vector<int32_t> GenerateRandomHierarchy(uint32_t nodeCount, uint32_t rootCount, unsigned int seed)
+		{
+			std::mt19937 randomEngine(seed);
+			std::vector<int32_t> parentIndices(nodeCount);
+			for (uint32_t i = 0; i < nodeCount; i++)
+			{
+				parentIndices[i] = i < rootCount ? -1 : (int32_t)(randomEngine() % i);
+			}
+			return parentIndices;
+		}
+
+		struct LocalValues
+		{
+			glm::vec3 m_Position;
+			glm::vec3 m_Rotation;
+			glm::vec3 m_Scale;
+		};
+
+		std::vector<LocalValues> GenerateLocalValues(size_t nodeCount, unsigned int seed)
+		{
+			std::mt19937 randomEngine(seed);
+			std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+			std::vector<LocalValues> localValues(nodeCount);
+			for (LocalValues& nodeValues : localValues)
+			{
+				nodeValues.m_Position = glm::vec3(unitDistribution(randomEngine), unitDistribution(randomEngine), unitDistribution(randomEngine));
+				nodeValues.m_Rotation = glm::vec3(unitDistribution(randomEngine), unitDistribution(randomEngine), unitDistribution(randomEngine)) * 0.1f;
+				nodeValues.m_Scale = glm::vec3(1.0f + 0.001f * unitDistribution(randomEngine));
+			}
+			return localValues;
+		}
+
+		glm::mat4 ComposeReferenceTransform(const LocalValues& nodeValues)
+		{
+			return glm::translate(glm::mat4(1.0f), nodeValues.m_Position) * glm::toMat4(glm::quat(nodeValues.m_Rotation)) * glm::scale(glm::mat4(1.0f), nodeValues.m_Scale);
+		}
+
+		//The layout entities used before the hierarchy: a separately allocated node per entity, updated by recursing through child pointers.
+		struct LegacyTransformNode
+		{
+			LocalValues m_LocalValues;
+			glm::mat4 m_Transform = glm::mat4(1.0f);
+			bool m_IsTransformDirty = true;
+			bool m_TransformChanged = false;
+			LegacyTransformNode* m_ParentNode = nullptr;
+			std::vector<LegacyTransformNode*> m_ChildNodes;
+
+			void UpdateTransform()
+			{
+				if (m_IsTransformDirty)
+				{
+					m_Transform = ComposeReferenceTransform(m_LocalValues);
+					if (m_ParentNode != nullptr)
+					{
+						m_Transform = m_ParentNode->m_Transform * m_Transform;
+					}
+					m_TransformChanged = true;
+				}
+
+				for (LegacyTransformNode* childNode : m_ChildNodes)
+				{
+					if (m_IsTransformDirty)
+					{
+						childNode->m_IsTransformDirty = true;
+					}
+					childNode->UpdateTransform();
+				}
+				m_IsTransformDirty = false;
+			}
+		};
+
+		bool MatricesMatch(const glm::mat4& firstMatrix, const glm::mat4& secondMatrix)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				//Relative, as translations grow along deep chains.
+				if (glm::any(glm::greaterThan(glm::abs(firstMatrix[i] - secondMatrix[i]), (glm::abs(secondMatrix[i]) + 1.0f) * 1e-3f)))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		//World matrices straight from the definition, following parents up to the root.
+		glm::mat4 ComputeReferenceWorldTransform(uint32_t nodeIndex, const std::vector<int32_t>& parentIndices, const std::vector<LocalValues>& localValues)
+		{
+			glm::mat4 worldTransform = ComposeReferenceTransform(localValues[nodeIndex]);
+			for (int32_t parentIndex = parentIndices[nodeIndex]; parentIndex >= 0; parentIndex = parentIndices[parentIndex])
+			{
+				worldTransform = ComposeReferenceTransform(localValues[parentIndex]) * worldTransform;
+			}
+			return worldTransform;
+		}
+	}
+
+	CrescentTest(TransformHierarchy_MatchesReferenceAcrossEdits)
+	{
+		const uint32_t nodeCount = 2000;
+		std::vector<int32_t> parentIndices = GenerateRandomHierarchy(nodeCount, 8, 3);
+		std::vector<LocalValues> localValues = GenerateLocalValues(nodeCount, 5);
+		std::vector<uint8_t> releasedNodes(nodeCount, 0);
+
+		TransformHierarchy transformHierarchy;
+		std::vector<TransformHandle> transformHandles(nodeCount);
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			transformHandles[i] = transformHierarchy.CreateTransform();
+			if (parentIndices[i] >= 0)
+			{
+				transformHierarchy.SetParent(transformHandles[i], transformHandles[parentIndices[i]]);
+			}
+		}
+
+		auto applyLocalValues = [&](uint32_t nodeIndex)
+		{
+			transformHierarchy.RetrieveLocalPosition(transformHandles[nodeIndex]) = localValues[nodeIndex].m_Position;
+			transformHierarchy.RetrieveLocalRotation(transformHandles[nodeIndex]) = localValues[nodeIndex].m_Rotation;
+			transformHierarchy.RetrieveLocalScale(transformHandles[nodeIndex]) = localValues[nodeIndex].m_Scale;
+			transformHierarchy.MarkTransformDirty(transformHandles[nodeIndex]);
+		};
+		auto checkAgainstReference = [&]()
+		{
+			transformHierarchy.UpdateWorldTransforms();
+			bool transformsMatch = true;
+			for (uint32_t i = 0; i < nodeCount; i++)
+			{
+				if (!releasedNodes[i])
+				{
+					transformsMatch &= MatricesMatch(transformHierarchy.RetrieveWorldTransform(transformHandles[i]), ComputeReferenceWorldTransform(i, parentIndices, localValues));
+				}
+			}
+			CrescentCheck(transformsMatch);
+		};
+
+		for (uint32_t i = 0; i < nodeCount; i++)
+		{
+			applyLocalValues(i);
+		}
+		checkAgainstReference();
+		CrescentCheck(transformHierarchy.ConsumeRecomputedTransformCount() == nodeCount);
+
+		//Editing a few nodes only recomputes their subtrees.
+		std::mt19937 randomEngine(9);
+		std::vector<LocalValues> editedValues = GenerateLocalValues(nodeCount, 13);
+		for (unsigned int i = 0; i < 20; i++)
+		{
+			uint32_t nodeIndex = 100 + randomEngine() % (nodeCount - 100);
+			localValues[nodeIndex] = editedValues[nodeIndex];
+			applyLocalValues(nodeIndex);
+		}
+		checkAgainstReference();
+		CrescentCheck(transformHierarchy.ConsumeRecomputedTransformCount() < nodeCount / 2);
+
+		//Reparenting to earlier nodes, and releasing nodes, whose children then become roots.
+		for (unsigned int i = 0; i < 50; i++)
+		{
+			uint32_t nodeIndex = 10 + randomEngine() % (nodeCount - 10);
+			parentIndices[nodeIndex] = (int32_t)(randomEngine() % nodeIndex);
+			if (releasedNodes[parentIndices[nodeIndex]])
+			{
+				parentIndices[nodeIndex] = -1;
+			}
+			transformHierarchy.SetParent(transformHandles[nodeIndex], parentIndices[nodeIndex] >= 0 ? transformHandles[parentIndices[nodeIndex]] : InvalidTransformHandle);
+		}
+		for (unsigned int i = 0; i < 30; i++)
+		{
+			uint32_t nodeIndex = randomEngine() % nodeCount;
+			if (releasedNodes[nodeIndex])
+			{
+				continue;
+			}
+			transformHierarchy.ReleaseTransform(transformHandles[nodeIndex]);
+			releasedNodes[nodeIndex] = 1;
+			for (uint32_t j = 0; j < nodeCount; j++)
+			{
+				parentIndices[j] = parentIndices[j] == (int32_t)nodeIndex ? -1 : parentIndices[j];
+			}
+		}
+		checkAgainstReference();
+	}
+
+	CrescentBenchmark(TransformHierarchy_AgainstRecursivePointerTree)
+	{
+		//100k nodes per shape. Every node is marked dirty before each run, then again with 1% of them, and both layouts compose the same matrices.
+		struct HierarchyShape
+		{
+			const char* m_ShapeName;
+			std::vector<int32_t> m_ParentIndices;
+		};
+		HierarchyShape hierarchyShapes[] = { { "deep, 100 chains x 1000", GenerateDeepHierarchy(100, 1000) }, { "wide, 1 root x 99999", GenerateWideHierarchy(100000) },
+			{ "random, 64 roots", GenerateRandomHierarchy(100000, 64, 17) } };
+
+		for (const HierarchyShape& hierarchyShape : hierarchyShapes)
+		{
+			const std::vector<int32_t>& parentIndices = hierarchyShape.m_ParentIndices;
+			const uint32_t nodeCount = (uint32_t)parentIndices.size();
+			std::vector<LocalValues> localValues = GenerateLocalValues(nodeCount, nodeCount);
+
+			//Allocated one by one, as entities were.
+			std::vector<std::unique_ptr<LegacyTransformNode>> legacyNodes(nodeCount);
+			for (uint32_t i = 0; i < nodeCount; i++)
+			{
+				legacyNodes[i].reset(new LegacyTransformNode());
+				legacyNodes[i]->m_LocalValues = localValues[i];
+			}
+			std::vector<LegacyTransformNode*> legacyRoots;
+			for (uint32_t i = 0; i < nodeCount; i++)
+			{
+				if (parentIndices[i] >= 0)
+				{
+					legacyNodes[i]->m_ParentNode = legacyNodes[parentIndices[i]].get();
+					legacyNodes[parentIndices[i]]->m_ChildNodes.push_back(legacyNodes[i].get());
+				}
+				else
+				{
+					legacyRoots.push_back(legacyNodes[i].get());
+				}
+			}
+
+			TransformHierarchy transformHierarchy;
+			std::vector<TransformHandle> transformHandles(nodeCount);
+			for (uint32_t i = 0; i < nodeCount; i++)
+			{
+				transformHandles[i] = transformHierarchy.CreateTransform();
+				transformHierarchy.RetrieveLocalPosition(transformHandles[i]) = localValues[i].m_Position;
+				transformHierarchy.RetrieveLocalRotation(transformHandles[i]) = localValues[i].m_Rotation;
+				transformHierarchy.RetrieveLocalScale(transformHandles[i]) = localValues[i].m_Scale;
+				if (parentIndices[i] >= 0)
+				{
+					transformHierarchy.SetParent(transformHandles[i], transformHandles[parentIndices[i]]);
+				}
+			}
+			transformHierarchy.UpdateWorldTransforms();
+
+			const uint32_t dirtyStrides[] = { 1, 100 };
+			for (uint32_t dirtyStride : dirtyStrides)
+			{
+				double legacyTime = Tests::MeasureMilliseconds([&]()
+				{
+					for (uint32_t i = 0; i < nodeCount; i += dirtyStride)
+					{
+						legacyNodes[i]->m_IsTransformDirty = true;
+					}
+					for (LegacyTransformNode* legacyRoot : legacyRoots)
+					{
+						legacyRoot->UpdateTransform();
+					}
+				});
+
+				double hierarchyTime = Tests::MeasureMilliseconds([&]()
+				{
+					for (uint32_t i = 0; i < nodeCount; i += dirtyStride)
+					{
+						transformHierarchy.MarkTransformDirty(transformHandles[i]);
+					}
+					transformHierarchy.UpdateWorldTransforms();
+				});
+
+				bool transformsMatch = true;
+				for (uint32_t i = 0; i < nodeCount; i += 97)
+				{
+					transformsMatch &= MatricesMatch(transformHierarchy.RetrieveWorldTransform(transformHandles[i]), legacyNodes[i]->m_Transform);
+				}
+				CrescentCheck(transformsMatch);
+
+				Tests::ReportTimings(std::string(hierarchyShape.m_ShapeName) + (dirtyStride == 1 ? ", all dirty" : ", 1% dirty"), legacyTime, hierarchyTime);
+			}
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#include "CrescentPCH.h"
+#include "../TestFramework.h"
+#include "Shading/UniformTable.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace Crescent
+{
+	namespace
+	{
+		//Found from this file's location rather than the working directory, which depends on how the tests are started.
+		const std::filesystem::path ShippedShaderDirectory = std::filesystem::path(__FILE__).parent_path() / "../../CrescentEngine/Resources/Shaders";
+
+		//Every name the engine's shaders can look up: plain uniforms, uniform block members, and arrays under both "name[0]" and "name". Shaders
+		//under Defunct are never loaded and are skipped.
+		std::set<std::string> CollectShippedUniformNames()
+		{
+			std::set<std::string> uniformNames;
+			if (!std::filesystem::exists(ShippedShaderDirectory))
+			{
+				return uniformNames;
+			}
+
+			const std::regex uniformDeclaration("^\\s*uniform\\s+\\w+\\s+(\\w+)\\s*(\\[[^\\]]*\\])?");
+			const std::regex uniformBlockDeclaration("^\\s*(layout\\s*\\([^)]*\\)\\s*)?uniform\\s+\\w+\\s*$");
+			const std::regex blockMemberDeclaration("^\\s*\\w+\\s+(\\w+)\\s*(\\[[^\\]]*\\])?\\s*;");
+			for (const auto& directoryEntry : std::filesystem::recursive_directory_iterator(ShippedShaderDirectory))
+			{
+				if (!directoryEntry.is_regular_file() || directoryEntry.path().string().find("Defunct") != std::string::npos)
+				{
+					continue;
+				}
+
+				std::ifstream shaderFile(directoryEntry.path());
+				std::string shaderLine;
+				bool insideUniformBlock = false;
+				while (std::getline(shaderFile, shaderLine))
+				{
+					shaderLine = shaderLine.substr(0, shaderLine.find("//"));
+					std::smatch declarationMatch;
+					if (insideUniformBlock)
+					{
+						insideUniformBlock = shaderLine.find('}') == std::string::npos;
+						if (!insideUniformBlock || !std::regex_search(shaderLine, declarationMatch, blockMemberDeclaration))
+						{
+							continue;
+						}
+					}
+					else if (std::regex_search(shaderLine, uniformBlockDeclaration))
+					{
+						insideUniformBlock = true;
+						continue;
+					}
+					else if (!std::regex_search(shaderLine, declarationMatch, uniformDeclaration))
+					{
+						continue;
+					}
+
+					uniformNames.insert(declarationMatch[1].str());
+					if (declarationMatch[2].matched)
+					{
+						uniformNames.insert(declarationMatch[1].str() + "[0]");
+					}
+				}
+			}
+			return uniformNames;
+		}
+	}
+
+	CrescentTest(UniformTable_FindsEveryInsertedName)
+	{
+		UniformTable uniformTable;
+		CrescentCheck(uniformTable.RetrieveUniformLocation(UniformID(std::string("model"))) == -1);
+
+		uniformTable.ResetTable(300);
+		for (int i = 0; i < 300; i++)
+		{
+			CrescentCheck(uniformTable.InsertUniformLocation(UniformID("uniform" + std::to_string(i)), i));
+		}
+
+		bool locationsMatch = true;
+		for (int i = 0; i < 300; i++)
+		{
+			locationsMatch &= uniformTable.RetrieveUniformLocation(UniformID("uniform" + std::to_string(i))) == i;
+		}
+		CrescentCheck(locationsMatch);
+		CrescentCheck(uniformTable.RetrieveUniformLocation(UniformID(std::string("uniform300"))) == -1);
+
+		//Names known at compile time hash the same as at runtime.
+		uniformTable.ResetTable(1);
+		CrescentCheck(uniformTable.InsertUniformLocation(UID("lightSpaceView"), 7));
+		CrescentCheck(uniformTable.RetrieveUniformLocation(UniformID(std::string("lightSpaceView"))) == 7);
+	}
+
+	CrescentTest(UniformTable_RefusesCollidingNames)
+	{
+		//Search for two different names sharing a 32-bit hash. By the birthday bound, one turns up within a few hundred thousand names.
+		std::unordered_map<uint32_t, std::string> namesByHash;
+		std::string firstName, secondName;
+		for (unsigned int i = 0; i < 2000000 && firstName.empty(); i++)
+		{
+			std::string uniformName = "u" + std::to_string(i);
+			auto insertion = namesByHash.insert(std::make_pair(UniformID(uniformName).m_Hash, uniformName));
+			if (!insertion.second)
+			{
+				firstName = insertion.first->second;
+				secondName = uniformName;
+			}
+		}
+		CrescentCheck(!firstName.empty() && firstName != secondName);
+
+		//The first name keeps its location. The second is refused rather than shadowing it.
+		UniformTable uniformTable;
+		uniformTable.ResetTable(3);
+		CrescentCheck(uniformTable.InsertUniformLocation(UniformID(firstName), 1));
+		CrescentCheck(uniformTable.InsertUniformLocation(UniformID(std::string("model")), 2));
+		CrescentCheck(!uniformTable.InsertUniformLocation(UniformID(secondName), 3));
+		CrescentCheck(uniformTable.RetrieveUniformLocation(UniformID(firstName)) == 1);
+		CrescentCheck(uniformTable.RetrieveUniformLocation(UniformID(std::string("model"))) == 2);
+	}
+
+	CrescentTest(UniformTable_ShippedShaderNamesDoNotCollide)
+	{
+		//Checked across all shaders at once rather than per shader, which is stricter than what the tables require.
+		std::set<std::string> uniformNames = CollectShippedUniformNames();
+		CrescentCheck(uniformNames.size() > 50);
+
+		std::map<uint32_t, std::string> namesByHash;
+		for (const std::string& uniformName : uniformNames)
+		{
+			auto insertion = namesByHash.insert(std::make_pair(UniformID(uniformName).m_Hash, uniformName));
+			CrescentCheck(insertion.second);
+		}
+	}
+
+	CrescentBenchmark(UniformTable_LookupAgainstNameScan)
+	{
+		//The names of the deferred point light shader, about a typical shader's worth. Uniforms were previously found by comparing the name, passed as
+		//a std::string, against every active uniform in turn.
+		const char* uniformNames[] = { "gPositionMetallic", "gNormalRoughness", "gAlbedoAO", "lightShadowMap", "clusterGrid", "clusterDepthSliceScale",
+			"cascadeViewProjections", "cascadeViewProjections[0]", "cascadeSplitDepths", "ShadowsEnabled", "lightDirection", "lightColor", "viewPosition",
+			"renderSize", "exposureAmount", "envIrradiance", "envPrefilter", "BRDFLUT", "skyIrradiance", "skyPrefilter", "TexSSAO", "SSAO" };
+		const int uniformCount = sizeof(uniformNames) / sizeof(uniformNames[0]);
+
+		std::vector<std::pair<std::string, int>> activeUniforms;
+		std::vector<UniformID> uniformIDs;
+		UniformTable uniformTable;
+		uniformTable.ResetTable(uniformCount);
+		for (int i = 0; i < uniformCount; i++)
+		{
+			activeUniforms.push_back(std::make_pair(std::string(uniformNames[i]), i));
+			uniformIDs.push_back(UniformID(std::string(uniformNames[i]))); //What UID computes at compile time.
+			uniformTable.InsertUniformLocation(uniformIDs.back(), i);
+		}
+
+		const unsigned int lookupCount = 1000000;
+		long long scanLocationSum = 0;
+		double nameScanTime = Tests::MeasureMilliseconds([&]()
+		{
+			scanLocationSum = 0;
+			for (unsigned int i = 0; i < lookupCount; i++)
+			{
+				std::string uniformName = uniformNames[(i * 7) % uniformCount];
+				for (const auto& activeUniform : activeUniforms)
+				{
+					if (activeUniform.first == uniformName)
+					{
+						scanLocationSum += activeUniform.second;
+						break;
+					}
+				}
+			}
+		});
+
+		long long tableLocationSum = 0;
+		double tableLookupTime = Tests::MeasureMilliseconds([&]()
+		{
+			tableLocationSum = 0;
+			for (unsigned int i = 0; i < lookupCount; i++)
+			{
+				tableLocationSum += uniformTable.RetrieveUniformLocation(uniformIDs[(i * 7) % uniformCount]);
+			}
+		});
+
+		CrescentCheck(scanLocationSum == tableLocationSum);
+		Tests::ReportTimings(std::to_string(lookupCount) + " lookups over " + std::to_string(uniformCount) + " uniforms", nameScanTime, tableLookupTime);
+	}
+}
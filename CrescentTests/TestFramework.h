@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+namespace Crescent
+{
+	namespace Tests
+	{
+		typedef void (*TestFunction)();
+
+		struct TestCase
+		{
+			const char* m_TestName;
+			TestFunction m_TestFunction;
+		};
+
+		/*
+			Tests and benchmarks register themselves through static registrars, so adding one only takes a new CrescentTest or CrescentBenchmark in any file
+			of the project. Tests only touch CPU side code and never create an OpenGL context, letting them run anywhere the engine builds.
+		*/
+
+		class TestRegistry
+		{
+		public:
+			static std::vector<TestCase>& RetrieveTests();
+			static std::vector<TestCase>& RetrieveBenchmarks();
+
+			//Failed checks are counted rather than thrown, so a test reports every check it fails.
+			static void ReportFailure(const char* expression, const char* filePath, int lineNumber);
+			static size_t RetrieveFailureCount();
+			//Heap allocations made by the whole process so far, counted through our replacement of the global operator new.
+			static size_t RetrieveHeapAllocationCount();
+			//Bytes requested by those allocations, including any freed since.
+			static size_t RetrieveHeapAllocatedBytes();
+
+		private:
+			//Disallow creation of any TestRegistry object. This is a static object.
+			TestRegistry();
+		};
+
+		struct TestRegistrar
+		{
+			TestRegistrar(const char* testName, TestFunction testFunction, bool isBenchmark);
+		};
+
+		//Prints one benchmark case, timing the approach an engine path replaced against the engine path itself.
+		void ReportTimings(const std::string& caseName, double baselineMilliseconds, double engineMilliseconds);
+
+		//Best time of several runs, in milliseconds, which leaves out warm up and scheduling noise.
+		template<typename Function>
+		double MeasureMilliseconds(Function function, unsigned int runCount = 5)
+		{
+			double bestTime = 0.0;
+			for (unsigned int i = 0; i < runCount; i++)
+			{
+				auto startTime = std::chrono::high_resolution_clock::now();
+				function();
+				double elapsedTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+				bestTime = i == 0 ? elapsedTime : std::min(bestTime, elapsedTime);
+			}
+			return bestTime;
+		}
+	}
+}
+
+#define CrescentTest(testName)		 static void testName(); static Crescent::Tests::TestRegistrar testName##Registrar(#testName, testName, false); static void testName()
+#define CrescentBenchmark(benchName) static void benchName(); static Crescent::Tests::TestRegistrar benchName##Registrar(#benchName, benchName, true); static void benchName()
+#define CrescentCheck(x)			 do { if (!(x)) { Crescent::Tests::TestRegistry::ReportFailure(#x, __FILE__, __LINE__); } } while (0)
@@ -0,0 +1,117 @@
+#include "CrescentPCH.h"
+#include "TestFramework.h"
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+
+/// Runs every registered test, returning a non-zero exit code if any check failed. Pass --benchmark to run the benchmarks instead, which compare
+/// the engine's CPU paths against the simpler approaches they replaced. Benchmarks are meant for release builds.
+
+static size_t s_HeapAllocationCount = 0;
+static size_t s_HeapAllocatedBytes = 0;
+
+//Every other form of new and delete forwards to these two by default.
+void* operator new(size_t byteSize)
+{
+	s_HeapAllocationCount++;
+	s_HeapAllocatedBytes += byteSize;
+	if (void* memory = malloc(byteSize ? byteSize : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+namespace Crescent
+{
+	namespace Tests
+	{
+		static size_t s_FailureCount = 0;
+
+		std::vector<TestCase>& TestRegistry::RetrieveTests()
+		{
+			static std::vector<TestCase> tests;
+			return tests;
+		}
+
+		std::vector<TestCase>& TestRegistry::RetrieveBenchmarks()
+		{
+			static std::vector<TestCase> benchmarks;
+			return benchmarks;
+		}
+
+		void TestRegistry::ReportFailure(const char* expression, const char* filePath, int lineNumber)
+		{
+			s_FailureCount++;
+			Crescent::ChangeConsoleTextColor(4);
+			std::cout << "    Check failed: " << expression << " (" << filePath << ":" << lineNumber << ")\n";
+			Crescent::ChangeConsoleTextColor(15);
+		}
+
+		size_t TestRegistry::RetrieveFailureCount()
+		{
+			return s_FailureCount;
+		}
+
+		size_t TestRegistry::RetrieveHeapAllocationCount()
+		{
+			return s_HeapAllocationCount;
+		}
+
+		size_t TestRegistry::RetrieveHeapAllocatedBytes()
+		{
+			return s_HeapAllocatedBytes;
+		}
+
+		void ReportTimings(const std::string& caseName, double baselineMilliseconds, double engineMilliseconds)
+		{
+			std::cout << "    " << caseName << ": " << std::fixed << std::setprecision(3) << baselineMilliseconds << " ms -> " << engineMilliseconds << " ms ("
+				<< std::setprecision(2) << baselineMilliseconds / std::max(engineMilliseconds, 1e-6) << "x)\n" << std::defaultfloat << std::setprecision(6);
+		}
+
+		TestRegistrar::TestRegistrar(const char* testName, TestFunction testFunction, bool isBenchmark)
+		{
+			TestCase testCase = { testName, testFunction };
+			(isBenchmark ? TestRegistry::RetrieveBenchmarks() : TestRegistry::RetrieveTests()).push_back(testCase);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace Crescent::Tests;
+
+	bool runBenchmarks = argc > 1 && strcmp(argv[1], "--benchmark") == 0;
+	if (runBenchmarks)
+	{
+		for (const TestCase& benchmark : TestRegistry::RetrieveBenchmarks())
+		{
+			CrescentInfo(benchmark.m_TestName);
+			benchmark.m_TestFunction();
+		}
+		//Benchmarks check that both sides agree, so a wrong result is still reported.
+		return TestRegistry::RetrieveFailureCount() == 0 ? 0 : 1;
+	}
+
+	size_t failedTestCount = 0;
+	for (const TestCase& test : TestRegistry::RetrieveTests())
+	{
+		size_t previousFailureCount = TestRegistry::RetrieveFailureCount();
+		test.m_TestFunction();
+		bool testPassed = TestRegistry::RetrieveFailureCount() == previousFailureCount;
+		failedTestCount += testPassed ? 0 : 1;
+
+		Crescent::ChangeConsoleTextColor(testPassed ? 2 : 4);
+		std::cout << (testPassed ? "[PASS] " : "[FAIL] ") << test.m_TestName << "\n";
+		Crescent::ChangeConsoleTextColor(15);
+	}
+
+	std::cout << TestRegistry::RetrieveTests().size() - failedTestCount << " of " << TestRegistry::RetrieveTests().size() << " tests passed.\n";
+	return failedTestCount == 0 ? 0 : 1;
+}
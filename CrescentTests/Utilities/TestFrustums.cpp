@@ -0,0 +1,20 @@
+#include "CrescentPCH.h"
+#include "TestFrustums.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+namespace Crescent
+{
+	namespace Tests
+	{
+		Frustum GenerateFrustum(std::mt19937& randomEngine, float viewDistance)
+		{
+			std::uniform_real_distribution<float> planarDistribution(-400.0f, 400.0f);
+			std::uniform_real_distribution<float> angleDistribution(0.0f, 6.2831853f);
+			glm::vec3 cameraPosition = glm::vec3(planarDistribution(randomEngine), 10.0f, planarDistribution(randomEngine));
+			float cameraAngle = angleDistribution(randomEngine);
+			glm::mat4 viewMatrix = glm::lookAt(cameraPosition, cameraPosition + glm::vec3(std::cos(cameraAngle), -0.1f, std::sin(cameraAngle)), glm::vec3(0.0f, 1.0f, 0.0f));
+			return Frustum(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, viewDistance) * viewMatrix);
+		}
+	}
+}
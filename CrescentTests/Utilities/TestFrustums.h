@@ -0,0 +1,12 @@
+#pragma once
+#include "Utilities/Frustum.h"
+#include <random>
+
+namespace Crescent
+{
+	namespace Tests
+	{
+		//A camera 10 units up, somewhere within 400 units of the level's center and facing a random direction, seeing up to the given distance.
+		Frustum GenerateFrustum(std::mt19937& randomEngine, float viewDistance);
+	}
+}